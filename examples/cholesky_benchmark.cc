@@ -0,0 +1,169 @@
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glog/logging.h>
+#include <gflags/gflags.h>
+
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+
+#include "graph/view_graph.h"
+#include "math/sparse_cholesky_llt.h"
+#include "rotation_averaging/internal/rotation_estimator_util.h"
+#include "util/timer.h"
+#include "util/types.h"
+
+DEFINE_string(g2o_filename, "", "The absolute path of g2o file");
+DEFINE_int32(num_threads, 0, "The maximum number of threads of CHOLMOD");
+DEFINE_int32(use_gpu, -1,
+             "1 to factorize on the GPU, 0 on the CPU, -1 to follow the "
+             "CHOLMOD_USE_GPU environment variable");
+
+namespace {
+
+const char* OrderingName(const gopt::CholeskyOrderingType ordering_type) {
+  switch (ordering_type) {
+    case gopt::CholeskyOrderingType::AMD:
+      return "AMD";
+    case gopt::CholeskyOrderingType::COLAMD:
+      return "COLAMD";
+    case gopt::CholeskyOrderingType::METIS:
+      return "METIS";
+    case gopt::CholeskyOrderingType::NESDIS:
+      return "NESDIS";
+    case gopt::CholeskyOrderingType::BEST:
+      return "BEST";
+  }
+  return "UNKNOWN";
+}
+
+const char* FactorizationName(
+    const gopt::CholeskyFactorizationType factorization_type) {
+  switch (factorization_type) {
+    case gopt::CholeskyFactorizationType::AUTO:
+      return "AUTO";
+    case gopt::CholeskyFactorizationType::SIMPLICIAL:
+      return "SIMPLICIAL";
+    case gopt::CholeskyFactorizationType::SUPERNODAL:
+      return "SUPERNODAL";
+  }
+  return "UNKNOWN";
+}
+
+}  // namespace
+
+// Compares the fill and the factorization time of the orderings and the
+// factorization types of CHOLMOD on the normal equations A^t * A of the
+// linearized rotation averaging problem of a view graph, which is the system
+// solved by the L1 and IRLS rotation solvers.
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, false);
+
+  google::InitGoogleLogging(argv[0]);
+  FLAGS_alsologtostderr = true;
+  FLAGS_colorlogtostderr = true;
+
+  if (argc < 2) {
+    LOG(INFO) << "[Usage]: cholesky_benchmark --g2o_filename=g2o_filename";
+    return 0;
+  }
+
+  gopt::graph::ViewGraph view_graph;
+  if (!view_graph.ReadG2OFile(FLAGS_g2o_filename)) {
+    LOG(ERROR) << "Failed to read " << FLAGS_g2o_filename;
+    return -1;
+  }
+
+  std::unordered_map<gopt::ImagePair, gopt::TwoViewGeometry> view_pairs;
+  for (const auto& edge_iter : view_graph.GetEdges()) {
+    for (const auto& em_iter : edge_iter.second) {
+      const gopt::image_t src = static_cast<gopt::image_t>(em_iter.second.src);
+      const gopt::image_t dst = static_cast<gopt::image_t>(em_iter.second.dst);
+      const gopt::ImagePair image_pair =
+          (src > dst) ? gopt::ImagePair(dst, src) : gopt::ImagePair(src, dst);
+      view_pairs[image_pair] = gopt::TwoViewGeometry();
+    }
+  }
+
+  std::unordered_map<gopt::image_t, Eigen::Vector3d> rotations;
+  for (const auto& node_iter : view_graph.GetNodes()) {
+    rotations[static_cast<gopt::image_t>(node_iter.first)] =
+        Eigen::Vector3d::Zero();
+  }
+
+  std::unordered_map<gopt::image_t, int> view_id_to_index;
+  gopt::internal::ViewIdToAscentIndex(rotations, &view_id_to_index);
+  Eigen::SparseMatrix<double> sparse_matrix;
+  gopt::internal::SetupLinearSystem(view_pairs, rotations.size(),
+                                    view_id_to_index, &sparse_matrix);
+
+  const Eigen::SparseMatrix<double> lhs =
+      (sparse_matrix.transpose() * sparse_matrix).triangularView<Eigen::Upper>();
+  LOG(INFO) << rotations.size() << " views, " << view_pairs.size()
+            << " view pairs, lhs " << lhs.rows() << "x" << lhs.cols() << " with "
+            << lhs.nonZeros() << " non-zeros in the upper triangle.";
+
+  const std::vector<gopt::CholeskyOrderingType> ordering_types = {
+      gopt::CholeskyOrderingType::AMD, gopt::CholeskyOrderingType::COLAMD,
+      gopt::CholeskyOrderingType::METIS, gopt::CholeskyOrderingType::NESDIS,
+      gopt::CholeskyOrderingType::BEST};
+  const std::vector<gopt::CholeskyFactorizationType> factorization_types = {
+      gopt::CholeskyFactorizationType::SIMPLICIAL,
+      gopt::CholeskyFactorizationType::SUPERNODAL};
+
+  std::ostringstream table;
+  table << std::left << std::setw(8) << "ordering" << std::setw(12)
+        << "factor" << std::setw(10) << "selected" << std::right
+        << std::setw(14) << "nnz(L)" << std::setw(8) << "fill" << std::setw(14)
+        << "flops" << std::setw(14) << "analyze (s)" << std::setw(14)
+        << "factorize (s)" << "\n";
+
+  for (const gopt::CholeskyOrderingType ordering_type : ordering_types) {
+    for (const gopt::CholeskyFactorizationType factorization_type :
+         factorization_types) {
+      gopt::SparseCholeskyLLtOptions options;
+      options.ordering_type = ordering_type;
+      options.factorization_type = factorization_type;
+      options.num_threads = FLAGS_num_threads;
+      options.use_gpu = FLAGS_use_gpu;
+      gopt::SparseCholeskyLLt linear_solver(options);
+
+      gopt::Timer timer;
+      timer.Start();
+      linear_solver.AnalyzePattern(lhs);
+      const double analyze_time = timer.ElapsedSeconds();
+      if (linear_solver.Info() != Eigen::Success) {
+        LOG(WARNING) << "The analysis failed with the "
+                     << OrderingName(ordering_type) << " ordering.";
+        continue;
+      }
+
+      timer.Start();
+      linear_solver.Factorize(lhs);
+      const double factorize_time = timer.ElapsedSeconds();
+      if (linear_solver.Info() != Eigen::Success) {
+        LOG(WARNING) << "The factorization failed with the "
+                     << OrderingName(ordering_type) << " ordering.";
+        continue;
+      }
+
+      table << std::left << std::setw(8) << OrderingName(ordering_type)
+            << std::setw(12) << FactorizationName(factorization_type)
+            << std::setw(10) << OrderingName(linear_solver.SelectedOrdering())
+            << std::right << std::setw(14) << std::fixed
+            << std::setprecision(0) << linear_solver.NumFactorNonZeros()
+            << std::setw(8) << std::setprecision(2)
+            << linear_solver.NumFactorNonZeros() / lhs.nonZeros()
+            << std::setw(14) << std::scientific << std::setprecision(3)
+            << linear_solver.NumFactorizationFlops() << std::setw(14)
+            << std::fixed << std::setprecision(4) << analyze_time
+            << std::setw(14) << factorize_time << "\n";
+    }
+  }
+
+  LOG(INFO) << "CHOLMOD orderings:\n" << table.str();
+  return 0;
+}
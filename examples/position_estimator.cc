@@ -5,9 +5,12 @@
 #include <glog/logging.h>
 #include <gflags/gflags.h>
 
+#include "util/profiler.h"
 #include "util/types.h"
 
 DEFINE_string(g2o_filename, "", "The absolute path of g2o file");
+DEFINE_string(trace_filename, "",
+              "If set, profiles the pipeline and writes a Chrome trace to it");
 
 int main(int argc, char* argv[]) {
   gflags::ParseCommandLineFlags(&argc, &argv, false);
@@ -21,6 +24,10 @@ int main(int argc, char* argv[]) {
     return 0;
   }
 
+  if (!FLAGS_trace_filename.empty()) {
+    gopt::Profiler::Instance().SetEnabled(true);
+  }
+
   std::string g2o_filename = FLAGS_g2o_filename;
   gopt::graph::ViewGraph view_graph;
   view_graph.ReadG2OFile(g2o_filename);
@@ -29,4 +36,9 @@ int main(int argc, char* argv[]) {
 
   std::unordered_map<gopt::image_t, Eigen::Vector3d> global_positions;
   view_graph.TranslationAveraging(options, &global_positions);
+
+  if (!FLAGS_trace_filename.empty()) {
+    LOG(INFO) << "Profile:\n" << gopt::Profiler::Instance().ReportTable();
+    gopt::Profiler::Instance().WriteChromeTrace(FLAGS_trace_filename);
+  }
 }
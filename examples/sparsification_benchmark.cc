@@ -0,0 +1,132 @@
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glog/logging.h>
+#include <gflags/gflags.h>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include "geometry/rotation_utils.h"
+#include "graph/view_graph.h"
+#include "util/map_util.h"
+#include "util/timer.h"
+#include "util/types.h"
+
+DEFINE_string(g2o_filename, "", "The absolute path of g2o file");
+
+namespace {
+
+struct SparsificationSetting {
+  std::string name;
+  bool sparsify_view_graph;
+  gopt::graph::EdgeSparsificationOptions options;
+};
+
+}  // namespace
+
+// Reports the trade-off between speed and accuracy of the sparsification of a
+// view graph for the rotation averaging by the robust L1-L2 estimator. The
+// accuracy is measured against the rotations estimated from all view pairs.
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, false);
+
+  google::InitGoogleLogging(argv[0]);
+  FLAGS_alsologtostderr = true;
+  FLAGS_colorlogtostderr = true;
+
+  if (argc < 2) {
+    LOG(INFO) << "[Usage]: sparsification_benchmark --g2o_filename="
+                 "g2o_filename";
+    return 0;
+  }
+
+  gopt::graph::ViewGraph view_graph;
+  if (!view_graph.ReadG2OFile(FLAGS_g2o_filename)) {
+    LOG(ERROR) << "Failed to read " << FLAGS_g2o_filename;
+    return -1;
+  }
+
+  std::vector<SparsificationSetting> settings(1);
+  settings[0].name = "none";
+  settings[0].sparsify_view_graph = false;
+  for (const int num_neighbors : {1, 2, 4, 8}) {
+    SparsificationSetting setting;
+    setting.name = "top-" + std::to_string(num_neighbors);
+    setting.sparsify_view_graph = true;
+    setting.options.num_neighbors = num_neighbors;
+    settings.push_back(setting);
+  }
+  for (const double epsilon : {2.0, 1.0, 0.5}) {
+    std::ostringstream name;
+    name << "ER eps=" << epsilon;
+    SparsificationSetting setting;
+    setting.name = name.str();
+    setting.sparsify_view_graph = true;
+    setting.options.type =
+        gopt::graph::EdgeSparsificationType::EFFECTIVE_RESISTANCE;
+    setting.options.epsilon = epsilon;
+    settings.push_back(setting);
+  }
+
+  std::ostringstream table;
+  table << std::left << std::setw(14) << "sparsifier" << std::right
+        << std::setw(12) << "view pairs" << std::setw(16) << "sparsify (s)"
+        << std::setw(16) << "estimate (s)" << std::setw(14) << "error (deg)"
+        << "\n";
+
+  std::unordered_map<gopt::image_t, Eigen::Vector3d> reference_rotations;
+  for (const SparsificationSetting& setting : settings) {
+    gopt::RotationEstimatorOptions options;
+    options.estimator_type = gopt::GlobalRotationEstimatorType::ROBUST_L1L2;
+    options.init_method =
+        gopt::GlobalRotationEstimatorInitMethod::MAXIMUM_SPANNING_TREE;
+
+    // The estimator runs on the view graph sparsified beforehand, so that its
+    // time does not include the sparsification.
+    gopt::graph::EdgeSparsificationSummary summary;
+    summary.num_kept_edges = view_graph.GetEdgesNum();
+    gopt::graph::ViewGraph sparse_view_graph;
+    gopt::graph::ViewGraph* estimated_view_graph = &view_graph;
+    if (setting.sparsify_view_graph) {
+      const gopt::graph::Graph<gopt::graph::ViewNode, gopt::graph::ViewEdge>
+          sparse_graph = view_graph.Sparsify(setting.options, &summary);
+      for (const auto& node_iter : sparse_graph.GetNodes()) {
+        sparse_view_graph.AddNode(node_iter.second);
+      }
+      for (const auto& edge_iter : sparse_graph.GetEdges()) {
+        for (const auto& em_iter : edge_iter.second) {
+          sparse_view_graph.AddEdge(em_iter.second);
+        }
+      }
+      estimated_view_graph = &sparse_view_graph;
+    }
+
+    std::unordered_map<gopt::image_t, Eigen::Vector3d> rotations;
+    gopt::Timer timer;
+    timer.Start();
+    if (!estimated_view_graph->RotationAveraging(options, &rotations)) {
+      LOG(WARNING) << "The rotation averaging failed with " << setting.name;
+      continue;
+    }
+    const double estimate_time = timer.ElapsedSeconds();
+    if (reference_rotations.empty()) {
+      reference_rotations = rotations;
+    }
+
+    table << std::left << std::setw(14) << setting.name << std::right
+          << std::setw(12) << summary.num_kept_edges << std::setw(16)
+          << std::fixed << std::setprecision(4) << summary.elapsed_seconds
+          << std::setw(16) << estimate_time << std::setw(14)
+          << gopt::geometry::ComputeMeanRotationErrorDegrees(
+                 reference_rotations, rotations)
+          << "\n";
+  }
+
+  LOG(INFO) << "Sparsification of " << FLAGS_g2o_filename << ":\n"
+            << table.str();
+  return 0;
+}
@@ -113,6 +113,18 @@ Eigen::MatrixXd ProjectToSOd(const Eigen::MatrixXd &M) {
   }
 }
 
+Eigen::Matrix3d AngleAxisToRotationMatrix(const Eigen::Vector3d& angle_axis) {
+  Eigen::Matrix3d rotation;
+  ceres::AngleAxisToRotationMatrix(angle_axis.data(), rotation.data());
+  return rotation;
+}
+
+Eigen::Vector3d RotationMatrixToAngleAxis(const Eigen::Matrix3d& rotation) {
+  Eigen::Vector3d angle_axis;
+  ceres::RotationMatrixToAngleAxis(rotation.data(), angle_axis.data());
+  return angle_axis;
+}
+
 Eigen::Vector3d MultiplyRotations(const Eigen::Vector3d& rotation1,
                                   const Eigen::Vector3d& rotation2) {
   Eigen::Matrix3d rotation1_mat, rotation2_mat;
@@ -225,6 +237,28 @@ void AlignOrientations(
   }
 }
 
+double ComputeMeanRotationErrorDegrees(
+    const std::unordered_map<image_t, Eigen::Vector3d>& reference_rotations,
+    const std::unordered_map<image_t, Eigen::Vector3d>& rotations) {
+  Eigen::Matrix3d alignment_sum = Eigen::Matrix3d::Zero();
+  for (const auto& rotation : reference_rotations) {
+    alignment_sum +=
+        AngleAxisToRotationMatrix(FindOrDie(rotations, rotation.first))
+            .transpose() *
+        AngleAxisToRotationMatrix(rotation.second);
+  }
+  const Eigen::Matrix3d alignment = ProjectToSOd(alignment_sum);
+
+  double sum_error_degrees = 0.0;
+  for (const auto& rotation : reference_rotations) {
+    const Eigen::Matrix3d error =
+        AngleAxisToRotationMatrix(FindOrDie(rotations, rotation.first)) *
+        alignment * AngleAxisToRotationMatrix(rotation.second).transpose();
+    sum_error_degrees += RadToDeg(Eigen::AngleAxisd(error).angle());
+  }
+  return sum_error_degrees / reference_rotations.size();
+}
+
 double RadToDeg(double angle_radians) {
   return angle_radians * kRadToDeg;
 }
@@ -31,6 +31,10 @@ double Clamp(const double val, const double min, const double max);
 
 Eigen::MatrixXd ProjectToSOd(const Eigen::MatrixXd &M);
 
+// Conversions between angle-axis vectors and rotation matrices.
+Eigen::Matrix3d AngleAxisToRotationMatrix(const Eigen::Vector3d& angle_axis);
+Eigen::Vector3d RotationMatrixToAngleAxis(const Eigen::Matrix3d& rotation);
+
 // Rotates the "rotation" set of orientations such that the orientations are
 // most closely aligned in an L2 sense. That is, "rotation" is transformed such
 // that R_rotation * R_gt_rotation^t is minimized.
@@ -43,6 +47,14 @@ void AlignOrientations(
     const std::unordered_map<image_t, Eigen::Vector3d>& gt_rotations,
     std::unordered_map<image_t, Eigen::Vector3d>* rotations);
 
+// The mean angular distance in degrees between the rotations and the
+// reference rotations, which are only defined up to a global rotation G. G is
+// estimated as the chordal mean of R_v^t * R_v^ref. The rotations must contain
+// all views of the reference rotations.
+double ComputeMeanRotationErrorDegrees(
+    const std::unordered_map<image_t, Eigen::Vector3d>& reference_rotations,
+    const std::unordered_map<image_t, Eigen::Vector3d>& rotations);
+
 // Use Ceres to perform a stable composition of rotations. This is not as
 // efficient as directly composing angle axis vectors (see the old
 // implementation commented above) but is more stable.
@@ -0,0 +1,251 @@
+#include "graph/edge_sparsification.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <numeric>
+
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+#include <glog/logging.h>
+
+#include "graph/union_find.h"
+#include "solver/sparse_linear_solver.h"
+#include "util/profiler.h"
+#include "util/random.h"
+#include "util/timer.h"
+
+namespace gopt {
+namespace graph {
+namespace {
+
+// The edge indices sorted by descending weight, with ties broken by index.
+std::vector<int> SortEdgesByWeight(const std::vector<double>& weights) {
+  std::vector<int> order(weights.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&weights](const int e1, const int e2) {
+                     return weights[e1] > weights[e2];
+                   });
+  return order;
+}
+
+// Kruskal's algorithm on the edges sorted by descending weight.
+int KeepMaximumSpanningForest(const int num_vertices,
+                              const std::vector<std::pair<int, int>>& edges,
+                              const std::vector<int>& sorted_edges,
+                              std::vector<bool>* edge_mask) {
+  UnionFind union_find(num_vertices);
+  int num_tree_edges = 0;
+  for (const int e : sorted_edges) {
+    const size_t root1 = union_find.FindRoot(edges[e].first);
+    const size_t root2 = union_find.FindRoot(edges[e].second);
+    if (root1 != root2) {
+      union_find.Union(root1, root2);
+      (*edge_mask)[e] = true;
+      num_tree_edges++;
+    }
+  }
+  return num_tree_edges;
+}
+
+void KeepHeaviestNeighbors(const int num_vertices,
+                           const std::vector<std::pair<int, int>>& edges,
+                           const std::vector<int>& sorted_edges,
+                           const int num_neighbors,
+                           std::vector<bool>* edge_mask) {
+  std::vector<int> num_kept_neighbors(num_vertices, 0);
+  for (const int e : sorted_edges) {
+    if (num_kept_neighbors[edges[e].first] < num_neighbors ||
+        num_kept_neighbors[edges[e].second] < num_neighbors) {
+      (*edge_mask)[e] = true;
+    }
+    num_kept_neighbors[edges[e].first]++;
+    num_kept_neighbors[edges[e].second]++;
+  }
+}
+
+// Approximates the leverages w_e * R_e of the edges. The potentials L^+ * B^t
+// * W^(1/2) * Q^t of k random projections Q with entries +-1 / sqrt(k) are
+// solved with the Laplacian L, which is made nonsingular by grounding one
+// vertex of each connected component. The resistance of an edge is then the
+// squared distance between the potentials of its vertices.
+bool ComputeLeverages(const int num_vertices,
+                      const std::vector<std::pair<int, int>>& edges,
+                      const std::vector<double>& weights,
+                      const EdgeSparsificationOptions& options,
+                      std::vector<double>* leverages) {
+  UnionFind union_find(num_vertices);
+  for (size_t e = 0; e < edges.size(); e++) {
+    if (weights[e] > 0.0) {
+      union_find.Union(edges[e].first, edges[e].second);
+    }
+  }
+  std::vector<bool> grounded(num_vertices, false);
+  std::vector<bool> component_grounded(num_vertices, false);
+  for (int i = 0; i < num_vertices; i++) {
+    const size_t root = union_find.FindRoot(i);
+    if (!component_grounded[root]) {
+      component_grounded[root] = true;
+      grounded[i] = true;
+    }
+  }
+
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.reserve(4 * edges.size() + num_vertices);
+  for (int i = 0; i < num_vertices; i++) {
+    if (grounded[i]) {
+      triplets.emplace_back(i, i, 1.0);
+    }
+  }
+  for (size_t e = 0; e < edges.size(); e++) {
+    const int u = edges[e].first;
+    const int v = edges[e].second;
+    if (!grounded[u]) {
+      triplets.emplace_back(u, u, weights[e]);
+    }
+    if (!grounded[v]) {
+      triplets.emplace_back(v, v, weights[e]);
+    }
+    if (!grounded[u] && !grounded[v]) {
+      triplets.emplace_back(u, v, -weights[e]);
+      triplets.emplace_back(v, u, -weights[e]);
+    }
+  }
+  Eigen::SparseMatrix<double> laplacian(num_vertices, num_vertices);
+  laplacian.setFromTriplets(triplets.begin(), triplets.end());
+
+  std::unique_ptr<SparseLinearSolver> linear_solver =
+      SparseLinearSolver::Create(options.linear_solver_options);
+  linear_solver->Compute(laplacian);
+  if (linear_solver->Info() != Eigen::Success) {
+    LOG(ERROR) << "Cannot factorize the Laplacian of the graph.";
+    return false;
+  }
+
+  const int num_projections = options.num_resistance_projections;
+  const double scale = 1.0 / std::sqrt(num_projections);
+  RandomNumberGenerator rng(options.seed);
+  Eigen::MatrixXd potentials = Eigen::MatrixXd::Zero(num_vertices,
+                                                     num_projections);
+  for (size_t e = 0; e < edges.size(); e++) {
+    const double weight = std::sqrt(weights[e]);
+    for (int k = 0; k < num_projections; k++) {
+      const double sign = rng.RandInt(0, 1) == 0 ? -scale : scale;
+      potentials(edges[e].first, k) += sign * weight;
+      potentials(edges[e].second, k) -= sign * weight;
+    }
+  }
+  for (int i = 0; i < num_vertices; i++) {
+    if (grounded[i]) {
+      potentials.row(i).setZero();
+    }
+  }
+  linear_solver->SolveInPlace(&potentials);
+
+  leverages->resize(edges.size());
+  for (size_t e = 0; e < edges.size(); e++) {
+    const double resistance =
+        (potentials.row(edges[e].first) - potentials.row(edges[e].second))
+            .squaredNorm();
+    (*leverages)[e] = std::min(weights[e] * resistance, 1.0);
+  }
+  return true;
+}
+
+}  // namespace
+
+bool SparsifyEdges(const int num_vertices,
+                   const std::vector<std::pair<int, int>>& edges,
+                   const std::vector<double>& weights,
+                   const EdgeSparsificationOptions& options,
+                   std::vector<bool>* edge_mask,
+                   EdgeSparsificationSummary* summary,
+                   std::vector<double>* kept_weights) {
+  GOPT_PROFILE_SCOPE("SparsifyEdges");
+  CHECK_NOTNULL(edge_mask);
+  CHECK_EQ(edges.size(), weights.size());
+  CHECK_GE(options.num_neighbors, 0);
+  CHECK_GT(options.epsilon, 0.0);
+  CHECK_GT(options.oversampling, 0.0);
+  CHECK_GT(options.num_resistance_projections, 0);
+  for (size_t e = 0; e < edges.size(); e++) {
+    CHECK_NE(edges[e].first, edges[e].second);
+    CHECK_GE(weights[e], 0.0);
+  }
+
+  Timer timer;
+  timer.Start();
+
+  const std::vector<int> sorted_edges = SortEdgesByWeight(weights);
+  edge_mask->assign(edges.size(), false);
+  const int num_tree_edges =
+      KeepMaximumSpanningForest(num_vertices, edges, sorted_edges, edge_mask);
+
+  // The edges which are kept deterministically keep their weights.
+  std::vector<double> sampled_weights(weights);
+
+  bool success = true;
+  switch (options.type) {
+    case EdgeSparsificationType::SPANNING_TREE_TOP_K: {
+      KeepHeaviestNeighbors(num_vertices, edges, sorted_edges,
+                            options.num_neighbors, edge_mask);
+      break;
+    }
+    case EdgeSparsificationType::EFFECTIVE_RESISTANCE: {
+      std::vector<double> leverages;
+      if (!ComputeLeverages(num_vertices, edges, weights, options,
+                            &leverages)) {
+        edge_mask->assign(edges.size(), true);
+        success = false;
+        break;
+      }
+      const double sampling_rate = options.oversampling *
+                                   std::log(std::max(num_vertices, 2)) /
+                                   (options.epsilon * options.epsilon);
+      // The sampled edges are reweighted by the inverse of their probability,
+      // so that the expected Laplacian of the kept edges is the Laplacian of
+      // the graph. The edges of the spanning forest are not sampled.
+      RandomNumberGenerator rng(options.seed + 1);
+      for (size_t e = 0; e < edges.size(); e++) {
+        const double probability = std::min(1.0, sampling_rate * leverages[e]);
+        if (rng.RandDouble(0.0, 1.0) < probability && !(*edge_mask)[e]) {
+          (*edge_mask)[e] = true;
+          sampled_weights[e] = weights[e] / probability;
+        }
+      }
+      break;
+    }
+  }
+
+  if (kept_weights != nullptr) {
+    kept_weights->assign(edges.size(), 0.0);
+    for (size_t e = 0; e < edges.size(); e++) {
+      if ((*edge_mask)[e]) {
+        (*kept_weights)[e] = sampled_weights[e];
+      }
+    }
+  }
+
+  if (summary != nullptr) {
+    double total_weight = 0.0;
+    double kept_weight = 0.0;
+    summary->num_kept_edges = 0;
+    for (size_t e = 0; e < edges.size(); e++) {
+      total_weight += weights[e];
+      if ((*edge_mask)[e]) {
+        kept_weight += weights[e];
+        summary->num_kept_edges++;
+      }
+    }
+    summary->num_edges = edges.size();
+    summary->num_spanning_tree_edges = num_tree_edges;
+    summary->kept_weight_ratio =
+        total_weight > 0.0 ? kept_weight / total_weight : 1.0;
+    summary->elapsed_seconds = timer.ElapsedSeconds();
+  }
+  return success;
+}
+
+}  // namespace graph
+}  // namespace gopt
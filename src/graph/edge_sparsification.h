@@ -0,0 +1,83 @@
+#ifndef GRAPH_EDGE_SPARSIFICATION_H_
+#define GRAPH_EDGE_SPARSIFICATION_H_
+
+#include <utility>
+#include <vector>
+
+#include "solver/solver_options.h"
+
+namespace gopt {
+namespace graph {
+
+enum class EdgeSparsificationType : int {
+  // The maximum spanning tree and the num_neighbors heaviest edges of each
+  // vertex.
+  SPANNING_TREE_TOP_K = 0,
+
+  // The maximum spanning tree and the edges sampled by their effective
+  // resistance (Spielman and Srivastava). The sampled edges are reweighted by
+  // the inverse of their sampling probability, so that the Laplacian of the
+  // kept edges equals the Laplacian of the graph in expectation, and
+  // preserves its spectrum within 1 +- epsilon with high probability if the
+  // oversampling is large enough.
+  EFFECTIVE_RESISTANCE = 1
+};
+
+struct EdgeSparsificationOptions {
+  EdgeSparsificationType type = EdgeSparsificationType::SPANNING_TREE_TOP_K;
+
+  int num_neighbors = 8;
+
+  // The error budget of the effective resistance sparsifier. An edge e is kept
+  // with the probability
+  //
+  //   min(1, oversampling * w_e * R_e * log(n) / epsilon^2),
+  //
+  // where w_e * R_e sums up to the number of vertices minus the number of
+  // connected components.
+  double epsilon = 1.0;
+  double oversampling = 0.5;
+
+  // The effective resistances are approximated by random projections of the
+  // potentials, which costs one solve per projection with a single
+  // factorization of the Laplacian.
+  int num_resistance_projections = 24;
+  solver::LinearSolverOptions linear_solver_options;
+
+  unsigned seed = 75;
+};
+
+struct EdgeSparsificationSummary {
+  int num_edges = 0;
+  int num_kept_edges = 0;
+  int num_spanning_tree_edges = 0;
+
+  // The fraction of the total edge weight which is kept.
+  double kept_weight_ratio = 0.0;
+
+  double elapsed_seconds = 0.0;
+};
+
+// Selects the edges of an undirected graph with the vertices 0, ...,
+// num_vertices - 1 which are kept by sparsification. The edges must be unique
+// and must not be self loops, and the weights must not be negative. The
+// maximum spanning forest is always kept, so the kept edges have the same
+// connected components. Returns false if the Laplacian could not be
+// factorized, in which case all edges are kept.
+//
+// If kept_weights is not null, it is set to the weights of the kept edges,
+// which are the weights w_e of the deterministically kept edges and w_e / p_e
+// of the edges sampled with the probability p_e, and to 0 for the dropped
+// edges.
+bool SparsifyEdges(const int num_vertices,
+                   const std::vector<std::pair<int, int>>& edges,
+                   const std::vector<double>& weights,
+                   const EdgeSparsificationOptions& options,
+                   std::vector<bool>* edge_mask,
+                   EdgeSparsificationSummary* summary = nullptr,
+                   std::vector<double>* kept_weights = nullptr);
+
+}  // namespace graph
+}  // namespace gopt
+
+#endif  // GRAPH_EDGE_SPARSIFICATION_H_
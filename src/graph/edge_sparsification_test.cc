@@ -0,0 +1,180 @@
+#include "graph/edge_sparsification.h"
+
+#include <algorithm>
+
+#include <Eigen/Core>
+
+#include "graph/union_find.h"
+#include "gtest/gtest.h"
+#include "util/random.h"
+
+namespace gopt {
+namespace graph {
+namespace {
+
+// Two dense groups of num_group_vertices vertices with random weights, which
+// are connected by a single edge between their first vertices.
+void CreateDenseGraph(const int num_group_vertices,
+                      std::vector<std::pair<int, int>>* edges,
+                      std::vector<double>* weights) {
+  RandomNumberGenerator rng(75);
+  for (const int offset : {0, num_group_vertices}) {
+    for (int u = 0; u < num_group_vertices; u++) {
+      for (int v = u + 1; v < num_group_vertices; v++) {
+        edges->emplace_back(offset + u, offset + v);
+        weights->push_back(rng.RandDouble(1.0, 10.0));
+      }
+    }
+  }
+  edges->emplace_back(0, num_group_vertices);
+  weights->push_back(0.1);
+}
+
+int CountConnectedComponents(const int num_vertices,
+                             const std::vector<std::pair<int, int>>& edges,
+                             const std::vector<bool>& edge_mask) {
+  UnionFind union_find(num_vertices);
+  for (size_t e = 0; e < edges.size(); e++) {
+    if (edge_mask[e]) {
+      union_find.Union(edges[e].first, edges[e].second);
+    }
+  }
+  int num_components = 0;
+  for (int i = 0; i < num_vertices; i++) {
+    num_components += union_find.FindRoot(i) == static_cast<size_t>(i);
+  }
+  return num_components;
+}
+
+// x^t * L * x for the Laplacian L of the weighted edges.
+double EvaluateLaplacian(const std::vector<std::pair<int, int>>& edges,
+                         const std::vector<double>& weights,
+                         const Eigen::VectorXd& x) {
+  double value = 0.0;
+  for (size_t e = 0; e < edges.size(); e++) {
+    const double difference = x(edges[e].first) - x(edges[e].second);
+    value += weights[e] * difference * difference;
+  }
+  return value;
+}
+
+}  // namespace
+
+TEST(EDGE_SPARSIFICATION_TEST, TestSpanningTreeTopK) {
+  static const int kNumGroupVertices = 40;
+  static const int kNumVertices = 2 * kNumGroupVertices;
+  std::vector<std::pair<int, int>> edges;
+  std::vector<double> weights;
+  CreateDenseGraph(kNumGroupVertices, &edges, &weights);
+
+  EdgeSparsificationOptions options;
+  options.num_neighbors = 3;
+  std::vector<bool> edge_mask;
+  EdgeSparsificationSummary summary;
+  EXPECT_TRUE(
+      SparsifyEdges(kNumVertices, edges, weights, options, &edge_mask,
+                    &summary));
+  ASSERT_EQ(edge_mask.size(), edges.size());
+  EXPECT_EQ(summary.num_edges, edges.size());
+  EXPECT_EQ(summary.num_spanning_tree_edges, kNumVertices - 1);
+  EXPECT_EQ(summary.num_kept_edges,
+            std::count(edge_mask.begin(), edge_mask.end(), true));
+  EXPECT_LE(summary.num_kept_edges,
+            kNumVertices - 1 + kNumVertices * options.num_neighbors);
+  EXPECT_EQ(CountConnectedComponents(kNumVertices, edges, edge_mask), 1);
+
+  // The bridge is in the spanning tree, and the heaviest edges of each vertex
+  // are kept.
+  EXPECT_TRUE(edge_mask.back());
+  for (int u = 0; u < kNumVertices; u++) {
+    std::vector<std::pair<double, int>> incident_edges;
+    for (size_t e = 0; e < edges.size(); e++) {
+      if (edges[e].first == u || edges[e].second == u) {
+        incident_edges.emplace_back(-weights[e], e);
+      }
+    }
+    std::sort(incident_edges.begin(), incident_edges.end());
+    for (int i = 0; i < options.num_neighbors; i++) {
+      EXPECT_TRUE(edge_mask[incident_edges[i].second]);
+    }
+  }
+}
+
+TEST(EDGE_SPARSIFICATION_TEST, TestEffectiveResistance) {
+  static const int kNumGroupVertices = 100;
+  static const int kNumVertices = 2 * kNumGroupVertices;
+  std::vector<std::pair<int, int>> edges;
+  std::vector<double> weights;
+  CreateDenseGraph(kNumGroupVertices, &edges, &weights);
+
+  // An isolated edge is a third component.
+  edges.emplace_back(kNumVertices, kNumVertices + 1);
+  weights.push_back(1.0);
+
+  EdgeSparsificationOptions options;
+  options.type = EdgeSparsificationType::EFFECTIVE_RESISTANCE;
+  std::vector<bool> edge_mask;
+  EdgeSparsificationSummary summary;
+  EXPECT_TRUE(SparsifyEdges(kNumVertices + 2, edges, weights, options,
+                            &edge_mask, &summary));
+  EXPECT_EQ(summary.num_spanning_tree_edges, kNumVertices);
+  EXPECT_LT(summary.num_kept_edges, 0.2 * edges.size());
+  EXPECT_EQ(CountConnectedComponents(kNumVertices + 2, edges, edge_mask), 2);
+  EXPECT_TRUE(edge_mask[edges.size() - 2]);
+  EXPECT_TRUE(edge_mask.back());
+
+  // A smaller error budget keeps more edges.
+  options.epsilon = 0.5;
+  EdgeSparsificationSummary accurate_summary;
+  SparsifyEdges(kNumVertices + 2, edges, weights, options, &edge_mask,
+                &accurate_summary);
+  EXPECT_GT(accurate_summary.num_kept_edges, 2 * summary.num_kept_edges);
+}
+
+TEST(EDGE_SPARSIFICATION_TEST, TestKeptWeights) {
+  static const int kNumGroupVertices = 100;
+  static const int kNumVertices = 2 * kNumGroupVertices;
+  std::vector<std::pair<int, int>> edges;
+  std::vector<double> weights;
+  CreateDenseGraph(kNumGroupVertices, &edges, &weights);
+
+  // The top-k sparsifier keeps the weights.
+  EdgeSparsificationOptions options;
+  std::vector<bool> edge_mask;
+  std::vector<double> kept_weights;
+  EXPECT_TRUE(SparsifyEdges(kNumVertices, edges, weights, options, &edge_mask,
+                            nullptr, &kept_weights));
+  ASSERT_EQ(kept_weights.size(), edges.size());
+  for (size_t e = 0; e < edges.size(); e++) {
+    EXPECT_EQ(kept_weights[e], edge_mask[e] ? weights[e] : 0.0);
+  }
+
+  // The sampled edges are reweighted, which preserves the quadratic form of
+  // the Laplacian.
+  options.type = EdgeSparsificationType::EFFECTIVE_RESISTANCE;
+  options.epsilon = 0.5;
+  EXPECT_TRUE(SparsifyEdges(kNumVertices, edges, weights, options, &edge_mask,
+                            nullptr, &kept_weights));
+  int num_reweighted_edges = 0;
+  for (size_t e = 0; e < edges.size(); e++) {
+    if (!edge_mask[e]) {
+      EXPECT_EQ(kept_weights[e], 0.0);
+      continue;
+    }
+    EXPECT_GE(kept_weights[e], weights[e]);
+    num_reweighted_edges += kept_weights[e] > weights[e];
+  }
+  EXPECT_GT(num_reweighted_edges, 0);
+
+  RandomNumberGenerator rng(76);
+  for (int i = 0; i < 10; i++) {
+    Eigen::VectorXd x(kNumVertices);
+    rng.SetRandom(&x);
+    EXPECT_NEAR(EvaluateLaplacian(edges, kept_weights, x) /
+                    EvaluateLaplacian(edges, weights, x),
+                1.0, 0.2);
+  }
+}
+
+}  // namespace graph
+}  // namespace gopt
@@ -1,6 +1,7 @@
 #ifndef GRAPH_GRAPH_H_
 #define GRAPH_GRAPH_H_
 
+#include <memory>
 #include <queue>
 #include <string>
 #include <unordered_set>
@@ -10,6 +11,8 @@
 
 #include "graph/node.h"
 #include "graph/edge.h"
+#include "graph/edge_sparsification.h"
+#include "graph/hierarchical_clustering.h"
 
 namespace gopt {
 namespace graph {
@@ -72,6 +75,25 @@ class Graph {
   // Graph-cut algorithm
   std::unordered_map<int, int> NormalizedCut(const size_t cluster_num) const;
 
+  // Hierarchical clustering by recursive normalized cuts. The cluster tree of
+  // the nodes of the edges is built by the first query and cached, and the
+  // subtrees of changed edges are rebuilt by the next query, which only
+  // approximates a rebuilt tree (see ClusterTree::Repair()). Partitions at
+  // several granularities only cost O(V) each. The queries are not thread
+  // safe.
+  void SetHierarchicalClusteringOptions(
+      const HierarchicalClusteringOptions& options);
+  const ClusterTree& GetClusterTree() const;
+  std::unordered_map<int, int> HierarchicalCut(const size_t cluster_num) const;
+
+  // Edge sparsification. Returns the graph with all nodes and the edges kept
+  // by SparsifyEdges(), where the edges between two nodes in both directions
+  // are one undirected edge whose weight is the sum of their weights. The
+  // weights of the kept edges are the reweighted weights of SparsifyEdges().
+  Graph<NodeType, EdgeType> Sparsify(
+      const EdgeSparsificationOptions& options,
+      EdgeSparsificationSummary* summary = nullptr) const;
+
   // graph information presentation.
   void ShowInfo() const;
   void ShowInfo(const std::string& filename) const;
@@ -92,6 +114,22 @@ class Graph {
   std::unordered_map<node_t, node_t> degrees_;
   std::unordered_map<node_t, node_t> out_degrees_;
   std::unordered_map<node_t, node_t> in_degrees_;
+
+ private:
+  // The nodes of the edges in ascending order of id, and the undirected graph
+  // of the edges over their indices in the CSR format of Graclus. The edges
+  // stored in both directions are merged, and self loops are dropped.
+  void BuildCSRGraph(std::vector<node_t>* node_ids, std::vector<int>* xadj,
+                     std::vector<int>* adjncy,
+                     std::vector<weight_d>* weights) const;
+
+  // The cached cluster tree and its options are shared by copies of the graph,
+  // by copy construction and assignment, until the tree is repaired. The
+  // changed edges are only recorded while there is a tree.
+  HierarchicalClusteringOptions cluster_tree_options_;
+  mutable std::shared_ptr<ClusterTree> cluster_tree_;
+  mutable std::vector<node_t> cluster_tree_node_ids_;
+  mutable std::vector<std::pair<node_t, node_t>> changed_edges_;
 };
 
 }  // namespace graph
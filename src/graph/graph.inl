@@ -1,6 +1,7 @@
 #include "graph/graph.h"
 
 #include <glog/logging.h>
+#include <algorithm>
 #include <fstream>
 
 #include "graph/color_gradient.h"
@@ -26,11 +27,17 @@ Graph<NodeType, EdgeType>::Graph(const size_t n) {
 
 template <typename NodeType, typename EdgeType>
 Graph<NodeType, EdgeType>::Graph(const Graph<NodeType, EdgeType>& graph) {
+  size_ = graph.size_;
   nodes_ = graph.GetNodes();
   edges_ = graph.GetEdges();
   degrees_ = graph.GetDegrees();
   out_degrees_ = graph.GetOutDegrees();
   in_degrees_ = graph.GetInDegrees();
+
+  cluster_tree_options_ = graph.cluster_tree_options_;
+  cluster_tree_ = graph.cluster_tree_;
+  cluster_tree_node_ids_ = graph.cluster_tree_node_ids_;
+  changed_edges_ = graph.changed_edges_;
 }
 
 template <typename NodeType, typename EdgeType>
@@ -193,6 +200,9 @@ bool Graph<NodeType, EdgeType>::AddEdge(const EdgeType& edge) {
   }
 
   edges_[edge.src][edge.dst] = edge;
+  if (cluster_tree_ != nullptr) {
+    changed_edges_.emplace_back(edge.src, edge.dst);
+  }
 
   return true;
 }
@@ -211,6 +221,9 @@ bool Graph<NodeType, EdgeType>::AlterEdge(const EdgeType& edge) {
   }
 
   edges_.at(edge.src).at(edge.dst) = edge;
+  if (cluster_tree_ != nullptr) {
+    changed_edges_.emplace_back(edge.src, edge.dst);
+  }
   return true;
 }
 
@@ -236,6 +249,9 @@ bool Graph<NodeType, EdgeType>::DeleteEdge(
   if (edges_[src].empty()) {
     edges_.erase(em_ite);
   }
+  if (cluster_tree_ != nullptr) {
+    changed_edges_.emplace_back(src, dst);
+  }
   return true;
 }
 
@@ -422,20 +438,217 @@ std::vector<EdgeType> Graph<NodeType, EdgeType>::ShortestPath(
 template <typename NodeType, typename EdgeType>
 std::unordered_map<int, int> Graph<NodeType, EdgeType>::NormalizedCut(
     const size_t cluster_num) const {
+  std::vector<node_t> node_ids;
+  std::vector<int> xadj, adjncy;
+  std::vector<weight_d> weights;
+  BuildCSRGraph(&node_ids, &xadj, &adjncy, &weights);
+  const int num_vertices = node_ids.size();
+
+  const std::vector<int> cut_labels = ComputeNormalizedMinGraphCut(
+      xadj, adjncy, QuantizeEdgeWeights(weights), cluster_num);
+  std::unordered_map<int, int> labels;
+  labels.reserve(num_vertices);
+  for (int i = 0; i < num_vertices; i++) {
+    labels.emplace(static_cast<int>(node_ids[i]), cut_labels[i]);
+  }
+  return labels;
+}
+
+template <typename NodeType, typename EdgeType>
+void Graph<NodeType, EdgeType>::SetHierarchicalClusteringOptions(
+    const HierarchicalClusteringOptions& options) {
+  cluster_tree_options_ = options;
+  cluster_tree_.reset();
+  changed_edges_.clear();
+}
+
+template <typename NodeType, typename EdgeType>
+const ClusterTree& Graph<NodeType, EdgeType>::GetClusterTree() const {
+  if (cluster_tree_ != nullptr && changed_edges_.empty()) {
+    return *cluster_tree_;
+  }
+
+  std::vector<node_t> node_ids;
+  std::vector<int> xadj, adjncy;
+  std::vector<weight_d> weights;
+  BuildCSRGraph(&node_ids, &xadj, &adjncy, &weights);
+  const std::vector<int> adjwgt = QuantizeEdgeWeights(weights);
+
+  // The tree is only repaired if the edges still have the same nodes.
+  if (cluster_tree_ != nullptr && node_ids == cluster_tree_node_ids_) {
+    std::vector<std::pair<int, int>> changed_edges;
+    changed_edges.reserve(changed_edges_.size());
+    for (const auto& edge : changed_edges_) {
+      const auto it1 =
+          std::lower_bound(node_ids.begin(), node_ids.end(), edge.first);
+      const auto it2 =
+          std::lower_bound(node_ids.begin(), node_ids.end(), edge.second);
+      if (it1 != node_ids.end() && *it1 == edge.first &&
+          it2 != node_ids.end() && *it2 == edge.second) {
+        changed_edges.emplace_back(it1 - node_ids.begin(),
+                                   it2 - node_ids.begin());
+      }
+    }
+    if (cluster_tree_.use_count() > 1) {
+      cluster_tree_ = std::make_shared<ClusterTree>(*cluster_tree_);
+    }
+    cluster_tree_->Repair(xadj, adjncy, adjwgt, changed_edges);
+  } else {
+    cluster_tree_ = std::make_shared<ClusterTree>();
+    cluster_tree_->Build(xadj, adjncy, adjwgt, cluster_tree_options_);
+    cluster_tree_node_ids_.swap(node_ids);
+  }
+  changed_edges_.clear();
+  return *cluster_tree_;
+}
+
+template <typename NodeType, typename EdgeType>
+std::unordered_map<int, int> Graph<NodeType, EdgeType>::HierarchicalCut(
+    const size_t cluster_num) const {
+  const std::vector<int> cluster_labels =
+      GetClusterTree().ExtractPartition(cluster_num);
+  std::unordered_map<int, int> labels;
+  labels.reserve(cluster_labels.size());
+  for (size_t i = 0; i < cluster_labels.size(); i++) {
+    labels.emplace(static_cast<int>(cluster_tree_node_ids_[i]),
+                   cluster_labels[i]);
+  }
+  return labels;
+}
+
+template <typename NodeType, typename EdgeType>
+Graph<NodeType, EdgeType> Graph<NodeType, EdgeType>::Sparsify(
+    const EdgeSparsificationOptions& options,
+    EdgeSparsificationSummary* summary) const {
+  std::vector<node_t> node_ids;
+  std::vector<int> xadj, adjncy;
+  std::vector<weight_d> weights;
+  BuildCSRGraph(&node_ids, &xadj, &adjncy, &weights);
+
+  // The undirected edges in ascending order.
   std::vector<std::pair<int, int>> edges;
-  std::vector<int> weights;
+  std::vector<double> edge_weights;
+  for (size_t i = 0; i < node_ids.size(); i++) {
+    for (int e = xadj[i]; e < xadj[i + 1]; e++) {
+      if (static_cast<int>(i) < adjncy[e]) {
+        edges.emplace_back(i, adjncy[e]);
+        edge_weights.push_back(std::max(weights[e], 0.0));
+      }
+    }
+  }
+  std::vector<bool> edge_mask;
+  std::vector<double> kept_weights;
+  SparsifyEdges(node_ids.size(), edges, edge_weights, options, &edge_mask,
+                summary, &kept_weights);
 
+  Graph<NodeType, EdgeType> graph(this->size_);
+  for (const auto& node_iter : nodes_) {
+    graph.AddNode(node_iter.second);
+  }
+  const auto GetVertexIdx = [&node_ids](const node_t id) {
+    return static_cast<int>(
+        std::lower_bound(node_ids.begin(), node_ids.end(), id) -
+        node_ids.begin());
+  };
   for (const auto& edge_iter : edges_) {
-    const EdgeMap& em = edge_iter.second;
-    for (auto em_iter : em) {
-      edges.emplace_back(
-          static_cast<int>(em_iter.second.src),
-          static_cast<int>(em_iter.second.dst));
-      weights.push_back(static_cast<int>(em_iter.second.weight));
+    for (const auto& em_iter : edge_iter.second) {
+      const int src = GetVertexIdx(edge_iter.first);
+      const int dst = GetVertexIdx(em_iter.first);
+      const auto it =
+          std::lower_bound(edges.begin(), edges.end(),
+                           std::make_pair(std::min(src, dst),
+                                          std::max(src, dst)));
+      const int e = it - edges.begin();
+      if (src == dst || !edge_mask[e]) {
+        continue;
+      }
+      // The directed edges of a sampled edge are scaled by its reweighting.
+      EdgeType edge = em_iter.second;
+      if (edge_weights[e] > 0.0) {
+        edge.weight *= kept_weights[e] / edge_weights[e];
+      }
+      graph.AddEdge(edge);
     }
   }
+  return graph;
+}
 
-  return ComputeNormalizedMinGraphCut(edges, weights, cluster_num);
+template <typename NodeType, typename EdgeType>
+void Graph<NodeType, EdgeType>::BuildCSRGraph(
+    std::vector<node_t>* node_ids, std::vector<int>* xadj,
+    std::vector<int>* adjncy, std::vector<weight_d>* weights) const {
+  // The nodes of the edges, in ascending order of id, are the vertices of the
+  // CSR graph handed to Graclus.
+  node_ids->clear();
+  for (const auto& edge_iter : edges_) {
+    node_ids->push_back(edge_iter.first);
+    for (const auto& em_iter : edge_iter.second) {
+      node_ids->push_back(em_iter.first);
+    }
+  }
+  std::sort(node_ids->begin(), node_ids->end());
+  node_ids->erase(std::unique(node_ids->begin(), node_ids->end()),
+                  node_ids->end());
+  const auto GetVertexIdx = [node_ids](const node_t id) {
+    return static_cast<int>(
+        std::lower_bound(node_ids->begin(), node_ids->end(), id) -
+        node_ids->begin());
+  };
+
+  // Each edge is added to the lists of both of its nodes. Self loops are
+  // dropped.
+  const int num_vertices = node_ids->size();
+  xadj->assign(num_vertices + 1, 0);
+  for (const auto& edge_iter : edges_) {
+    const int src = GetVertexIdx(edge_iter.first);
+    for (const auto& em_iter : edge_iter.second) {
+      const int dst = GetVertexIdx(em_iter.first);
+      if (src != dst) {
+        ++(*xadj)[src + 1];
+        ++(*xadj)[dst + 1];
+      }
+    }
+  }
+  for (int i = 0; i < num_vertices; i++) {
+    (*xadj)[i + 1] += (*xadj)[i];
+  }
+
+  std::vector<std::pair<int, weight_d>> adjacency((*xadj)[num_vertices]);
+  std::vector<int> next(xadj->begin(), xadj->end() - 1);
+  for (const auto& edge_iter : edges_) {
+    const int src = GetVertexIdx(edge_iter.first);
+    for (const auto& em_iter : edge_iter.second) {
+      const int dst = GetVertexIdx(em_iter.first);
+      if (src != dst) {
+        adjacency[next[src]++] = std::make_pair(dst, em_iter.second.weight);
+        adjacency[next[dst]++] = std::make_pair(src, em_iter.second.weight);
+      }
+    }
+  }
+
+  // The edges stored in both directions are merged, in place.
+  int num_entries = 0;
+  for (int i = 0; i < num_vertices; i++) {
+    const int begin = (*xadj)[i];
+    std::sort(adjacency.begin() + begin, adjacency.begin() + (*xadj)[i + 1]);
+    (*xadj)[i] = num_entries;
+    for (int e = begin; e < (*xadj)[i + 1]; e++) {
+      if (num_entries > (*xadj)[i] &&
+          adjacency[num_entries - 1].first == adjacency[e].first) {
+        adjacency[num_entries - 1].second += adjacency[e].second;
+      } else {
+        adjacency[num_entries++] = adjacency[e];
+      }
+    }
+  }
+  (*xadj)[num_vertices] = num_entries;
+
+  adjncy->resize(num_entries);
+  weights->resize(num_entries);
+  for (int e = 0; e < num_entries; e++) {
+    (*adjncy)[e] = adjacency[e].first;
+    (*weights)[e] = adjacency[e].second;
+  }
 }
 
 template <typename NodeType, typename EdgeType>
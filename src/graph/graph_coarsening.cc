@@ -0,0 +1,104 @@
+#include "graph/graph_coarsening.h"
+
+#include <algorithm>
+#include <mutex>
+
+extern "C" {
+#include "Graclus/metisLib/metis.h"
+}
+
+#include <glog/logging.h>
+
+#include "graph/graph_cut.h"
+
+namespace gopt {
+namespace graph {
+
+std::vector<std::vector<int>> ComputeCoarseningHierarchy(
+    const int num_vertices, const std::vector<std::pair<int, int>>& edges,
+    const std::vector<int>& weights, const int coarsen_to) {
+  CHECK_EQ(edges.size(), weights.size());
+  CHECK_GT(coarsen_to, 0);
+
+  std::vector<std::vector<int>> hierarchy;
+  if (num_vertices <= coarsen_to || edges.empty()) {
+    return hierarchy;
+  }
+
+  // Graclus takes the adjacency structure of the graph in CSR format, where
+  // each edge appears in the lists of both of its vertices. Self loops are
+  // dropped.
+  std::vector<idxtype> xadj(num_vertices + 1, 0);
+  for (const auto& edge : edges) {
+    CHECK_GE(edge.first, 0);
+    CHECK_LT(edge.first, num_vertices);
+    CHECK_GE(edge.second, 0);
+    CHECK_LT(edge.second, num_vertices);
+    if (edge.first != edge.second) {
+      ++xadj[edge.first + 1];
+      ++xadj[edge.second + 1];
+    }
+  }
+  for (int i = 0; i < num_vertices; i++) {
+    xadj[i + 1] += xadj[i];
+  }
+
+  std::vector<idxtype> adjncy(xadj[num_vertices]);
+  std::vector<idxtype> adjwgt(xadj[num_vertices]);
+  std::vector<idxtype> next(xadj.begin(), xadj.end() - 1);
+  for (size_t i = 0; i < edges.size(); i++) {
+    const int vertex1 = edges[i].first;
+    const int vertex2 = edges[i].second;
+    if (vertex1 == vertex2) {
+      continue;
+    }
+    adjncy[next[vertex1]] = vertex2;
+    adjwgt[next[vertex1]++] = weights[i];
+    adjncy[next[vertex2]] = vertex1;
+    adjwgt[next[vertex2]++] = weights[i];
+  }
+
+  // Graclus reseeds and draws from the global rand(), see GraclusMutex().
+  std::lock_guard<std::mutex> lock(GraclusMutex());
+  GraphType graph;
+  SetUpGraph(&graph, OP_KMETIS, num_vertices, 1, xadj.data(), adjncy.data(),
+             nullptr, adjwgt.data(), 1);
+
+  CtrlType ctrl;
+  ctrl.CType = MATCH_SHEMKWAY;
+  ctrl.IType = KMETIS_ITYPE;
+  ctrl.RType = KMETIS_RTYPE;
+  ctrl.dbglvl = 0;
+  ctrl.optype = OP_KMETIS;
+  ctrl.CoarsenTo = coarsen_to;
+  // Bounds the number of input vertices merged into one coarse vertex by the
+  // bound 1.5 * n / CoarsenTo of MLKKM_WPartGraphKway(), without the factor
+  // of 100 by which it relaxes the bound there, so that the coarse vertices
+  // stay small.
+  ctrl.maxvwgt = std::max(2, static_cast<int>(1.5 * num_vertices / coarsen_to));
+  InitRandom(-1);
+  AllocateWorkSpace(&ctrl, &graph, 2);
+
+  Coarsen2Way(&ctrl, &graph);
+
+  GraphType* finer = &graph;
+  while (finer->coarser != nullptr) {
+    hierarchy.emplace_back(finer->cmap, finer->cmap + finer->nvtxs);
+    finer = finer->coarser;
+  }
+
+  // Release the coarse graphs, which Graclus allocated.
+  GraphType* coarser = graph.coarser;
+  while (coarser != nullptr) {
+    GraphType* next_coarser = coarser->coarser;
+    FreeGraph(coarser);
+    coarser = next_coarser;
+  }
+  FreeWorkSpace(&ctrl, &graph);
+  GKfree(reinterpret_cast<void**>(&graph.gdata), LTERM);
+
+  return hierarchy;
+}
+
+}  // namespace graph
+}  // namespace gopt
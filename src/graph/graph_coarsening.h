@@ -0,0 +1,30 @@
+#ifndef GRAPH_GRAPH_COARSENING_H_
+#define GRAPH_GRAPH_COARSENING_H_
+
+#include <utility>
+#include <vector>
+
+namespace gopt {
+namespace graph {
+
+// Coarsens a weighted, undirected graph with the vertices 0, ..., num_vertices
+// - 1 by the multilevel heavy edge matching of Graclus. Every level matches
+// each vertex with at most one neighbor, preferring heavy edges, and merges the
+// matched vertices. The coarsening stops once a level has at most coarsen_to
+// vertices or the matching barely reduces the graph anymore.
+//
+// Returns one map per coarsening step, from the vertices of the finer level to
+// the vertices of the coarser level, starting with the input graph. Composing
+// the maps aggregates the input vertices.
+//
+// The coarsening holds GraclusMutex(), as Graclus reseeds the global rand(),
+// so that the hierarchy is the same for the same graph, but calls from several
+// threads run one after another.
+std::vector<std::vector<int>> ComputeCoarseningHierarchy(
+    const int num_vertices, const std::vector<std::pair<int, int>>& edges,
+    const std::vector<int>& weights, const int coarsen_to);
+
+}  // namespace graph
+}  // namespace gopt
+
+#endif  // GRAPH_GRAPH_COARSENING_H_
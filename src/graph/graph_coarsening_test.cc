@@ -0,0 +1,73 @@
+#include "graph/graph_coarsening.h"
+
+#include <algorithm>
+
+#include "gtest/gtest.h"
+
+namespace gopt {
+namespace graph {
+namespace {
+
+// The edges of a width x height grid graph.
+void CreateGridGraph(const int width, const int height,
+                     std::vector<std::pair<int, int>>* edges,
+                     std::vector<int>* weights) {
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      const int vertex = y * width + x;
+      if (x + 1 < width) {
+        edges->emplace_back(vertex, vertex + 1);
+        weights->push_back(1 + (x + y) % 3);
+      }
+      if (y + 1 < height) {
+        edges->emplace_back(vertex, vertex + width);
+        weights->push_back(1 + (x * y) % 3);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST(GRAPH_COARSENING_TEST, TestComputeCoarseningHierarchy) {
+  static const int kWidth = 30;
+  static const int kHeight = 20;
+  static const int kCoarsenTo = 20;
+  std::vector<std::pair<int, int>> edges;
+  std::vector<int> weights;
+  CreateGridGraph(kWidth, kHeight, &edges, &weights);
+
+  const std::vector<std::vector<int>> hierarchy = ComputeCoarseningHierarchy(
+      kWidth * kHeight, edges, weights, kCoarsenTo);
+  ASSERT_GT(hierarchy.size(), 1);
+
+  int num_vertices = kWidth * kHeight;
+  for (const std::vector<int>& level : hierarchy) {
+    ASSERT_EQ(level.size(), num_vertices);
+    const int num_coarse_vertices =
+        *std::max_element(level.begin(), level.end()) + 1;
+    EXPECT_LT(num_coarse_vertices, num_vertices);
+
+    // Every coarse vertex merges one or two vertices of the finer level.
+    std::vector<int> num_merged(num_coarse_vertices, 0);
+    for (const int coarse_vertex : level) {
+      ASSERT_GE(coarse_vertex, 0);
+      ++num_merged[coarse_vertex];
+    }
+    for (const int count : num_merged) {
+      EXPECT_GE(count, 1);
+      EXPECT_LE(count, 2);
+    }
+    num_vertices = num_coarse_vertices;
+  }
+  EXPECT_LT(num_vertices, kWidth * kHeight / 4);
+}
+
+TEST(GRAPH_COARSENING_TEST, TestComputeCoarseningHierarchySmallGraph) {
+  const std::vector<std::pair<int, int>> edges = {{0, 1}, {1, 2}, {2, 3}};
+  const std::vector<int> weights = {1, 2, 1};
+  EXPECT_TRUE(ComputeCoarseningHierarchy(4, edges, weights, 4).empty());
+}
+
+}  // namespace graph
+}  // namespace gopt
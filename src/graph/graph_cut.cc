@@ -1,6 +1,8 @@
 #include "graph/graph_cut.h"
 
-#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 extern "C" {
 #include "Graclus/metisLib/metis.h"
@@ -8,117 +10,72 @@ extern "C" {
 
 #include <glog/logging.h>
 
+#include "graph/parallel_graph_cut.h"
+
 namespace gopt {
 namespace graph {
+namespace {
 
-// Wrapper class for weighted, undirected Graclus graph.
-class GraclusGraph {
- public:
-  GraclusGraph(const std::vector<std::pair<int, int>>& edges,
-               const std::vector<int>& weights) {
-    CHECK_EQ(edges.size(), weights.size());
-
-    std::unordered_map<int, std::vector<std::pair<int, int>>> adjacency_list;
-    for (size_t i = 0; i < edges.size(); ++i) {
-      const auto& edge = edges[i];
-      const auto weight = weights[i];
-      const int vertex_idx1 = GetVertexIdx(edge.first);
-      const int vertex_idx2 = GetVertexIdx(edge.second);
-      adjacency_list[vertex_idx1].emplace_back(vertex_idx2, weight);
-      adjacency_list[vertex_idx2].emplace_back(vertex_idx1, weight);
-    }
-
-    xadj_.reserve(vertex_id_to_idx_.size() + 1);
-    adjncy_.reserve(2 * edges.size());
-    adjwgt_.reserve(2 * edges.size());
-
-    idxtype edge_idx = 0;
-    for (size_t i = 0; i < vertex_id_to_idx_.size(); ++i) {
-      xadj_.push_back(edge_idx);
-
-      if (adjacency_list.count(i) == 0) {
-        continue;
-      }
-
-      for (const auto& edge : adjacency_list[i]) {
-        edge_idx += 1;
-        adjncy_.push_back(edge.first);
-        adjwgt_.push_back(edge.second);
-      }
-    }
-
-    xadj_.push_back(edge_idx);
-
-    CHECK_EQ(edge_idx, 2 * edges.size());
-    CHECK_EQ(xadj_.size(), vertex_id_to_idx_.size() + 1);
-    CHECK_EQ(adjncy_.size(), 2 * edges.size());
-    CHECK_EQ(adjwgt_.size(), 2 * edges.size());
+// Bounds of the quantized weights. The degrees and the volumes of Graclus are
+// sums of weights of type int, so the total weight is bounded as well.
+const double kMaxQuantizedWeight = 1 << 20;
+const double kMaxQuantizedTotalWeight = 1 << 29;
 
-    data.gdata = data.rdata = nullptr;
+}  // namespace
 
-    data.nvtxs = vertex_id_to_idx_.size();
-    data.nedges = 2 * edges.size();
-    data.mincut = data.minvol = -1;
-
-    data.xadj = xadj_.data();
-    data.adjncy = adjncy_.data();
-
-    data.vwgt = nullptr;
-    data.adjwgt = adjwgt_.data();
-
-    data.adjwgtsum = nullptr;
-    data.label = nullptr;
-    data.cmap = nullptr;
-
-    data.where = data.pwgts = nullptr;
-    data.id = data.ed = nullptr;
-    data.bndptr = data.bndind = nullptr;
-    data.rinfo = nullptr;
-    data.vrinfo = nullptr;
-    data.nrinfo = nullptr;
-
-    data.ncon = 1;
-    data.nvwgt = nullptr;
-    data.npwgts = nullptr;
+std::mutex& GraclusMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
 
-    data.vsize = nullptr;
+std::vector<int> QuantizeEdgeWeights(const std::vector<double>& weights) {
+  double max_weight = 0.0;
+  double total_weight = 0.0;
+  for (const double weight : weights) {
+    CHECK_GE(weight, 0.0);
+    max_weight = std::max(max_weight, weight);
+    total_weight += weight;
+  }
 
-    data.coarser = data.finer = nullptr;
+  std::vector<int> quantized_weights(weights.size(), 0);
+  if (max_weight == 0.0) {
+    return quantized_weights;
   }
 
-  int GetVertexIdx(const int id) {
-    const auto it = vertex_id_to_idx_.find(id);
-    if (it == vertex_id_to_idx_.end()) {
-      const int idx = vertex_id_to_idx_.size();
-      vertex_id_to_idx_.emplace(id, idx);
-      vertex_idx_to_id_.emplace(idx, id);
-      return idx;
-    } else {
-      return it->second;
+  const double scale = std::min(kMaxQuantizedWeight / max_weight,
+                                kMaxQuantizedTotalWeight / total_weight);
+  for (size_t i = 0; i < weights.size(); i++) {
+    if (weights[i] > 0.0) {
+      quantized_weights[i] =
+          std::max(1, static_cast<int>(std::lround(scale * weights[i])));
     }
   }
+  return quantized_weights;
+}
 
-  int GetVertexId(const int idx) { return vertex_idx_to_id_.at(idx); }
-
-  GraphType data;
-
- private:
-  std::unordered_map<int, int> vertex_id_to_idx_;
-  std::unordered_map<int, int> vertex_idx_to_id_;
-  std::vector<idxtype> xadj_;
-  std::vector<idxtype> adjncy_;
-  std::vector<idxtype> adjwgt_;
-};
+std::vector<int> ComputeNormalizedMinGraphCut(const std::vector<int>& xadj,
+                                              const std::vector<int>& adjncy,
+                                              const std::vector<int>& adjwgt,
+                                              const int num_parts,
+                                              const int num_threads) {
+  CHECK(!xadj.empty());
+  CHECK_EQ(xadj.back(), adjncy.size());
+  CHECK_EQ(adjncy.size(), adjwgt.size());
+  CHECK_GT(num_parts, 0);
+
+  if (num_threads > 1) {
+    return ComputeParallelNormalizedCut(xadj, adjncy, adjwgt, num_parts,
+                                        num_threads);
+  }
 
-std::unordered_map<int, int> ComputeNormalizedMinGraphCut(
-    const std::vector<std::pair<int, int>>& edges,
-    const std::vector<int>& weights, const int num_parts) {
-  GraclusGraph graph(edges, weights);
+  int num_vertices = static_cast<int>(xadj.size()) - 1;
+  std::vector<idxtype> cut_labels(num_vertices);
+  if (num_vertices == 0) {
+    return cut_labels;
+  }
 
   const int levels =
-      amax((graph.data.nvtxs) / (40 * log2_metis(num_parts)), 20 * (num_parts));
-
-  std::vector<idxtype> cut_labels(graph.data.nvtxs);
+      amax(num_vertices / (40 * log2_metis(num_parts)), 20 * num_parts);
 
   int options[11];
   options[0] = 0;
@@ -128,17 +85,74 @@ std::unordered_map<int, int> ComputeNormalizedMinGraphCut(
   int edgecut;
   int var_num_parts = num_parts;
 
-  MLKKM_PartGraphKway(&graph.data.nvtxs, graph.data.xadj, graph.data.adjncy,
-                      graph.data.vwgt, graph.data.adjwgt, &wgtflag, &numflag,
+  // Graclus takes the graph by non-const pointers, but only reads it with C
+  // numbering.
+  std::unique_lock<std::mutex> lock(GraclusMutex());
+  MLKKM_PartGraphKway(&num_vertices, const_cast<idxtype*>(xadj.data()),
+                      const_cast<idxtype*>(adjncy.data()), nullptr,
+                      const_cast<idxtype*>(adjwgt.data()), &wgtflag, &numflag,
                       &var_num_parts, &chain_length, options, &edgecut,
                       cut_labels.data(), levels);
+  lock.unlock();
+
+  VLOG(2) << "Normalized cut: "
+          << ComputeNormalizedCutValue(xadj, adjncy, adjwgt, cut_labels,
+                                       num_parts);
+  return cut_labels;
+}
+
+std::unordered_map<int, int> ComputeNormalizedMinGraphCut(
+    const std::vector<std::pair<int, int>>& edges,
+    const std::vector<int>& weights, const int num_parts,
+    const int num_threads) {
+  CHECK_EQ(edges.size(), weights.size());
+
+  // The vertices of the edges, in ascending order of id.
+  std::vector<int> vertex_ids;
+  vertex_ids.reserve(2 * edges.size());
+  for (const auto& edge : edges) {
+    vertex_ids.push_back(edge.first);
+    vertex_ids.push_back(edge.second);
+  }
+  std::sort(vertex_ids.begin(), vertex_ids.end());
+  vertex_ids.erase(std::unique(vertex_ids.begin(), vertex_ids.end()),
+                   vertex_ids.end());
+  const auto GetVertexIdx = [&vertex_ids](const int id) {
+    return static_cast<int>(
+        std::lower_bound(vertex_ids.begin(), vertex_ids.end(), id) -
+        vertex_ids.begin());
+  };
+
+  std::vector<std::pair<int, int>> edge_indices(edges.size());
+  std::vector<int> xadj(vertex_ids.size() + 1, 0);
+  for (size_t i = 0; i < edges.size(); ++i) {
+    edge_indices[i].first = GetVertexIdx(edges[i].first);
+    edge_indices[i].second = GetVertexIdx(edges[i].second);
+    ++xadj[edge_indices[i].first + 1];
+    ++xadj[edge_indices[i].second + 1];
+  }
+  for (size_t i = 0; i < vertex_ids.size(); ++i) {
+    xadj[i + 1] += xadj[i];
+  }
+
+  std::vector<int> adjncy(xadj.back());
+  std::vector<int> adjwgt(xadj.back());
+  std::vector<int> next(xadj.begin(), xadj.end() - 1);
+  for (size_t i = 0; i < edges.size(); ++i) {
+    const int vertex_idx1 = edge_indices[i].first;
+    const int vertex_idx2 = edge_indices[i].second;
+    adjncy[next[vertex_idx1]] = vertex_idx2;
+    adjwgt[next[vertex_idx1]++] = weights[i];
+    adjncy[next[vertex_idx2]] = vertex_idx1;
+    adjwgt[next[vertex_idx2]++] = weights[i];
+  }
 
-  float lbvec[MAXNCON];
-  ComputePartitionBalance(&graph.data, num_parts, cut_labels.data(), lbvec);
-  ComputeNCut(&graph.data, &cut_labels[0], num_parts);
+  const std::vector<int> cut_labels = ComputeNormalizedMinGraphCut(
+      xadj, adjncy, adjwgt, num_parts, num_threads);
   std::unordered_map<int, int> labels;
+  labels.reserve(cut_labels.size());
   for (size_t idx = 0; idx < cut_labels.size(); ++idx) {
-    labels.emplace(graph.GetVertexId(idx), cut_labels[idx]);
+    labels.emplace(vertex_ids[idx], cut_labels[idx]);
   }
 
   return labels;
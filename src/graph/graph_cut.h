@@ -3,17 +3,51 @@
 
 #include <glog/logging.h>
 
+#include <mutex>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace gopt {
 namespace graph {
 
+// Computes the normalized min-cut of an undirected graph with the vertices 0,
+// ..., xadj.size() - 2 using Graclus. The graph is given in the CSR format of
+// Graclus, where each edge appears in the lists of both of its vertices, and
+// is handed to Graclus without copies. Returns the cluster label per vertex.
+// With more than one thread, ComputeParallelNormalizedCut() is run instead.
+// It is a different algorithm than the serial Graclus, so the partitions with
+// one thread differ from those with more threads, which do not depend on
+// their number.
+std::vector<int> ComputeNormalizedMinGraphCut(const std::vector<int>& xadj,
+                                              const std::vector<int>& adjncy,
+                                              const std::vector<int>& adjwgt,
+                                              const int num_parts,
+                                              const int num_threads = 1);
+
 // Compute the normalized min-cut of an undirected graph using Graclus.
 // Partitions the graph into clusters and returns the cluster labels per vertex.
+// With more than one thread, the multilevel kernel k-means of Graclus is run by
+// ComputeParallelNormalizedCut() instead, whose partitions have a comparable
+// normalized cut but differ from those of one thread. The edge list is
+// converted to CSR by sorting the vertex ids.
 std::unordered_map<int, int> ComputeNormalizedMinGraphCut(
     const std::vector<std::pair<int, int>>& edges,
-    const std::vector<int>& weights, const int num_parts);
+    const std::vector<int>& weights, const int num_parts,
+    const int num_threads = 1);
+
+// Graclus keeps its random state in the process-global rand(), which it
+// reseeds with a fixed seed at every partitioning and coarsening. All calls
+// into Graclus hold this mutex, so that concurrent calls neither interleave
+// their random streams nor make the results depend on the thread schedule.
+// Other users of rand() in the process are still reseeded by these calls.
+std::mutex& GraclusMutex();
+
+// Quantizes non-negative edge weights to the integer weights of Graclus. All
+// weights are scaled by the same factor, so that their ratios are preserved up
+// to rounding, and positive weights stay positive. The factor bounds the total
+// weight, as Graclus sums the weights into ints.
+std::vector<int> QuantizeEdgeWeights(const std::vector<double>& weights);
 
 }  // namespace graph
 }  // namespace gopt
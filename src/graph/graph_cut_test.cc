@@ -57,5 +57,31 @@ TEST(GRAPH_CUT_TEST, TestComputeNormalizedMinGraphCutDisconnected) {
   }
 }
 
+TEST(GRAPH_CUT_TEST, TestComputeNormalizedMinGraphCutCSR) {
+  // Two triangles connected by the edge (2, 3).
+  const std::vector<int> xadj = {0, 2, 4, 7, 10, 12, 14};
+  const std::vector<int> adjncy = {1, 2, 0, 2, 0, 1, 3, 2, 4, 5, 3, 5, 3, 4};
+  const std::vector<int> adjwgt = {5, 5, 5, 5, 5, 5, 1, 1, 5, 5, 5, 5, 5, 5};
+  const std::vector<int> cut_labels =
+      ComputeNormalizedMinGraphCut(xadj, adjncy, adjwgt, 2);
+  ASSERT_EQ(cut_labels.size(), 6);
+  EXPECT_EQ(cut_labels[1], cut_labels[0]);
+  EXPECT_EQ(cut_labels[2], cut_labels[0]);
+  EXPECT_EQ(cut_labels[4], cut_labels[3]);
+  EXPECT_EQ(cut_labels[5], cut_labels[3]);
+  EXPECT_NE(cut_labels[0], cut_labels[3]);
+}
+
+TEST(GRAPH_CUT_TEST, TestQuantizeEdgeWeights) {
+  const std::vector<int> weights =
+      QuantizeEdgeWeights({0.25, 0.5, 0.0, 1e-9, 0.125});
+  ASSERT_EQ(weights.size(), 5);
+  EXPECT_EQ(weights[0], 2 * weights[4]);
+  EXPECT_EQ(weights[1], 4 * weights[4]);
+  EXPECT_EQ(weights[2], 0);
+  EXPECT_EQ(weights[3], 1);
+  EXPECT_GT(weights[4], 1000);
+}
+
 }  // namespace graph
 }  // namespace gopt
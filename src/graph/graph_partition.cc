@@ -0,0 +1,339 @@
+#include "graph/graph_partition.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <glog/logging.h>
+
+#include "graph/graph_cut.h"
+#include "graph/union_find.h"
+#include "util/profiler.h"
+
+namespace gopt {
+namespace graph {
+namespace {
+
+// An undirected graph in the CSR format of Graclus.
+struct CSRGraph {
+  std::vector<int> xadj;
+  std::vector<int> adjncy;
+  std::vector<int> adjwgt;
+};
+
+// Self loops are dropped.
+void BuildCSRGraph(const int num_vertices,
+                   const std::vector<std::pair<int, int>>& edges,
+                   const std::vector<int>& weights, CSRGraph* graph) {
+  graph->xadj.assign(num_vertices + 1, 0);
+  for (const auto& edge : edges) {
+    CHECK_GE(edge.first, 0);
+    CHECK_LT(edge.first, num_vertices);
+    CHECK_GE(edge.second, 0);
+    CHECK_LT(edge.second, num_vertices);
+    if (edge.first != edge.second) {
+      ++graph->xadj[edge.first + 1];
+      ++graph->xadj[edge.second + 1];
+    }
+  }
+  for (int i = 0; i < num_vertices; i++) {
+    graph->xadj[i + 1] += graph->xadj[i];
+  }
+
+  graph->adjncy.resize(graph->xadj[num_vertices]);
+  graph->adjwgt.resize(graph->xadj[num_vertices]);
+  std::vector<int> next(graph->xadj.begin(), graph->xadj.end() - 1);
+  for (size_t i = 0; i < edges.size(); i++) {
+    const int vertex1 = edges[i].first;
+    const int vertex2 = edges[i].second;
+    if (vertex1 == vertex2) {
+      continue;
+    }
+    graph->adjncy[next[vertex1]] = vertex2;
+    graph->adjwgt[next[vertex1]++] = weights[i];
+    graph->adjncy[next[vertex2]] = vertex1;
+    graph->adjwgt[next[vertex2]++] = weights[i];
+  }
+}
+
+// Splits a cluster into the connected components of its induced subgraph, in
+// breadth first order. local_indices has to be -1 for all vertices and is
+// restored.
+void SplitIntoComponents(const CSRGraph& graph, const std::vector<int>& cluster,
+                         std::vector<int>* local_indices,
+                         std::vector<std::vector<int>>* components) {
+  for (const int vertex : cluster) {
+    (*local_indices)[vertex] = 0;
+  }
+
+  components->clear();
+  for (const int root : cluster) {
+    if ((*local_indices)[root] != 0) {
+      continue;
+    }
+    components->emplace_back(1, root);
+    std::vector<int>& component = components->back();
+    (*local_indices)[root] = 1;
+    for (size_t i = 0; i < component.size(); i++) {
+      const int vertex = component[i];
+      for (int e = graph.xadj[vertex]; e < graph.xadj[vertex + 1]; e++) {
+        const int neighbor = graph.adjncy[e];
+        if ((*local_indices)[neighbor] == 0) {
+          (*local_indices)[neighbor] = 1;
+          component.push_back(neighbor);
+        }
+      }
+    }
+  }
+
+  for (const int vertex : cluster) {
+    (*local_indices)[vertex] = -1;
+  }
+}
+
+// Cuts the induced subgraph of a connected cluster into num_parts parts by
+// the normalized cut. Falls back to consecutive runs of the breadth first
+// order if the cut does not split the cluster.
+void CutCluster(const CSRGraph& graph, const std::vector<int>& cluster,
+                const int num_parts, const int max_cluster_size,
+                const int num_threads, std::vector<int>* local_indices,
+                std::vector<std::vector<int>>* parts) {
+  const int num_cluster_vertices = cluster.size();
+  for (int i = 0; i < num_cluster_vertices; i++) {
+    (*local_indices)[cluster[i]] = i;
+  }
+
+  CSRGraph subgraph;
+  subgraph.xadj.reserve(num_cluster_vertices + 1);
+  subgraph.xadj.push_back(0);
+  for (const int vertex : cluster) {
+    for (int e = graph.xadj[vertex]; e < graph.xadj[vertex + 1]; e++) {
+      const int neighbor_index = (*local_indices)[graph.adjncy[e]];
+      if (neighbor_index != -1) {
+        subgraph.adjncy.push_back(neighbor_index);
+        subgraph.adjwgt.push_back(graph.adjwgt[e]);
+      }
+    }
+    subgraph.xadj.push_back(subgraph.adjncy.size());
+  }
+
+  for (const int vertex : cluster) {
+    (*local_indices)[vertex] = -1;
+  }
+
+  const std::vector<int> labels =
+      ComputeNormalizedMinGraphCut(subgraph.xadj, subgraph.adjncy,
+                                   subgraph.adjwgt, num_parts, num_threads);
+  parts->assign(num_parts, std::vector<int>());
+  for (int i = 0; i < num_cluster_vertices; i++) {
+    (*parts)[labels[i]].push_back(cluster[i]);
+  }
+  parts->erase(std::remove_if(parts->begin(), parts->end(),
+                              [](const std::vector<int>& part) {
+                                return part.empty();
+                              }),
+               parts->end());
+
+  if (parts->size() < 2) {
+    LOG(WARNING) << "The normalized cut did not split a cluster of "
+                 << num_cluster_vertices << " vertices.";
+    parts->clear();
+    for (int begin = 0; begin < num_cluster_vertices;
+         begin += max_cluster_size) {
+      const int end = std::min(begin + max_cluster_size, num_cluster_vertices);
+      parts->emplace_back(cluster.begin() + begin, cluster.begin() + end);
+    }
+  }
+}
+
+// Returns the outside vertices by which a cluster is expanded.
+std::vector<int> FindOverlappingVertices(
+    const CSRGraph& graph, const std::vector<int>& cluster,
+    const OverlappingPartitionOptions& options, std::vector<int>* distances,
+    std::vector<int64_t>* connections) {
+  const size_t max_num_overlapping_vertices = static_cast<size_t>(
+      std::ceil(options.max_overlap_ratio * cluster.size()));
+
+  std::vector<int> overlapping_vertices;
+  std::vector<int> visited(cluster);
+  for (const int vertex : cluster) {
+    (*distances)[vertex] = 0;
+  }
+
+  // The vertices at distance hop, ordered by the weight of their edges to the
+  // vertices at distance hop - 1.
+  std::vector<int> frontier(cluster);
+  std::vector<int> next_frontier;
+  for (int hop = 1; hop <= options.num_hops &&
+                    overlapping_vertices.size() < max_num_overlapping_vertices;
+       hop++) {
+    next_frontier.clear();
+    for (const int vertex : frontier) {
+      for (int e = graph.xadj[vertex]; e < graph.xadj[vertex + 1]; e++) {
+        const int neighbor = graph.adjncy[e];
+        if ((*distances)[neighbor] == -1) {
+          (*distances)[neighbor] = hop;
+          visited.push_back(neighbor);
+          next_frontier.push_back(neighbor);
+        }
+        if ((*distances)[neighbor] == hop) {
+          (*connections)[neighbor] += graph.adjwgt[e];
+        }
+      }
+    }
+
+    std::sort(next_frontier.begin(), next_frontier.end(),
+              [connections](const int vertex1, const int vertex2) {
+                const int64_t connection1 = (*connections)[vertex1];
+                const int64_t connection2 = (*connections)[vertex2];
+                return connection1 > connection2 ||
+                       (connection1 == connection2 && vertex1 < vertex2);
+              });
+    const size_t num_added =
+        std::min(next_frontier.size(),
+                 max_num_overlapping_vertices - overlapping_vertices.size());
+    overlapping_vertices.insert(overlapping_vertices.end(),
+                                next_frontier.begin(),
+                                next_frontier.begin() + num_added);
+    frontier.swap(next_frontier);
+  }
+
+  for (const int vertex : visited) {
+    (*distances)[vertex] = -1;
+    (*connections)[vertex] = 0;
+  }
+  return overlapping_vertices;
+}
+
+}  // namespace
+
+void ComputeOverlappingPartition(const int num_vertices,
+                                 const std::vector<std::pair<int, int>>& edges,
+                                 const std::vector<int>& weights,
+                                 const OverlappingPartitionOptions& options,
+                                 OverlappingPartition* partition) {
+  GOPT_PROFILE_SCOPE("OverlappingPartition");
+  CHECK_NOTNULL(partition);
+  CHECK_EQ(edges.size(), weights.size());
+  CHECK_GT(options.num_threads, 0);
+  CHECK_GT(options.max_cluster_size, 1);
+  CHECK_GE(options.num_hops, 0);
+  CHECK_GE(options.max_overlap_ratio, 0.0);
+
+  CSRGraph graph;
+  BuildCSRGraph(num_vertices, edges, weights, &graph);
+
+  // Split the oversize clusters until all of them are small enough.
+  std::vector<int> local_indices(num_vertices, -1);
+  std::vector<std::vector<int>> clusters;
+  std::vector<std::vector<int>> pending_clusters(1);
+  pending_clusters[0].resize(num_vertices);
+  for (int i = 0; i < num_vertices; i++) {
+    pending_clusters[0][i] = i;
+  }
+  std::vector<std::vector<int>> components;
+  std::vector<std::vector<int>> parts;
+  while (!pending_clusters.empty()) {
+    const std::vector<int> cluster = std::move(pending_clusters.back());
+    pending_clusters.pop_back();
+    SplitIntoComponents(graph, cluster, &local_indices, &components);
+    for (std::vector<int>& component : components) {
+      const int component_size = component.size();
+      if (component_size <= options.max_cluster_size) {
+        clusters.push_back(std::move(component));
+        continue;
+      }
+
+      const int num_parts = (component_size + options.max_cluster_size - 1) /
+                            options.max_cluster_size;
+      CutCluster(graph, component, num_parts, options.max_cluster_size,
+                 options.num_threads, &local_indices, &parts);
+      for (std::vector<int>& part : parts) {
+        pending_clusters.push_back(std::move(part));
+      }
+    }
+  }
+
+  // The clusters are ordered by their smallest vertex, so that the partition
+  // does not depend on the order of the splits.
+  for (std::vector<int>& cluster : clusters) {
+    std::sort(cluster.begin(), cluster.end());
+  }
+  std::sort(clusters.begin(), clusters.end(),
+            [](const std::vector<int>& cluster1,
+               const std::vector<int>& cluster2) {
+              return cluster1[0] < cluster2[0];
+            });
+
+  const int num_clusters = clusters.size();
+  partition->labels.assign(num_vertices, -1);
+  for (int k = 0; k < num_clusters; k++) {
+    for (const int vertex : clusters[k]) {
+      partition->labels[vertex] = k;
+    }
+  }
+
+#pragma omp parallel num_threads(options.num_threads)
+  {
+    std::vector<int> distances(num_vertices, -1);
+    std::vector<int64_t> connections(num_vertices, 0);
+
+#pragma omp for schedule(dynamic)
+    for (int k = 0; k < num_clusters; k++) {
+      const std::vector<int> overlapping_vertices = FindOverlappingVertices(
+          graph, clusters[k], options, &distances, &connections);
+      std::vector<int>& cluster = clusters[k];
+      cluster.insert(cluster.end(), overlapping_vertices.begin(),
+                     overlapping_vertices.end());
+      std::sort(cluster.begin(), cluster.end());
+    }
+  }
+  partition->clusters.swap(clusters);
+
+  // The overlap structure of the expanded clusters.
+  partition->vertex_clusters.assign(num_vertices, std::vector<int>());
+  for (int k = 0; k < num_clusters; k++) {
+    for (const int vertex : partition->clusters[k]) {
+      partition->vertex_clusters[vertex].push_back(k);
+    }
+  }
+
+  std::vector<std::pair<int, int>> shared_cluster_pairs;
+  for (const std::vector<int>& memberships : partition->vertex_clusters) {
+    for (size_t i = 0; i < memberships.size(); i++) {
+      for (size_t j = i + 1; j < memberships.size(); j++) {
+        shared_cluster_pairs.emplace_back(memberships[i], memberships[j]);
+      }
+    }
+  }
+  std::sort(shared_cluster_pairs.begin(), shared_cluster_pairs.end());
+
+  partition->overlaps.clear();
+  UnionFind union_find(num_clusters);
+  for (size_t i = 0; i < shared_cluster_pairs.size(); i++) {
+    if (i == 0 || shared_cluster_pairs[i] != shared_cluster_pairs[i - 1]) {
+      ClusterOverlap overlap;
+      overlap.cluster1 = shared_cluster_pairs[i].first;
+      overlap.cluster2 = shared_cluster_pairs[i].second;
+      partition->overlaps.push_back(overlap);
+      union_find.Union(overlap.cluster1, overlap.cluster2);
+    }
+    ++partition->overlaps.back().num_shared_vertices;
+  }
+
+  std::vector<size_t> roots(num_clusters);
+  for (int k = 0; k < num_clusters; k++) {
+    roots[k] = union_find.FindRoot(k);
+  }
+  std::sort(roots.begin(), roots.end());
+  partition->num_overlap_components =
+      std::unique(roots.begin(), roots.end()) - roots.begin();
+
+  VLOG(1) << "Partitioned " << num_vertices << " vertices into "
+          << num_clusters << " clusters with " << partition->overlaps.size()
+          << " overlaps in " << partition->num_overlap_components
+          << " components.";
+}
+
+}  // namespace graph
+}  // namespace gopt
@@ -0,0 +1,66 @@
+#ifndef GRAPH_GRAPH_PARTITION_H_
+#define GRAPH_GRAPH_PARTITION_H_
+
+#include <utility>
+#include <vector>
+
+namespace gopt {
+namespace graph {
+
+struct OverlappingPartitionOptions {
+  int num_threads = 1;
+
+  // Maximum number of vertices of a cluster before it is expanded. Clusters of
+  // the normalized cut which are larger are split recursively.
+  int max_cluster_size = 2000;
+
+  // Each cluster is expanded by the outside vertices within num_hops edges of
+  // it, at most max_overlap_ratio times its size. The closer vertices come
+  // first, and vertices at the same distance are ordered by the weight of
+  // their edges to the cluster.
+  int num_hops = 1;
+  double max_overlap_ratio = 0.2;
+};
+
+// The overlap of two expanded clusters.
+struct ClusterOverlap {
+  int cluster1 = -1;
+  int cluster2 = -1;
+  int num_shared_vertices = 0;
+};
+
+struct OverlappingPartition {
+  // The disjoint cluster of each vertex, before the expansion.
+  std::vector<int> labels;
+
+  // The vertices of each expanded cluster, in ascending order.
+  std::vector<std::vector<int>> clusters;
+
+  // The clusters which contain each vertex, in ascending order.
+  std::vector<std::vector<int>> vertex_clusters;
+
+  // The pairs of clusters which share vertices, with cluster1 < cluster2, in
+  // ascending order.
+  std::vector<ClusterOverlap> overlaps;
+
+  // Number of connected components of the clusters linked by their overlaps.
+  // Clusters can only be registered to each other if this is 1.
+  int num_overlap_components = 0;
+};
+
+// Partitions an undirected graph with the vertices 0, ..., num_vertices - 1
+// into clusters of at most max_cluster_size vertices by the normalized cut,
+// and expands the clusters by their boundary vertices, so that neighboring
+// clusters share vertices and can be registered to each other. The parts of
+// the normalized cut are split into their connected components, and parts
+// which are still too large are cut again.
+void ComputeOverlappingPartition(const int num_vertices,
+                                 const std::vector<std::pair<int, int>>& edges,
+                                 const std::vector<int>& weights,
+                                 const OverlappingPartitionOptions& options,
+                                 OverlappingPartition* partition);
+
+}  // namespace graph
+}  // namespace gopt
+
+#endif  // GRAPH_GRAPH_PARTITION_H_
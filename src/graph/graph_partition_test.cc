@@ -0,0 +1,168 @@
+#include "graph/graph_partition.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "gtest/gtest.h"
+
+namespace gopt {
+namespace graph {
+namespace {
+
+// The edges of a width x height grid graph, whose vertices start at offset.
+void CreateGridGraph(const int width, const int height, const int offset,
+                     std::vector<std::pair<int, int>>* edges,
+                     std::vector<int>* weights) {
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      const int vertex = offset + y * width + x;
+      if (x + 1 < width) {
+        edges->emplace_back(vertex, vertex + 1);
+        weights->push_back(1 + (x + y) % 3);
+      }
+      if (y + 1 < height) {
+        edges->emplace_back(vertex, vertex + width);
+        weights->push_back(1 + (x * y) % 3);
+      }
+    }
+  }
+}
+
+// Returns the hop distances from the vertices of a cluster.
+std::vector<int> ComputeDistances(
+    const int num_vertices, const std::vector<std::pair<int, int>>& edges,
+    const std::vector<int>& cluster) {
+  std::vector<int> distances(num_vertices, num_vertices);
+  for (const int vertex : cluster) {
+    distances[vertex] = 0;
+  }
+  for (int i = 0; i < num_vertices; i++) {
+    for (const auto& edge : edges) {
+      distances[edge.first] =
+          std::min(distances[edge.first], distances[edge.second] + 1);
+      distances[edge.second] =
+          std::min(distances[edge.second], distances[edge.first] + 1);
+    }
+  }
+  return distances;
+}
+
+void CheckPartition(const int num_vertices,
+                    const std::vector<std::pair<int, int>>& edges,
+                    const OverlappingPartitionOptions& options,
+                    const OverlappingPartition& partition) {
+  ASSERT_EQ(partition.labels.size(), num_vertices);
+  ASSERT_EQ(partition.vertex_clusters.size(), num_vertices);
+  const int num_clusters = partition.clusters.size();
+
+  std::vector<int> cluster_sizes(num_clusters, 0);
+  for (const int label : partition.labels) {
+    ASSERT_GE(label, 0);
+    ASSERT_LT(label, num_clusters);
+    ++cluster_sizes[label];
+  }
+
+  for (int k = 0; k < num_clusters; k++) {
+    const std::vector<int>& cluster = partition.clusters[k];
+    EXPECT_LE(cluster_sizes[k], options.max_cluster_size);
+    EXPECT_LE(cluster.size(),
+              cluster_sizes[k] +
+                  std::ceil(options.max_overlap_ratio * cluster_sizes[k]));
+    EXPECT_TRUE(std::is_sorted(cluster.begin(), cluster.end()));
+
+    // The cluster contains its disjoint part and vertices close to it.
+    std::vector<int> core;
+    for (int i = 0; i < num_vertices; i++) {
+      if (partition.labels[i] == k) {
+        core.push_back(i);
+      }
+    }
+    EXPECT_TRUE(std::includes(cluster.begin(), cluster.end(), core.begin(),
+                              core.end()));
+    const std::vector<int> distances =
+        ComputeDistances(num_vertices, edges, core);
+    for (const int vertex : cluster) {
+      EXPECT_LE(distances[vertex], options.num_hops);
+      EXPECT_NE(std::find(partition.vertex_clusters[vertex].begin(),
+                          partition.vertex_clusters[vertex].end(), k),
+                partition.vertex_clusters[vertex].end());
+    }
+  }
+
+  int num_shared_vertices = 0;
+  for (const std::vector<int>& memberships : partition.vertex_clusters) {
+    num_shared_vertices +=
+        memberships.size() * (memberships.size() - 1) / 2;
+  }
+  for (const ClusterOverlap& overlap : partition.overlaps) {
+    EXPECT_LT(overlap.cluster1, overlap.cluster2);
+    EXPECT_GT(overlap.num_shared_vertices, 0);
+    num_shared_vertices -= overlap.num_shared_vertices;
+  }
+  EXPECT_EQ(num_shared_vertices, 0);
+}
+
+}  // namespace
+
+TEST(GRAPH_PARTITION_TEST, TestOverlappingPartition) {
+  static const int kWidth = 40;
+  static const int kHeight = 30;
+  std::vector<std::pair<int, int>> edges;
+  std::vector<int> weights;
+  CreateGridGraph(kWidth, kHeight, 0, &edges, &weights);
+
+  OverlappingPartitionOptions options;
+  options.max_cluster_size = 150;
+  options.num_hops = 1;
+  options.max_overlap_ratio = 0.2;
+  OverlappingPartition partition;
+  ComputeOverlappingPartition(kWidth * kHeight, edges, weights, options,
+                              &partition);
+  CheckPartition(kWidth * kHeight, edges, options, partition);
+  EXPECT_GE(partition.clusters.size(), 8);
+  EXPECT_EQ(partition.num_overlap_components, 1);
+
+  // More hops, the parallel normalized cut, and an overlap that is not
+  // limited by the ratio.
+  options.num_threads = 4;
+  options.num_hops = 2;
+  options.max_overlap_ratio = 10.0;
+  ComputeOverlappingPartition(kWidth * kHeight, edges, weights, options,
+                              &partition);
+  CheckPartition(kWidth * kHeight, edges, options, partition);
+  for (size_t k = 0; k < partition.clusters.size(); k++) {
+    std::vector<int> core;
+    for (int i = 0; i < kWidth * kHeight; i++) {
+      if (partition.labels[i] == static_cast<int>(k)) {
+        core.push_back(i);
+      }
+    }
+    const std::vector<int> distances =
+        ComputeDistances(kWidth * kHeight, edges, core);
+    const int num_close_vertices =
+        std::count_if(distances.begin(), distances.end(),
+                      [](const int distance) { return distance <= 2; });
+    EXPECT_EQ(partition.clusters[k].size(), num_close_vertices);
+  }
+}
+
+TEST(GRAPH_PARTITION_TEST, TestDisconnectedGraph) {
+  std::vector<std::pair<int, int>> edges;
+  std::vector<int> weights;
+  CreateGridGraph(10, 10, 0, &edges, &weights);
+  CreateGridGraph(10, 5, 100, &edges, &weights);
+
+  OverlappingPartitionOptions options;
+  options.max_cluster_size = 60;
+  OverlappingPartition partition;
+  ComputeOverlappingPartition(150, edges, weights, options, &partition);
+  CheckPartition(150, edges, options, partition);
+
+  // The second grid is small enough to be a cluster of its own.
+  EXPECT_EQ(partition.num_overlap_components, 2);
+  EXPECT_EQ(partition.clusters.back().size(), 50);
+  EXPECT_EQ(partition.clusters.back().front(), 100);
+}
+
+}  // namespace graph
+}  // namespace gopt
@@ -404,5 +404,126 @@ TEST(UNDIRECTED_GRAPH_TEST, TEST_EXTRACTCONNECTEDCOMPONENTS) {
   EXPECT_EQ(cc_num, 2);
 }
 
+TEST(UNDIRECTED_GRAPH_TEST, TEST_NORMALIZEDCUT) {
+  // Two cliques of weights below 1.0, which are connected by a weaker edge.
+  Graph<Node, Edge> graph;
+  for (node_t offset : {0, 10}) {
+    for (node_t i = 0; i < 6; i++) {
+      for (node_t j = i + 1; j < 6; j++) {
+        const weight_d weight = 0.5 + 0.05 * ((i + j) % 3);
+        graph.AddUEdge(Edge(offset + i, offset + j, weight),
+                       Edge(offset + j, offset + i, weight));
+      }
+    }
+  }
+  graph.AddUEdge(Edge(0, 10, 0.01), Edge(10, 0, 0.01));
+
+  const unordered_map<int, int> labels = graph.NormalizedCut(2);
+  ASSERT_EQ(labels.size(), 12);
+  for (int i = 1; i < 6; i++) {
+    EXPECT_EQ(labels.at(i), labels.at(0));
+    EXPECT_EQ(labels.at(10 + i), labels.at(10));
+  }
+  EXPECT_NE(labels.at(0), labels.at(10));
+}
+
+TEST(UNDIRECTED_GRAPH_TEST, TEST_HIERARCHICALCUT) {
+  // Four cliques in a ring, which are connected by weaker edges.
+  Graph<Node, Edge> graph;
+  HierarchicalClusteringOptions options;
+  options.max_leaf_size = 3;
+  graph.SetHierarchicalClusteringOptions(options);
+  for (node_t offset : {0, 10, 20, 30}) {
+    for (node_t i = 0; i < 6; i++) {
+      for (node_t j = i + 1; j < 6; j++) {
+        graph.AddUEdge(Edge(offset + i, offset + j, 1.0),
+                       Edge(offset + j, offset + i, 1.0));
+      }
+    }
+    const node_t next = (offset + 10) % 40;
+    graph.AddUEdge(Edge(offset, next, 0.05), Edge(next, offset, 0.05));
+  }
+
+  for (const size_t cluster_num : {2, 4}) {
+    const unordered_map<int, int> labels = graph.HierarchicalCut(cluster_num);
+    ASSERT_EQ(labels.size(), 24);
+    for (node_t offset : {0, 10, 20, 30}) {
+      for (int i = 1; i < 6; i++) {
+        EXPECT_EQ(labels.at(offset + i), labels.at(offset));
+      }
+    }
+    EXPECT_NE(labels.at(0), labels.at(20));
+    if (cluster_num == 4) {
+      EXPECT_NE(labels.at(0), labels.at(10));
+      EXPECT_NE(labels.at(10), labels.at(30));
+    }
+  }
+  const ClusterTree* cluster_tree = &graph.GetClusterTree();
+
+  // Copies share the tree and keep the options.
+  {
+    const Graph<Node, Edge> copied_graph(graph);
+    EXPECT_EQ(&copied_graph.GetClusterTree(), cluster_tree);
+    Graph<Node, Edge> assigned_graph;
+    assigned_graph = graph;
+    EXPECT_EQ(&assigned_graph.GetClusterTree(), cluster_tree);
+  }
+
+  // Changing an edge within a clique only repairs the tree.
+  graph.AlterEdge(Edge(1, 2, 0.5));
+  EXPECT_EQ(&graph.GetClusterTree(), cluster_tree);
+  EXPECT_EQ(graph.HierarchicalCut(4).size(), 24);
+
+  // A new node rebuilds it.
+  graph.AddUEdge(Edge(5, 40, 1.0), Edge(40, 5, 1.0));
+  const unordered_map<int, int> labels = graph.HierarchicalCut(4);
+  ASSERT_EQ(labels.size(), 25);
+  EXPECT_EQ(labels.at(40), labels.at(5));
+}
+
+TEST(UNDIRECTED_GRAPH_TEST, TEST_SPARSIFY) {
+  // A complete graph whose edges are stored in both directions.
+  Graph<Node, Edge> graph;
+  for (node_t i = 0; i < 12; i++) {
+    for (node_t j = i + 1; j < 12; j++) {
+      const weight_d weight = 1.0 + (i * j) % 5;
+      graph.AddUEdge(Edge(i, j, weight), Edge(j, i, weight));
+    }
+  }
+
+  EdgeSparsificationOptions options;
+  options.num_neighbors = 1;
+  EdgeSparsificationSummary summary;
+  const Graph<Node, Edge> sparse_graph = graph.Sparsify(options, &summary);
+  EXPECT_EQ(summary.num_edges, 66);
+  EXPECT_EQ(sparse_graph.GetNodesNum(), 12);
+  EXPECT_EQ(sparse_graph.GetEdgesNum(), 2 * summary.num_kept_edges);
+  EXPECT_LT(summary.num_kept_edges, 66);
+  EXPECT_EQ(sparse_graph.ExtractConnectedComponents().size(), 1);
+  for (const auto& edge_iter : sparse_graph.GetEdges()) {
+    for (const auto& em_iter : edge_iter.second) {
+      EXPECT_TRUE(sparse_graph.HasEdge(em_iter.first, edge_iter.first));
+    }
+  }
+
+  // The sampled edges of the effective resistance sparsifier are reweighted
+  // in both directions.
+  options.type = EdgeSparsificationType::EFFECTIVE_RESISTANCE;
+  const Graph<Node, Edge> sampled_graph = graph.Sparsify(options, &summary);
+  EXPECT_LT(summary.num_kept_edges, 66);
+  int num_reweighted_edges = 0;
+  for (const auto& edge_iter : sampled_graph.GetEdges()) {
+    for (const auto& em_iter : edge_iter.second) {
+      const weight_d weight =
+          graph.GetEdge(edge_iter.first, em_iter.first).weight;
+      EXPECT_GE(em_iter.second.weight, weight);
+      EXPECT_EQ(em_iter.second.weight,
+                sampled_graph.GetEdge(em_iter.first, edge_iter.first).weight);
+      num_reweighted_edges += em_iter.second.weight > weight;
+    }
+  }
+  EXPECT_GT(num_reweighted_edges, 0);
+}
+
 }  // namespace graph
 }  // namespace gopt
@@ -0,0 +1,253 @@
+#include "graph/hierarchical_clustering.h"
+
+#include <algorithm>
+#include <queue>
+
+#include <glog/logging.h>
+
+#include "graph/graph_cut.h"
+#include "util/profiler.h"
+
+namespace gopt {
+namespace graph {
+
+void ClusterTree::Build(const std::vector<int>& xadj,
+                        const std::vector<int>& adjncy,
+                        const std::vector<int>& adjwgt,
+                        const HierarchicalClusteringOptions& options) {
+  GOPT_PROFILE_SCOPE("BuildClusterTree");
+  CHECK(!xadj.empty());
+  CHECK_EQ(xadj.back(), adjncy.size());
+  CHECK_EQ(adjncy.size(), adjwgt.size());
+  CHECK_GT(options.num_threads, 0);
+  CHECK_GT(options.max_leaf_size, 0);
+
+  options_ = options;
+  const int num_vertices = static_cast<int>(xadj.size()) - 1;
+  vertices_.resize(num_vertices);
+  for (int i = 0; i < num_vertices; i++) {
+    vertices_[i] = i;
+  }
+  local_indices_.assign(num_vertices, -1);
+
+  nodes_.assign(1, Node());
+  nodes_[0].end = num_vertices;
+  BuildSubtree(xadj, adjncy, adjwgt, 0);
+  Finalize();
+}
+
+void ClusterTree::Repair(
+    const std::vector<int>& xadj, const std::vector<int>& adjncy,
+    const std::vector<int>& adjwgt,
+    const std::vector<std::pair<int, int>>& changed_edges) {
+  GOPT_PROFILE_SCOPE("RepairClusterTree");
+  CHECK_EQ(xadj.size(), vertices_.size() + 1);
+  CHECK_EQ(xadj.back(), adjncy.size());
+  CHECK_EQ(adjncy.size(), adjwgt.size());
+
+  // The smallest cluster which contains both vertices of each changed edge.
+  // Leaves do not depend on their edges.
+  std::vector<bool> changed(nodes_.size(), false);
+  for (const auto& edge : changed_edges) {
+    int node1 = vertex_leaves_[edge.first];
+    int node2 = vertex_leaves_[edge.second];
+    while (nodes_[node1].depth > nodes_[node2].depth) {
+      node1 = nodes_[node1].parent;
+    }
+    while (nodes_[node2].depth > nodes_[node1].depth) {
+      node2 = nodes_[node2].parent;
+    }
+    while (node1 != node2) {
+      node1 = nodes_[node1].parent;
+      node2 = nodes_[node2].parent;
+    }
+    if (nodes_[node1].children[0] >= 0) {
+      changed[node1] = true;
+    }
+  }
+
+  // Only the subtrees of changed nodes without changed ancestors are rebuilt.
+  // The nodes are numbered in preorder, so the ancestors come first.
+  std::vector<int> rebuilt_nodes;
+  std::vector<bool> in_rebuilt_subtree(nodes_.size(), false);
+  for (size_t i = 0; i < nodes_.size(); i++) {
+    const int parent = nodes_[i].parent;
+    in_rebuilt_subtree[i] = parent >= 0 && in_rebuilt_subtree[parent];
+    if (changed[i] && !in_rebuilt_subtree[i]) {
+      rebuilt_nodes.push_back(i);
+      in_rebuilt_subtree[i] = true;
+    }
+  }
+  if (rebuilt_nodes.empty()) {
+    return;
+  }
+
+  VLOG(2) << "Rebuilding " << rebuilt_nodes.size()
+          << " subtrees of the cluster tree.";
+  for (const int node : rebuilt_nodes) {
+    nodes_[node].children[0] = -1;
+    nodes_[node].children[1] = -1;
+    BuildSubtree(xadj, adjncy, adjwgt, node);
+  }
+  Finalize();
+}
+
+std::vector<int> ClusterTree::ExtractPartition(const int num_clusters) const {
+  CHECK_GT(num_clusters, 0);
+  CHECK(!nodes_.empty());
+  const int num_splits = std::min(num_clusters, num_leaves_) - 1;
+
+  std::vector<int> labels(vertices_.size(), -1);
+  int num_labels = 0;
+  std::vector<int> stack(1, 0);
+  while (!stack.empty()) {
+    const Node& node = nodes_[stack.back()];
+    stack.pop_back();
+    if (node.split_rank >= 0 && node.split_rank < num_splits) {
+      stack.push_back(node.children[1]);
+      stack.push_back(node.children[0]);
+      continue;
+    }
+    for (int i = node.begin; i < node.end; i++) {
+      labels[vertices_[i]] = num_labels;
+    }
+    num_labels++;
+  }
+  return labels;
+}
+
+void ClusterTree::BuildSubtree(const std::vector<int>& xadj,
+                               const std::vector<int>& adjncy,
+                               const std::vector<int>& adjwgt,
+                               const int root) {
+  std::vector<int> sub_xadj, sub_adjncy, sub_adjwgt;
+  std::vector<int> stack(1, root);
+  while (!stack.empty()) {
+    const int node = stack.back();
+    stack.pop_back();
+    const int begin = nodes_[node].begin;
+    const int end = nodes_[node].end;
+    const int num_vertices = end - begin;
+    if (num_vertices <= options_.max_leaf_size) {
+      continue;
+    }
+
+    // The subgraph induced by the cluster.
+    for (int i = begin; i < end; i++) {
+      local_indices_[vertices_[i]] = i - begin;
+    }
+    sub_xadj.assign(1, 0);
+    sub_adjncy.clear();
+    sub_adjwgt.clear();
+    for (int i = begin; i < end; i++) {
+      const int vertex = vertices_[i];
+      for (int e = xadj[vertex]; e < xadj[vertex + 1]; e++) {
+        const int neighbor = local_indices_[adjncy[e]];
+        if (neighbor >= 0 && adjwgt[e] > 0) {
+          sub_adjncy.push_back(neighbor);
+          sub_adjwgt.push_back(adjwgt[e]);
+        }
+      }
+      sub_xadj.push_back(sub_adjncy.size());
+    }
+    for (int i = begin; i < end; i++) {
+      local_indices_[vertices_[i]] = -1;
+    }
+
+    // Clusters without edges, or whose bisection failed, are split in half.
+    int middle = begin + num_vertices / 2;
+    if (!sub_adjncy.empty()) {
+      const std::vector<int> cut_labels = ComputeNormalizedMinGraphCut(
+          sub_xadj, sub_adjncy, sub_adjwgt, 2, options_.num_threads);
+      std::vector<int> sides[2];
+      for (int i = 0; i < num_vertices; i++) {
+        sides[cut_labels[i] == 0 ? 0 : 1].push_back(vertices_[begin + i]);
+      }
+      if (!sides[0].empty() && !sides[1].empty()) {
+        std::copy(sides[0].begin(), sides[0].end(), vertices_.begin() + begin);
+        std::copy(sides[1].begin(), sides[1].end(),
+                  vertices_.begin() + begin + sides[0].size());
+        middle = begin + sides[0].size();
+      }
+    }
+
+    for (int side = 0; side < 2; side++) {
+      Node child;
+      child.parent = node;
+      child.begin = side == 0 ? begin : middle;
+      child.end = side == 0 ? middle : end;
+      nodes_[node].children[side] = nodes_.size();
+      nodes_.push_back(child);
+      stack.push_back(nodes_[node].children[side]);
+    }
+  }
+}
+
+void ClusterTree::Finalize() {
+  std::vector<Node> nodes;
+  nodes.reserve(nodes_.size());
+  // The old index of each node, with its new parent and its side in it.
+  struct StackEntry {
+    int old_node;
+    int parent;
+    int side;
+  };
+  std::vector<StackEntry> stack(1, StackEntry{0, -1, 0});
+  while (!stack.empty()) {
+    const int old_node = stack.back().old_node;
+    const int parent = stack.back().parent;
+    const int side = stack.back().side;
+    stack.pop_back();
+
+    const int node = nodes.size();
+    nodes.push_back(nodes_[old_node]);
+    nodes[node].parent = parent;
+    nodes[node].depth = parent >= 0 ? nodes[parent].depth + 1 : 0;
+    nodes[node].split_rank = -1;
+    if (parent >= 0) {
+      nodes[parent].children[side] = node;
+    }
+    if (nodes[node].children[0] >= 0) {
+      stack.push_back(StackEntry{nodes[node].children[1], node, 1});
+      stack.push_back(StackEntry{nodes[node].children[0], node, 0});
+    }
+  }
+  nodes_.swap(nodes);
+
+  // The leaves of the vertices.
+  vertex_leaves_.assign(vertices_.size(), -1);
+  num_leaves_ = 0;
+  for (size_t node = 0; node < nodes_.size(); node++) {
+    if (nodes_[node].children[0] < 0) {
+      for (int i = nodes_[node].begin; i < nodes_[node].end; i++) {
+        vertex_leaves_[vertices_[i]] = node;
+      }
+      num_leaves_++;
+    }
+  }
+
+  // The largest clusters are bisected first, which keeps the clusters of
+  // every partition balanced. Ties are broken by the order of the tree.
+  typedef std::pair<int, int> SizeNode;
+  const auto Compare = [](const SizeNode& a, const SizeNode& b) {
+    return a.first < b.first || (a.first == b.first && a.second > b.second);
+  };
+  std::priority_queue<SizeNode, std::vector<SizeNode>, decltype(Compare)>
+      queue(Compare);
+  queue.emplace(nodes_[0].end - nodes_[0].begin, 0);
+  int split_rank = 0;
+  while (!queue.empty()) {
+    const int node = queue.top().second;
+    queue.pop();
+    if (nodes_[node].children[0] < 0) {
+      continue;
+    }
+    nodes_[node].split_rank = split_rank++;
+    for (const int child : nodes_[node].children) {
+      queue.emplace(nodes_[child].end - nodes_[child].begin, child);
+    }
+  }
+}
+
+}  // namespace graph
+}  // namespace gopt
@@ -0,0 +1,100 @@
+#ifndef GRAPH_HIERARCHICAL_CLUSTERING_H_
+#define GRAPH_HIERARCHICAL_CLUSTERING_H_
+
+#include <utility>
+#include <vector>
+
+namespace gopt {
+namespace graph {
+
+struct HierarchicalClusteringOptions {
+  int num_threads = 1;
+
+  // Clusters with at most max_leaf_size vertices are not bisected, so
+  // partitions have at most about num_vertices / max_leaf_size * 2 clusters.
+  int max_leaf_size = 16;
+};
+
+// A hierarchical clustering of an undirected graph with the vertices 0, ...,
+// num_vertices - 1 by recursive bisection with the normalized cut of Graclus.
+// The tree is built once, and partitions into any number of clusters are
+// extracted from it in O(V), by applying the bisections of the largest
+// clusters first.
+//
+// The graphs are given in the CSR format of Graclus, with each edge in the
+// lists of both of its vertices.
+class ClusterTree {
+ public:
+  ClusterTree() {}
+
+  void Build(const std::vector<int>& xadj, const std::vector<int>& adjncy,
+             const std::vector<int>& adjwgt,
+             const HierarchicalClusteringOptions& options);
+
+  // Approximately updates the tree after the edges between the pairs of
+  // vertices in changed_edges were added, removed or reweighted. The graph has
+  // to have the same vertices. Only the subtrees of the smallest clusters which
+  // contain both vertices of a changed edge are rebuilt. This is a local
+  // repair: a changed edge does not cross the bisections above its cluster,
+  // but it changes the volume of the sides which contain it, and so the
+  // normalized cut optimum of every ancestor, whose bisections are kept. Call
+  // Build() to recluster the whole graph.
+  void Repair(const std::vector<int>& xadj, const std::vector<int>& adjncy,
+              const std::vector<int>& adjwgt,
+              const std::vector<std::pair<int, int>>& changed_edges);
+
+  // Returns the cluster of each vertex of a partition into
+  // min(num_clusters, MaxNumClusters()) clusters, numbered in the order of
+  // the tree.
+  std::vector<int> ExtractPartition(const int num_clusters) const;
+
+  int NumVertices() const { return vertices_.size(); }
+
+  // The vertices in the order of the tree, in which the clusters of every
+  // partition are contiguous and ordered by their labels.
+  const std::vector<int>& OrderedVertices() const { return vertices_; }
+
+  // Number of leaves of the tree.
+  int MaxNumClusters() const { return num_leaves_; }
+
+ private:
+  // A cluster of the tree, whose vertices are vertices_[begin, end).
+  struct Node {
+    int parent = -1;
+    int children[2] = {-1, -1};
+    int begin = 0;
+    int end = 0;
+    int depth = 0;
+
+    // The bisection of the node is the split_rank-th bisection applied when
+    // the partitions are extracted, or -1 for leaves.
+    int split_rank = -1;
+  };
+
+  // Recursively bisects the subtree of a node without children.
+  void BuildSubtree(const std::vector<int>& xadj,
+                    const std::vector<int>& adjncy,
+                    const std::vector<int>& adjwgt, const int root);
+
+  // Renumbers the nodes reachable from the root in preorder, which drops the
+  // nodes of replaced subtrees, and updates the depths, the leaves of the
+  // vertices and the split ranks.
+  void Finalize();
+
+  HierarchicalClusteringOptions options_;
+  std::vector<Node> nodes_;
+  std::vector<int> vertices_;
+
+  // The leaf of each vertex.
+  std::vector<int> vertex_leaves_;
+
+  int num_leaves_ = 0;
+
+  // The local index of each vertex in the subgraph being bisected, or -1.
+  std::vector<int> local_indices_;
+};
+
+}  // namespace graph
+}  // namespace gopt
+
+#endif  // GRAPH_HIERARCHICAL_CLUSTERING_H_
@@ -0,0 +1,171 @@
+#include "graph/hierarchical_clustering.h"
+
+#include <algorithm>
+#include <map>
+
+#include "gtest/gtest.h"
+#include "util/random.h"
+
+namespace gopt {
+namespace graph {
+namespace {
+
+// A graph of num_groups groups of group_size vertices, whose vertices are
+// connected more densely within than between the groups.
+void CreateClusteredGraph(const int num_groups, const int group_size,
+                          std::vector<int>* xadj, std::vector<int>* adjncy,
+                          std::vector<int>* adjwgt) {
+  RandomNumberGenerator rng(74);
+  const int num_vertices = num_groups * group_size;
+  std::map<std::pair<int, int>, int> weights;
+  for (int u = 0; u < num_vertices; u++) {
+    const int group = u / group_size;
+    for (int i = 0; i < 6; i++) {
+      const int v = group * group_size + rng.RandInt(0, group_size - 1);
+      if (v != u) {
+        weights[std::make_pair(std::min(u, v), std::max(u, v))] =
+            rng.RandInt(5, 20);
+      }
+    }
+    const int v = rng.RandInt(0, num_vertices - 1);
+    if (v / group_size != group) {
+      weights[std::make_pair(std::min(u, v), std::max(u, v))] = 1;
+    }
+  }
+
+  std::vector<std::vector<std::pair<int, int>>> adjacency(num_vertices);
+  for (const auto& weight : weights) {
+    adjacency[weight.first.first].emplace_back(weight.first.second,
+                                               weight.second);
+    adjacency[weight.first.second].emplace_back(weight.first.first,
+                                                weight.second);
+  }
+  xadj->assign(1, 0);
+  adjncy->clear();
+  adjwgt->clear();
+  for (const auto& neighbors : adjacency) {
+    for (const auto& neighbor : neighbors) {
+      adjncy->push_back(neighbor.first);
+      adjwgt->push_back(neighbor.second);
+    }
+    xadj->push_back(adjncy->size());
+  }
+}
+
+// Sets the weight of the edge between u and v in the lists of both vertices,
+// and inserts the edge if the graph does not have it.
+void SetEdgeWeight(const int u, const int v, const int weight,
+                   std::vector<int>* xadj, std::vector<int>* adjncy,
+                   std::vector<int>* adjwgt) {
+  for (const auto& edge : {std::make_pair(u, v), std::make_pair(v, u)}) {
+    const auto begin = adjncy->begin() + (*xadj)[edge.first];
+    const auto end = adjncy->begin() + (*xadj)[edge.first + 1];
+    const auto it = std::find(begin, end, edge.second);
+    if (it != end) {
+      (*adjwgt)[it - adjncy->begin()] = weight;
+      continue;
+    }
+    const int e = (*xadj)[edge.first + 1];
+    adjncy->insert(adjncy->begin() + e, edge.second);
+    adjwgt->insert(adjwgt->begin() + e, weight);
+    for (size_t i = edge.first + 1; i < xadj->size(); i++) {
+      (*xadj)[i]++;
+    }
+  }
+}
+
+// Checks that the partitions have the requested number of clusters and that
+// each partition refines the previous one.
+void CheckNestedPartitions(const ClusterTree& cluster_tree,
+                           const std::vector<int>& num_clusters) {
+  std::vector<int> previous_labels;
+  for (const int k : num_clusters) {
+    const std::vector<int> labels = cluster_tree.ExtractPartition(k);
+    ASSERT_EQ(labels.size(), cluster_tree.NumVertices());
+    EXPECT_EQ(*std::max_element(labels.begin(), labels.end()) + 1,
+              std::min(k, cluster_tree.MaxNumClusters()));
+    // The clusters are numbered in the order of the tree, whose first child
+    // of each node holds the first vertices of the node.
+    const std::vector<int>& vertices = cluster_tree.OrderedVertices();
+    for (size_t i = 1; i < vertices.size(); i++) {
+      EXPECT_LE(labels[vertices[i - 1]], labels[vertices[i]]);
+    }
+    if (!previous_labels.empty()) {
+      std::map<int, int> parents;
+      for (size_t i = 0; i < labels.size(); i++) {
+        const auto it = parents.emplace(labels[i], previous_labels[i]).first;
+        EXPECT_EQ(it->second, previous_labels[i]);
+      }
+    }
+    previous_labels = labels;
+  }
+}
+
+}  // namespace
+
+TEST(HIERARCHICAL_CLUSTERING_TEST, TestNestedPartitions) {
+  static const int kNumGroups = 4;
+  static const int kGroupSize = 100;
+  std::vector<int> xadj, adjncy, adjwgt;
+  CreateClusteredGraph(kNumGroups, kGroupSize, &xadj, &adjncy, &adjwgt);
+
+  HierarchicalClusteringOptions options;
+  options.max_leaf_size = 10;
+  ClusterTree cluster_tree;
+  cluster_tree.Build(xadj, adjncy, adjwgt, options);
+  EXPECT_EQ(cluster_tree.NumVertices(), kNumGroups * kGroupSize);
+  EXPECT_GE(cluster_tree.MaxNumClusters(), kNumGroups * kGroupSize / 10);
+  CheckNestedPartitions(cluster_tree, {1, 2, 3, 4, 16, 64, 10000});
+
+  // The planted groups are recovered by the first two levels.
+  const std::vector<int> labels = cluster_tree.ExtractPartition(kNumGroups);
+  std::vector<int> cluster_sizes(kNumGroups, 0);
+  for (int i = 0; i < kNumGroups * kGroupSize; i++) {
+    EXPECT_EQ(labels[i], labels[i / kGroupSize * kGroupSize]);
+    cluster_sizes[labels[i]]++;
+  }
+  for (const int cluster_size : cluster_sizes) {
+    EXPECT_EQ(cluster_size, kGroupSize);
+  }
+}
+
+TEST(HIERARCHICAL_CLUSTERING_TEST, TestRepair) {
+  static const int kNumGroups = 4;
+  static const int kGroupSize = 100;
+  std::vector<int> xadj, adjncy, adjwgt;
+  CreateClusteredGraph(kNumGroups, kGroupSize, &xadj, &adjncy, &adjwgt);
+
+  HierarchicalClusteringOptions options;
+  options.max_leaf_size = 10;
+  ClusterTree cluster_tree;
+  cluster_tree.Build(xadj, adjncy, adjwgt, options);
+  const std::vector<int> labels = cluster_tree.ExtractPartition(kNumGroups);
+
+  // Reweighting the edges within the first group only rebuilds its subtree,
+  // so the partition of the groups is kept.
+  std::vector<std::pair<int, int>> changed_edges;
+  for (int u = 0; u < kGroupSize; u++) {
+    for (int e = xadj[u]; e < xadj[u + 1]; e++) {
+      if (adjncy[e] < kGroupSize) {
+        adjwgt[e] = 1 + (u + adjncy[e]) % 7;
+        if (u < adjncy[e]) {
+          changed_edges.emplace_back(u, adjncy[e]);
+        }
+      }
+    }
+  }
+  cluster_tree.Repair(xadj, adjncy, adjwgt, changed_edges);
+  EXPECT_EQ(cluster_tree.ExtractPartition(kNumGroups), labels);
+  CheckNestedPartitions(cluster_tree, {1, 2, 4, 8, 16, 32, 10000});
+
+  // A heavy edge between two groups rebuilds the tree from their common
+  // cluster, whose partitions are still consistent.
+  SetEdgeWeight(0, kNumGroups * kGroupSize - 1, 100, &xadj, &adjncy, &adjwgt);
+  ASSERT_EQ(xadj.back(), adjncy.size());
+  changed_edges.assign(1, std::make_pair(0, kNumGroups * kGroupSize - 1));
+  cluster_tree.Repair(xadj, adjncy, adjwgt, changed_edges);
+  CheckNestedPartitions(cluster_tree, {1, 2, 4, 8, 16, 32, 10000});
+}
+
+}  // namespace graph
+}  // namespace gopt
@@ -0,0 +1,547 @@
+#include "graph/parallel_graph_cut.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <utility>
+
+extern "C" {
+#include "Graclus/metisLib/metis.h"
+}
+
+#include <glog/logging.h>
+
+#include "graph/graph_cut.h"
+#include "util/profiler.h"
+
+namespace gopt {
+namespace graph {
+namespace {
+
+// Rounds of handshaking per matching. Most vertices are matched in the first
+// rounds, the remaining ones are mostly isolated by matched neighbors.
+const int kNumMatchingRounds = 4;
+
+// The coarsening stops once a level keeps more than this fraction of the
+// vertices of the finer level.
+const double kMinCoarseningRatio = 0.95;
+
+const int kMaxNumRefinementPasses = 10;
+
+// The edge weights of the coarsest graph are scaled to this maximum for
+// Graclus, whose weights are of type int.
+const int64_t kMaxGraclusWeight = 1 << 24;
+
+// A level of the multilevel hierarchy. Every vertex keeps the sum of the
+// degrees, the weight of the edges between, and the number of the input
+// vertices it merges, so that the normalized association of a partition is
+// the same on all levels.
+struct LevelGraph {
+  int NumVertices() const { return static_cast<int>(xadj.size()) - 1; }
+
+  std::vector<int> xadj;
+  std::vector<int> adjncy;
+  std::vector<int64_t> adjwgt;
+  std::vector<int64_t> degrees;
+  // Counted in both directions, as in assoc(c, c).
+  std::vector<int64_t> internal_weights;
+  std::vector<int> sizes;
+
+  // Maps the vertices to the vertices of the next coarser level.
+  std::vector<int> cmap;
+};
+
+// The statistics of the clusters of a partition of a level.
+struct ClusterStats {
+  std::vector<int64_t> associations;
+  std::vector<int64_t> volumes;
+  std::vector<int> num_vertices;
+};
+
+double Ratio(const int64_t association, const int64_t volume) {
+  return volume > 0 ? static_cast<double>(association) / volume : 0.0;
+}
+
+double NormalizedAssociation(const ClusterStats& stats) {
+  double normalized_association = 0.0;
+  for (size_t c = 0; c < stats.volumes.size(); c++) {
+    normalized_association += Ratio(stats.associations[c], stats.volumes[c]);
+  }
+  return normalized_association;
+}
+
+LevelGraph CreateFinestLevel(const std::vector<int>& xadj,
+                             const std::vector<int>& adjncy,
+                             const std::vector<int>& adjwgt,
+                             const int num_threads) {
+  const int num_vertices = static_cast<int>(xadj.size()) - 1;
+
+  LevelGraph graph;
+  graph.xadj.resize(num_vertices + 1);
+  graph.degrees.resize(num_vertices);
+  graph.internal_weights.resize(num_vertices);
+  graph.sizes.assign(num_vertices, 1);
+
+  // Self loops are moved into the internal weights.
+  graph.xadj[0] = 0;
+  for (int u = 0; u < num_vertices; u++) {
+    int num_neighbors = 0;
+    for (int e = xadj[u]; e < xadj[u + 1]; e++) {
+      CHECK_GE(adjncy[e], 0);
+      CHECK_LT(adjncy[e], num_vertices);
+      num_neighbors += adjncy[e] != u;
+    }
+    graph.xadj[u + 1] = graph.xadj[u] + num_neighbors;
+  }
+  graph.adjncy.resize(graph.xadj[num_vertices]);
+  graph.adjwgt.resize(graph.xadj[num_vertices]);
+
+#pragma omp parallel for num_threads(num_threads)
+  for (int u = 0; u < num_vertices; u++) {
+    int64_t degree = 0;
+    int64_t internal_weight = 0;
+    int position = graph.xadj[u];
+    for (int e = xadj[u]; e < xadj[u + 1]; e++) {
+      degree += adjwgt[e];
+      if (adjncy[e] == u) {
+        internal_weight += adjwgt[e];
+      } else {
+        graph.adjncy[position] = adjncy[e];
+        graph.adjwgt[position++] = adjwgt[e];
+      }
+    }
+    graph.degrees[u] = degree;
+    graph.internal_weights[u] = internal_weight;
+  }
+  return graph;
+}
+
+// Matches the vertices by handshaking and stores the coarse vertex of each
+// vertex in graph->cmap. Returns the number of coarse vertices.
+int ComputeMatching(const int max_size, const int num_threads,
+                    LevelGraph* graph) {
+  const int num_vertices = graph->NumVertices();
+  std::vector<int> matches(num_vertices, -1);
+  std::vector<int> proposals(num_vertices);
+
+  for (int round = 0; round < kNumMatchingRounds; round++) {
+#pragma omp parallel for num_threads(num_threads)
+    for (int u = 0; u < num_vertices; u++) {
+      proposals[u] = -1;
+      if (matches[u] != -1) {
+        continue;
+      }
+
+      // The normalized edge weight is symmetric, so that the heaviest edge of
+      // the unmatched vertices is always matched.
+      double best_score = 0.0;
+      for (int e = graph->xadj[u]; e < graph->xadj[u + 1]; e++) {
+        const int v = graph->adjncy[e];
+        if (matches[v] != -1 || graph->adjwgt[e] <= 0 ||
+            graph->sizes[u] + graph->sizes[v] > max_size) {
+          continue;
+        }
+        const double score =
+            graph->adjwgt[e] *
+            (1.0 / graph->degrees[u] + 1.0 / graph->degrees[v]);
+        if (score > best_score ||
+            (score == best_score && v < proposals[u])) {
+          best_score = score;
+          proposals[u] = v;
+        }
+      }
+    }
+
+    int num_matched = 0;
+#pragma omp parallel for num_threads(num_threads) reduction(+ : num_matched)
+    for (int u = 0; u < num_vertices; u++) {
+      const int v = proposals[u];
+      if (v != -1 && proposals[v] == u) {
+        matches[u] = v;
+        num_matched++;
+      }
+    }
+    if (num_matched == 0) {
+      break;
+    }
+  }
+
+  // Each pair of matched vertices is numbered by its smaller vertex.
+  graph->cmap.resize(num_vertices);
+  int num_coarse_vertices = 0;
+  for (int u = 0; u < num_vertices; u++) {
+    const int v = matches[u];
+    graph->cmap[u] =
+        (v != -1 && v < u) ? graph->cmap[v] : num_coarse_vertices++;
+  }
+  return num_coarse_vertices;
+}
+
+LevelGraph ContractGraph(const LevelGraph& graph, const int num_coarse_vertices,
+                         const int num_threads) {
+  const int num_vertices = graph.NumVertices();
+  std::vector<std::pair<int, int>> fine_vertices(num_coarse_vertices,
+                                                 std::make_pair(-1, -1));
+  for (int u = 0; u < num_vertices; u++) {
+    std::pair<int, int>& fine = fine_vertices[graph.cmap[u]];
+    (fine.first == -1 ? fine.first : fine.second) = u;
+  }
+
+  LevelGraph coarse_graph;
+  coarse_graph.xadj.assign(num_coarse_vertices + 1, 0);
+  coarse_graph.degrees.resize(num_coarse_vertices);
+  coarse_graph.internal_weights.resize(num_coarse_vertices);
+  coarse_graph.sizes.resize(num_coarse_vertices);
+  std::vector<std::vector<std::pair<int, int64_t>>> adjacency(
+      num_coarse_vertices);
+
+#pragma omp parallel num_threads(num_threads)
+  {
+    // Position of each coarse neighbor in the adjacency of the current coarse
+    // vertex, or -1.
+    std::vector<int> positions(num_coarse_vertices, -1);
+
+#pragma omp for
+    for (int c = 0; c < num_coarse_vertices; c++) {
+      std::vector<std::pair<int, int64_t>>& neighbors = adjacency[c];
+      int64_t degree = 0;
+      int64_t internal_weight = 0;
+      int size = 0;
+      for (const int u : {fine_vertices[c].first, fine_vertices[c].second}) {
+        if (u == -1) {
+          continue;
+        }
+        degree += graph.degrees[u];
+        internal_weight += graph.internal_weights[u];
+        size += graph.sizes[u];
+        for (int e = graph.xadj[u]; e < graph.xadj[u + 1]; e++) {
+          const int d = graph.cmap[graph.adjncy[e]];
+          if (d == c) {
+            internal_weight += graph.adjwgt[e];
+          } else if (positions[d] == -1) {
+            positions[d] = neighbors.size();
+            neighbors.emplace_back(d, graph.adjwgt[e]);
+          } else {
+            neighbors[positions[d]].second += graph.adjwgt[e];
+          }
+        }
+      }
+      for (const auto& neighbor : neighbors) {
+        positions[neighbor.first] = -1;
+      }
+
+      coarse_graph.degrees[c] = degree;
+      coarse_graph.internal_weights[c] = internal_weight;
+      coarse_graph.sizes[c] = size;
+      coarse_graph.xadj[c + 1] = neighbors.size();
+    }
+  }
+
+  for (int c = 0; c < num_coarse_vertices; c++) {
+    coarse_graph.xadj[c + 1] += coarse_graph.xadj[c];
+  }
+  coarse_graph.adjncy.resize(coarse_graph.xadj[num_coarse_vertices]);
+  coarse_graph.adjwgt.resize(coarse_graph.xadj[num_coarse_vertices]);
+
+#pragma omp parallel for num_threads(num_threads)
+  for (int c = 0; c < num_coarse_vertices; c++) {
+    int position = coarse_graph.xadj[c];
+    for (const auto& neighbor : adjacency[c]) {
+      coarse_graph.adjncy[position] = neighbor.first;
+      coarse_graph.adjwgt[position++] = neighbor.second;
+    }
+    std::vector<std::pair<int, int64_t>>().swap(adjacency[c]);
+  }
+  return coarse_graph;
+}
+
+// Partitions the coarsest graph by the recursive bisection of Graclus, with
+// the number of merged vertices as the vertex weights.
+void PartitionCoarsestGraph(const LevelGraph& graph, const int num_parts,
+                            std::vector<int>* labels) {
+  int num_vertices = graph.NumVertices();
+  labels->resize(num_vertices);
+  if (num_vertices <= num_parts) {
+    for (int u = 0; u < num_vertices; u++) {
+      (*labels)[u] = u;
+    }
+    return;
+  }
+
+  int64_t max_weight = 1;
+  for (const int64_t weight : graph.adjwgt) {
+    max_weight = std::max(max_weight, weight);
+  }
+  const double scale =
+      std::min(1.0, static_cast<double>(kMaxGraclusWeight) / max_weight);
+
+  std::vector<idxtype> xadj(graph.xadj.begin(), graph.xadj.end());
+  std::vector<idxtype> adjncy(graph.adjncy.begin(), graph.adjncy.end());
+  std::vector<idxtype> vwgt(graph.sizes.begin(), graph.sizes.end());
+  std::vector<idxtype> adjwgt(graph.adjwgt.size());
+  for (size_t e = 0; e < adjwgt.size(); e++) {
+    adjwgt[e] = graph.adjwgt[e] > 0
+                    ? std::max<idxtype>(1, std::llround(scale * graph.adjwgt[e]))
+                    : 0;
+  }
+
+  int wgtflag = 3;
+  int numflag = 0;
+  int var_num_parts = num_parts;
+  int options[10];
+  options[0] = 0;
+  int edgecut;
+  std::vector<float> tpwgts(num_parts, 1.0f / num_parts);
+  std::lock_guard<std::mutex> lock(GraclusMutex());
+  METIS_WPartGraphRecursive(&num_vertices, xadj.data(), adjncy.data(),
+                            vwgt.data(), adjwgt.data(), &wgtflag, &numflag,
+                            &var_num_parts, tpwgts.data(), options, &edgecut,
+                            labels->data());
+}
+
+void ComputeClusterStats(const LevelGraph& graph, const std::vector<int>& labels,
+                         const int num_parts, const int num_threads,
+                         ClusterStats* stats) {
+  stats->associations.assign(num_parts, 0);
+  stats->volumes.assign(num_parts, 0);
+  stats->num_vertices.assign(num_parts, 0);
+
+  // The sums are exact, so the stats do not depend on the number of threads.
+#pragma omp parallel num_threads(num_threads)
+  {
+    ClusterStats local_stats;
+    local_stats.associations.assign(num_parts, 0);
+    local_stats.volumes.assign(num_parts, 0);
+    local_stats.num_vertices.assign(num_parts, 0);
+
+#pragma omp for
+    for (int u = 0; u < graph.NumVertices(); u++) {
+      const int c = labels[u];
+      local_stats.volumes[c] += graph.degrees[u];
+      local_stats.num_vertices[c]++;
+      local_stats.associations[c] += graph.internal_weights[u];
+      for (int e = graph.xadj[u]; e < graph.xadj[u + 1]; e++) {
+        if (labels[graph.adjncy[e]] == c) {
+          local_stats.associations[c] += graph.adjwgt[e];
+        }
+      }
+    }
+
+#pragma omp critical
+    {
+      for (int c = 0; c < num_parts; c++) {
+        stats->associations[c] += local_stats.associations[c];
+        stats->volumes[c] += local_stats.volumes[c];
+        stats->num_vertices[c] += local_stats.num_vertices[c];
+      }
+    }
+  }
+}
+
+// Runs one pass of the boundary refinement. Returns true if the normalized
+// association was improved, otherwise labels and stats are unchanged.
+bool RefinePartition(const LevelGraph& graph, const int num_parts,
+                     const int num_threads, std::vector<int>* labels,
+                     ClusterStats* stats) {
+  const int num_vertices = graph.NumVertices();
+  std::vector<int> moves(num_vertices, -1);
+  std::vector<double> gains(num_vertices, 0.0);
+
+#pragma omp parallel num_threads(num_threads)
+  {
+    // The weight of the edges to each cluster, or -1 if there are none.
+    std::vector<int64_t> links(num_parts, -1);
+    std::vector<int> linked_clusters;
+
+#pragma omp for
+    for (int u = 0; u < num_vertices; u++) {
+      const int a = (*labels)[u];
+      if (stats->num_vertices[a] <= 1) {
+        continue;
+      }
+
+      linked_clusters.clear();
+      for (int e = graph.xadj[u]; e < graph.xadj[u + 1]; e++) {
+        const int b = (*labels)[graph.adjncy[e]];
+        if (links[b] == -1) {
+          links[b] = 0;
+          linked_clusters.push_back(b);
+        }
+        links[b] += graph.adjwgt[e];
+      }
+
+      const int64_t link_a = std::max<int64_t>(links[a], 0);
+      const double removal_gain =
+          Ratio(stats->associations[a] - 2 * link_a -
+                    graph.internal_weights[u],
+                stats->volumes[a] - graph.degrees[u]) -
+          Ratio(stats->associations[a], stats->volumes[a]);
+      for (const int b : linked_clusters) {
+        if (b == a) {
+          continue;
+        }
+        const double gain =
+            removal_gain +
+            Ratio(stats->associations[b] + 2 * links[b] +
+                      graph.internal_weights[u],
+                  stats->volumes[b] + graph.degrees[u]) -
+            Ratio(stats->associations[b], stats->volumes[b]);
+        if (gain > gains[u] || (gain == gains[u] && moves[u] != -1 &&
+                                b < moves[u])) {
+          gains[u] = gain;
+          moves[u] = b;
+        }
+      }
+
+      for (const int b : linked_clusters) {
+        links[b] = -1;
+      }
+    }
+  }
+
+  // A move is applied if no neighbor proposes a move with a larger gain, so
+  // that the gains of the applied moves do not depend on each other through
+  // the edges between them.
+  std::vector<int> previous_labels = *labels;
+  int num_moves = 0;
+#pragma omp parallel for num_threads(num_threads) reduction(+ : num_moves)
+  for (int u = 0; u < num_vertices; u++) {
+    if (moves[u] == -1) {
+      continue;
+    }
+    bool dominant = true;
+    for (int e = graph.xadj[u]; e < graph.xadj[u + 1] && dominant; e++) {
+      const int v = graph.adjncy[e];
+      dominant = moves[v] == -1 || gains[v] < gains[u] ||
+                 (gains[v] == gains[u] && u < v);
+    }
+    if (dominant) {
+      (*labels)[u] = moves[u];
+      num_moves++;
+    }
+  }
+  if (num_moves == 0) {
+    return false;
+  }
+
+  // The moves still interact through the statistics of the clusters, which
+  // may make the pass worse, or empty a cluster, as a whole.
+  ClusterStats new_stats;
+  ComputeClusterStats(graph, *labels, num_parts, num_threads, &new_stats);
+  bool valid = NormalizedAssociation(new_stats) > NormalizedAssociation(*stats);
+  for (int c = 0; c < num_parts && valid; c++) {
+    valid = new_stats.num_vertices[c] > 0 || stats->num_vertices[c] == 0;
+  }
+  if (!valid) {
+    labels->swap(previous_labels);
+    return false;
+  }
+
+  *stats = std::move(new_stats);
+  return true;
+}
+
+void RefinePartition(const LevelGraph& graph, const int num_parts,
+                     const int num_threads, std::vector<int>* labels) {
+  ClusterStats stats;
+  ComputeClusterStats(graph, *labels, num_parts, num_threads, &stats);
+  for (int pass = 0; pass < kMaxNumRefinementPasses; pass++) {
+    if (!RefinePartition(graph, num_parts, num_threads, labels, &stats)) {
+      break;
+    }
+  }
+}
+
+}  // namespace
+
+std::vector<int> ComputeParallelNormalizedCut(const std::vector<int>& xadj,
+                                              const std::vector<int>& adjncy,
+                                              const std::vector<int>& adjwgt,
+                                              const int num_parts,
+                                              const int num_threads) {
+  GOPT_PROFILE_SCOPE("ParallelNormalizedCut");
+  CHECK(!xadj.empty());
+  CHECK_EQ(adjncy.size(), adjwgt.size());
+  CHECK_EQ(xadj.back(), adjncy.size());
+  CHECK_GT(num_parts, 0);
+  CHECK_GT(num_threads, 0);
+
+  const int num_vertices = static_cast<int>(xadj.size()) - 1;
+  if (num_parts == 1) {
+    return std::vector<int>(num_vertices, 0);
+  }
+
+  // The coarsening parameters of MLKKM_PartGraphKway().
+  const int coarsen_to =
+      std::max(num_vertices / (40 * log2_metis(num_parts)), 20 * num_parts);
+  const int max_size =
+      std::max(2, static_cast<int>(150.0 * num_vertices / coarsen_to));
+
+  std::vector<LevelGraph> levels;
+  levels.push_back(CreateFinestLevel(xadj, adjncy, adjwgt, num_threads));
+  while (levels.back().NumVertices() > coarsen_to) {
+    LevelGraph& graph = levels.back();
+    const int num_coarse_vertices =
+        ComputeMatching(max_size, num_threads, &graph);
+    if (num_coarse_vertices > kMinCoarseningRatio * graph.NumVertices()) {
+      graph.cmap.clear();
+      break;
+    }
+    LevelGraph coarse_graph =
+        ContractGraph(graph, num_coarse_vertices, num_threads);
+    levels.push_back(std::move(coarse_graph));
+  }
+  VLOG(2) << "Coarsened " << num_vertices << " vertices to "
+          << levels.back().NumVertices() << " in " << levels.size() - 1
+          << " levels";
+
+  std::vector<int> labels;
+  PartitionCoarsestGraph(levels.back(), num_parts, &labels);
+  RefinePartition(levels.back(), num_parts, num_threads, &labels);
+
+  for (int level = static_cast<int>(levels.size()) - 2; level >= 0; level--) {
+    const LevelGraph& graph = levels[level];
+    std::vector<int> fine_labels(graph.NumVertices());
+#pragma omp parallel for num_threads(num_threads)
+    for (int u = 0; u < graph.NumVertices(); u++) {
+      fine_labels[u] = labels[graph.cmap[u]];
+    }
+    labels.swap(fine_labels);
+    levels.pop_back();
+    RefinePartition(graph, num_parts, num_threads, &labels);
+  }
+
+  return labels;
+}
+
+double ComputeNormalizedCutValue(const std::vector<int>& xadj,
+                                 const std::vector<int>& adjncy,
+                                 const std::vector<int>& adjwgt,
+                                 const std::vector<int>& labels,
+                                 const int num_parts) {
+  CHECK_EQ(labels.size() + 1, xadj.size());
+  std::vector<int64_t> cuts(num_parts, 0);
+  std::vector<int64_t> volumes(num_parts, 0);
+  for (size_t u = 0; u < labels.size(); u++) {
+    const int c = labels[u];
+    CHECK_GE(c, 0);
+    CHECK_LT(c, num_parts);
+    for (int e = xadj[u]; e < xadj[u + 1]; e++) {
+      volumes[c] += adjwgt[e];
+      if (labels[adjncy[e]] != c) {
+        cuts[c] += adjwgt[e];
+      }
+    }
+  }
+
+  double normalized_cut = 0.0;
+  for (int c = 0; c < num_parts; c++) {
+    normalized_cut += Ratio(cuts[c], volumes[c]);
+  }
+  return normalized_cut;
+}
+
+}  // namespace graph
+}  // namespace gopt
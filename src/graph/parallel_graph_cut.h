@@ -0,0 +1,51 @@
+#ifndef GRAPH_PARALLEL_GRAPH_CUT_H_
+#define GRAPH_PARALLEL_GRAPH_CUT_H_
+
+#include <vector>
+
+namespace gopt {
+namespace graph {
+
+// Multithreaded multilevel kernel k-means for the normalized cut, following
+// the scheme of Graclus:
+//
+//   1. The graph is coarsened by heavy edge matchings, which are computed in
+//      parallel by handshaking: every unmatched vertex proposes to the
+//      neighbor of the largest normalized edge weight w_uv (1 / d_u + 1 / d_v),
+//      and mutual proposals are matched. The contraction of the matched
+//      vertices is parallel over the coarse vertices.
+//   2. The coarsest graph is partitioned by the recursive bisection of
+//      Graclus, as in MLKKM_PartGraphKway().
+//   3. The partition is projected back level by level and refined by parallel
+//      boundary passes of weighted kernel k-means, which maximize the
+//      normalized association sum_c assoc(c, c) / vol(c) exactly, since every
+//      coarse vertex keeps the degree and the internal weight of the vertices
+//      it merges. The moves of a pass are proposed in parallel, and a move is
+//      applied if it has a larger gain than the moves proposed by the
+//      neighbors of its vertex. A pass which does not improve the objective is
+//      reverted.
+//
+// The result does not depend on the number of threads, including one thread.
+// This only holds for this function: ComputeNormalizedMinGraphCut() runs the
+// serial Graclus with one thread, whose partitions differ. The graph with the
+// vertices 0, ..., xadj.size() - 2 is given in the CSR format of Graclus, where
+// each edge appears in the lists of both of its vertices. Returns the cluster
+// label of each vertex, in [0, num_parts).
+std::vector<int> ComputeParallelNormalizedCut(const std::vector<int>& xadj,
+                                              const std::vector<int>& adjncy,
+                                              const std::vector<int>& adjwgt,
+                                              const int num_parts,
+                                              const int num_threads);
+
+// Returns the normalized cut sum_c cut(c) / vol(c) of the labels of a graph in
+// the CSR format of Graclus. Clusters of zero volume are skipped.
+double ComputeNormalizedCutValue(const std::vector<int>& xadj,
+                                 const std::vector<int>& adjncy,
+                                 const std::vector<int>& adjwgt,
+                                 const std::vector<int>& labels,
+                                 const int num_parts);
+
+}  // namespace graph
+}  // namespace gopt
+
+#endif  // GRAPH_PARALLEL_GRAPH_CUT_H_
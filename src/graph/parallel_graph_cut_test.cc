@@ -0,0 +1,130 @@
+#include "graph/parallel_graph_cut.h"
+
+#include <unordered_map>
+#include <utility>
+
+#include "graph/graph_cut.h"
+#include "gtest/gtest.h"
+#include "util/random.h"
+
+namespace gopt {
+namespace graph {
+namespace {
+
+// A graph of num_groups groups of group_size vertices, whose vertices are
+// connected more densely within than between the groups.
+void CreateClusteredGraph(const int num_groups, const int group_size,
+                          std::vector<std::pair<int, int>>* edges,
+                          std::vector<int>* weights) {
+  RandomNumberGenerator rng(70);
+  const int num_vertices = num_groups * group_size;
+  for (int u = 0; u < num_vertices; u++) {
+    const int group = u / group_size;
+    for (int i = 0; i < 6; i++) {
+      const int v = group * group_size + rng.RandInt(0, group_size - 1);
+      if (v != u) {
+        edges->emplace_back(u, v);
+        weights->push_back(rng.RandInt(5, 20));
+      }
+    }
+    const int v = rng.RandInt(0, num_vertices - 1);
+    if (v / group_size != group) {
+      edges->emplace_back(u, v);
+      weights->push_back(rng.RandInt(1, 5));
+    }
+  }
+}
+
+void EdgesToCSR(const int num_vertices,
+                const std::vector<std::pair<int, int>>& edges,
+                const std::vector<int>& weights, std::vector<int>* xadj,
+                std::vector<int>* adjncy, std::vector<int>* adjwgt) {
+  std::vector<std::vector<std::pair<int, int>>> adjacency(num_vertices);
+  for (size_t i = 0; i < edges.size(); i++) {
+    adjacency[edges[i].first].emplace_back(edges[i].second, weights[i]);
+    adjacency[edges[i].second].emplace_back(edges[i].first, weights[i]);
+  }
+  xadj->assign(1, 0);
+  for (const auto& neighbors : adjacency) {
+    for (const auto& neighbor : neighbors) {
+      adjncy->push_back(neighbor.first);
+      adjwgt->push_back(neighbor.second);
+    }
+    xadj->push_back(adjncy->size());
+  }
+}
+
+}  // namespace
+
+TEST(PARALLEL_GRAPH_CUT_TEST, TestComparableToGraclus) {
+  static const int kNumGroups = 8;
+  static const int kGroupSize = 250;
+  static const int kNumVertices = kNumGroups * kGroupSize;
+  std::vector<std::pair<int, int>> edges;
+  std::vector<int> weights;
+  CreateClusteredGraph(kNumGroups, kGroupSize, &edges, &weights);
+  std::vector<int> xadj, adjncy, adjwgt;
+  EdgesToCSR(kNumVertices, edges, weights, &xadj, &adjncy, &adjwgt);
+
+  const std::unordered_map<int, int> serial_labels =
+      ComputeNormalizedMinGraphCut(edges, weights, kNumGroups);
+  std::vector<int> labels(kNumVertices);
+  for (const auto& label : serial_labels) {
+    labels[label.first] = label.second;
+  }
+  const double serial_normalized_cut =
+      ComputeNormalizedCutValue(xadj, adjncy, adjwgt, labels, kNumGroups);
+
+  labels = ComputeParallelNormalizedCut(xadj, adjncy, adjwgt, kNumGroups, 4);
+  ASSERT_EQ(labels.size(), kNumVertices);
+  std::vector<int> cluster_sizes(kNumGroups, 0);
+  for (const int label : labels) {
+    ASSERT_GE(label, 0);
+    ASSERT_LT(label, kNumGroups);
+    cluster_sizes[label]++;
+  }
+  for (const int cluster_size : cluster_sizes) {
+    EXPECT_GT(cluster_size, 0);
+  }
+  const double parallel_normalized_cut =
+      ComputeNormalizedCutValue(xadj, adjncy, adjwgt, labels, kNumGroups);
+  EXPECT_LT(parallel_normalized_cut, 1.1 * serial_normalized_cut + 0.05);
+
+  // The planted groups have a normalized cut of about 8 * 3 / 78.
+  EXPECT_LT(parallel_normalized_cut, 0.5);
+}
+
+TEST(PARALLEL_GRAPH_CUT_TEST, TestIndependentOfNumThreads) {
+  static const int kNumGroups = 5;
+  static const int kGroupSize = 300;
+  std::vector<std::pair<int, int>> edges;
+  std::vector<int> weights;
+  CreateClusteredGraph(kNumGroups, kGroupSize, &edges, &weights);
+  std::vector<int> xadj, adjncy, adjwgt;
+  EdgesToCSR(kNumGroups * kGroupSize, edges, weights, &xadj, &adjncy, &adjwgt);
+
+  const std::vector<int> labels =
+      ComputeParallelNormalizedCut(xadj, adjncy, adjwgt, kNumGroups, 1);
+  for (const int num_threads : {2, 3, 8}) {
+    EXPECT_EQ(ComputeParallelNormalizedCut(xadj, adjncy, adjwgt, kNumGroups,
+                                           num_threads),
+              labels);
+  }
+}
+
+TEST(PARALLEL_GRAPH_CUT_TEST, TestComputeNormalizedMinGraphCut) {
+  const std::vector<std::pair<int, int>> edges = {
+      {3, 4}, {3, 6}, {3, 5}, {0, 4}, {0, 1}, {0, 6}, {0, 7}, {0, 5},
+      {0, 2}, {4, 1}, {1, 6}, {1, 5}, {6, 7}, {7, 5}, {5, 2}, {3, 4}, {2, 2}};
+  const std::vector<int> weights = {0, 3, 1, 3,  1, 2, 6, 1, 8,
+                                    1, 1, 80, 2, 1, 1, 4, 2};
+  const auto cut_labels = ComputeNormalizedMinGraphCut(edges, weights, 2, 4);
+  EXPECT_EQ(cut_labels.size(), 8);
+  for (const auto& label : cut_labels) {
+    EXPECT_GE(label.second, 0);
+    EXPECT_LT(label.second, 2);
+  }
+}
+
+}  // namespace graph
+}  // namespace gopt
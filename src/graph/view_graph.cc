@@ -1,11 +1,29 @@
 #include "graph/view_graph.h"
 
+#include <algorithm>
+#include <queue>
+#include <utility>
+#include <vector>
+
 #include <Eigen/Geometry>
 
+#include "geometry/rotation_utils.h"
+#include "graph/union_find.h"
+#ifdef CONSENSUS_ADMM_ENABLED
+#include "rotation_averaging/consensus_admm_rotation_estimator.h"
+#endif
 #include "rotation_averaging/lagrange_dual_rotation_estimator.h"
+#include "rotation_averaging/partitioned_rotation_estimator.h"
 #include "rotation_averaging/robust_l1l2_rotation_estimator.h"
 #include "rotation_averaging/hybrid_rotation_estimator.h"
+#include "translation_averaging/bata_position_estimator.h"
+#include "translation_averaging/ligt_position_estimator.h"
 #include "translation_averaging/lud_position_estimator.h"
+#include "translation_averaging/nonlinear_position_refiner.h"
+#include "translation_averaging/partitioned_position_estimator.h"
+#include "translation_averaging/translation_filter.h"
+#include "util/map_util.h"
+#include "util/profiler.h"
 #include "util/random.h"
 
 namespace gopt {
@@ -14,6 +32,8 @@ namespace graph {
 ViewGraph::ViewGraph() {}
 
 bool ViewGraph::ReadG2OFile(const std::string &filename) {
+  GOPT_PROFILE_SCOPE("ReadG2OFile");
+
   // A string used to contain the contents of a single line.
   std::string line;
 
@@ -91,6 +111,7 @@ bool ViewGraph::MotionAveraging(
     const PositionEstimatorOptions& position_estimator_options,
     std::unordered_map<image_t, Eigen::Vector3d>* global_rotations,
     std::unordered_map<image_t, Eigen::Vector3d>* positions) {
+  GOPT_PROFILE_SCOPE("MotionAveraging");
   return RotationAveraging(rotation_estimator_options, global_rotations) &&
          TranslationAveraging(position_estimator_options, positions);
 }
@@ -98,13 +119,21 @@ bool ViewGraph::MotionAveraging(
 bool ViewGraph::RotationAveraging(
     const RotationEstimatorOptions& options,
     std::unordered_map<image_t, Eigen::Vector3d>* global_rotations) {
+  GOPT_PROFILE_SCOPE("RotationAveraging");
   std::unique_ptr<RotationEstimator> rotation_estimator =
       CreateRotationEstimator(options);
+  if (rotation_estimator == nullptr) {
+    LOG(ERROR) << "Rotation estimator type is not supported!";
+    return false;
+  }
 
   InitializeGlobalRotations(options, global_rotations);
 
   std::unordered_map<ImagePair, TwoViewGeometry> view_pairs;
   ViewEdgesToViewPairs(&view_pairs);
+  if (options.sparsify_view_graph) {
+    SparsifyViewPairs(options.sparsification_options, &view_pairs);
+  }
 
   bool success =
       rotation_estimator->EstimateRotations(view_pairs, global_rotations);
@@ -122,9 +151,15 @@ bool ViewGraph::RotationAveraging(
 
 bool ViewGraph::TranslationAveraging(
     const PositionEstimatorOptions& options,
-    std::unordered_map<image_t, Eigen::Vector3d>* positions) {
+    std::unordered_map<image_t, Eigen::Vector3d>* positions,
+    solver::Summary* refinement_summary) {
+  GOPT_PROFILE_SCOPE("TranslationAveraging");
   std::unique_ptr<PositionEstimator> position_estimator =
       CreatePositionEstimator(options);
+  if (position_estimator == nullptr) {
+    LOG(ERROR) << "Position estimator type is not supported!";
+    return false;
+  }
 
   InitializeGlobalPositions(positions);
 
@@ -137,9 +172,54 @@ bool ViewGraph::TranslationAveraging(
     global_rotations[node_id] = node_iter.second.rotation;
   }
 
+  if (options.filter_relative_translations) {
+    TranslationFilterOptions filter_options;
+    filter_options.num_threads = options.num_threads;
+    filter_options.num_iterations = options.num_filter_iterations;
+    filter_options.translation_projection_tolerance =
+        options.translation_projection_tolerance;
+    const int num_removed_view_pairs = FilterViewPairsFromRelativeTranslation(
+        filter_options, global_rotations, &view_pairs);
+    LOG(INFO) << "1DSfM filter removed " << num_removed_view_pairs
+              << " view pairs.";
+  }
+
+  if (options.linear_initialization &&
+      options.estimator_type != PositionEstimatorType::LIGT) {
+    LiGTPositionEstimator::Options ligt_options;
+    ligt_options.num_threads = options.num_threads;
+    ligt_options.baseline_prior_weight = options.baseline_prior_weight;
+    LiGTPositionEstimator ligt_position_estimator(ligt_options);
+
+    std::unordered_map<image_t, Eigen::Vector3d> initial_positions;
+    if (ligt_position_estimator.EstimatePositions(
+            view_pairs, global_rotations, &initial_positions)) {
+      position_estimator->SetInitialPositions(initial_positions);
+    } else {
+      LOG(WARNING) << "Linear initialization of the positions failed.";
+    }
+  }
+
   bool success =
       position_estimator->EstimatePositions(view_pairs, global_rotations, positions);
 
+  if (success && options.nonlinear_refinement) {
+    NonlinearPositionRefiner::Options refiner_options;
+    refiner_options.num_threads = options.num_threads;
+    refiner_options.max_num_iterations = options.max_num_refinement_iterations;
+    refiner_options.residual_type = options.refinement_residual_type;
+    refiner_options.robust_loss_width = options.refinement_robust_loss_width;
+    NonlinearPositionRefiner position_refiner(refiner_options);
+    if (!position_refiner.RefinePositions(
+            view_pairs, global_rotations, positions)) {
+      LOG(WARNING) << "Nonlinear refinement of the positions failed, the "
+                      "estimated positions are kept.";
+    }
+    if (refinement_summary != nullptr) {
+      *refinement_summary = position_refiner.GetSummary();
+    }
+  }
+
   // Assing global positions to each node.
   if (success) {
     for (const auto& position_iter : *positions) {
@@ -147,8 +227,8 @@ bool ViewGraph::TranslationAveraging(
       nodes_[node_id].translation = position_iter.second;
     }
   }
-  
-  return true;
+
+  return success;
 }
 
 void ViewGraph::ViewEdgesToViewPairs(
@@ -174,6 +254,31 @@ void ViewGraph::ViewEdgesToViewPairs(
   }
 }
 
+void ViewGraph::SparsifyViewPairs(
+    const EdgeSparsificationOptions& options,
+    std::unordered_map<ImagePair, TwoViewGeometry>* view_pairs) const {
+  EdgeSparsificationSummary summary;
+  const Graph<ViewNode, ViewEdge> sparse_graph = Sparsify(options, &summary);
+  // Only the view pairs of the dropped edges are removed. The kept view pairs
+  // keep their visibility scores, which the partitioned and consensus ADMM
+  // estimators use as the weights of their normalized cuts, rather than the
+  // reweighted weights of the sampled edges.
+  for (auto it = view_pairs->begin(); it != view_pairs->end();) {
+    if (!sparse_graph.HasEdge(it->first.first, it->first.second) &&
+        !sparse_graph.HasEdge(it->first.second, it->first.first)) {
+      it = view_pairs->erase(it);
+    } else {
+      ++it;
+    }
+  }
+  LOG(INFO) << "The sparsified view graph keeps " << summary.num_kept_edges
+            << " of " << summary.num_edges << " view pairs ("
+            << summary.num_spanning_tree_edges
+            << " of the maximum spanning tree) and "
+            << 100.0 * summary.kept_weight_ratio << "% of the weight, in "
+            << summary.elapsed_seconds << " s.";
+}
+
 void ViewGraph::InitializeGlobalRotations(
     const RotationEstimatorOptions& options,
     std::unordered_map<image_t, Eigen::Vector3d>* global_rotations) {
@@ -201,7 +306,73 @@ void ViewGraph::InitializeGlobalRotationsRandomly(
 
 void ViewGraph::InitializeGlobalRotationsFromMST(
     std::unordered_map<image_t, Eigen::Vector3d>* global_rotations) {
-  // TODO(chenyu): implementation here.
+  GOPT_PROFILE_SCOPE("InitializeGlobalRotationsFromMST");
+  std::vector<node_t> node_ids;
+  node_ids.reserve(nodes_.size());
+  for (const auto& node_iter : nodes_) {
+    node_ids.push_back(node_iter.first);
+  }
+  std::sort(node_ids.begin(), node_ids.end());
+
+  // The edges by descending weight, with ties broken by the node ids.
+  std::vector<const ViewEdge*> view_edges;
+  for (const auto& edge_iter : edges_) {
+    for (const auto& em_iter : edge_iter.second) {
+      view_edges.push_back(&em_iter.second);
+    }
+  }
+  std::sort(view_edges.begin(), view_edges.end(),
+            [](const ViewEdge* edge1, const ViewEdge* edge2) {
+              if (edge1->weight != edge2->weight) {
+                return edge1->weight > edge2->weight;
+              }
+              return std::make_pair(edge1->src, edge1->dst) <
+                     std::make_pair(edge2->src, edge2->dst);
+            });
+
+  // Kruskal's algorithm, where each tree edge stores the relative rotation
+  // R_ij = R_j * R_i^t towards both of its nodes.
+  UnionFind union_find(node_ids.size());
+  union_find.InitWithNodes(node_ids);
+  std::unordered_map<node_t, std::vector<std::pair<node_t, Eigen::Vector3d>>>
+      tree_neighbors;
+  for (const ViewEdge* view_edge : view_edges) {
+    const size_t root1 = union_find.FindRoot(view_edge->src);
+    const size_t root2 = union_find.FindRoot(view_edge->dst);
+    if (root1 == root2) {
+      continue;
+    }
+    union_find.Union(view_edge->src, view_edge->dst);
+    tree_neighbors[view_edge->src].emplace_back(view_edge->dst,
+                                                view_edge->rotation_2);
+    tree_neighbors[view_edge->dst].emplace_back(view_edge->src,
+                                                -view_edge->rotation_2);
+  }
+
+  // The rotations are chained along the tree from the node with the smallest
+  // id of each connected component, whose rotation is the identity.
+  global_rotations->clear();
+  std::queue<node_t> queue;
+  for (const node_t root : node_ids) {
+    if (ContainsKey(*global_rotations, root)) {
+      continue;
+    }
+    (*global_rotations)[root] = Eigen::Vector3d::Zero();
+    queue.push(root);
+    while (!queue.empty()) {
+      const node_t node_id = queue.front();
+      queue.pop();
+      const Eigen::Vector3d rotation = FindOrDie(*global_rotations, node_id);
+      for (const auto& neighbor : tree_neighbors[node_id]) {
+        if (ContainsKey(*global_rotations, neighbor.first)) {
+          continue;
+        }
+        (*global_rotations)[neighbor.first] =
+            geometry::ApplyRelativeRotation(rotation, neighbor.second);
+        queue.push(neighbor.first);
+      }
+    }
+  }
 }
 
 void ViewGraph::InitializeGlobalPositions(
@@ -213,11 +384,16 @@ void ViewGraph::InitializeGlobalPositions(
 
 std::unique_ptr<RotationEstimator> ViewGraph::CreateRotationEstimator(
     const RotationEstimatorOptions& options) {
+  return CreateRotationEstimator(options, size_);
+}
+
+std::unique_ptr<RotationEstimator> ViewGraph::CreateRotationEstimator(
+    const RotationEstimatorOptions& options, const int num_views) {
   std::unique_ptr<RotationEstimator> rotation_estimator = nullptr;
   switch (options.estimator_type) {
     case GlobalRotationEstimatorType::LAGRANGIAN_DUAL: {
       rotation_estimator.reset(new LagrangeDualRotationEstimator(
-          size_, 3, options.sdp_solver_options));
+          num_views, 3, options.sdp_solver_options));
       break;
     }
     case GlobalRotationEstimatorType::HYBRID: {
@@ -225,7 +401,7 @@ std::unique_ptr<RotationEstimator> ViewGraph::CreateRotationEstimator(
       hybrid_options.sdp_solver_options = options.sdp_solver_options;
       hybrid_options.irls_options = options.irls_options;
       rotation_estimator.reset(
-          new HybridRotationEstimator(size_, 3, hybrid_options));
+          new HybridRotationEstimator(num_views, 3, hybrid_options));
       break;
     }
     case GlobalRotationEstimatorType::ROBUST_L1L2: {
@@ -237,10 +413,38 @@ std::unique_ptr<RotationEstimator> ViewGraph::CreateRotationEstimator(
           new RobustL1L2RotationEstimator(robust_l1l2_options));
       break;
     }
+#ifdef CONSENSUS_ADMM_ENABLED
+    case GlobalRotationEstimatorType::CONSENSUS_ADMM: {
+      ConsensusADMMRotationEstimator::Options admm_options;
+      admm_options.num_workers = options.num_admm_workers;
+      if (options.max_cluster_size > 0) {
+        admm_options.max_cluster_size = options.max_cluster_size;
+      }
+      admm_options.linear_solver_options =
+          options.irls_options.linear_solver_options;
+      return std::unique_ptr<RotationEstimator>(
+          new ConsensusADMMRotationEstimator(admm_options));
+    }
+#endif
     default:
       break;
   }
 
+  if (rotation_estimator != nullptr && options.max_cluster_size > 0) {
+    PartitionedRotationEstimator::Options partitioned_options;
+    partitioned_options.num_threads = options.irls_options.num_threads;
+    partitioned_options.max_cluster_size = options.max_cluster_size;
+    partitioned_options.irls_options = options.irls_options;
+
+    // The clusters and their alignment are solved by the same estimator
+    // without partitioning.
+    RotationEstimatorOptions cluster_options = options;
+    cluster_options.max_cluster_size = 0;
+    rotation_estimator.reset(new PartitionedRotationEstimator(
+        partitioned_options, [this, cluster_options](const int num_views) {
+          return CreateRotationEstimator(cluster_options, num_views);
+        }));
+  }
   return rotation_estimator;
 }
 
@@ -250,6 +454,7 @@ std::unique_ptr<PositionEstimator> ViewGraph::CreatePositionEstimator(
   switch (options.estimator_type) {
     case PositionEstimatorType::LUD: {
       LUDPositionEstimator::Options lud_options;
+      lud_options.num_threads = options.num_threads;
       lud_options.max_num_iterations = options.max_num_iterations;
       lud_options.max_num_reweighted_iterations = options.max_num_reweighted_iterations;
       lud_options.convergence_criterion = options.convergence_criterion;
@@ -257,12 +462,39 @@ std::unique_ptr<PositionEstimator> ViewGraph::CreatePositionEstimator(
       break;
     }
     case PositionEstimatorType::BATA: {
-      // TODO(chenyu): implement BATA position estimator.
+      BATAPositionEstimator::Options bata_options;
+      bata_options.num_threads = options.num_threads;
+      bata_options.max_num_iterations = options.bata_max_num_iterations;
+      bata_options.convergence_criterion = options.convergence_criterion;
+      bata_options.robust_loss_width = options.robust_loss_width;
+      position_estimator.reset(new BATAPositionEstimator(bata_options));
+      break;
+    }
+    case PositionEstimatorType::LIGT: {
+      LiGTPositionEstimator::Options ligt_options;
+      ligt_options.num_threads = options.num_threads;
+      ligt_options.baseline_prior_weight = options.baseline_prior_weight;
+      position_estimator.reset(new LiGTPositionEstimator(ligt_options));
       break;
     }
     default:
       break;
   }
+
+  if (position_estimator != nullptr && options.max_cluster_size > 0) {
+    PartitionedPositionEstimator::Options partitioned_options;
+    partitioned_options.num_threads = options.num_threads;
+    partitioned_options.max_cluster_size = options.max_cluster_size;
+    partitioned_options.overlap_ratio = options.cluster_overlap_ratio;
+
+    // The clusters are solved by the same estimator without partitioning.
+    PositionEstimatorOptions cluster_options = options;
+    cluster_options.max_cluster_size = 0;
+    position_estimator.reset(new PartitionedPositionEstimator(
+        partitioned_options, [this, cluster_options]() {
+          return CreatePositionEstimator(cluster_options);
+        }));
+  }
   return position_estimator;
 }
 
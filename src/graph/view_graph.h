@@ -9,6 +9,7 @@
 #include "graph/edge.h"
 
 #include "rotation_averaging/rotation_estimator.h"
+#include "solver/summary.h"
 #include "translation_averaging/position_estimator.h"
 
 namespace gopt {
@@ -32,9 +33,13 @@ class ViewGraph : public Graph<ViewNode, ViewEdge> {
       const RotationEstimatorOptions& options,
       std::unordered_map<image_t, Eigen::Vector3d>* global_rotations);
 
+  // If the nonlinear refinement is enabled and refinement_summary is not
+  // null, the number of iterations and the time of the refinement are
+  // returned in it.
   bool TranslationAveraging(
       const PositionEstimatorOptions& options,
-      std::unordered_map<image_t, Eigen::Vector3d>* positions);
+      std::unordered_map<image_t, Eigen::Vector3d>* positions,
+      solver::Summary* refinement_summary = nullptr);
 
   bool ReadG2OFile(const std::string &filename);
 
@@ -42,6 +47,12 @@ class ViewGraph : public Graph<ViewNode, ViewEdge> {
   void ViewEdgesToViewPairs(
     std::unordered_map<ImagePair, TwoViewGeometry>* view_pairs);
 
+  // Removes the view pairs whose edges are dropped by the sparsification of
+  // the view graph. The kept view pairs are not changed.
+  void SparsifyViewPairs(
+      const EdgeSparsificationOptions& options,
+      std::unordered_map<ImagePair, TwoViewGeometry>* view_pairs) const;
+
   void InitializeGlobalRotations(
       const RotationEstimatorOptions& options,
       std::unordered_map<image_t, Eigen::Vector3d>* global_rotations);
@@ -55,6 +66,8 @@ class ViewGraph : public Graph<ViewNode, ViewEdge> {
   
   std::unique_ptr<RotationEstimator> CreateRotationEstimator(
       const RotationEstimatorOptions& options);
+  std::unique_ptr<RotationEstimator> CreateRotationEstimator(
+      const RotationEstimatorOptions& options, const int num_views);
 
   std::unique_ptr<PositionEstimator> CreatePositionEstimator(
       const PositionEstimatorOptions& options);
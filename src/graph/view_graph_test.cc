@@ -0,0 +1,68 @@
+#include "graph/view_graph.h"
+
+#include <unordered_map>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <gtest/gtest.h>
+
+#include "geometry/rotation_utils.h"
+#include "rotation_averaging/test_util.h"
+
+namespace gopt {
+namespace graph {
+
+class ViewGraphTest : public RotationAveragingTest {
+ protected:
+  ViewGraph view_graph_;
+
+ public:
+  ViewGraphTest() : RotationAveragingTest(73) {}
+
+  void TestConsensusADMMRotationAveraging(
+      const GlobalRotationEstimatorInitMethod init_method) {
+    CreateGTRotations(200);
+    CreateViewEdges(4, 1.0);
+
+    RotationEstimatorOptions options;
+    options.estimator_type = GlobalRotationEstimatorType::CONSENSUS_ADMM;
+    options.init_method = init_method;
+    options.num_admm_workers = 2;
+    options.max_cluster_size = 50;
+
+    std::unordered_map<image_t, Eigen::Vector3d> estimated_rotations;
+    ASSERT_TRUE(view_graph_.RotationAveraging(options, &estimated_rotations));
+    ASSERT_EQ(estimated_rotations.size(), rotations_.size());
+    EXPECT_LT(geometry::ComputeMeanRotationErrorDegrees(rotations_,
+                                                        estimated_rotations),
+              1.0);
+  }
+
+  // Adds the view pairs of the sequence to the view graph as edges.
+  void CreateViewEdges(const int num_neighbors,
+                       const double rotation_noise_degrees) {
+    CreateRelativeRotations(num_neighbors, rotation_noise_degrees);
+    for (const auto& view_pair : view_pairs_) {
+      ViewEdge edge;
+      edge.src = view_pair.first.first;
+      edge.dst = view_pair.first.second;
+      edge.rotation_2 = view_pair.second.rotation_2;
+      edge.translation_2.setZero();
+      view_graph_.AddEdge(edge);
+    }
+  }
+};
+
+#ifdef CONSENSUS_ADMM_ENABLED
+TEST_F(ViewGraphTest, ConsensusADMMRotationAveragingFromSpanningTree) {
+  TestConsensusADMMRotationAveraging(
+      GlobalRotationEstimatorInitMethod::MAXIMUM_SPANNING_TREE);
+}
+
+TEST_F(ViewGraphTest, ConsensusADMMRotationAveragingFromIdentity) {
+  TestConsensusADMMRotationAveraging(GlobalRotationEstimatorInitMethod::RANDOM);
+}
+#endif
+
+}  // namespace graph
+}  // namespace gopt
@@ -0,0 +1,105 @@
+#include "math/selected_inversion.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "util/profiler.h"
+
+namespace gopt {
+
+void ComputeSelectedInverse(const Eigen::SparseMatrix<double>& L,
+                            Eigen::SparseMatrix<double>* inverse) {
+  GOPT_PROFILE_SCOPE("SelectedInverse");
+  CHECK_NOTNULL(inverse);
+  CHECK_EQ(L.rows(), L.cols());
+  CHECK(L.isCompressed());
+
+  *inverse = L;
+  const int num_cols = L.cols();
+  const int* outer_indices = L.outerIndexPtr();
+  const int* inner_indices = L.innerIndexPtr();
+  const double* l = L.valuePtr();
+  double* z = inverse->valuePtr();
+
+  // sum_{k > j} L_kj * Z_ik for the rows i > j of column j.
+  std::vector<double> sums;
+  for (int j = num_cols - 1; j >= 0; j--) {
+    const int diagonal_index = outer_indices[j];
+    const int begin = diagonal_index + 1;
+    const int num_rows = outer_indices[j + 1] - begin;
+    CHECK(num_rows >= 0 && inner_indices[diagonal_index] == j)
+        << "The diagonal of column " << j << " is not its first entry.";
+    const double l_jj = l[diagonal_index];
+
+    // Z_ik for the rows i >= k of column j is the entry of row i of column k,
+    // which was computed before. The symmetric entries Z_ki are added at the
+    // same time.
+    sums.assign(num_rows, 0.0);
+    for (int a = 0; a < num_rows; a++) {
+      const int k = inner_indices[begin + a];
+      const int* position = inner_indices + outer_indices[k];
+      const int* column_end = inner_indices + outer_indices[k + 1];
+      for (int b = a; b < num_rows; b++) {
+        const int i = inner_indices[begin + b];
+        position = std::lower_bound(position, column_end, i);
+        CHECK(position != column_end && *position == i)
+            << "Entry (" << i << ", " << k << ") is not in the pattern of the "
+            << "factor.";
+        const double z_ik = z[position - inner_indices];
+        sums[b] += l[begin + a] * z_ik;
+        if (b != a) {
+          sums[a] += l[begin + b] * z_ik;
+        }
+      }
+    }
+
+    double z_jj = 1.0 / l_jj;
+    for (int b = 0; b < num_rows; b++) {
+      z[begin + b] = -sums[b] / l_jj;
+      z_jj -= l[begin + b] * z[begin + b];
+    }
+    z[diagonal_index] = z_jj / l_jj;
+  }
+}
+
+void ComputeSelectedInverse(const Eigen::SparseMatrix<double>& L,
+                            const Eigen::VectorXi& permutation,
+                            Eigen::SparseMatrix<double>* inverse) {
+  CHECK_NOTNULL(inverse);
+  CHECK_EQ(permutation.size(), L.cols());
+
+  Eigen::SparseMatrix<double> permuted_inverse;
+  ComputeSelectedInverse(L, &permuted_inverse);
+
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.reserve(permuted_inverse.nonZeros());
+  for (int k = 0; k < permuted_inverse.outerSize(); k++) {
+    const int col = permutation(k);
+    for (Eigen::SparseMatrix<double>::InnerIterator it(permuted_inverse, k);
+         it; ++it) {
+      const int row = permutation(it.row());
+      triplets.emplace_back(std::max(row, col), std::min(row, col),
+                            it.value());
+    }
+  }
+  inverse->resize(L.rows(), L.cols());
+  inverse->setFromTriplets(triplets.begin(), triplets.end());
+}
+
+Eigen::MatrixXd GetSymmetricBlock(const Eigen::SparseMatrix<double>& lower,
+                                  const int row, const int col,
+                                  const int num_rows, const int num_cols) {
+  Eigen::MatrixXd block(num_rows, num_cols);
+  for (int c = 0; c < num_cols; c++) {
+    for (int r = 0; r < num_rows; r++) {
+      const int i = row + r;
+      const int j = col + c;
+      block(r, c) = i >= j ? lower.coeff(i, j) : lower.coeff(j, i);
+    }
+  }
+  return block;
+}
+
+}  // namespace gopt
@@ -0,0 +1,44 @@
+#ifndef MATH_SELECTED_INVERSION_H_
+#define MATH_SELECTED_INVERSION_H_
+
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+
+namespace gopt {
+
+// Computes the entries of the inverse Z = (L * L^t)^{-1} on the sparsity
+// pattern of the sparse Cholesky factor L by the Takahashi recursion
+//
+//   Z_jj = (1 / L_jj - sum_{k > j} L_kj * Z_kj) / L_jj,
+//   Z_ij = -(sum_{k > j} L_kj * Z_ik) / L_jj,       i > j,
+//
+// where the sums run over the non-zeros of column j of L. The columns are
+// computed from the last to the first, and the rows of each column of L form a
+// clique of the pattern of L, so only entries on the pattern are ever needed.
+// The cost is of the order of the flops of the factorization, and no dense
+// inverse is formed.
+//
+// L has to be lower triangular and compressed, with the rows of each column
+// sorted and the diagonal as the first entry of each column, e.g. a simplicial
+// factor of CHOLMOD or Eigen. inverse is the lower triangle of Z with the
+// pattern of L.
+void ComputeSelectedInverse(const Eigen::SparseMatrix<double>& L,
+                            Eigen::SparseMatrix<double>* inverse);
+
+// The same for the factor L * L^t = mat(p, p) of a matrix mat with the
+// fill-reducing permutation p, where p(k) is the row of mat of the k-th row of
+// L. inverse is the lower triangle of the entries of mat^{-1} on the permuted
+// pattern of L + L^t, which contains the pattern of mat.
+void ComputeSelectedInverse(const Eigen::SparseMatrix<double>& L,
+                            const Eigen::VectorXi& permutation,
+                            Eigen::SparseMatrix<double>* inverse);
+
+// Returns the block of the symmetric matrix whose lower triangle is lower.
+// Entries outside the pattern of lower are returned as zero.
+Eigen::MatrixXd GetSymmetricBlock(const Eigen::SparseMatrix<double>& lower,
+                                  const int row, const int col,
+                                  const int num_rows, const int num_cols);
+
+}  // namespace gopt
+
+#endif  // MATH_SELECTED_INVERSION_H_
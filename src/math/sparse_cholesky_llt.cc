@@ -1,12 +1,15 @@
 #include "math/sparse_cholesky_llt.h"
 
+#include <algorithm>
+#include <limits>
+
 #include <cholmod.h>
 #include <glog/logging.h>
 
 #include <Eigen/Core>
 #include <Eigen/SparseCore>
 
-#include "util/timer.h"
+#include "util/profiler.h"
 
 // UF_long is deprecated but SuiteSparse_long is only available in
 // newer versions of SuiteSparse. So for older versions of
@@ -19,9 +22,15 @@
 namespace gopt {
 namespace {
 
-cholmod_sparse ViewAsCholmod(const Eigen::SparseMatrix<double>& const_mat) {
-  Eigen::SparseMatrix<double>& mat =
-      const_cast<Eigen::SparseMatrix<double>&>(const_mat);
+// The index type of the matrix must match the CHOLMOD interface the view is
+// passed to, i.e. int for cholmod_* and SuiteSparse_long for cholmod_l_*.
+template <typename StorageIndex>
+cholmod_sparse ViewAsCholmod(
+    const Eigen::SparseMatrix<double, Eigen::ColMajor, StorageIndex>&
+        const_mat) {
+  Eigen::SparseMatrix<double, Eigen::ColMajor, StorageIndex>& mat =
+      const_cast<Eigen::SparseMatrix<double, Eigen::ColMajor, StorageIndex>&>(
+          const_mat);
   cholmod_sparse res;
   res.nzmax = mat.nonZeros();
   res.nrow = mat.rows();
@@ -39,24 +48,65 @@ cholmod_sparse ViewAsCholmod(const Eigen::SparseMatrix<double>& const_mat) {
 
   // Set to 0 if the matrix is not symmetric.
   res.stype = 1;
-  res.itype = CHOLMOD_INT;
+  res.itype = sizeof(StorageIndex) == sizeof(SuiteSparse_long) ? CHOLMOD_LONG
+                                                               : CHOLMOD_INT;
   res.xtype = CHOLMOD_REAL;
   res.dtype = CHOLMOD_DOUBLE;
   return res;
 }
 
-cholmod_dense ViewAsCholmod(const Eigen::VectorXd& const_vec) {
-  Eigen::VectorXd& vec = const_cast<Eigen::VectorXd&>(const_vec);
+// Views the column major matrix data with leading dimension num_rows as a
+// CHOLMOD dense matrix.
+cholmod_dense ViewAsCholmod(double* data, const int num_rows,
+                            const int num_cols) {
   cholmod_dense res;
-  res.nrow = vec.rows();
-  res.ncol = vec.cols();
+  res.nrow = num_rows;
+  res.ncol = num_cols;
   res.nzmax = res.nrow * res.ncol;
-  res.d = vec.size();
-  res.x = reinterpret_cast<void*>(vec.data());
+  res.d = num_rows;
+  res.x = reinterpret_cast<void*>(data);
   res.z = 0;
   res.xtype = CHOLMOD_REAL;
+  res.dtype = CHOLMOD_DOUBLE;
   return res;
 }
+
+// Copies the packed simplicial LL^t factor with the index type StorageIndex.
+template <typename StorageIndex>
+bool CopySimplicialFactor(const cholmod_factor& factor,
+                          Eigen::SparseMatrix<double>* L,
+                          Eigen::VectorXi* permutation) {
+  const StorageIndex* column_pointers =
+      reinterpret_cast<const StorageIndex*>(factor.p);
+  const StorageIndex* row_indices =
+      reinterpret_cast<const StorageIndex*>(factor.i);
+  const double* values = reinterpret_cast<const double*>(factor.x);
+  const StorageIndex* perm = reinterpret_cast<const StorageIndex*>(factor.Perm);
+  const int num_cols = factor.n;
+  const StorageIndex num_nonzeros = column_pointers[num_cols];
+  if (num_nonzeros > std::numeric_limits<int>::max()) {
+    LOG(ERROR) << "The factor has too many non-zeros for 32-bit indices.";
+    return false;
+  }
+
+  Eigen::SparseMatrix<double> factor_copy(num_cols, num_cols);
+  factor_copy.resizeNonZeros(num_nonzeros);
+  std::copy(column_pointers, column_pointers + num_cols + 1,
+            factor_copy.outerIndexPtr());
+  std::copy(row_indices, row_indices + num_nonzeros,
+            factor_copy.innerIndexPtr());
+  std::copy(values, values + num_nonzeros, factor_copy.valuePtr());
+  // CHOLMOD keeps the diagonal first, but the other rows are not necessarily
+  // sorted after updates. Transposing twice sorts them.
+  const Eigen::SparseMatrix<double> factor_transpose = factor_copy.transpose();
+  *L = factor_transpose.transpose();
+
+  permutation->resize(num_cols);
+  for (int k = 0; k < num_cols; k++) {
+    (*permutation)(k) = perm[k];
+  }
+  return true;
+}
 }  // namespace
 
 // A class for performing the choleksy decomposition of a sparse matrix using
@@ -65,74 +115,250 @@ cholmod_dense ViewAsCholmod(const Eigen::VectorXd& const_vec) {
 // linear solver interface except that it is not templated and requires sparse
 // matrices.
 SparseCholeskyLLt::SparseCholeskyLLt(const Eigen::SparseMatrix<double>& mat)
-    : cholmod_factor_(nullptr),
-      is_factorization_ok_(false),
-      is_analysis_ok_(false),
-      info_(Eigen::Success) {
-  cholmod_start(&cc_);
-  cc_.useGPU = 1;
+    : SparseCholeskyLLt(SparseCholeskyLLtOptions()) {
   Compute(mat);
 }
 
 SparseCholeskyLLt::SparseCholeskyLLt()
-    : cholmod_factor_(nullptr),
+    : SparseCholeskyLLt(SparseCholeskyLLtOptions()) {}
+
+SparseCholeskyLLt::SparseCholeskyLLt(const SparseCholeskyLLtOptions& options)
+    : options_(options),
+      use_long_(false),
+      cholmod_factor_(nullptr),
+      solution_(nullptr),
+      solve_workspace_y_(nullptr),
+      solve_workspace_e_(nullptr),
       is_factorization_ok_(false),
       is_analysis_ok_(false),
       info_(Eigen::Success) {
-  cholmod_start(&cc_);
-  cc_.useGPU = 1;
+  StartCommon(options_.index_type == CholeskyIndexType::INT64);
 }
 
-SparseCholeskyLLt::~SparseCholeskyLLt() {
-  if (cholmod_factor_ != nullptr) {
+SparseCholeskyLLt::~SparseCholeskyLLt() { FinishCommon(); }
+
+void SparseCholeskyLLt::StartCommon(const bool use_long) {
+  use_long_ = use_long;
+  if (use_long_) {
+    cholmod_l_start(&cc_);
+  } else {
+    cholmod_start(&cc_);
+  }
+
+  cc_.useGPU = options_.use_gpu;
+
+  if (options_.num_threads > 0) {
+#if defined(CHOLMOD_MAIN_VERSION) && CHOLMOD_MAIN_VERSION >= 4
+    cc_.nthreads_max = options_.num_threads;
+#else
+    VLOG(2) << "The number of threads of CHOLMOD can only be set since "
+               "CHOLMOD 4, it is left to the BLAS.";
+#endif
+  }
+
+  // Cholmod can try multiple re-ordering strategies to find a fill reducing
+  // ordering, and keeps the one with the least fill.
+  switch (options_.ordering_type) {
+    case CholeskyOrderingType::AMD:
+      cc_.nmethods = 1;
+      cc_.method[0].ordering = CHOLMOD_AMD;
+      break;
+    case CholeskyOrderingType::COLAMD:
+      cc_.nmethods = 1;
+      cc_.method[0].ordering = CHOLMOD_COLAMD;
+      break;
+    case CholeskyOrderingType::METIS:
+      cc_.nmethods = 1;
+      cc_.method[0].ordering = CHOLMOD_METIS;
+      break;
+    case CholeskyOrderingType::NESDIS:
+      cc_.nmethods = 1;
+      cc_.method[0].ordering = CHOLMOD_NESDIS;
+      break;
+    case CholeskyOrderingType::BEST:
+      cc_.nmethods = 3;
+      cc_.method[0].ordering = CHOLMOD_AMD;
+      cc_.method[1].ordering = CHOLMOD_METIS;
+      cc_.method[2].ordering = CHOLMOD_NESDIS;
+      break;
+  }
+
+  switch (options_.factorization_type) {
+    case CholeskyFactorizationType::AUTO:
+      cc_.supernodal = CHOLMOD_AUTO;
+      break;
+    case CholeskyFactorizationType::SIMPLICIAL:
+      cc_.supernodal = CHOLMOD_SIMPLICIAL;
+      break;
+    case CholeskyFactorizationType::SUPERNODAL:
+      cc_.supernodal = CHOLMOD_SUPERNODAL;
+      break;
+  }
+}
+
+void SparseCholeskyLLt::FinishCommon() {
+  if (use_long_) {
+    cholmod_l_free_factor(&cholmod_factor_, &cc_);
+    cholmod_l_free_dense(&solution_, &cc_);
+    cholmod_l_free_dense(&solve_workspace_y_, &cc_);
+    cholmod_l_free_dense(&solve_workspace_e_, &cc_);
+    cholmod_l_finish(&cc_);
+  } else {
     cholmod_free_factor(&cholmod_factor_, &cc_);
+    cholmod_free_dense(&solution_, &cc_);
+    cholmod_free_dense(&solve_workspace_y_, &cc_);
+    cholmod_free_dense(&solve_workspace_e_, &cc_);
+    cholmod_finish(&cc_);
   }
-  cholmod_finish(&cc_);
+  is_analysis_ok_ = false;
+  is_factorization_ok_ = false;
+}
+
+bool SparseCholeskyLLt::ShouldSwitchToLongIndices() const {
+  return !use_long_ && options_.index_type == CholeskyIndexType::AUTO &&
+         (cc_.status == CHOLMOD_TOO_LARGE ||
+          (cc_.status == CHOLMOD_OK &&
+           cc_.lnz > options_.max_int32_factor_nonzeros));
+}
+
+bool SparseCholeskyLLt::UsesLongIndices() const { return use_long_; }
+
+void SparseCholeskyLLt::SetSymbolicFactorizationCache(
+    const std::shared_ptr<SymbolicFactorizationCache>& cache) {
+  symbolic_factorization_cache_ = cache;
 }
 
 void SparseCholeskyLLt::AnalyzePattern(const Eigen::SparseMatrix<double>& mat) {
-  // Release the current decomposition if there is one.
-  if (cholmod_factor_ != nullptr) {
+  GOPT_PROFILE_SCOPE("CholeskyAnalyze");
+  if (!use_long_) {
+    // Release the current decomposition if there is one.
     cholmod_free_factor(&cholmod_factor_, &cc_);
+
+    if (symbolic_factorization_cache_ != nullptr) {
+      cholmod_factor_ = symbolic_factorization_cache_->Find(mat, &cc_);
+      if (cholmod_factor_ != nullptr) {
+        is_analysis_ok_ = true;
+        is_factorization_ok_ = false;
+        info_ = Eigen::Success;
+        return;
+      }
+    }
+
+    // Get the cholmod view of the sparse matrix.
+    cholmod_sparse A = ViewAsCholmod(mat);
+    AnalyzeCholmod(&A);
+    if (!ShouldSwitchToLongIndices()) {
+      if (info_ == Eigen::Success && symbolic_factorization_cache_ != nullptr) {
+        symbolic_factorization_cache_->Insert(mat, cholmod_factor_, &cc_);
+      }
+      return;
+    }
+
+    LOG(INFO) << "The Cholesky factor of the " << mat.rows() << "x"
+              << mat.cols() << " matrix has " << cc_.lnz
+              << " non-zeros, switching to 64-bit indices.";
+    FinishCommon();
+    StartCommon(true);
   }
 
-  // Get the cholmod view of the sparse matrix.
+  long_mat_ = mat;
+  cholmod_sparse A = ViewAsCholmod(long_mat_);
+  AnalyzeCholmod(&A);
+}
+
+void SparseCholeskyLLt::AnalyzePattern(const LongSparseMatrix& mat) {
+  GOPT_PROFILE_SCOPE("CholeskyAnalyze");
+  if (!use_long_) {
+    FinishCommon();
+    StartCommon(true);
+  }
   cholmod_sparse A = ViewAsCholmod(mat);
+  AnalyzeCholmod(&A);
+}
 
-  // Cholmod can try multiple re-ordering strategies to find a fill
-  // reducing ordering. Here we just tell it use AMD with automatic
-  // matrix dependence choice of supernodal versus simplicial
-  // factorization.
-  cc_.nmethods = 1;
-  cc_.method[0].ordering = CHOLMOD_AMD;
-  cc_.supernodal = CHOLMOD_AUTO;
+void SparseCholeskyLLt::AnalyzeCholmod(cholmod_sparse* A) {
+  // Release the current decomposition if there is one.
+  if (use_long_) {
+    cholmod_l_free_factor(&cholmod_factor_, &cc_);
+  } else {
+    cholmod_free_factor(&cholmod_factor_, &cc_);
+  }
+  is_analysis_ok_ = false;
+  is_factorization_ok_ = false;
 
   // Perform symbolic analysis of the matrix.
-  cholmod_factor_ = cholmod_analyze(&A, &cc_);
+  if (use_long_) {
+    cholmod_factor_ = cholmod_l_analyze(A, &cc_);
+  } else {
+    cholmod_factor_ = cholmod_analyze(A, &cc_);
+  }
   if (VLOG_IS_ON(2)) {
-    cholmod_print_common(const_cast<char*>("Symbolic Analysis"), &cc_);
+    if (use_long_) {
+      cholmod_l_print_common(const_cast<char*>("Symbolic Analysis"), &cc_);
+    } else {
+      cholmod_print_common(const_cast<char*>("Symbolic Analysis"), &cc_);
+    }
   }
 
+  if (cc_.status == CHOLMOD_NOT_INSTALLED) {
+    LOG(ERROR) << "CHOLMOD failure: The ordering is not installed, CHOLMOD "
+                  "was probably built without METIS.";
+    info_ = Eigen::InvalidInput;
+    return;
+  }
   if (cc_.status != CHOLMOD_OK) {
-    VLOG(2) << "cholmod_analyze failed. error code: %d" << cc_.status;
+    VLOG(2) << "cholmod_analyze failed. error code: " << cc_.status;
     info_ = Eigen::NumericalIssue;
     return;
   }
 
   is_analysis_ok_ = true;
-  is_factorization_ok_ = false;
   info_ = Eigen::Success;
 }
 
 void SparseCholeskyLLt::Factorize(const Eigen::SparseMatrix<double>& mat) {
+  GOPT_PROFILE_SCOPE("CholeskyFactorize");
+  if (!use_long_) {
+    cholmod_sparse A = ViewAsCholmod(mat);
+    FactorizeCholmod(&A);
+    if (info_ == Eigen::Success || !ShouldSwitchToLongIndices()) {
+      return;
+    }
+
+    // The numeric factor overflowed 32-bit indices, so the analysis has to be
+    // redone with 64-bit indices.
+    LOG(INFO) << "The Cholesky factor of the " << mat.rows() << "x"
+              << mat.cols() << " matrix is too large for 32-bit indices, "
+              << "switching to 64-bit indices.";
+    FinishCommon();
+    StartCommon(true);
+    long_mat_ = mat;
+    cholmod_sparse long_A = ViewAsCholmod(long_mat_);
+    AnalyzeCholmod(&long_A);
+    if (info_ != Eigen::Success) {
+      return;
+    }
+  } else {
+    long_mat_ = mat;
+  }
+
+  cholmod_sparse A = ViewAsCholmod(long_mat_);
+  FactorizeCholmod(&A);
+}
+
+void SparseCholeskyLLt::Factorize(const LongSparseMatrix& mat) {
+  GOPT_PROFILE_SCOPE("CholeskyFactorize");
+  CHECK(use_long_) << "Cannot call Factorize() with 64-bit indices after "
+                      "analyzing a matrix with 32-bit indices.";
+  cholmod_sparse A = ViewAsCholmod(mat);
+  FactorizeCholmod(&A);
+}
+
+void SparseCholeskyLLt::FactorizeCholmod(cholmod_sparse* A) {
   CHECK_NOTNULL(cholmod_factor_);
   CHECK(is_analysis_ok_) << "Cannot call Factorize() because symbolic analysis "
                             "of the matrix (i.e. AnalyzePattern()) failed!";
-  Timer timer;
-  timer.Start();
-  cholmod_sparse A = ViewAsCholmod(mat);
-  timer.Pause();
-  // LOG(INFO) << "ViewAsCholmod took: " << timer.ElapsedSeconds() << " s.";
+  is_factorization_ok_ = false;
 
   // Save the current print level and silence CHOLMOD, otherwise
   // CHOLMOD is prone to dumping stuff to stderr, which can be
@@ -142,10 +368,9 @@ void SparseCholeskyLLt::Factorize(const Eigen::SparseMatrix<double>& mat) {
   cc_.print = 0;
 
   cc_.quick_return_if_not_posdef = 1;
-  timer.Start();
-  int cholmod_status = cholmod_factorize(&A, cholmod_factor_, &cc_);
-  timer.Pause();
-  // LOG(INFO) << "Cholmod factorize took: " << timer.ElapsedSeconds() << " s.";
+  const int cholmod_status = use_long_
+                                 ? cholmod_l_factorize(A, cholmod_factor_, &cc_)
+                                 : cholmod_factorize(A, cholmod_factor_, &cc_);
   cc_.print = old_print_level;
 
   // TODO(sameeragarwal): This switch statement is not consistent. It
@@ -200,41 +425,200 @@ void SparseCholeskyLLt::Factorize(const Eigen::SparseMatrix<double>& mat) {
   }
 }
 
+bool SparseCholeskyLLt::UpdateDowndate(const bool update,
+                                       const Eigen::SparseMatrix<double>& C) {
+  GOPT_PROFILE_SCOPE("CholeskyUpdateDowndate");
+  CHECK_NOTNULL(cholmod_factor_);
+  CHECK(is_factorization_ok_)
+      << "Cannot call UpdateDowndate() because numeric factorization "
+         "of the matrix (i.e. Factorize()) failed!";
+  CHECK_EQ(C.rows(), static_cast<int>(cholmod_factor_->n));
+  if (C.cols() == 0) {
+    return true;
+  }
+
+  LongSparseMatrix long_C;
+  cholmod_sparse C_view;
+  if (use_long_) {
+    long_C = C;
+    C_view = ViewAsCholmod(long_C);
+  } else {
+    C_view = ViewAsCholmod(C);
+  }
+  // C is not symmetric.
+  C_view.stype = 0;
+
+  // cholmod_updown() expects the rows of C to be permuted by the fill-reducing
+  // ordering of the factor.
+  cholmod_sparse* permuted_C = nullptr;
+  int cholmod_status = 0;
+  if (use_long_) {
+    permuted_C = cholmod_l_submatrix(
+        &C_view, reinterpret_cast<SuiteSparse_long*>(cholmod_factor_->Perm),
+        cholmod_factor_->n, nullptr, -1, 1, 1, &cc_);
+    if (permuted_C != nullptr) {
+      cholmod_status =
+          cholmod_l_updown(update, permuted_C, cholmod_factor_, &cc_);
+    }
+    cholmod_l_free_sparse(&permuted_C, &cc_);
+  } else {
+    permuted_C = cholmod_submatrix(
+        &C_view, reinterpret_cast<int*>(cholmod_factor_->Perm),
+        cholmod_factor_->n, nullptr, -1, 1, 1, &cc_);
+    if (permuted_C != nullptr) {
+      cholmod_status = cholmod_updown(update, permuted_C, cholmod_factor_, &cc_);
+    }
+    cholmod_free_sparse(&permuted_C, &cc_);
+  }
+
+  if (cholmod_status == 0 || cc_.status != CHOLMOD_OK) {
+    VLOG(2) << "cholmod_updown failed. error code: " << cc_.status;
+    is_factorization_ok_ = false;
+    info_ = Eigen::NumericalIssue;
+    return false;
+  }
+
+  info_ = Eigen::Success;
+  return true;
+}
+
+bool SparseCholeskyLLt::GetFactor(Eigen::SparseMatrix<double>* L,
+                                  Eigen::VectorXi* permutation) {
+  CHECK_NOTNULL(L);
+  CHECK_NOTNULL(permutation);
+  CHECK_NOTNULL(cholmod_factor_);
+  CHECK(is_factorization_ok_)
+      << "Cannot call GetFactor() because numeric factorization "
+         "of the matrix (i.e. Factorize()) failed!";
+
+  cholmod_factor* factor =
+      use_long_ ? cholmod_l_copy_factor(cholmod_factor_, &cc_)
+                : cholmod_copy_factor(cholmod_factor_, &cc_);
+  if (factor == nullptr) {
+    LOG(ERROR) << "cholmod_copy_factor failed. error code: " << cc_.status;
+    return false;
+  }
+
+  // A packed and monotonic simplicial LL^t factor.
+  const int cholmod_status =
+      use_long_
+          ? cholmod_l_change_factor(CHOLMOD_REAL, 1, 0, 1, 1, factor, &cc_)
+          : cholmod_change_factor(CHOLMOD_REAL, 1, 0, 1, 1, factor, &cc_);
+  bool success = cholmod_status != 0 && cc_.status == CHOLMOD_OK;
+  if (!success) {
+    LOG(ERROR) << "cholmod_change_factor failed. error code: " << cc_.status;
+  } else if (use_long_) {
+    success = CopySimplicialFactor<SuiteSparse_long>(*factor, L, permutation);
+  } else {
+    success = CopySimplicialFactor<int>(*factor, L, permutation);
+  }
+
+  if (use_long_) {
+    cholmod_l_free_factor(&factor, &cc_);
+  } else {
+    cholmod_free_factor(&factor, &cc_);
+  }
+  return success;
+}
+
 void SparseCholeskyLLt::Compute(const Eigen::SparseMatrix<double>& mat) {
   AnalyzePattern(mat);
   Factorize(mat);
 }
 
+void SparseCholeskyLLt::Compute(const LongSparseMatrix& mat) {
+  AnalyzePattern(mat);
+  Factorize(mat);
+}
+
 Eigen::ComputationInfo SparseCholeskyLLt::Info() { return info_; }
 
+double SparseCholeskyLLt::NumFactorNonZeros() const { return cc_.lnz; }
+
+double SparseCholeskyLLt::NumFactorizationFlops() const { return cc_.fl; }
+
+CholeskyOrderingType SparseCholeskyLLt::SelectedOrdering() const {
+  switch (cc_.method[cc_.selected].ordering) {
+    case CHOLMOD_COLAMD:
+      return CholeskyOrderingType::COLAMD;
+    case CHOLMOD_METIS:
+      return CholeskyOrderingType::METIS;
+    case CHOLMOD_NESDIS:
+      return CholeskyOrderingType::NESDIS;
+    default:
+      return CholeskyOrderingType::AMD;
+  }
+}
+
 // Using the cholesky decomposition, solve for x that minimizes
 //    lhs * x = rhs
 // where lhs is the factorized matrix.
 Eigen::VectorXd SparseCholeskyLLt::Solve(const Eigen::VectorXd& rhs) {
+  Eigen::VectorXd solution = rhs;
+  if (!SolveColumns(solution.data(), solution.rows(), 1)) {
+    return Eigen::VectorXd();
+  }
+  return solution;
+}
+
+Eigen::MatrixXd SparseCholeskyLLt::Solve(const Eigen::MatrixXd& rhs) {
+  Eigen::MatrixXd solution = rhs;
+  if (!SolveColumns(solution.data(), solution.rows(), solution.cols())) {
+    return Eigen::MatrixXd();
+  }
+  return solution;
+}
+
+void SparseCholeskyLLt::SolveInPlace(Eigen::VectorXd* rhs) {
+  CHECK_NOTNULL(rhs);
+  SolveColumns(rhs->data(), rhs->rows(), 1);
+}
+
+void SparseCholeskyLLt::SolveInPlace(Eigen::MatrixXd* rhs) {
+  CHECK_NOTNULL(rhs);
+  SolveColumns(rhs->data(), rhs->rows(), rhs->cols());
+}
+
+bool SparseCholeskyLLt::SolveColumns(double* rhs, const int num_rows,
+                                     const int num_cols) {
+  GOPT_PROFILE_SCOPE("CholeskySolve");
   CHECK_NOTNULL(cholmod_factor_);
   CHECK(is_analysis_ok_) << "Cannot call Solve() because symbolic analysis "
                             "of the matrix (i.e. AnalyzePattern()) failed!";
   CHECK(is_factorization_ok_)
       << "Cannot call Solve() because numeric factorization "
          "of the matrix (i.e. Factorize()) failed!";
+  CHECK_EQ(num_rows, static_cast<int>(cholmod_factor_->n));
 
-  Eigen::VectorXd solution;
   if (cc_.status != CHOLMOD_OK) {
     LOG(ERROR) << "cholmod_solve failed. CHOLMOD status is not CHOLMOD_OK";
-    return solution;
+    info_ = Eigen::NumericalIssue;
+    return false;
   }
 
-  // returns a cholmod_dense*
-  cholmod_dense b = ViewAsCholmod(rhs);
-  cholmod_dense* x = cholmod_solve(CHOLMOD_A, cholmod_factor_, &b, &cc_);
-  if (x == nullptr) {
+  // cholmod_solve2() only reallocates the solution and its workspaces if the
+  // number of columns changed since the last solve.
+  cholmod_dense b = ViewAsCholmod(rhs, num_rows, num_cols);
+  const int cholmod_status =
+      use_long_
+          ? cholmod_l_solve2(CHOLMOD_A, cholmod_factor_, &b, nullptr,
+                             &solution_, nullptr, &solve_workspace_y_,
+                             &solve_workspace_e_, &cc_)
+          : cholmod_solve2(CHOLMOD_A, cholmod_factor_, &b, nullptr, &solution_,
+                           nullptr, &solve_workspace_y_, &solve_workspace_e_,
+                           &cc_);
+  if (!cholmod_status) {
     info_ = Eigen::NumericalIssue;
-    return solution;
+    return false;
   }
   // cholmod_gpu_stats(&cc_);
-  solution = Eigen::Map<Eigen::VectorXd>(reinterpret_cast<double*>(x->x),
-                                         x->nrow, x->ncol);
-  return solution;
+
+  const double* solution = reinterpret_cast<const double*>(solution_->x);
+  for (int c = 0; c < num_cols; c++) {
+    std::copy(solution + c * solution_->d,
+              solution + c * solution_->d + num_rows, rhs + c * num_rows);
+  }
+  return true;
 }
 
 }  // namespace gopt
@@ -3,6 +3,10 @@
 
 #include <cholmod.h>
 
+#include <limits>
+#include <memory>
+
+#include <Eigen/Core>
 #include <Eigen/SparseCore>
 
 // UF_long is deprecated but SuiteSparse_long is only available in
@@ -13,8 +17,73 @@
 #define SuiteSparse_long UF_long
 #endif
 
+#include "math/symbolic_factorization_cache.h"
+
 namespace gopt {
 
+// Fill-reducing orderings of CHOLMOD.
+enum class CholeskyOrderingType : int {
+  // Approximate minimum degree.
+  AMD = 0,
+  // Column approximate minimum degree. CHOLMOD uses AMD for symmetric
+  // matrices, so this only differs for unsymmetric inputs.
+  COLAMD = 1,
+  // Nested dissection of METIS. Requires CHOLMOD to be built with METIS.
+  METIS = 2,
+  // CHOLMOD's own nested dissection, based on METIS graph partitioning.
+  NESDIS = 3,
+  // Try AMD, METIS and NESDIS, and keep the ordering with the least fill.
+  BEST = 4
+};
+
+enum class CholeskyFactorizationType : int {
+  // Let CHOLMOD choose by the number of flops per non-zero of the factor.
+  AUTO = 0,
+  SIMPLICIAL = 1,
+  SUPERNODAL = 2
+};
+
+// Index types of the CHOLMOD interface. The 32-bit interface limits the number
+// of non-zeros of the factor to about 2^31, which the factors of large
+// translation systems and Laplacians exceed.
+enum class CholeskyIndexType : int {
+  // Start with 32-bit indices and switch to the 64-bit interface once a
+  // factor is too large for them.
+  AUTO = 0,
+  INT32 = 1,
+  INT64 = 2
+};
+
+// Sparse matrices with the 64-bit indices of the cholmod_l_* interface.
+typedef Eigen::SparseMatrix<double, Eigen::ColMajor, SuiteSparse_long>
+    LongSparseMatrix;
+
+struct SparseCholeskyLLtOptions {
+  CholeskyOrderingType ordering_type = CholeskyOrderingType::AMD;
+
+  CholeskyFactorizationType factorization_type =
+      CholeskyFactorizationType::AUTO;
+
+  // Maximum number of threads of CHOLMOD (available since CHOLMOD 4). The
+  // threads of the BLAS used by the supernodal factorization are set by the
+  // BLAS library, e.g. OMP_NUM_THREADS or OPENBLAS_NUM_THREADS. Non-positive
+  // values keep the CHOLMOD default.
+  int num_threads = 0;
+
+  // 1 to factorize on the GPU, 0 to factorize on the CPU and -1 to follow the
+  // CHOLMOD_USE_GPU environment variable. Only used if CHOLMOD was built with
+  // CUDA support.
+  int use_gpu = -1;
+
+  CholeskyIndexType index_type = CholeskyIndexType::AUTO;
+
+  // With CholeskyIndexType::AUTO, factors with more non-zeros than this are
+  // computed with 64-bit indices. The supernodal factor also stores the zeros
+  // of relaxed supernodes, so its size is only bounded loosely by the number
+  // of non-zeros, hence the margin to 2^31.
+  double max_int32_factor_nonzeros = 0.5 * std::numeric_limits<int>::max();
+};
+
 // A class for performing the choleksy decomposition of a sparse matrix using
 // CHOLMOD from SuiteSparse. This allows us to utilize the supernodal algorithms
 // which are not included with Eigen. CHOLMOD automatically determines if the
@@ -22,13 +91,27 @@ namespace gopt {
 // to mimic the Eigen linear solver interface except that it is not templated
 // and requires sparse matrices.
 //
+// The ordering, the factorization type and the threading of CHOLMOD are set by
+// SparseCholeskyLLtOptions. The ordering matters a lot for the fill of the
+// factor, especially on view graphs with many loop closures. Factors too large
+// for 32-bit indices are computed with the 64-bit interface of CHOLMOD.
+//
 // NOTE: The matrix mat should be a symmetric matrix.
 class SparseCholeskyLLt {
  public:
   explicit SparseCholeskyLLt(const Eigen::SparseMatrix<double>& mat);
   SparseCholeskyLLt();
+  explicit SparseCholeskyLLt(const SparseCholeskyLLtOptions& options);
   ~SparseCholeskyLLt();
 
+  // Share the symbolic analyses with other solvers. AnalyzePattern() reuses the
+  // cached analysis of the sparsity pattern of the matrix if there is one, and
+  // caches its own analysis otherwise. The solvers sharing a cache should use
+  // the same options, since the cache is keyed by the pattern only. The cache
+  // is not used with 64-bit indices.
+  void SetSymbolicFactorizationCache(
+      const std::shared_ptr<SymbolicFactorizationCache>& cache);
+
   // Perform symbolic analysis of the matrix. This is useful for analyzing
   // matrices with the same sparsity pattern when used in conjunction with
   // Factorize().
@@ -44,6 +127,36 @@ class SparseCholeskyLLt {
   // AnalyzePattern() followed by Factorize().
   void Compute(const Eigen::SparseMatrix<double>& mat);
 
+  // The same for matrices with 64-bit indices, which always use the 64-bit
+  // interface of CHOLMOD.
+  void AnalyzePattern(const LongSparseMatrix& mat);
+  void Factorize(const LongSparseMatrix& mat);
+  void Compute(const LongSparseMatrix& mat);
+
+  // Updates (update = true) or downdates (update = false) the factorization of
+  // mat to the factorization of mat + C * C^t or mat - C * C^t, where C is a
+  // sparse matrix with as many rows as mat. This costs much less than
+  // factorizing the modified matrix if C has few columns, e.g. when a few
+  // edges are added to or removed from a least squares problem. The factor is
+  // converted to a simplicial LDL^t factorization by the first update.
+  //
+  // Returns false if the update failed, e.g. because the downdated matrix is
+  // not positive definite. The matrix has to be factorized again in this case.
+  bool UpdateDowndate(const bool update, const Eigen::SparseMatrix<double>& C);
+
+  // Copies the factor of the current factorization, i.e. the lower triangular
+  // matrix L with L * L^t = mat(p, p), to L and the fill-reducing permutation p
+  // to permutation, where p(k) is the row of mat of the k-th row of L. The rows
+  // of each column of L are sorted, with the diagonal first. Supernodal and
+  // LDL^t factors are converted to a simplicial LL^t factor on a copy, so the
+  // factorization itself is not modified. Returns false if the conversion
+  // failed or L has too many non-zeros for 32-bit indices.
+  bool GetFactor(Eigen::SparseMatrix<double>* L, Eigen::VectorXi* permutation);
+
+  // Returns true if the 64-bit interface of CHOLMOD is in use, either because
+  // it was requested or because a factor was too large for 32-bit indices.
+  bool UsesLongIndices() const;
+
   // Returns the current state of the decomposition. After each step users
   // should ensure that Info() returns Eigen::Success.
   Eigen::ComputationInfo Info();
@@ -53,9 +166,58 @@ class SparseCholeskyLLt {
   // where lhs is the factorized matrix.
   Eigen::VectorXd Solve(const Eigen::VectorXd& rhs);
 
+  // Solves for all columns of rhs at once. CHOLMOD performs the triangular
+  // solves blockwise, which is considerably faster than solving the columns
+  // one by one.
+  Eigen::MatrixXd Solve(const Eigen::MatrixXd& rhs);
+
+  // Same as Solve(), but overwrites rhs with the solution. The CHOLMOD
+  // workspaces are kept between calls, so repeated solves with right hand
+  // sides of the same size do not allocate memory.
+  void SolveInPlace(Eigen::VectorXd* rhs);
+  void SolveInPlace(Eigen::MatrixXd* rhs);
+
+  // Statistics of the last symbolic analysis: the number of non-zeros of the
+  // factor, the number of flops of the numeric factorization, and the ordering
+  // CHOLMOD selected.
+  double NumFactorNonZeros() const;
+  double NumFactorizationFlops() const;
+  CholeskyOrderingType SelectedOrdering() const;
+
  private:
+  // Starts cc_ with the 32-bit or the 64-bit interface, and copies the
+  // options to it.
+  void StartCommon(const bool use_long);
+  // Releases the factor, the workspaces and cc_.
+  void FinishCommon();
+
+  // Analyzes and factorizes A with the interface cc_ was started with. A must
+  // have the matching index type.
+  void AnalyzeCholmod(cholmod_sparse* A);
+  void FactorizeCholmod(cholmod_sparse* A);
+
+  // Returns true if the last step failed because the factor does not fit
+  // 32-bit indices and the solver may switch to 64-bit indices.
+  bool ShouldSwitchToLongIndices() const;
+
+  // Solves for the columns of the column major matrix rhs, whose leading
+  // dimension is num_rows, and stores the solution in rhs. Returns false if
+  // the solve failed.
+  bool SolveColumns(double* rhs, const int num_rows, const int num_cols);
+
+  const SparseCholeskyLLtOptions options_;
+  // Whether cc_ was started with cholmod_l_start().
+  bool use_long_;
   cholmod_common cc_;
   cholmod_factor* cholmod_factor_;
+  // Workspaces of cholmod_solve2(), which are reused by all solves.
+  cholmod_dense* solution_;
+  cholmod_dense* solve_workspace_y_;
+  cholmod_dense* solve_workspace_e_;
+  std::shared_ptr<SymbolicFactorizationCache> symbolic_factorization_cache_;
+  // Copy of the last 32-bit matrix with 64-bit indices, once the solver
+  // switched to the 64-bit interface.
+  LongSparseMatrix long_mat_;
   bool is_factorization_ok_, is_analysis_ok_;
   Eigen::ComputationInfo info_;
 };
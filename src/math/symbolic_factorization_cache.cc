@@ -0,0 +1,176 @@
+#include "math/symbolic_factorization_cache.h"
+
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "util/hash.h"
+
+namespace gopt {
+namespace {
+
+// Returns true if the pattern of mat is the pattern of the entry.
+bool HasPattern(const Eigen::SparseMatrix<double>& mat,
+                const std::vector<int>& outer_indices,
+                const std::vector<int>& inner_indices) {
+  if (static_cast<int>(outer_indices.size()) != mat.outerSize() + 1 ||
+      static_cast<int>(inner_indices.size()) != mat.nonZeros()) {
+    return false;
+  }
+  int index = 0;
+  for (int col = 0; col < mat.outerSize(); col++) {
+    if (outer_indices[col] != index) {
+      return false;
+    }
+    for (Eigen::SparseMatrix<double>::InnerIterator it(mat, col); it; ++it) {
+      if (inner_indices[index++] != it.row()) {
+        return false;
+      }
+    }
+  }
+  return outer_indices.back() == index;
+}
+
+// Copies and frees factors with the API of their index type.
+cholmod_factor* CopyFactor(cholmod_factor* factor, cholmod_common* common) {
+  return factor->itype == CHOLMOD_LONG ? cholmod_l_copy_factor(factor, common)
+                                       : cholmod_copy_factor(factor, common);
+}
+
+void FreeFactor(cholmod_factor** factor, cholmod_common* common) {
+  if ((*factor)->itype == CHOLMOD_LONG) {
+    cholmod_l_free_factor(factor, common);
+  } else {
+    cholmod_free_factor(factor, common);
+  }
+}
+
+}  // namespace
+
+size_t HashSparsityPattern(const Eigen::SparseMatrix<double>& mat) {
+  size_t seed = 0;
+  std::HashCombine(static_cast<int>(mat.rows()), &seed);
+  std::HashCombine(static_cast<int>(mat.cols()), &seed);
+  for (int col = 0; col < mat.outerSize(); col++) {
+    std::HashCombine(col, &seed);
+    for (Eigen::SparseMatrix<double>::InnerIterator it(mat, col); it; ++it) {
+      std::HashCombine(static_cast<int>(it.row()), &seed);
+    }
+  }
+  return seed;
+}
+
+SymbolicFactorizationCache::SymbolicFactorizationCache()
+    : num_entries_(0), num_hits_(0) {
+  cholmod_start(&cc_);
+  cholmod_l_start(&long_cc_);
+}
+
+SymbolicFactorizationCache::~SymbolicFactorizationCache() {
+  Clear();
+  cholmod_finish(&cc_);
+  cholmod_l_finish(&long_cc_);
+}
+
+cholmod_factor* SymbolicFactorizationCache::Find(
+    const Eigen::SparseMatrix<double>& mat, cholmod_common* common) {
+  CHECK_NOTNULL(common);
+  const size_t hash = HashSparsityPattern(mat);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  Entry* entry = FindEntry(mat, hash, common->itype);
+  if (entry == nullptr) {
+    return nullptr;
+  }
+
+  ++num_hits_;
+  VLOG(2) << "Reusing the symbolic factorization of a " << mat.rows() << "x"
+          << mat.cols() << " matrix.";
+  return CopyFactor(entry->symbolic_factor, common);
+}
+
+void SymbolicFactorizationCache::Insert(
+    const Eigen::SparseMatrix<double>& mat, cholmod_factor* symbolic_factor,
+    cholmod_common* common) {
+  CHECK_NOTNULL(symbolic_factor);
+  CHECK_NOTNULL(common);
+  CHECK_EQ(symbolic_factor->xtype, CHOLMOD_PATTERN)
+      << "Only symbolic factorizations can be cached.";
+  CHECK_EQ(symbolic_factor->itype, common->itype);
+  const size_t hash = HashSparsityPattern(mat);
+
+  Entry entry;
+  entry.num_rows = mat.rows();
+  entry.num_cols = mat.cols();
+  entry.outer_indices.reserve(mat.outerSize() + 1);
+  entry.inner_indices.reserve(mat.nonZeros());
+  for (int col = 0; col < mat.outerSize(); col++) {
+    entry.outer_indices.push_back(entry.inner_indices.size());
+    for (Eigen::SparseMatrix<double>::InnerIterator it(mat, col); it; ++it) {
+      entry.inner_indices.push_back(it.row());
+    }
+  }
+  entry.outer_indices.push_back(entry.inner_indices.size());
+
+  // The cached factor is allocated by the common of the cache, which is not
+  // thread safe, and freed by it even after the solver which analyzed the
+  // pattern finished its own common.
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (FindEntry(mat, hash, symbolic_factor->itype) != nullptr) {
+    return;
+  }
+  entry.symbolic_factor =
+      CopyFactor(symbolic_factor, GetCommon(symbolic_factor->itype));
+  if (entry.symbolic_factor == nullptr) {
+    LOG(WARNING) << "Failed to copy the symbolic factorization.";
+    return;
+  }
+  entries_[hash].push_back(std::move(entry));
+  ++num_entries_;
+}
+
+void SymbolicFactorizationCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& hash_entries : entries_) {
+    for (Entry& entry : hash_entries.second) {
+      FreeFactor(&entry.symbolic_factor,
+                 GetCommon(entry.symbolic_factor->itype));
+    }
+  }
+  entries_.clear();
+  num_entries_ = 0;
+  num_hits_ = 0;
+}
+
+int SymbolicFactorizationCache::NumEntries() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_entries_;
+}
+
+int SymbolicFactorizationCache::NumHits() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_hits_;
+}
+
+cholmod_common* SymbolicFactorizationCache::GetCommon(const int itype) {
+  return itype == CHOLMOD_LONG ? &long_cc_ : &cc_;
+}
+
+SymbolicFactorizationCache::Entry* SymbolicFactorizationCache::FindEntry(
+    const Eigen::SparseMatrix<double>& mat, const size_t hash,
+    const int itype) {
+  auto hash_entries = entries_.find(hash);
+  if (hash_entries == entries_.end()) {
+    return nullptr;
+  }
+  for (Entry& entry : hash_entries->second) {
+    if (entry.symbolic_factor->itype == itype &&
+        entry.num_rows == mat.rows() && entry.num_cols == mat.cols() &&
+        HasPattern(mat, entry.outer_indices, entry.inner_indices)) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace gopt
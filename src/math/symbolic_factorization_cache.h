@@ -0,0 +1,89 @@
+#ifndef MATH_SYMBOLIC_FACTORIZATION_CACHE_H_
+#define MATH_SYMBOLIC_FACTORIZATION_CACHE_H_
+
+#include <cholmod.h>
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <Eigen/SparseCore>
+
+#include "util/util.h"
+
+namespace gopt {
+
+// Hashes the dimensions and the positions of the non-zero entries of mat, but
+// not their values.
+size_t HashSparsityPattern(const Eigen::SparseMatrix<double>& mat);
+
+// A cache of the symbolic Cholesky factorizations (i.e. the fill-reducing
+// ordering, the elimination tree and the supernodal structure) computed by
+// SparseCholeskyLLt::AnalyzePattern(), keyed by the sparsity pattern of the
+// analyzed matrix. Solvers that share a cache only analyze a pattern once, e.g.
+// the L1 and the IRLS stages of the rotation averaging, which both factorize
+// A^t * A of the same incidence matrix A.
+//
+// The cache is meant to be shared by a std::shared_ptr between the stages of
+// one problem, and is thread safe.
+class SymbolicFactorizationCache {
+ public:
+  SymbolicFactorizationCache();
+  ~SymbolicFactorizationCache();
+
+  // Returns a copy of the symbolic factorization of the pattern of mat, which
+  // is owned by the caller and allocated with common, or nullptr if the
+  // pattern has not been analyzed yet with the index type of common. Patterns
+  // are found by their hash and compared exactly, so colliding patterns never
+  // share a factorization.
+  cholmod_factor* Find(const Eigen::SparseMatrix<double>& mat,
+                       cholmod_common* common);
+
+  // Stores a copy of the symbolic factorization of the pattern of mat, which
+  // was allocated with common. The copy is allocated with a common of the
+  // cache, so it outlives common. The factor must not be numerically
+  // factorized yet. If the pattern is already cached, the cache is not
+  // changed.
+  void Insert(const Eigen::SparseMatrix<double>& mat,
+              cholmod_factor* symbolic_factor, cholmod_common* common);
+
+  // Releases all cached factorizations.
+  void Clear();
+
+  int NumEntries();
+  int NumHits();
+
+ private:
+  struct Entry {
+    int num_rows;
+    int num_cols;
+
+    // The compressed column pattern of the analyzed matrix.
+    std::vector<int> outer_indices;
+    std::vector<int> inner_indices;
+
+    cholmod_factor* symbolic_factor;
+  };
+
+  // The common of the cache for factors with 32-bit or 64-bit indices.
+  cholmod_common* GetCommon(const int itype);
+
+  // Returns the entry of the pattern of mat among the entries with its hash
+  // and the index type itype, or nullptr.
+  Entry* FindEntry(const Eigen::SparseMatrix<double>& mat, const size_t hash,
+                   const int itype);
+
+  std::mutex mutex_;
+  cholmod_common cc_;
+  cholmod_common long_cc_;
+  // The entries of the patterns with the same hash.
+  std::unordered_map<size_t, std::vector<Entry>> entries_;
+  int num_entries_;
+  int num_hits_;
+
+  DISALLOW_COPY_AND_ASSIGN(SymbolicFactorizationCache);
+};
+
+}  // namespace gopt
+
+#endif  // MATH_SYMBOLIC_FACTORIZATION_CACHE_H_
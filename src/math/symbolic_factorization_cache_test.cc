@@ -0,0 +1,119 @@
+#include "math/symbolic_factorization_cache.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <Eigen/Cholesky>
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+
+#include "gtest/gtest.h"
+#include "math/sparse_cholesky_llt.h"
+
+namespace gopt {
+namespace {
+
+// An arrow matrix, whose dense row and column are those of the hub. Arrow
+// matrices with different hubs have the same dimensions and number of
+// non-zeros, but need different fill-reducing orderings.
+Eigen::SparseMatrix<double> CreateArrowMatrix(const int size, const int hub,
+                                              const double scale) {
+  std::vector<Eigen::Triplet<double>> triplets;
+  for (int i = 0; i < size; i++) {
+    triplets.emplace_back(i, i, scale * (i == hub ? size : 2.0));
+    if (i != hub) {
+      triplets.emplace_back(std::min(i, hub), std::max(i, hub), -scale);
+    }
+  }
+  Eigen::SparseMatrix<double> mat(size, size);
+  mat.setFromTriplets(triplets.begin(), triplets.end());
+  return mat;
+}
+
+void ExpectSolves(const Eigen::SparseMatrix<double>& mat,
+                  SparseCholeskyLLt* llt) {
+  const Eigen::VectorXd rhs = Eigen::VectorXd::LinSpaced(mat.rows(), 1.0, 2.0);
+  const Eigen::MatrixXd dense_mat =
+      Eigen::MatrixXd(mat).selfadjointView<Eigen::Upper>();
+  const Eigen::VectorXd solution = llt->Solve(rhs);
+  ASSERT_EQ(llt->Info(), Eigen::Success);
+  EXPECT_LT((solution - dense_mat.ldlt().solve(rhs)).norm(), 1e-10);
+}
+
+}  // namespace
+
+TEST(SymbolicFactorizationCache, ReusesAnalysisOfSamePattern) {
+  static const int kSize = 50;
+  const std::shared_ptr<SymbolicFactorizationCache> cache =
+      std::make_shared<SymbolicFactorizationCache>();
+
+  SparseCholeskyLLt llt1;
+  llt1.SetSymbolicFactorizationCache(cache);
+  const Eigen::SparseMatrix<double> mat1 = CreateArrowMatrix(kSize, 0, 1.0);
+  llt1.Compute(mat1);
+  ASSERT_EQ(llt1.Info(), Eigen::Success);
+  EXPECT_EQ(cache->NumEntries(), 1);
+  EXPECT_EQ(cache->NumHits(), 0);
+
+  // Only the values differ.
+  SparseCholeskyLLt llt2;
+  llt2.SetSymbolicFactorizationCache(cache);
+  const Eigen::SparseMatrix<double> mat2 = CreateArrowMatrix(kSize, 0, 3.0);
+  llt2.Compute(mat2);
+  ASSERT_EQ(llt2.Info(), Eigen::Success);
+  EXPECT_EQ(cache->NumEntries(), 1);
+  EXPECT_EQ(cache->NumHits(), 1);
+  ExpectSolves(mat2, &llt2);
+}
+
+TEST(SymbolicFactorizationCache, OutlivesAnalyzingSolver) {
+  static const int kSize = 50;
+  const std::shared_ptr<SymbolicFactorizationCache> cache =
+      std::make_shared<SymbolicFactorizationCache>();
+
+  // The common of the solver which analyzed the pattern is finished before
+  // the cached factorization is reused.
+  {
+    SparseCholeskyLLt llt;
+    llt.SetSymbolicFactorizationCache(cache);
+    llt.Compute(CreateArrowMatrix(kSize, 0, 1.0));
+    ASSERT_EQ(llt.Info(), Eigen::Success);
+  }
+
+  SparseCholeskyLLt llt;
+  llt.SetSymbolicFactorizationCache(cache);
+  const Eigen::SparseMatrix<double> mat = CreateArrowMatrix(kSize, 0, 2.0);
+  llt.Compute(mat);
+  ASSERT_EQ(llt.Info(), Eigen::Success);
+  EXPECT_EQ(cache->NumHits(), 1);
+  ExpectSolves(mat, &llt);
+}
+
+TEST(SymbolicFactorizationCache, DoesNotShareAnalysisOfEqualSizedPatterns) {
+  static const int kSize = 50;
+  const std::shared_ptr<SymbolicFactorizationCache> cache =
+      std::make_shared<SymbolicFactorizationCache>();
+
+  const Eigen::SparseMatrix<double> mat1 = CreateArrowMatrix(kSize, 0, 1.0);
+  const Eigen::SparseMatrix<double> mat2 =
+      CreateArrowMatrix(kSize, kSize - 1, 1.0);
+  ASSERT_EQ(mat1.nonZeros(), mat2.nonZeros());
+
+  SparseCholeskyLLt llt1;
+  llt1.SetSymbolicFactorizationCache(cache);
+  llt1.Compute(mat1);
+  ASSERT_EQ(llt1.Info(), Eigen::Success);
+
+  SparseCholeskyLLt llt2;
+  llt2.SetSymbolicFactorizationCache(cache);
+  llt2.Compute(mat2);
+  ASSERT_EQ(llt2.Info(), Eigen::Success);
+  EXPECT_EQ(cache->NumEntries(), 2);
+  EXPECT_EQ(cache->NumHits(), 0);
+
+  ExpectSolves(mat1, &llt1);
+  ExpectSolves(mat2, &llt2);
+}
+
+}  // namespace gopt
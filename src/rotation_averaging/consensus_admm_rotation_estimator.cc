@@ -0,0 +1,860 @@
+#include "rotation_averaging/consensus_admm_rotation_estimator.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef OPENMP_ENABLED
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+
+#include <Eigen/SparseCore>
+#include <glog/logging.h>
+
+#include "geometry/rotation_utils.h"
+#include "graph/graph_partition.h"
+#include "solver/sparse_linear_solver.h"
+#include "util/map_util.h"
+#include "util/profiler.h"
+#include "util/view_pair_util.h"
+
+extern char** environ;
+
+namespace gopt {
+namespace {
+
+// Alignment of the arrays in the shared memory, so that the arrays written by
+// different workers do not share cache lines.
+const size_t kSharedMemoryAlignment = 64;
+
+// The descriptor of the shared memory in the workers.
+const int kWorkerSharedMemoryFd = 3;
+
+size_t AlignSharedMemory(const size_t size) {
+  return (size + kSharedMemoryAlignment - 1) / kSharedMemoryAlignment *
+         kSharedMemoryAlignment;
+}
+
+// A POSIX shared memory object mapped into the address space. The estimator
+// creates it and hands its descriptor to the workers, which map it as well.
+// Its name is unlinked right away, so the memory is released once the last
+// process unmaps it, even if the processes are killed.
+class SharedMemory {
+ public:
+  SharedMemory() {}
+
+  ~SharedMemory() {
+    if (data_ != nullptr) {
+      munmap(data_, size_);
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  // Creates a zero initialized shared memory object of the given size.
+  bool Create(const size_t size) {
+    static std::atomic<int> counter(0);
+    const std::string name = "/gopt_admm_" + std::to_string(getpid()) + "_" +
+                             std::to_string(counter++);
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+      PLOG(ERROR) << "Cannot create the shared memory " << name;
+      return false;
+    }
+    shm_unlink(name.c_str());
+
+    // The descriptor is duplicated onto kWorkerSharedMemoryFd in the workers,
+    // which only clears its close-on-exec flag if the descriptors differ.
+    fd_ = fcntl(fd, F_DUPFD_CLOEXEC, kWorkerSharedMemoryFd + 1);
+    close(fd);
+    if (fd_ < 0) {
+      PLOG(ERROR) << "Cannot duplicate the descriptor of the shared memory";
+      return false;
+    }
+
+    // The memory is zero initialized by ftruncate().
+    if (ftruncate(fd_, size) != 0) {
+      PLOG(ERROR) << "Cannot allocate " << size << " bytes of shared memory";
+      return false;
+    }
+    return Map(size);
+  }
+
+  // Maps the shared memory object of an inherited descriptor.
+  bool Open(const int fd) {
+    fd_ = fd;
+    struct stat status;
+    if (fstat(fd_, &status) != 0) {
+      PLOG(ERROR) << "Cannot query the size of the shared memory";
+      return false;
+    }
+    return Map(status.st_size);
+  }
+
+  int fd() const { return fd_; }
+  char* data() const { return data_; }
+
+ private:
+  bool Map(const size_t size) {
+    void* data =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (data == MAP_FAILED) {
+      PLOG(ERROR) << "Cannot map the shared memory";
+      return false;
+    }
+    data_ = static_cast<char*>(data);
+    size_ = size;
+    return true;
+  }
+
+  int fd_ = -1;
+  size_t size_ = 0;
+  char* data_ = nullptr;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedMemory);
+};
+
+// The state at the start of the shared memory. The plain fields are only read
+// after a barrier which follows their writes, which orders the accesses.
+struct SharedState {
+  pthread_barrier_t barrier;
+
+  // Set by a worker whose clusters cannot be solved.
+  int failed = 0;
+
+  // Set by the first worker when it stops.
+  int num_iterations = 0;
+
+  // The sizes of the problem and the options, which the estimator sets before
+  // it spawns the workers.
+  int num_workers = 0;
+  int num_shared_views = 0;
+  int num_copies = 0;
+  int verbosity = 0;
+  double penalty = 0.0;
+  int max_num_iterations = 0;
+  double convergence_tolerance = 0.0;
+  solver::LinearSolverOptions linear_solver_options;
+
+  // The offsets of the arrays from the start of the shared memory.
+  size_t residuals_offset = 0;
+  size_t consensus_offset = 0;
+  size_t copies_offset = 0;
+  size_t rotations_offset = 0;
+  size_t worker_offsets_offset = 0;
+};
+
+// The arrays in the shared memory. Rotation matrices are stored column major.
+struct SharedArrays {
+  SharedState* state = nullptr;
+
+  // The squared primal and dual residuals of each worker, double buffered by
+  // the parity of the iteration, so that a worker can write the residuals of
+  // the next iteration while the others still sum the current ones.
+  double* residuals = nullptr;
+
+  // The consensus rotation Z_v of each shared view.
+  double* consensus_rotations = nullptr;
+
+  // R_v^k + U_v^k of each copy of a shared view.
+  double* copies = nullptr;
+
+  // The estimated rotations of all views.
+  double* rotations = nullptr;
+
+  // The offset of the problem of each worker, see AppendWorkerProblem().
+  size_t* worker_offsets = nullptr;
+};
+
+SharedArrays GetSharedArrays(char* data) {
+  SharedArrays shared;
+  shared.state = reinterpret_cast<SharedState*>(data);
+  shared.residuals =
+      reinterpret_cast<double*>(data + shared.state->residuals_offset);
+  shared.consensus_rotations =
+      reinterpret_cast<double*>(data + shared.state->consensus_offset);
+  shared.copies = reinterpret_cast<double*>(data + shared.state->copies_offset);
+  shared.rotations =
+      reinterpret_cast<double*>(data + shared.state->rotations_offset);
+  shared.worker_offsets =
+      reinterpret_cast<size_t*>(data + shared.state->worker_offsets_offset);
+  return shared;
+}
+
+// Appends a value or an array of trivially copyable values to a buffer. The
+// arrays are preceded by their size.
+template <typename T>
+void AppendValue(const T& value, std::vector<char>* buffer) {
+  const char* bytes = reinterpret_cast<const char*>(&value);
+  buffer->insert(buffer->end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+void AppendArray(const std::vector<T>& values, std::vector<char>* buffer) {
+  AppendValue(values.size(), buffer);
+  const char* bytes = reinterpret_cast<const char*>(values.data());
+  buffer->insert(buffer->end(), bytes, bytes + values.size() * sizeof(T));
+}
+
+// Reads a value or an array appended by AppendValue() or AppendArray(), and
+// advances the cursor past it.
+template <typename T>
+T ReadValue(const char** cursor) {
+  T value;
+  std::memcpy(&value, *cursor, sizeof(T));
+  *cursor += sizeof(T);
+  return value;
+}
+
+template <typename T>
+std::vector<T> ReadArray(const char** cursor) {
+  std::vector<T> values(ReadValue<size_t>(cursor));
+  if (!values.empty()) {
+    std::memcpy(values.data(), *cursor, values.size() * sizeof(T));
+  }
+  *cursor += values.size() * sizeof(T);
+  return values;
+}
+
+void AppendRotation(const Eigen::Matrix3d& rotation,
+                    std::vector<double>* rotations) {
+  rotations->insert(rotations->end(), rotation.data(), rotation.data() + 9);
+}
+
+// The view graph and its partition, from which the estimator extracts the
+// problems of the workers.
+struct ConsensusProblem {
+  std::vector<std::pair<int, int>> edges;
+  std::vector<Eigen::Matrix3d> relative_rotations;
+  std::vector<std::vector<int>> adjacent_edges;
+  std::vector<Eigen::Matrix3d> initial_rotations;
+  graph::OverlappingPartition partition;
+
+  // The index of each view among the shared views, or -1.
+  std::vector<int> shared_view_indices;
+  std::vector<int> shared_views;
+
+  // The copies of the shared views of cluster k are
+  // cluster_copies[k], ..., cluster_copies[k + 1] - 1, in ascending order of
+  // view, and shared_view_copies holds the copies of each shared view.
+  std::vector<int> cluster_copies;
+  std::vector<std::vector<int>> shared_view_copies;
+};
+
+// The local problem of a cluster in a worker.
+struct ClusterProblem {
+  // The views of the cluster, and whether the cluster is their disjoint
+  // cluster, which writes their estimated rotations.
+  std::vector<int> views;
+  std::vector<int> owned_views;
+
+  // The index of each local view among the shared views, or -1, and the copy
+  // of the first shared view.
+  std::vector<int> shared_view_indices;
+  int first_copy = 0;
+
+  // The edges (i, j) between the local views and their relative rotations.
+  std::vector<int> edges;
+  std::vector<double> relative_rotations;
+
+  // The local views of the shared views, in ascending order.
+  std::vector<int> shared_local_views;
+
+  // The view whose rotation is fixed to its initial rotation if the cluster
+  // has no shared views.
+  int anchor_local_view = -1;
+  Eigen::Matrix3d anchor_rotation;
+
+  std::unique_ptr<SparseLinearSolver> linear_solver;
+
+  // The rotations R_v^k of the views stacked vertically, and the scaled duals
+  // U_v^k of the shared views.
+  Eigen::MatrixXd rotations;
+  Eigen::MatrixXd duals;
+};
+
+int ClusterWorker(const int cluster, const int num_workers) {
+  return cluster % num_workers;
+}
+
+// Appends the problem of a worker, which is all it reads of the view graph:
+// the views, edges, relative and initial rotations of its clusters, and the
+// copies of the shared views whose consensus rotations it updates.
+void AppendWorkerProblem(const ConsensusProblem& problem, const int worker,
+                         const int num_workers, std::vector<int>* local_indices,
+                         std::vector<char>* buffer) {
+  const int num_clusters = problem.partition.clusters.size();
+  AppendValue<int>((num_clusters - worker + num_workers - 1) / num_workers,
+                   buffer);
+  for (int k = worker; k < num_clusters; k += num_workers) {
+    const std::vector<int>& views = problem.partition.clusters[k];
+    for (size_t i = 0; i < views.size(); i++) {
+      (*local_indices)[views[i]] = i;
+    }
+
+    std::vector<int> owned_views;
+    std::vector<int> shared_view_indices;
+    std::vector<double> initial_rotations;
+    std::vector<int> edges;
+    std::vector<double> relative_rotations;
+    for (size_t i = 0; i < views.size(); i++) {
+      owned_views.push_back(problem.partition.labels[views[i]] == k);
+      shared_view_indices.push_back(problem.shared_view_indices[views[i]]);
+      AppendRotation(problem.initial_rotations[views[i]], &initial_rotations);
+      for (const int e : problem.adjacent_edges[views[i]]) {
+        const int j = (*local_indices)[problem.edges[e].second];
+        if (problem.edges[e].first != views[i] || j < 0) {
+          continue;
+        }
+        edges.push_back(i);
+        edges.push_back(j);
+        AppendRotation(problem.relative_rotations[e], &relative_rotations);
+      }
+    }
+    for (const int view : views) {
+      (*local_indices)[view] = -1;
+    }
+
+    AppendArray(views, buffer);
+    AppendArray(owned_views, buffer);
+    AppendArray(shared_view_indices, buffer);
+    AppendValue<int>(problem.cluster_copies[k], buffer);
+    AppendArray(initial_rotations, buffer);
+    AppendArray(edges, buffer);
+    AppendArray(relative_rotations, buffer);
+  }
+
+  // The consensus rotation of a shared view is updated by the worker of its
+  // first cluster.
+  std::vector<int> consensus_views;
+  for (size_t s = 0; s < problem.shared_views.size(); s++) {
+    const int first_cluster =
+        problem.partition.vertex_clusters[problem.shared_views[s]].front();
+    if (ClusterWorker(first_cluster, num_workers) == worker) {
+      consensus_views.push_back(s);
+    }
+  }
+  AppendArray(consensus_views, buffer);
+  for (const int s : consensus_views) {
+    AppendArray(problem.shared_view_copies[s], buffer);
+  }
+}
+
+// Reads the problem of a cluster appended by AppendWorkerProblem(), and sets
+// up its chordal problem, whose matrix
+//
+//   sum_(i,j) A_ij^t * A_ij + rho / 2 * sum_v E_v^t * E_v
+//
+// for the residuals A_ij * X = R_j - R_ij * R_i and the selections E_v of the
+// shared views is factorized once.
+bool SetupClusterProblem(const SharedState& state, const char** cursor,
+                         ClusterProblem* cluster_problem) {
+  cluster_problem->views = ReadArray<int>(cursor);
+  cluster_problem->owned_views = ReadArray<int>(cursor);
+  cluster_problem->shared_view_indices = ReadArray<int>(cursor);
+  cluster_problem->first_copy = ReadValue<int>(cursor);
+  const std::vector<double> initial_rotations = ReadArray<double>(cursor);
+  cluster_problem->edges = ReadArray<int>(cursor);
+  cluster_problem->relative_rotations = ReadArray<double>(cursor);
+
+  const int num_local_views = cluster_problem->views.size();
+  for (int i = 0; i < num_local_views; i++) {
+    if (cluster_problem->shared_view_indices[i] >= 0) {
+      cluster_problem->shared_local_views.push_back(i);
+    }
+  }
+  if (cluster_problem->shared_local_views.empty()) {
+    cluster_problem->anchor_local_view = 0;
+    cluster_problem->anchor_rotation =
+        Eigen::Map<const Eigen::Matrix3d>(initial_rotations.data());
+  }
+
+  std::vector<Eigen::Triplet<double>> triplets;
+  const auto AddBlock = [&triplets](const int row, const int col,
+                                    const Eigen::Matrix3d& block) {
+    for (int r = 0; r < 3; r++) {
+      for (int c = 0; c < 3; c++) {
+        triplets.emplace_back(3 * row + r, 3 * col + c, block(r, c));
+      }
+    }
+  };
+
+  const int num_local_edges = cluster_problem->edges.size() / 2;
+  for (int e = 0; e < num_local_edges; e++) {
+    const int i = cluster_problem->edges[2 * e];
+    const int j = cluster_problem->edges[2 * e + 1];
+    const Eigen::Map<const Eigen::Matrix3d> relative_rotation(
+        cluster_problem->relative_rotations.data() + 9 * e);
+    AddBlock(i, i, Eigen::Matrix3d::Identity());
+    AddBlock(j, j, Eigen::Matrix3d::Identity());
+    AddBlock(i, j, -relative_rotation.transpose());
+    AddBlock(j, i, -relative_rotation);
+  }
+  for (const int i : cluster_problem->shared_local_views) {
+    AddBlock(i, i, 0.5 * state.penalty * Eigen::Matrix3d::Identity());
+  }
+  if (cluster_problem->anchor_local_view >= 0) {
+    AddBlock(cluster_problem->anchor_local_view,
+             cluster_problem->anchor_local_view, Eigen::Matrix3d::Identity());
+  }
+
+  Eigen::SparseMatrix<double> lhs(3 * num_local_views, 3 * num_local_views);
+  lhs.setFromTriplets(triplets.begin(), triplets.end());
+
+  cluster_problem->rotations.resize(3 * num_local_views, 3);
+  for (int i = 0; i < num_local_views; i++) {
+    cluster_problem->rotations.block<3, 3>(3 * i, 0) =
+        Eigen::Map<const Eigen::Matrix3d>(initial_rotations.data() + 9 * i);
+  }
+  cluster_problem->duals.setZero(
+      3 * cluster_problem->shared_local_views.size(), 3);
+
+  cluster_problem->linear_solver =
+      SparseLinearSolver::Create(state.linear_solver_options);
+  cluster_problem->linear_solver->Compute(lhs);
+  if (cluster_problem->linear_solver->Info() != Eigen::Success) {
+    LOG(ERROR) << "Cannot factorize the system of a cluster with "
+               << num_local_views << " views.";
+    return false;
+  }
+  return true;
+}
+
+// Solves the chordal problem of a cluster for the current consensus rotations
+// and duals, and projects the solution onto SO(3).
+void SolveClusterProblem(const SharedArrays& shared,
+                         ClusterProblem* cluster_problem) {
+  const int num_local_views = cluster_problem->views.size();
+  Eigen::MatrixXd rhs = Eigen::MatrixXd::Zero(3 * num_local_views, 3);
+  for (size_t s = 0; s < cluster_problem->shared_local_views.size(); s++) {
+    const int i = cluster_problem->shared_local_views[s];
+    const Eigen::Map<const Eigen::Matrix3d> consensus_rotation(
+        shared.consensus_rotations +
+        9 * cluster_problem->shared_view_indices[i]);
+    rhs.block<3, 3>(3 * i, 0) =
+        0.5 * shared.state->penalty *
+        (consensus_rotation - cluster_problem->duals.block<3, 3>(3 * s, 0));
+  }
+  if (cluster_problem->anchor_local_view >= 0) {
+    rhs.block<3, 3>(3 * cluster_problem->anchor_local_view, 0) =
+        cluster_problem->anchor_rotation;
+  }
+
+  cluster_problem->linear_solver->SolveInPlace(&rhs);
+  for (int i = 0; i < num_local_views; i++) {
+    cluster_problem->rotations.block<3, 3>(3 * i, 0) =
+        geometry::ProjectToSOd(rhs.block<3, 3>(3 * i, 0));
+  }
+}
+
+// Spawns a worker process, which inherits the shared memory as
+// kWorkerSharedMemoryFd. Returns the process id, or -1.
+pid_t SpawnWorker(const std::string& worker_executable,
+                  const int shared_memory_fd, const int worker) {
+  posix_spawn_file_actions_t file_actions;
+  posix_spawn_file_actions_init(&file_actions);
+  posix_spawn_file_actions_adddup2(&file_actions, shared_memory_fd,
+                                   kWorkerSharedMemoryFd);
+
+  std::string fd_argument = std::to_string(kWorkerSharedMemoryFd);
+  std::string worker_argument = std::to_string(worker);
+  std::vector<char> executable(worker_executable.begin(),
+                               worker_executable.end());
+  executable.push_back('\0');
+  char* argv[] = {executable.data(), &fd_argument[0], &worker_argument[0],
+                  nullptr};
+
+  pid_t pid = -1;
+  const int error = posix_spawnp(&pid, executable.data(), &file_actions,
+                                 nullptr, argv, environ);
+  posix_spawn_file_actions_destroy(&file_actions);
+  if (error != 0) {
+    LOG(ERROR) << "Cannot spawn the worker " << worker_executable << ": "
+               << std::strerror(error);
+    return -1;
+  }
+  return pid;
+}
+
+// Waits for the workers. If a worker failed or was killed, the other workers
+// may wait at a barrier forever, so they are killed. Returns false if a worker
+// did not succeed.
+bool WaitForWorkers(std::vector<pid_t>* workers) {
+  bool success = true;
+  while (!workers->empty()) {
+    int status = 0;
+    const pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      PLOG(ERROR) << "Cannot wait for the workers";
+      return false;
+    }
+    const auto it = std::find(workers->begin(), workers->end(), pid);
+    if (it == workers->end()) {
+      continue;
+    }
+    workers->erase(it);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      if (WIFSIGNALED(status)) {
+        LOG(ERROR) << "Worker " << pid << " was killed by signal "
+                   << WTERMSIG(status) << ".";
+      }
+      if (success) {
+        for (const pid_t worker : *workers) {
+          kill(worker, SIGKILL);
+        }
+      }
+      success = false;
+    }
+  }
+  return success;
+}
+
+}  // namespace
+
+ConsensusADMMRotationEstimator::ConsensusADMMRotationEstimator(
+    const ConsensusADMMRotationEstimator::Options& options)
+    : options_(options) {
+  CHECK_GT(options_.num_workers, 0);
+  CHECK_GT(options_.max_cluster_size, 1);
+  CHECK_GE(options_.overlap_ratio, 0.0);
+  CHECK_GT(options_.penalty, 0.0);
+  CHECK_GT(options_.max_num_iterations, 0);
+  CHECK(!options_.worker_executable.empty());
+}
+
+bool ConsensusADMMRotationEstimator::EstimateRotations(
+    const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+    std::unordered_map<image_t, Eigen::Vector3d>* rotations) {
+  GOPT_PROFILE_SCOPE("ConsensusADMMRotationEstimation");
+  CHECK_NOTNULL(rotations);
+  num_iterations_ = 0;
+
+  std::vector<ImagePair> view_id_pairs;
+  std::vector<image_t> view_ids;
+  std::unordered_map<image_t, int> view_id_to_index;
+  IndexViewPairs(view_pairs, *rotations, &view_id_pairs, &view_ids,
+                 &view_id_to_index);
+
+  const int num_views = view_ids.size();
+  if (num_views == 0) {
+    LOG(ERROR) << "There are no view pairs with initial rotations.";
+    return false;
+  }
+
+  ConsensusProblem problem;
+  problem.initial_rotations.reserve(num_views);
+  for (const image_t view_id : view_ids) {
+    problem.initial_rotations.push_back(
+        geometry::AngleAxisToRotationMatrix(FindOrDie(*rotations, view_id)));
+  }
+  problem.adjacent_edges.resize(num_views);
+  problem.edges.reserve(view_id_pairs.size());
+  problem.relative_rotations.reserve(view_id_pairs.size());
+  std::vector<int> edge_weights;
+  edge_weights.reserve(view_id_pairs.size());
+  for (const ImagePair& view_id_pair : view_id_pairs) {
+    const TwoViewGeometry& two_view_geometry =
+        FindOrDieNoPrint(view_pairs, view_id_pair);
+    const int e = problem.edges.size();
+    problem.edges.emplace_back(
+        FindOrDie(view_id_to_index, view_id_pair.first),
+        FindOrDie(view_id_to_index, view_id_pair.second));
+    problem.relative_rotations.push_back(
+        geometry::AngleAxisToRotationMatrix(two_view_geometry.rotation_2));
+    edge_weights.push_back(std::max(two_view_geometry.visibility_score, 1));
+    problem.adjacent_edges[problem.edges.back().first].push_back(e);
+    problem.adjacent_edges[problem.edges.back().second].push_back(e);
+  }
+
+  graph::OverlappingPartitionOptions partition_options;
+  partition_options.num_threads = options_.num_workers;
+  partition_options.max_cluster_size = options_.max_cluster_size;
+  partition_options.num_hops = 1;
+  partition_options.max_overlap_ratio = options_.overlap_ratio;
+  graph::ComputeOverlappingPartition(num_views, problem.edges, edge_weights,
+                                     partition_options, &problem.partition);
+  const int num_clusters = problem.partition.clusters.size();
+  if (problem.partition.num_overlap_components > 1) {
+    LOG(ERROR) << "The clusters form "
+               << problem.partition.num_overlap_components
+               << " components by their overlaps, whose rotations cannot be "
+                  "aligned.";
+    return false;
+  }
+
+  problem.shared_view_indices.assign(num_views, -1);
+  for (int i = 0; i < num_views; i++) {
+    if (problem.partition.vertex_clusters[i].size() > 1) {
+      problem.shared_view_indices[i] = problem.shared_views.size();
+      problem.shared_views.push_back(i);
+    }
+  }
+  const int num_shared_views = problem.shared_views.size();
+  problem.shared_view_copies.resize(num_shared_views);
+  problem.cluster_copies.assign(1, 0);
+  for (int k = 0; k < num_clusters; k++) {
+    int copy = problem.cluster_copies.back();
+    for (const int view : problem.partition.clusters[k]) {
+      const int s = problem.shared_view_indices[view];
+      if (s >= 0) {
+        problem.shared_view_copies[s].push_back(copy++);
+      }
+    }
+    problem.cluster_copies.push_back(copy);
+  }
+  const int num_copies = problem.cluster_copies.back();
+  const int num_workers = std::min(options_.num_workers, num_clusters);
+  VLOG(1) << num_clusters << " clusters with " << num_shared_views
+          << " shared views are solved by " << num_workers << " workers.";
+
+  std::vector<char> worker_problems;
+  std::vector<size_t> worker_offsets;
+  std::vector<int> local_indices(num_views, -1);
+  for (int w = 0; w < num_workers; w++) {
+    worker_offsets.push_back(worker_problems.size());
+    AppendWorkerProblem(problem, w, num_workers, &local_indices,
+                        &worker_problems);
+  }
+  worker_offsets.push_back(worker_problems.size());
+
+  const size_t state_size = AlignSharedMemory(sizeof(SharedState));
+  const size_t residuals_size =
+      AlignSharedMemory(4 * num_workers * sizeof(double));
+  const size_t consensus_size =
+      AlignSharedMemory(9 * num_shared_views * sizeof(double));
+  const size_t copies_size = AlignSharedMemory(9 * num_copies * sizeof(double));
+  const size_t rotations_size =
+      AlignSharedMemory(9 * num_views * sizeof(double));
+  const size_t worker_offsets_size =
+      AlignSharedMemory((num_workers + 1) * sizeof(size_t));
+  const size_t problems_offset = state_size + residuals_size +
+                                 consensus_size + copies_size +
+                                 rotations_size + worker_offsets_size;
+  SharedMemory shared_memory;
+  if (!shared_memory.Create(problems_offset + worker_problems.size())) {
+    return false;
+  }
+
+  SharedState* state = new (shared_memory.data()) SharedState();
+  state->num_workers = num_workers;
+  state->num_shared_views = num_shared_views;
+  state->num_copies = num_copies;
+  state->verbosity = FLAGS_v;
+  state->penalty = options_.penalty;
+  state->max_num_iterations = options_.max_num_iterations;
+  state->convergence_tolerance = options_.convergence_tolerance;
+  state->linear_solver_options = options_.linear_solver_options;
+  state->residuals_offset = state_size;
+  state->consensus_offset = state->residuals_offset + residuals_size;
+  state->copies_offset = state->consensus_offset + consensus_size;
+  state->rotations_offset = state->copies_offset + copies_size;
+  state->worker_offsets_offset = state->rotations_offset + rotations_size;
+
+  const SharedArrays shared = GetSharedArrays(shared_memory.data());
+  for (int s = 0; s < num_shared_views; s++) {
+    Eigen::Map<Eigen::Matrix3d>(shared.consensus_rotations + 9 * s) =
+        problem.initial_rotations[problem.shared_views[s]];
+  }
+  for (int w = 0; w <= num_workers; w++) {
+    shared.worker_offsets[w] = problems_offset + worker_offsets[w];
+  }
+  std::copy(worker_problems.begin(), worker_problems.end(),
+            shared_memory.data() + problems_offset);
+
+  pthread_barrierattr_t barrier_attributes;
+  pthread_barrierattr_init(&barrier_attributes);
+  pthread_barrierattr_setpshared(&barrier_attributes, PTHREAD_PROCESS_SHARED);
+  const int barrier_error =
+      pthread_barrier_init(&state->barrier, &barrier_attributes, num_workers);
+  pthread_barrierattr_destroy(&barrier_attributes);
+  if (barrier_error != 0) {
+    LOG(ERROR) << "Cannot create a process shared barrier.";
+    return false;
+  }
+
+  std::vector<pid_t> workers;
+  bool success = true;
+  for (int w = 0; w < num_workers; w++) {
+    const pid_t pid =
+        SpawnWorker(options_.worker_executable, shared_memory.fd(), w);
+    if (pid < 0) {
+      for (const pid_t worker : workers) {
+        kill(worker, SIGKILL);
+      }
+      success = false;
+      break;
+    }
+    workers.push_back(pid);
+  }
+  success = WaitForWorkers(&workers) && success;
+  pthread_barrier_destroy(&state->barrier);
+  if (!success) {
+    LOG(ERROR) << "The consensus ADMM failed.";
+    return false;
+  }
+
+  num_iterations_ = state->num_iterations;
+  VLOG(1) << "The consensus ADMM stopped after " << num_iterations_
+          << " iterations.";
+  for (int i = 0; i < num_views; i++) {
+    (*rotations)[view_ids[i]] = geometry::RotationMatrixToAngleAxis(
+        Eigen::Map<const Eigen::Matrix3d>(shared.rotations + 9 * i));
+  }
+  return true;
+}
+
+bool ConsensusADMMRotationEstimator::RunWorker(const int shared_memory_fd,
+                                               const int worker) {
+  SharedMemory shared_memory;
+  if (!shared_memory.Open(shared_memory_fd)) {
+    return false;
+  }
+  const SharedArrays shared = GetSharedArrays(shared_memory.data());
+  SharedState* state = shared.state;
+  const int num_workers = state->num_workers;
+  FLAGS_v = state->verbosity;
+
+  // The workers run in parallel, so each of them is single threaded.
+#ifdef OPENMP_ENABLED
+  omp_set_num_threads(1);
+#endif
+  Eigen::setNbThreads(1);
+
+  const char* cursor = shared_memory.data() + shared.worker_offsets[worker];
+  const int num_worker_clusters = ReadValue<int>(&cursor);
+  std::vector<ClusterProblem> cluster_problems;
+  for (int c = 0; c < num_worker_clusters; c++) {
+    cluster_problems.emplace_back();
+    if (!SetupClusterProblem(*state, &cursor, &cluster_problems.back())) {
+      state->failed = 1;
+      cluster_problems.pop_back();
+    }
+  }
+  const std::vector<int> consensus_views = ReadArray<int>(&cursor);
+  std::vector<std::vector<int>> consensus_view_copies;
+  for (size_t s = 0; s < consensus_views.size(); s++) {
+    consensus_view_copies.push_back(ReadArray<int>(&cursor));
+  }
+
+  int iteration = 0;
+  bool success = true;
+  for (; iteration < state->max_num_iterations; iteration++) {
+    for (ClusterProblem& cluster_problem : cluster_problems) {
+      SolveClusterProblem(shared, &cluster_problem);
+      for (size_t s = 0; s < cluster_problem.shared_local_views.size(); s++) {
+        const int i = cluster_problem.shared_local_views[s];
+        Eigen::Map<Eigen::Matrix3d>(
+            shared.copies + 9 * (cluster_problem.first_copy + s)) =
+            cluster_problem.rotations.block<3, 3>(3 * i, 0) +
+            cluster_problem.duals.block<3, 3>(3 * s, 0);
+      }
+    }
+    pthread_barrier_wait(&state->barrier);
+
+    double dual_residual = 0.0;
+    for (size_t c = 0; c < consensus_views.size(); c++) {
+      Eigen::Matrix3d mean = Eigen::Matrix3d::Zero();
+      for (const int copy : consensus_view_copies[c]) {
+        mean += Eigen::Map<const Eigen::Matrix3d>(shared.copies + 9 * copy);
+      }
+      Eigen::Map<Eigen::Matrix3d> consensus_rotation(
+          shared.consensus_rotations + 9 * consensus_views[c]);
+      const Eigen::Matrix3d previous_rotation = consensus_rotation;
+      consensus_rotation = geometry::ProjectToSOd(mean);
+      dual_residual += state->penalty * state->penalty *
+                       (consensus_rotation - previous_rotation).squaredNorm();
+    }
+    pthread_barrier_wait(&state->barrier);
+
+    double primal_residual = 0.0;
+    for (ClusterProblem& cluster_problem : cluster_problems) {
+      for (size_t s = 0; s < cluster_problem.shared_local_views.size(); s++) {
+        const int i = cluster_problem.shared_local_views[s];
+        const Eigen::Map<const Eigen::Matrix3d> consensus_rotation(
+            shared.consensus_rotations +
+            9 * cluster_problem.shared_view_indices[i]);
+        const Eigen::Matrix3d residual =
+            cluster_problem.rotations.block<3, 3>(3 * i, 0) -
+            consensus_rotation;
+        cluster_problem.duals.block<3, 3>(3 * s, 0) += residual;
+        primal_residual += residual.squaredNorm();
+      }
+    }
+    double* residuals =
+        shared.residuals + 2 * (num_workers * (iteration % 2) + worker);
+    residuals[0] = primal_residual;
+    residuals[1] = dual_residual;
+    pthread_barrier_wait(&state->barrier);
+
+    if (state->failed != 0) {
+      success = false;
+      break;
+    }
+    primal_residual = 0.0;
+    dual_residual = 0.0;
+    for (int w = 0; w < num_workers; w++) {
+      residuals = shared.residuals + 2 * (num_workers * (iteration % 2) + w);
+      primal_residual += residuals[0];
+      dual_residual += residuals[1];
+    }
+    primal_residual =
+        std::sqrt(primal_residual / std::max(state->num_copies, 1));
+    dual_residual =
+        std::sqrt(dual_residual / std::max(state->num_shared_views, 1));
+    VLOG_IF(2, worker == 0) << "Iteration " << iteration
+                            << ", primal residual: " << primal_residual
+                            << ", dual residual: " << dual_residual;
+    if (primal_residual < state->convergence_tolerance &&
+        dual_residual < state->convergence_tolerance) {
+      iteration++;
+      break;
+    }
+  }
+
+  if (!success) {
+    return false;
+  }
+  if (worker == 0) {
+    state->num_iterations = iteration;
+  }
+
+  // Each view is written by the worker of its disjoint cluster, with the
+  // consensus rotation if it is shared.
+  for (const ClusterProblem& cluster_problem : cluster_problems) {
+    for (size_t i = 0; i < cluster_problem.views.size(); i++) {
+      if (!cluster_problem.owned_views[i]) {
+        continue;
+      }
+      Eigen::Map<Eigen::Matrix3d> rotation(shared.rotations +
+                                           9 * cluster_problem.views[i]);
+      const int s = cluster_problem.shared_view_indices[i];
+      if (s >= 0) {
+        rotation = Eigen::Map<const Eigen::Matrix3d>(
+            shared.consensus_rotations + 9 * s);
+      } else {
+        rotation = cluster_problem.rotations.block<3, 3>(3 * i, 0);
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace gopt
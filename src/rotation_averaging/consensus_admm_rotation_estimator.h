@@ -0,0 +1,103 @@
+#ifndef ROTATION_AVERAGING_CONSENSUS_ADMM_ROTATION_ESTIMATOR_H_
+#define ROTATION_AVERAGING_CONSENSUS_ADMM_ROTATION_ESTIMATOR_H_
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "rotation_averaging/rotation_estimator.h"
+#include "solver/solver_options.h"
+#include "util/util.h"
+
+#ifndef GOPT_CONSENSUS_ADMM_WORKER
+#define GOPT_CONSENSUS_ADMM_WORKER "consensus_admm_worker"
+#endif
+
+namespace gopt {
+
+// Rotation averaging by consensus ADMM over worker processes on a single host,
+// for view graphs whose problems do not fit into the memory of one process.
+//
+// The view graph is partitioned into clusters of about max_cluster_size views,
+// which are expanded by their neighboring views so that adjacent clusters
+// share views. Each cluster k holds its own copies R_v^k of the rotations of
+// its views, and the copies of a shared view v are constrained to a consensus
+// rotation Z_v. Each iteration
+//
+//   1. solves the chordal problem of each cluster
+//        min sum_(i,j) || R_j - R_ij * R_i ||_F^2
+//            + rho / 2 * sum_v || R_v - Z_v + U_v ||_F^2,
+//      by a sparse linear system whose matrix is factorized once, and
+//      projects the solution onto SO(3),
+//   2. sets Z_v to the projection of the mean of R_v^k + U_v^k,
+//   3. updates the scaled duals U_v^k += R_v^k - Z_v.
+//
+// The clusters are distributed round robin over num_workers processes, which
+// are spawned from the consensus_admm_worker executable rather than forked, as
+// the calling process may run threads, e.g. of OpenMP, which do not survive a
+// fork(). The estimator writes the views, edges and rotations of the clusters
+// of each worker to POSIX shared memory, and each worker reads and builds only
+// the linear systems of its own clusters. The consensus rotations, the copies
+// of the shared views and the residuals are exchanged through the same shared
+// memory, and the workers are synchronized by a process shared barrier.
+class ConsensusADMMRotationEstimator : public RotationEstimator {
+ public:
+  struct Options {
+    // Number of worker processes. At most one worker per cluster is spawned.
+    int num_workers = 4;
+
+    // Maximum number of views of a cluster before its expansion.
+    int max_cluster_size = 2000;
+
+    // Each cluster is expanded by its neighboring views, at most overlap_ratio
+    // times its size.
+    double overlap_ratio = 0.2;
+
+    // Penalty of the consensus constraints R_v^k = Z_v.
+    double penalty = 1.0;
+
+    int max_num_iterations = 200;
+
+    // The iterations stop when the RMS of the primal residuals R_v^k - Z_v and
+    // of the dual residuals rho * (Z_v - Z_v^prev) are below the tolerance.
+    double convergence_tolerance = 1e-6;
+
+    solver::LinearSolverOptions linear_solver_options;
+
+    // The worker executable, which is searched in PATH if it has no slash. It
+    // defaults to the consensus_admm_worker of the build tree.
+    std::string worker_executable = GOPT_CONSENSUS_ADMM_WORKER;
+  };
+
+  explicit ConsensusADMMRotationEstimator(
+      const ConsensusADMMRotationEstimator::Options& options);
+
+  // The rotations of the views must be initialized, e.g. by a spanning tree,
+  // as the consensus rotations start from them. Returns false if a worker
+  // failed, or if the overlaps of the clusters are not connected, in which
+  // case the rotations of the components would be in unrelated frames.
+  bool EstimateRotations(
+      const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+      std::unordered_map<image_t, Eigen::Vector3d>* rotations) override;
+
+  // Number of iterations of the last estimation.
+  int NumIterations() const { return num_iterations_; }
+
+  // The entry point of the worker processes, which map the shared memory of
+  // the estimator from the inherited descriptor. Returns false if the worker
+  // or another worker failed.
+  static bool RunWorker(const int shared_memory_fd, const int worker);
+
+ private:
+  const ConsensusADMMRotationEstimator::Options options_;
+  int num_iterations_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(ConsensusADMMRotationEstimator);
+};
+
+}  // namespace gopt
+
+#endif  // ROTATION_AVERAGING_CONSENSUS_ADMM_ROTATION_ESTIMATOR_H_
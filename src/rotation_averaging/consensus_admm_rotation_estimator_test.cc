@@ -0,0 +1,65 @@
+#include "rotation_averaging/consensus_admm_rotation_estimator.h"
+
+#include <unordered_map>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "geometry/rotation_utils.h"
+#include "rotation_averaging/test_util.h"
+#include "util/random.h"
+
+namespace gopt {
+class ConsensusADMMRotationEstimatorTest : public RotationAveragingTest {
+ public:
+  ConsensusADMMRotationEstimatorTest() : RotationAveragingTest(73) {}
+
+  void TestConsensusADMMRotationEstimator(
+      const int num_views, const int num_neighbors, const int num_workers,
+      const int max_cluster_size, const double rotation_noise_degrees,
+      const double tolerance_degrees) {
+    CreateGTRotations(num_views);
+    CreateRelativeRotations(num_neighbors, rotation_noise_degrees);
+
+    ConsensusADMMRotationEstimator::Options options;
+    options.num_workers = num_workers;
+    options.max_cluster_size = max_cluster_size;
+    ConsensusADMMRotationEstimator rotation_estimator(options);
+
+    // The initial rotations are the ground truth in another frame, perturbed
+    // by 5 degrees.
+    const Eigen::Vector3d alignment = rng_.RandVector3d();
+    std::unordered_map<image_t, Eigen::Vector3d> estimated_rotations;
+    for (const auto& rotation : rotations_) {
+      estimated_rotations[rotation.first] = geometry::MultiplyRotations(
+          geometry::MultiplyRotations(rotation.second, alignment),
+          geometry::DegToRad(5.0) * rng_.RandVector3d().normalized());
+    }
+    EXPECT_TRUE(rotation_estimator.EstimateRotations(view_pairs_,
+                                                     &estimated_rotations));
+    EXPECT_EQ(estimated_rotations.size(), rotations_.size());
+    EXPECT_GT(rotation_estimator.NumIterations(), 0);
+    EXPECT_LE(rotation_estimator.NumIterations(), options.max_num_iterations);
+
+    // Rotations are recovered up to a rotation G.
+    EXPECT_LT(geometry::ComputeMeanRotationErrorDegrees(rotations_,
+                                                        estimated_rotations),
+              tolerance_degrees);
+  }
+};
+
+TEST_F(ConsensusADMMRotationEstimatorTest, SingleCluster) {
+  TestConsensusADMMRotationEstimator(40, 4, 2, 100, 0.0, 1e-6);
+}
+
+TEST_F(ConsensusADMMRotationEstimatorTest, ClustersReachConsensus) {
+  TestConsensusADMMRotationEstimator(400, 4, 3, 50, 0.0, 0.1);
+}
+
+TEST_F(ConsensusADMMRotationEstimatorTest, ClustersWithNoise) {
+  TestConsensusADMMRotationEstimator(400, 6, 4, 80, 2.0, 3.0);
+}
+
+}  // namespace gopt
@@ -0,0 +1,22 @@
+#include <cstdlib>
+
+#include <glog/logging.h>
+
+#include "rotation_averaging/consensus_admm_rotation_estimator.h"
+
+// A worker process of ConsensusADMMRotationEstimator, which spawns it with the
+// descriptor of its shared memory and the index of the worker.
+int main(int argc, char* argv[]) {
+  google::InitGoogleLogging(argv[0]);
+  FLAGS_logtostderr = true;
+
+  if (argc != 3) {
+    LOG(ERROR) << "[Usage]: consensus_admm_worker shared_memory_fd worker";
+    return EXIT_FAILURE;
+  }
+
+  return gopt::ConsensusADMMRotationEstimator::RunWorker(std::atoi(argv[1]),
+                                                         std::atoi(argv[2]))
+             ? EXIT_SUCCESS
+             : EXIT_FAILURE;
+}
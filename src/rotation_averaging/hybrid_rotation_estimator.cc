@@ -52,10 +52,12 @@ bool HybridRotationEstimator::EstimateRotations(
   internal::ViewIdToAscentIndex(*global_rotations, &view_id_to_index_);
   ld_rotation_estimator_->SetViewIdToIndex(view_id_to_index_);
 
-  Eigen::SparseMatrix<double> sparse_matrix;
+  const std::shared_ptr<Eigen::SparseMatrix<double>> sparse_matrix =
+      std::make_shared<Eigen::SparseMatrix<double>>();
   internal::SetupLinearSystem(
       view_pairs, (*global_rotations).size(),
-      view_id_to_index_, &sparse_matrix);
+      view_id_to_index_, sparse_matrix.get(),
+      options_.irls_options.num_threads);
   irls_rotation_refiner_->SetViewIdToIndex(view_id_to_index_);
   irls_rotation_refiner_->SetSparseMatrix(sparse_matrix);
 
@@ -1,7 +1,9 @@
 #ifndef ROTATION_AVERAGING_INTERNAL_ROTATION_ESTIMATOR_UTIL_H_
 #define ROTATION_AVERAGING_INTERNAL_ROTATION_ESTIMATOR_UTIL_H_
 
+#include <algorithm>
 #include <unordered_map>
+#include <vector>
 
 #include <Eigen/Core>
 #include <Eigen/SparseCore>
@@ -9,6 +11,7 @@
 #include "util/hash.h"
 #include "util/types.h"
 #include "util/map_util.h"
+#include "util/profiler.h"
 
 namespace gopt {
 namespace internal {
@@ -32,51 +35,85 @@ static inline void ViewIdToAscentIndex(
 // Sets up the sparse linear system such that dR_ij = dR_j - dR_i. This is the
 // first-order approximation of the angle-axis rotations. This should only be
 // called once.
+//
+// The rows 3k, 3k + 1 and 3k + 2 belong to the k-th relative rotation, so
+// every row has at most two entries, -1 and 1, at known columns. The
+// compressed column storage is therefore filled directly, without triplets
+// and sorting: the number of relative rotations of each view gives the offsets
+// of its columns, and the columns of the views are filled in parallel.
 static inline void SetupLinearSystem(
     const std::unordered_map<ImagePair, TwoViewGeometry>& relative_rotations,
     const size_t num_rotations,
     const std::unordered_map<image_t, int>& view_id_to_index,
-    Eigen::SparseMatrix<double>* sparse_matrix) {
+    Eigen::SparseMatrix<double>* sparse_matrix, const int num_threads = 1) {
+  GOPT_PROFILE_SCOPE("SetupLinearSystem");
+
   // The rotation change is one less than the number of global rotations because
   // we keep one rotation constant.
-  (*sparse_matrix).resize(
-      relative_rotations.size() * 3, (num_rotations - 1) * 3);
-
+  const int num_views = num_rotations - 1;
+  const int num_edges = relative_rotations.size();
   const int kStartRotationIndex = -1;
 
-  // For each relative rotation constraint, add an entry to the sparse
-  // matrix. We use the first order approximation of angle axis such that:
-  // R_ij = R_j - R_i. This makes the sparse matrix just a bunch of identity
-  // matrices.
+  // The views of each relative rotation, in the order of the residuals.
+  std::vector<int> view1_indices(num_edges), view2_indices(num_edges);
   int rotation_error_index = 0;
-  std::vector<Eigen::Triplet<double>> triplet_list;
   for (const auto& relative_rotation : relative_rotations) {
-    const int view1_index =
+    view1_indices[rotation_error_index] =
         FindOrDie(view_id_to_index, relative_rotation.first.first) - 1;
-    if (view1_index != kStartRotationIndex) {
-      triplet_list.emplace_back(3 * rotation_error_index + 0,
-                                3 * view1_index + 0, -1.0);
-      triplet_list.emplace_back(3 * rotation_error_index + 1,
-                                3 * view1_index + 1, -1.0);
-      triplet_list.emplace_back(3 * rotation_error_index + 2,
-                                3 * view1_index + 2, -1.0);
-    }
-
-    const int view2_index =
+    view2_indices[rotation_error_index] =
         FindOrDie(view_id_to_index, relative_rotation.first.second) - 1;
-    if (view2_index != kStartRotationIndex) {
-      triplet_list.emplace_back(3 * rotation_error_index + 0,
-                                3 * view2_index + 0, 1.0);
-      triplet_list.emplace_back(3 * rotation_error_index + 1,
-                                3 * view2_index + 1, 1.0);
-      triplet_list.emplace_back(3 * rotation_error_index + 2,
-                                3 * view2_index + 2, 1.0);
-    }
-
     ++rotation_error_index;
   }
 
-  sparse_matrix->setFromTriplets(triplet_list.begin(), triplet_list.end());
+  // The relative rotations of each view in increasing order, which keeps the
+  // rows of each column sorted.
+  std::vector<int> view_offsets(num_views + 1, 0);
+  for (int k = 0; k < num_edges; k++) {
+    if (view1_indices[k] != kStartRotationIndex) {
+      ++view_offsets[view1_indices[k] + 1];
+    }
+    if (view2_indices[k] != kStartRotationIndex) {
+      ++view_offsets[view2_indices[k] + 1];
+    }
+  }
+  for (int v = 0; v < num_views; v++) {
+    view_offsets[v + 1] += view_offsets[v];
+  }
+  std::vector<int> view_edges(view_offsets[num_views]);
+  std::vector<int> next_view_edge(view_offsets.begin(), view_offsets.end() - 1);
+  for (int k = 0; k < num_edges; k++) {
+    if (view1_indices[k] != kStartRotationIndex) {
+      view_edges[next_view_edge[view1_indices[k]]++] = k;
+    }
+    if (view2_indices[k] != kStartRotationIndex) {
+      view_edges[next_view_edge[view2_indices[k]]++] = k;
+    }
+  }
+
+  sparse_matrix->resize(num_edges * 3, num_views * 3);
+  sparse_matrix->resizeNonZeros(3 * view_offsets[num_views]);
+  int* outer_indices = sparse_matrix->outerIndexPtr();
+  int* inner_indices = sparse_matrix->innerIndexPtr();
+  double* values = sparse_matrix->valuePtr();
+
+  // For each relative rotation constraint, add an entry to the sparse
+  // matrix. We use the first order approximation of angle axis such that:
+  // R_ij = R_j - R_i. This makes the sparse matrix just a bunch of identity
+  // matrices.
+#pragma omp parallel for num_threads(num_threads)
+  for (int v = 0; v < num_views; v++) {
+    const int num_view_edges = view_offsets[v + 1] - view_offsets[v];
+    for (int c = 0; c < 3; c++) {
+      const int column_offset = 3 * view_offsets[v] + c * num_view_edges;
+      outer_indices[3 * v + c] = column_offset;
+      for (int i = 0; i < num_view_edges; i++) {
+        const int k = view_edges[view_offsets[v] + i];
+        inner_indices[column_offset + i] = 3 * k + c;
+        values[column_offset + i] = view1_indices[k] == v ? -1.0 : 1.0;
+      }
+    }
+  }
+  outer_indices[3 * num_views] = 3 * view_offsets[num_views];
 }
 
 }  // namespace internal
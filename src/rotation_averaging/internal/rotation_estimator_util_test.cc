@@ -0,0 +1,100 @@
+#include "rotation_averaging/internal/rotation_estimator_util.h"
+
+#include <unordered_map>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+#include <gtest/gtest.h>
+
+#include "util/map_util.h"
+#include "util/random.h"
+
+namespace gopt {
+namespace {
+
+// The system dR_ij = dR_j - dR_i assembled from triplets, without the columns
+// of the constant rotation of index 0.
+Eigen::SparseMatrix<double> SetupLinearSystemFromTriplets(
+    const std::unordered_map<ImagePair, TwoViewGeometry>& relative_rotations,
+    const size_t num_rotations,
+    const std::unordered_map<image_t, int>& view_id_to_index) {
+  std::vector<Eigen::Triplet<double>> triplets;
+  int rotation_error_index = 0;
+  for (const auto& relative_rotation : relative_rotations) {
+    const int view1_index =
+        FindOrDie(view_id_to_index, relative_rotation.first.first) - 1;
+    const int view2_index =
+        FindOrDie(view_id_to_index, relative_rotation.first.second) - 1;
+    for (int c = 0; c < 3; c++) {
+      if (view1_index >= 0) {
+        triplets.emplace_back(3 * rotation_error_index + c,
+                              3 * view1_index + c, -1.0);
+      }
+      if (view2_index >= 0) {
+        triplets.emplace_back(3 * rotation_error_index + c,
+                              3 * view2_index + c, 1.0);
+      }
+    }
+    ++rotation_error_index;
+  }
+
+  Eigen::SparseMatrix<double> sparse_matrix(3 * relative_rotations.size(),
+                                            3 * (num_rotations - 1));
+  sparse_matrix.setFromTriplets(triplets.begin(), triplets.end());
+  return sparse_matrix;
+}
+
+}  // namespace
+
+TEST(RotationEstimatorUtil, SetupLinearSystemMatchesTriplets) {
+  static const int kNumViews = 50;
+  static const int kNumViewPairs = 200;
+  RandomNumberGenerator rng(67);
+
+  // The view ids are not contiguous, and the smallest id is the constant view.
+  std::unordered_map<image_t, Eigen::Vector3d> rotations;
+  for (int i = 0; i < kNumViews; i++) {
+    rotations[3 * i + 5] = rng.RandVector3d();
+  }
+  std::unordered_map<image_t, int> view_id_to_index;
+  internal::ViewIdToAscentIndex(rotations, &view_id_to_index);
+  ASSERT_EQ(FindOrDie(view_id_to_index, 5), 0);
+
+  // Some relative rotations of the constant view, in both orders of the pair.
+  std::unordered_map<ImagePair, TwoViewGeometry> relative_rotations;
+  relative_rotations[ImagePair(5, 8)] = TwoViewGeometry();
+  relative_rotations[ImagePair(5, 3 * (kNumViews - 1) + 5)] =
+      TwoViewGeometry();
+  while (relative_rotations.size() < static_cast<size_t>(kNumViewPairs)) {
+    const image_t view_id1 = 3 * rng.RandInt(0, kNumViews - 1) + 5;
+    const image_t view_id2 = 3 * rng.RandInt(0, kNumViews - 1) + 5;
+    if (view_id1 != view_id2) {
+      relative_rotations[ImagePair(view_id1, view_id2)] = TwoViewGeometry();
+    }
+  }
+
+  const Eigen::SparseMatrix<double> expected_matrix =
+      SetupLinearSystemFromTriplets(relative_rotations, kNumViews,
+                                    view_id_to_index);
+  for (const int num_threads : {1, 4}) {
+    Eigen::SparseMatrix<double> sparse_matrix;
+    internal::SetupLinearSystem(relative_rotations, kNumViews,
+                                view_id_to_index, &sparse_matrix, num_threads);
+    ASSERT_TRUE(sparse_matrix.isCompressed());
+    ASSERT_EQ(sparse_matrix.rows(), expected_matrix.rows());
+    ASSERT_EQ(sparse_matrix.cols(), expected_matrix.cols());
+    ASSERT_EQ(sparse_matrix.nonZeros(), expected_matrix.nonZeros());
+    for (int col = 0; col <= expected_matrix.cols(); col++) {
+      ASSERT_EQ(sparse_matrix.outerIndexPtr()[col],
+                expected_matrix.outerIndexPtr()[col]);
+    }
+    for (int i = 0; i < expected_matrix.nonZeros(); i++) {
+      EXPECT_EQ(sparse_matrix.innerIndexPtr()[i],
+                expected_matrix.innerIndexPtr()[i]);
+      EXPECT_EQ(sparse_matrix.valuePtr()[i], expected_matrix.valuePtr()[i]);
+    }
+  }
+}
+
+}  // namespace gopt
@@ -1,14 +1,17 @@
 #include "rotation_averaging/irls_rotation_local_refiner.h"
 
+#include <cmath>
 #include <iomanip>
 #include <iostream>
+#include <vector>
 #include <glog/logging.h>
 
 #include "rotation_averaging/rotation_estimator.h"
 #include "rotation_averaging/internal/rotation_estimator_util.h"
 #include "geometry/rotation_utils.h"
-#include "math/sparse_cholesky_llt.h"
+#include "math/selected_inversion.h"
 #include "util/map_util.h"
+#include "util/profiler.h"
 #include "util/types.h"
 #include "util/timer.h"
 
@@ -35,13 +38,19 @@ void IRLSRotationLocalRefiner::SetViewIdToIndex(
 }
 
 void IRLSRotationLocalRefiner::SetSparseMatrix(
-    const Eigen::SparseMatrix<double>& sparse_matrix) {
+    const std::shared_ptr<const Eigen::SparseMatrix<double>>& sparse_matrix) {
   sparse_matrix_ = sparse_matrix;
 }
 
+void IRLSRotationLocalRefiner::SetSymbolicFactorizationCache(
+    const std::shared_ptr<SymbolicFactorizationCache>& cache) {
+  symbolic_factorization_cache_ = cache;
+}
+
 bool IRLSRotationLocalRefiner::SolveIRLS(
     const std::unordered_map<ImagePair, TwoViewGeometry>& relative_rotations,
     std::unordered_map<image_t, Eigen::Vector3d>* global_rotations) {
+  GOPT_PROFILE_SCOPE("IRLS");
   const int num_edges = relative_rotations.size();
 
   CHECK_NOTNULL(global_rotations);
@@ -52,18 +61,24 @@ bool IRLSRotationLocalRefiner::SolveIRLS(
     internal::ViewIdToAscentIndex(*global_rotations, &view_id_to_index_);
   }
 
-  if (sparse_matrix_.rows() == 0) {
+  if (sparse_matrix_ == nullptr) {
+    std::shared_ptr<Eigen::SparseMatrix<double>> sparse_matrix =
+        std::make_shared<Eigen::SparseMatrix<double>>();
     internal::SetupLinearSystem(
         relative_rotations, (*global_rotations).size(),
-        view_id_to_index_, &sparse_matrix_);
+        view_id_to_index_, sparse_matrix.get(), options_.num_threads);
+    sparse_matrix_ = sparse_matrix;
   }
+  const Eigen::SparseMatrix<double>& sparse_matrix = *sparse_matrix_;
 
   // Set up the linear solver and analyze the sparsity pattern of the
   // system. Since the sparsity pattern will not change with each linear solve
   // this can help speed up the solution time.
-  SparseCholeskyLLt linear_solver;
-  linear_solver.AnalyzePattern(sparse_matrix_.transpose() * sparse_matrix_);
-  if (linear_solver.Info() != Eigen::Success) {
+  std::unique_ptr<SparseLinearSolver> linear_solver =
+      SparseLinearSolver::Create(options_.linear_solver_options);
+  linear_solver->SetSymbolicFactorizationCache(symbolic_factorization_cache_);
+  linear_solver->AnalyzePattern(sparse_matrix.transpose() * sparse_matrix);
+  if (linear_solver->Info() != Eigen::Success) {
     LOG(ERROR) << "Cholesky decomposition failed.";
     return false;
   }
@@ -74,7 +89,13 @@ bool IRLSRotationLocalRefiner::SolveIRLS(
 
   ComputeResiduals(relative_rotations, global_rotations);
 
+  sparse_matrix_transpose_ = sparse_matrix.transpose();
+
   Eigen::ArrayXd weights(num_edges * 3);
+  // The weights of the current factorization, which lag behind weights for
+  // the edges whose weights barely changed if the factorization is updated.
+  Eigen::ArrayXd factorized_weights;
+  bool factor_modified = false;
   Eigen::SparseMatrix<double> at_weight;
   Timer timer;
   timer.Start();
@@ -89,18 +110,40 @@ bool IRLSRotationLocalRefiner::SolveIRLS(
       weights.segment<3>(3 * k).setConstant(w);
     }
 
-    // Update the factorization for the weighted values.
-    at_weight = sparse_matrix_.transpose() * weights.matrix().asDiagonal();
-    linear_solver.Factorize(at_weight * sparse_matrix_);
-    if (linear_solver.Info() != Eigen::Success) {
-      LOG(ERROR) << "Failed to factorize the least squares system.";
-      return false;
+    // Update the factorization for the weighted values. If only a few weights
+    // changed, the factorization is updated instead of being recomputed.
+    if (factorized_weights.size() == 0 ||
+        !UpdateFactorization(weights, &factorized_weights, linear_solver.get(),
+                             &factor_modified)) {
+      factorized_weights = weights;
+      at_weight =
+          sparse_matrix_transpose_ * factorized_weights.matrix().asDiagonal();
+      const Eigen::SparseMatrix<double> lhs = at_weight * sparse_matrix;
+
+      // Updates turn a supernodal factor into a simplicial one, which the
+      // numeric factorization would keep, so the pattern is analyzed again.
+      if (factor_modified) {
+        linear_solver->AnalyzePattern(lhs);
+        if (linear_solver->Info() != Eigen::Success) {
+          LOG(ERROR) << "Cholesky decomposition failed.";
+          return false;
+        }
+        factor_modified = false;
+      }
+      linear_solver->Factorize(lhs);
+      if (linear_solver->Info() != Eigen::Success) {
+        LOG(ERROR) << "Failed to factorize the least squares system.";
+        return false;
+      }
+    } else {
+      at_weight =
+          sparse_matrix_transpose_ * factorized_weights.matrix().asDiagonal();
     }
 
     // Solve the least squares problem.
-    tangent_space_step_ =
-        linear_solver.Solve(at_weight * tangent_space_residual_);
-    if (linear_solver.Info() != Eigen::Success) {
+    tangent_space_step_ = at_weight * tangent_space_residual_;
+    linear_solver->SolveInPlace(&tangent_space_step_);
+    if (linear_solver->Info() != Eigen::Success) {
       LOG(ERROR) << "Failed to solve the least squares system.";
       return false;
     }
@@ -123,6 +166,126 @@ bool IRLSRotationLocalRefiner::SolveIRLS(
 
   LOG(INFO) << "Total time [IRLS]: "
             << timer.ElapsedMicroSeconds() * 1e-3 << " ms.";
+
+  if (options_.compute_covariances &&
+      !ComputeCovariances(relative_rotations, linear_solver.get())) {
+    LOG(WARNING) << "Failed to compute the covariances of the rotations.";
+  }
+  return true;
+}
+
+const std::unordered_map<image_t, Eigen::Matrix3d>&
+IRLSRotationLocalRefiner::GetCovariances() const {
+  return covariances_;
+}
+
+const std::unordered_map<ImagePair, Eigen::Matrix3d>&
+IRLSRotationLocalRefiner::GetEdgeCovariances() const {
+  return edge_covariances_;
+}
+
+bool IRLSRotationLocalRefiner::ComputeCovariances(
+    const std::unordered_map<ImagePair, TwoViewGeometry>& relative_rotations,
+    SparseLinearSolver* linear_solver) {
+  GOPT_PROFILE_SCOPE("IRLSCovariances");
+  covariances_.clear();
+  edge_covariances_.clear();
+
+  // Only the entries on the pattern of the factor are computed, which contains
+  // the diagonal blocks and the blocks of the edges.
+  Eigen::SparseMatrix<double> inverse;
+  if (!linear_solver->ComputeSelectedInverse(&inverse)) {
+    return false;
+  }
+
+  for (const auto& view : view_id_to_index_) {
+    const int view_index = view.second - 1;
+    if (view_index == kConstantRotationIndex) {
+      covariances_[view.first].setZero();
+      continue;
+    }
+    covariances_[view.first] = GetSymmetricBlock(
+        inverse, 3 * view_index, 3 * view_index, 3, 3);
+  }
+
+  if (!options_.compute_edge_covariances) {
+    return true;
+  }
+  for (const auto& relative_rotation : relative_rotations) {
+    const int view_index1 =
+        FindOrDie(view_id_to_index_, relative_rotation.first.first) - 1;
+    const int view_index2 =
+        FindOrDie(view_id_to_index_, relative_rotation.first.second) - 1;
+    Eigen::Matrix3d& edge_covariance = edge_covariances_[relative_rotation.first];
+    if (view_index1 == kConstantRotationIndex ||
+        view_index2 == kConstantRotationIndex) {
+      edge_covariance.setZero();
+      continue;
+    }
+    edge_covariance = GetSymmetricBlock(inverse, 3 * view_index1,
+                                        3 * view_index2, 3, 3);
+  }
+  return true;
+}
+
+bool IRLSRotationLocalRefiner::UpdateFactorization(
+    const Eigen::ArrayXd& weights, Eigen::ArrayXd* factorized_weights,
+    SparseLinearSolver* linear_solver, bool* factor_modified) {
+  const int num_edges = weights.size() / 3;
+  std::vector<int> changed_edges;
+  for (int k = 0; k < num_edges; k++) {
+    const double factorized_weight = (*factorized_weights)(3 * k);
+    if (std::abs(weights(3 * k) - factorized_weight) >
+        options_.weight_update_tolerance * factorized_weight) {
+      changed_edges.push_back(k);
+    }
+  }
+  if (changed_edges.size() >
+      options_.max_weight_update_ratio * static_cast<double>(num_edges)) {
+    return false;
+  }
+
+  // Changing the weight of an edge by delta changes A^t * W * A by delta times
+  // the outer products of the three rows of the edge, so the rows scaled by
+  // sqrt(|delta|) are the columns of the update (delta > 0) or the downdate.
+  std::vector<Eigen::Triplet<double>> update_triplets, downdate_triplets;
+  int num_update_columns = 0, num_downdate_columns = 0;
+  for (const int k : changed_edges) {
+    const double delta = weights(3 * k) - (*factorized_weights)(3 * k);
+    const double scale = std::sqrt(std::abs(delta));
+    std::vector<Eigen::Triplet<double>>& triplets =
+        delta > 0.0 ? update_triplets : downdate_triplets;
+    int& num_columns = delta > 0.0 ? num_update_columns : num_downdate_columns;
+    for (int row = 3 * k; row < 3 * k + 3; row++) {
+      for (Eigen::SparseMatrix<double>::InnerIterator it(
+               sparse_matrix_transpose_, row);
+           it; ++it) {
+        triplets.emplace_back(it.row(), num_columns, scale * it.value());
+      }
+      ++num_columns;
+    }
+  }
+
+  // Update before downdating, which keeps the intermediate matrix positive
+  // definite.
+  Eigen::SparseMatrix<double> update(sparse_matrix_->cols(),
+                                     num_update_columns);
+  update.setFromTriplets(update_triplets.begin(), update_triplets.end());
+  Eigen::SparseMatrix<double> downdate(sparse_matrix_->cols(),
+                                       num_downdate_columns);
+  downdate.setFromTriplets(downdate_triplets.begin(), downdate_triplets.end());
+  *factor_modified = *factor_modified || !changed_edges.empty();
+  if (!linear_solver->UpdateDowndate(true, update) ||
+      !linear_solver->UpdateDowndate(false, downdate)) {
+    VLOG(2) << "Failed to update the factorization, refactorizing.";
+    return false;
+  }
+
+  VLOG(2) << "Updated the factorization with " << changed_edges.size()
+          << " edges.";
+  for (const int k : changed_edges) {
+    factorized_weights->segment<3>(3 * k) = weights.segment<3>(3 * k);
+  }
   return true;
 }
 
@@ -3,9 +3,13 @@
 
 #include <vector>
 #include <utility>
+#include <memory>
 #include <unordered_map>
 
 #include "geometry/rotation_utils.h"
+#include "math/symbolic_factorization_cache.h"
+#include "solver/solver_options.h"
+#include "solver/sparse_linear_solver.h"
 #include "util/types.h"
 
 #include <Eigen/Core>
@@ -27,6 +31,27 @@ class IRLSRotationLocalRefiner {
     // This is the point where the Huber-like cost function switches from L1 to
     // L2.
     double irls_loss_parameter_sigma = geometry::DegToRad(5.0);
+
+    // The solver of the weighted normal equations.
+    solver::LinearSolverOptions linear_solver_options;
+
+    // If the weights of at most this fraction of the edges changed by more
+    // than weight_update_tolerance (relative to the factorized weight) since
+    // the last factorization, the factorization is updated and downdated by
+    // the rank-3 terms of these edges instead of being recomputed. The other
+    // edges keep their factorized weights, so the iterations only approximate
+    // IRLS. Disabled by default (0), which always refactorizes. Only the
+    // CHOLMOD backend supports updates.
+    double max_weight_update_ratio = 0.0;
+    double weight_update_tolerance = 0.01;
+
+    // Computes the covariances of the rotations from the factorization of the
+    // last iteration by selected inversion (see GetCovariances()), and also the
+    // cross covariances of the views of each relative rotation if
+    // compute_edge_covariances is set. Requires a Cholesky backend of the
+    // linear solver.
+    bool compute_covariances = false;
+    bool compute_edge_covariances = false;
   };
 
   IRLSRotationLocalRefiner(
@@ -37,12 +62,32 @@ class IRLSRotationLocalRefiner {
 
   void SetViewIdToIndex(const std::unordered_map<image_t, int>& view_id_to_index);
 
-  void SetSparseMatrix(const Eigen::SparseMatrix<double>& sparse_matrix);
+  // Shares the matrix A of the linear system with the other stages.
+  void SetSparseMatrix(
+      const std::shared_ptr<const Eigen::SparseMatrix<double>>& sparse_matrix);
+
+  // Shares the symbolic analysis of the normal equations with other solvers.
+  void SetSymbolicFactorizationCache(
+      const std::shared_ptr<SymbolicFactorizationCache>& cache);
 
   bool SolveIRLS(
       const std::unordered_map<ImagePair, TwoViewGeometry>& relative_rotations,
       std::unordered_map<image_t, Eigen::Vector3d>* global_rotations);
 
+  // The 3x3 covariances of the tangent space errors of the rotations, i.e. the
+  // diagonal blocks of (A^t * W * A)^{-1} with the weights W of the last
+  // iteration, up to the scale of the noise of the relative rotations. The
+  // covariances are relative to the constant rotation, whose covariance is
+  // zero. Since the axes of the linearized system are decoupled, the
+  // covariances are diagonal. Only computed if compute_covariances is set.
+  const std::unordered_map<image_t, Eigen::Matrix3d>& GetCovariances() const;
+
+  // The cross covariances of the two views of each relative rotation, i.e. the
+  // off-diagonal blocks of (A^t * W * A)^{-1} of the edges, with the rows of
+  // the first view. Only computed if compute_edge_covariances is set.
+  const std::unordered_map<ImagePair, Eigen::Matrix3d>& GetEdgeCovariances()
+      const;
+
   // We keep one of the rotations as constant to remove the ambiguity of the
   // linear system.
   static const int kConstantRotationIndex = -1;
@@ -59,6 +104,23 @@ class IRLSRotationLocalRefiner {
     const std::unordered_map<ImagePair, TwoViewGeometry>& relative_rotations,
     std::unordered_map<image_t, Eigen::Vector3d>* global_rotations);
 
+  // Modifies the factorization of A^t * diag(factorized_weights) * A by the
+  // edges whose weights changed by more than the tolerance, and sets their
+  // factorized weights to weights. Returns false if there are too many such
+  // edges or the modification failed, in which case the system has to be
+  // factorized again. factor_modified is set if the factorization was
+  // modified, even if the modification failed.
+  bool UpdateFactorization(const Eigen::ArrayXd& weights,
+                           Eigen::ArrayXd* factorized_weights,
+                           SparseLinearSolver* linear_solver,
+                           bool* factor_modified);
+
+  // Computes the covariances from the factorization of the last iteration.
+  // Returns false if the linear solver has no Cholesky factor.
+  bool ComputeCovariances(
+      const std::unordered_map<ImagePair, TwoViewGeometry>& relative_rotations,
+      SparseLinearSolver* linear_solver);
+
   // Computes the average size of the most recent step of the algorithm.
   // The is the average over all non-fixed global_rotations_ of their
   // rotation magnitudes.
@@ -72,7 +134,11 @@ class IRLSRotationLocalRefiner {
 
   // The sparse matrix used to maintain the linear system. This is matrix A in
   // Ax = b.
-  Eigen::SparseMatrix<double> sparse_matrix_;
+  std::shared_ptr<const Eigen::SparseMatrix<double>> sparse_matrix_;
+  // The transpose of sparse_matrix_, whose columns are the rows of A.
+  Eigen::SparseMatrix<double> sparse_matrix_transpose_;
+
+  std::shared_ptr<SymbolicFactorizationCache> symbolic_factorization_cache_;
 
   // x in the linear system Ax = b.
   Eigen::VectorXd tangent_space_step_;
@@ -80,6 +146,9 @@ class IRLSRotationLocalRefiner {
   // b in the linear system Ax = b.
   Eigen::VectorXd tangent_space_residual_;
 
+  std::unordered_map<image_t, Eigen::Matrix3d> covariances_;
+  std::unordered_map<ImagePair, Eigen::Matrix3d> edge_covariances_;
+
 };
 
 }  // namespace gopt
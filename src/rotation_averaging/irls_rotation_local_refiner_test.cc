@@ -0,0 +1,65 @@
+#include "rotation_averaging/irls_rotation_local_refiner.h"
+
+#include <unordered_map>
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "geometry/rotation_utils.h"
+#include "rotation_averaging/test_util.h"
+#include "util/map_util.h"
+#include "util/random.h"
+
+namespace gopt {
+
+class IRLSRotationLocalRefinerTest : public RotationAveragingTest {
+ public:
+  IRLSRotationLocalRefinerTest() : RotationAveragingTest(65) {}
+
+  // Refines the rotations perturbed by 5 degrees, whose relative rotations
+  // are noisy and partly outliers, with the given options.
+  std::unordered_map<image_t, Eigen::Vector3d> RefineRotations(
+      const IRLSRotationLocalRefiner::IRLSRefinerOptions& options) {
+    RandomNumberGenerator rng(65);
+    std::unordered_map<image_t, Eigen::Vector3d> estimated_rotations;
+    for (const auto& rotation : rotations_) {
+      estimated_rotations[rotation.first] = geometry::MultiplyRotations(
+          rotation.second,
+          geometry::DegToRad(5.0) * rng.RandVector3d().normalized());
+    }
+
+    IRLSRotationLocalRefiner refiner(rotations_.size(), view_pairs_.size(),
+                                     options);
+    EXPECT_TRUE(refiner.SolveIRLS(view_pairs_, &estimated_rotations));
+    return estimated_rotations;
+  }
+};
+
+TEST_F(IRLSRotationLocalRefinerTest, UpdatedFactorizationMatchesRefactorization) {
+  CreateGTRotations(100);
+  CreateRelativeRotations(6, 1.0, 10);
+
+  IRLSRotationLocalRefiner::IRLSRefinerOptions options;
+  options.max_num_irls_iterations = 50;
+  options.irls_step_convergence_threshold = 1e-6;
+  ASSERT_EQ(options.max_weight_update_ratio, 0.0);
+  const std::unordered_map<image_t, Eigen::Vector3d> refactorized_rotations =
+      RefineRotations(options);
+
+  // Most of the weights settle after a few iterations, after which only the
+  // edges whose weights still change are updated.
+  options.max_weight_update_ratio = 0.5;
+  options.weight_update_tolerance = 0.05;
+  const std::unordered_map<image_t, Eigen::Vector3d> updated_rotations =
+      RefineRotations(options);
+
+  for (const auto& rotation : refactorized_rotations) {
+    const Eigen::Vector3d difference =
+        geometry::RelativeRotationFromTwoRotations(
+            rotation.second, FindOrDie(updated_rotations, rotation.first));
+    EXPECT_LT(geometry::RadToDeg(difference.norm()), 0.1);
+  }
+}
+
+}  // namespace gopt
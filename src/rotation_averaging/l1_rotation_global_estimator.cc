@@ -7,6 +7,7 @@
 #include "rotation_averaging/internal/rotation_estimator_util.h"
 #include "solver/l1_solver.h"
 #include "util/map_util.h"
+#include "util/profiler.h"
 #include "util/timer.h"
 
 namespace gopt {
@@ -25,13 +26,19 @@ void L1RotationGlobalEstimator::SetViewIdToIndex(
 }
 
 void L1RotationGlobalEstimator::SetSparseMatrix(
-    const Eigen::SparseMatrix<double>& sparse_matrix) {
+    const std::shared_ptr<const Eigen::SparseMatrix<double>>& sparse_matrix) {
   sparse_matrix_ = sparse_matrix;
 }
 
+void L1RotationGlobalEstimator::SetSymbolicFactorizationCache(
+    const std::shared_ptr<SymbolicFactorizationCache>& cache) {
+  symbolic_factorization_cache_ = cache;
+}
+
 bool L1RotationGlobalEstimator::SolveL1Regression(
     const std::unordered_map<ImagePair, TwoViewGeometry>& relative_rotations,
     std::unordered_map<image_t, Eigen::Vector3d>* global_rotations) {
+  GOPT_PROFILE_SCOPE("L1Regression");
   const int num_edges = relative_rotations.size();
 
   CHECK_NOTNULL(global_rotations);
@@ -42,16 +49,20 @@ bool L1RotationGlobalEstimator::SolveL1Regression(
     internal::ViewIdToAscentIndex(*global_rotations, &view_id_to_index_);
   }
 
-  if (sparse_matrix_.rows() == 0) {
+  if (sparse_matrix_ == nullptr) {
+    std::shared_ptr<Eigen::SparseMatrix<double>> sparse_matrix =
+        std::make_shared<Eigen::SparseMatrix<double>>();
     internal::SetupLinearSystem(
         relative_rotations, (*global_rotations).size(),
-        view_id_to_index_, &sparse_matrix_);
+        view_id_to_index_, sparse_matrix.get());
+    sparse_matrix_ = sparse_matrix;
   }
 
   L1Solver<Eigen::SparseMatrix<double>>::Options l1_solver_options;
   l1_solver_options.max_num_iterations = 5;
+  l1_solver_options.linear_solver_options = options_.linear_solver_options;
   L1Solver<Eigen::SparseMatrix<double> > l1_solver(
-      l1_solver_options, sparse_matrix_);
+      l1_solver_options, sparse_matrix_, symbolic_factorization_cache_);
 
   tangent_space_step_.setZero();
   ComputeResiduals(relative_rotations, global_rotations);
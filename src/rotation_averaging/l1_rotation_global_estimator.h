@@ -1,11 +1,14 @@
 #ifndef L1_ROTATION_GLOBAL_ESTIMATOR_H_
 #define L1_ROTATION_GLOBAL_ESTIMATOR_H_
 
+#include <memory>
 #include <unordered_map>
 
 #include <Eigen/Core>
 #include <Eigen/SparseCore>
 
+#include "math/symbolic_factorization_cache.h"
+#include "solver/solver_options.h"
 #include "util/types.h"
 #include "util/hash.h"
 
@@ -22,6 +25,9 @@ class L1RotationGlobalEstimator {
 
     // Average step size threshold to terminate the L1 minimization
     double l1_step_convergence_threshold = 0.001;
+
+    // The solver of the linear systems of the L1 solver.
+    solver::LinearSolverOptions linear_solver_options;
   };
 
   L1RotationGlobalEstimator(
@@ -30,7 +36,13 @@ class L1RotationGlobalEstimator {
 
   void SetViewIdToIndex(
       const std::unordered_map<image_t, int>& view_id_to_index);
-  void SetSparseMatrix(const Eigen::SparseMatrix<double>& sparse_matrix);
+  // Shares the matrix A of the linear system with the other stages.
+  void SetSparseMatrix(
+      const std::shared_ptr<const Eigen::SparseMatrix<double>>& sparse_matrix);
+
+  // Shares the symbolic analysis of the normal equations with other solvers.
+  void SetSymbolicFactorizationCache(
+      const std::shared_ptr<SymbolicFactorizationCache>& cache);
 
   bool SolveL1Regression(
       const std::unordered_map<ImagePair, TwoViewGeometry>& relative_rotations,
@@ -65,7 +77,9 @@ class L1RotationGlobalEstimator {
 
   // The sparse matrix used to maintain the linear system. This is matrix A in
   // Ax = b.
-  Eigen::SparseMatrix<double> sparse_matrix_;
+  std::shared_ptr<const Eigen::SparseMatrix<double>> sparse_matrix_;
+
+  std::shared_ptr<SymbolicFactorizationCache> symbolic_factorization_cache_;
 
   // x in the linear system Ax = b.
   Eigen::VectorXd tangent_space_step_;
@@ -19,6 +19,7 @@
 #include "solver/rbr_sdp_solver.h"
 #include "solver/rank_restricted_sdp_solver.h"
 #include "solver/riemannian_staircase.h"
+#include "util/profiler.h"
 
 namespace gopt {
 LagrangeDualRotationEstimator::LagrangeDualRotationEstimator(const int N,
@@ -53,6 +54,7 @@ double LagrangeDualRotationEstimator::GetErrorBound() const {
 bool LagrangeDualRotationEstimator::EstimateRotations(
     const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
     std::unordered_map<image_t, Eigen::Vector3d>* global_rotations) {
+  GOPT_PROFILE_SCOPE("LagrangeDual");
   const int N = images_num_;
 
   CHECK_GT(view_pairs.size(), 0);
@@ -64,15 +66,24 @@ bool LagrangeDualRotationEstimator::EstimateRotations(
 
   // Set for R_
   std::unordered_map<size_t, std::vector<size_t>> adj_edges;
-  FillinRelativeGraph(view_pairs, R_, adj_edges);
+  {
+    GOPT_PROFILE_SCOPE("FillinRelativeGraph");
+    FillinRelativeGraph(view_pairs, R_, adj_edges);
+  }
 
   std::unique_ptr<solver::SDPSolver> solver = this->CreateSDPSolver(N, dim_);
   solver->SetCovariance(-R_);
   solver->SetAdjacentEdges(adj_edges);
-  solver->Solve(summary_);
+  {
+    GOPT_PROFILE_SCOPE("SDPSolve");
+    solver->Solve(summary_);
+  }
   Y_ = solver->GetSolution();
 
-  RetrieveRotations(Y_, global_rotations);
+  {
+    GOPT_PROFILE_SCOPE("RetrieveRotations");
+    RetrieveRotations(Y_, global_rotations);
+  }
 
   LOG(INFO) << "LagrangeDual converged in "
             << summary_.total_iterations_num << " iterations.";
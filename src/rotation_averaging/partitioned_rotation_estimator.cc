@@ -0,0 +1,367 @@
+#include "rotation_averaging/partitioned_rotation_estimator.h"
+
+#include <algorithm>
+#include <map>
+#include <queue>
+
+#include <glog/logging.h>
+
+#include "geometry/rotation_utils.h"
+#include "graph/graph_partition.h"
+#include "util/map_util.h"
+#include "util/profiler.h"
+#include "util/timer.h"
+#include "util/view_pair_util.h"
+
+namespace gopt {
+namespace {
+
+// Iterations of the Weiszfeld algorithm for the chordal median.
+const int kNumWeiszfeldIterations = 10;
+
+// The cut view pairs between two clusters k < l, as estimates of the relative
+// rotation X_l * X_k^t of the clusters.
+struct CutViewPairs {
+  std::vector<Eigen::Matrix3d> relative_rotations;
+  std::vector<double> weights;
+};
+
+// The rotation minimizing the weighted sum of the chordal distances
+// || R - R_i ||_F, which is robust to the outliers among the cut view pairs.
+Eigen::Matrix3d ComputeChordalMedian(const CutViewPairs& cut_view_pairs) {
+  const std::vector<Eigen::Matrix3d>& rotations =
+      cut_view_pairs.relative_rotations;
+  const std::vector<double>& weights = cut_view_pairs.weights;
+
+  Eigen::Matrix3d median = Eigen::Matrix3d::Zero();
+  double weight_sum = 0.0;
+  for (size_t i = 0; i < rotations.size(); i++) {
+    median += weights[i] * rotations[i];
+    weight_sum += weights[i];
+  }
+  median /= weight_sum;
+
+  for (int iter = 0; iter < kNumWeiszfeldIterations; iter++) {
+    Eigen::Matrix3d sum = Eigen::Matrix3d::Zero();
+    weight_sum = 0.0;
+    for (size_t i = 0; i < rotations.size(); i++) {
+      const double distance = std::max((median - rotations[i]).norm(), 1e-8);
+      sum += weights[i] / distance * rotations[i];
+      weight_sum += weights[i] / distance;
+    }
+    median = sum / weight_sum;
+  }
+  return geometry::ProjectToSOd(median);
+}
+
+// The view pairs and the rotations of the views of a cluster, which holds view
+// indices in ascending order. Each pair is added by its first view.
+void ExtractClusterProblem(
+    const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+    const std::unordered_map<image_t, Eigen::Vector3d>& rotations,
+    const std::vector<int>& cluster, const std::vector<image_t>& view_ids,
+    const std::vector<ImagePair>& view_id_pairs,
+    const std::vector<std::pair<int, int>>& edges,
+    const std::vector<std::vector<int>>& adjacent_edges,
+    std::unordered_map<ImagePair, TwoViewGeometry>* cluster_view_pairs,
+    std::unordered_map<image_t, Eigen::Vector3d>* cluster_rotations) {
+  for (const int view_index : cluster) {
+    for (const int e : adjacent_edges[view_index]) {
+      if (edges[e].first == view_index &&
+          std::binary_search(cluster.begin(), cluster.end(),
+                             edges[e].second)) {
+        (*cluster_view_pairs)[view_id_pairs[e]] =
+            FindOrDieNoPrint(view_pairs, view_id_pairs[e]);
+      }
+    }
+    (*cluster_rotations)[view_ids[view_index]] =
+        FindOrDie(rotations, view_ids[view_index]);
+  }
+}
+
+int FindRoot(const int cluster, std::vector<int>* parents) {
+  int root = cluster;
+  while ((*parents)[root] != root) {
+    root = (*parents)[root];
+  }
+  return root;
+}
+
+}  // namespace
+
+PartitionedRotationEstimator::PartitionedRotationEstimator(
+    const PartitionedRotationEstimator::Options& options,
+    const RotationEstimatorFactory& estimator_factory)
+    : options_(options), estimator_factory_(estimator_factory) {
+  CHECK_GT(options_.num_threads, 0);
+  CHECK_GT(options_.max_cluster_size, 1);
+  CHECK(estimator_factory_);
+}
+
+bool PartitionedRotationEstimator::EstimateRotations(
+    const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+    std::unordered_map<image_t, Eigen::Vector3d>* rotations) {
+  GOPT_PROFILE_SCOPE("PartitionedRotationEstimation");
+  CHECK_NOTNULL(rotations);
+
+  edges_.clear();
+  edge_weights_.clear();
+  adjacent_edges_.clear();
+
+  IndexViewPairs(view_pairs, *rotations, &view_id_pairs_, &index_to_view_id_,
+                 &view_id_to_index_);
+
+  const int num_views = index_to_view_id_.size();
+  if (num_views == 0) {
+    LOG(ERROR) << "There are no view pairs with initial rotations.";
+    return false;
+  }
+
+  adjacent_edges_.resize(num_views);
+  edges_.reserve(view_id_pairs_.size());
+  edge_weights_.reserve(view_id_pairs_.size());
+  for (const ImagePair& view_id_pair : view_id_pairs_) {
+    const int e = edges_.size();
+    edges_.emplace_back(FindOrDie(view_id_to_index_, view_id_pair.first),
+                        FindOrDie(view_id_to_index_, view_id_pair.second));
+    edge_weights_.push_back(std::max(
+        FindOrDieNoPrint(view_pairs, view_id_pair).visibility_score, 1));
+    adjacent_edges_[edges_.back().first].push_back(e);
+    adjacent_edges_[edges_.back().second].push_back(e);
+  }
+
+  std::vector<int> all_views(num_views);
+  for (int i = 0; i < num_views; i++) {
+    all_views[i] = i;
+  }
+
+  if (num_views <= options_.max_cluster_size) {
+    VLOG(1) << "The view graph is not partitioned, it has only " << num_views
+            << " views.";
+    std::unordered_map<ImagePair, TwoViewGeometry> valid_view_pairs;
+    std::unordered_map<image_t, Eigen::Vector3d> valid_rotations;
+    ExtractClusterProblem(view_pairs, *rotations, all_views, index_to_view_id_,
+                          view_id_pairs_, edges_, adjacent_edges_,
+                          &valid_view_pairs, &valid_rotations);
+    std::unique_ptr<RotationEstimator> rotation_estimator =
+        estimator_factory_(num_views);
+    if (!rotation_estimator->EstimateRotations(valid_view_pairs,
+                                               &valid_rotations)) {
+      return false;
+    }
+    for (const auto& rotation : valid_rotations) {
+      (*rotations)[rotation.first] = rotation.second;
+    }
+    return true;
+  }
+
+  Timer timer;
+  timer.Start();
+
+  std::vector<std::vector<int>> clusters;
+  PartitionViews(&clusters);
+
+  // The estimators are created upfront, since the factory is not required to
+  // be thread safe, and each one is released once its cluster is solved. The
+  // rotation of a single view is arbitrary, so it is not solved.
+  std::vector<std::unique_ptr<RotationEstimator>> rotation_estimators(
+      clusters.size());
+  std::vector<int> view_clusters(num_views);
+  for (size_t k = 0; k < clusters.size(); k++) {
+    if (clusters[k].size() > 1) {
+      rotation_estimators[k] = estimator_factory_(clusters[k].size());
+    }
+    for (const int view_index : clusters[k]) {
+      view_clusters[view_index] = k;
+    }
+  }
+
+  std::vector<std::unordered_map<image_t, Eigen::Vector3d>> cluster_rotations(
+      clusters.size());
+  std::vector<char> cluster_success(clusters.size(), 0);
+
+#pragma omp parallel for num_threads(options_.num_threads) schedule(dynamic)
+  for (size_t k = 0; k < clusters.size(); k++) {
+    std::unordered_map<ImagePair, TwoViewGeometry> cluster_view_pairs;
+    ExtractClusterProblem(view_pairs, *rotations, clusters[k],
+                          index_to_view_id_, view_id_pairs_, edges_,
+                          adjacent_edges_, &cluster_view_pairs,
+                          &cluster_rotations[k]);
+    if (rotation_estimators[k] == nullptr) {
+      cluster_success[k] = 1;
+      continue;
+    }
+
+    cluster_success[k] = rotation_estimators[k]->EstimateRotations(
+        cluster_view_pairs, &cluster_rotations[k]);
+    rotation_estimators[k].reset();
+  }
+
+  for (size_t k = 0; k < clusters.size(); k++) {
+    if (!cluster_success[k]) {
+      LOG(ERROR) << "Failed to estimate the rotations of cluster " << k
+                 << " with " << clusters[k].size() << " views.";
+      return false;
+    }
+  }
+
+  std::vector<Eigen::Vector3d> alignments;
+  if (!AlignClusters(view_pairs, view_clusters, cluster_rotations,
+                     &alignments)) {
+    return false;
+  }
+
+  for (int i = 0; i < num_views; i++) {
+    const image_t view_id = index_to_view_id_[i];
+    const int k = view_clusters[i];
+    (*rotations)[view_id] = geometry::MultiplyRotations(
+        FindOrDie(cluster_rotations[k], view_id), alignments[k]);
+  }
+  cluster_rotations.clear();
+  timer.Pause();
+
+  LOG(INFO) << "Total time [Partitioned, " << clusters.size()
+            << " clusters]: " << timer.ElapsedMicroSeconds() * 1e-3 << " ms.";
+
+  if (options_.refine_rotations) {
+    std::unordered_map<ImagePair, TwoViewGeometry> valid_view_pairs;
+    std::unordered_map<image_t, Eigen::Vector3d> valid_rotations;
+    ExtractClusterProblem(view_pairs, *rotations, all_views, index_to_view_id_,
+                          view_id_pairs_, edges_, adjacent_edges_,
+                          &valid_view_pairs, &valid_rotations);
+    IRLSRotationLocalRefiner rotation_refiner(
+        num_views, valid_view_pairs.size(), options_.irls_options);
+    if (rotation_refiner.SolveIRLS(valid_view_pairs, &valid_rotations)) {
+      for (const auto& rotation : valid_rotations) {
+        (*rotations)[rotation.first] = rotation.second;
+      }
+    } else {
+      LOG(WARNING) << "Failed to refine the aligned rotations.";
+    }
+  }
+
+  return true;
+}
+
+void PartitionedRotationEstimator::PartitionViews(
+    std::vector<std::vector<int>>* clusters) const {
+  GOPT_PROFILE_SCOPE("PartitionViews");
+  const int num_views = index_to_view_id_.size();
+
+  // The clusters are disjoint, the views of the cut view pairs align them.
+  graph::OverlappingPartitionOptions partition_options;
+  partition_options.num_threads = options_.num_threads;
+  partition_options.max_cluster_size = options_.max_cluster_size;
+  partition_options.num_hops = 0;
+  partition_options.max_overlap_ratio = 0.0;
+  graph::OverlappingPartition partition;
+  graph::ComputeOverlappingPartition(num_views, edges_, edge_weights_,
+                                     partition_options, &partition);
+  clusters->swap(partition.clusters);
+
+  VLOG(1) << "Partitioned " << num_views << " views into " << clusters->size()
+          << " clusters.";
+}
+
+bool PartitionedRotationEstimator::AlignClusters(
+    const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+    const std::vector<int>& view_clusters,
+    const std::vector<std::unordered_map<image_t, Eigen::Vector3d>>&
+        cluster_rotations,
+    std::vector<Eigen::Vector3d>* alignments) const {
+  GOPT_PROFILE_SCOPE("AlignClusters");
+  const int num_clusters = cluster_rotations.size();
+
+  // X_l * X_k^t = (R_j^l)^t * R_ij * R_i^k for the view pairs (i, j) between
+  // the clusters k and l, and the transpose if k > l.
+  std::map<std::pair<int, int>, CutViewPairs> cluster_pairs;
+  for (size_t e = 0; e < edges_.size(); e++) {
+    const int k = view_clusters[edges_[e].first];
+    const int l = view_clusters[edges_[e].second];
+    if (k == l) {
+      continue;
+    }
+
+    const ImagePair& view_id_pair = view_id_pairs_[e];
+    const Eigen::Matrix3d rotation1 = geometry::AngleAxisToRotationMatrix(
+        FindOrDie(cluster_rotations[k], view_id_pair.first));
+    const Eigen::Matrix3d rotation2 = geometry::AngleAxisToRotationMatrix(
+        FindOrDie(cluster_rotations[l], view_id_pair.second));
+    const Eigen::Matrix3d relative_rotation =
+        geometry::AngleAxisToRotationMatrix(
+            FindOrDieNoPrint(view_pairs, view_id_pair).rotation_2);
+    const Eigen::Matrix3d cluster_relative_rotation =
+        rotation2.transpose() * relative_rotation * rotation1;
+
+    CutViewPairs& cut_view_pairs =
+        cluster_pairs[std::make_pair(std::min(k, l), std::max(k, l))];
+    cut_view_pairs.relative_rotations.push_back(
+        k < l ? cluster_relative_rotation
+              : Eigen::Matrix3d(cluster_relative_rotation.transpose()));
+    cut_view_pairs.weights.push_back(edge_weights_[e]);
+  }
+
+  // The rotation averaging problem of the clusters.
+  std::unordered_map<ImagePair, TwoViewGeometry> cluster_view_pairs;
+  std::vector<std::vector<std::pair<int, Eigen::Vector3d>>> neighbors(
+      num_clusters);
+  std::vector<int> parents(num_clusters);
+  for (int k = 0; k < num_clusters; k++) {
+    parents[k] = k;
+  }
+  for (const auto& cluster_pair : cluster_pairs) {
+    const int k = cluster_pair.first.first;
+    const int l = cluster_pair.first.second;
+    TwoViewGeometry& two_view_geometry = cluster_view_pairs[ImagePair(k, l)];
+    two_view_geometry.rotation_2 = geometry::RotationMatrixToAngleAxis(
+        ComputeChordalMedian(cluster_pair.second));
+    two_view_geometry.visibility_score =
+        cluster_pair.second.relative_rotations.size();
+    neighbors[k].emplace_back(l, two_view_geometry.rotation_2);
+    neighbors[l].emplace_back(k, -two_view_geometry.rotation_2);
+    parents[FindRoot(l, &parents)] = FindRoot(k, &parents);
+  }
+
+  for (int k = 1; k < num_clusters; k++) {
+    if (FindRoot(k, &parents) != FindRoot(0, &parents)) {
+      LOG(ERROR) << "Cluster " << k << " is not connected to the others.";
+      return false;
+    }
+  }
+
+  // Initialize the rotations of the clusters along a spanning tree, which is
+  // already the solution if the clusters form a tree.
+  std::unordered_map<image_t, Eigen::Vector3d> cluster_alignments;
+  cluster_alignments[0] = Eigen::Vector3d::Zero();
+  std::queue<int> queue;
+  queue.push(0);
+  while (!queue.empty()) {
+    const int k = queue.front();
+    queue.pop();
+    for (const auto& neighbor : neighbors[k]) {
+      if (!ContainsKey(cluster_alignments, neighbor.first)) {
+        cluster_alignments[neighbor.first] = geometry::ApplyRelativeRotation(
+            cluster_alignments[k], neighbor.second);
+        queue.push(neighbor.first);
+      }
+    }
+  }
+
+  if (static_cast<int>(cluster_view_pairs.size()) >= num_clusters) {
+    std::unique_ptr<RotationEstimator> rotation_estimator =
+        estimator_factory_(num_clusters);
+    if (!rotation_estimator->EstimateRotations(cluster_view_pairs,
+                                               &cluster_alignments)) {
+      LOG(ERROR) << "Failed to estimate the rotations of the clusters.";
+      return false;
+    }
+  }
+
+  alignments->resize(num_clusters);
+  for (int k = 0; k < num_clusters; k++) {
+    (*alignments)[k] = FindOrDie(cluster_alignments, k);
+  }
+  return true;
+}
+
+}  // namespace gopt
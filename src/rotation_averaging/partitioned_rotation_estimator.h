@@ -0,0 +1,102 @@
+#ifndef ROTATION_AVERAGING_PARTITIONED_ROTATION_ESTIMATOR_H_
+#define ROTATION_AVERAGING_PARTITIONED_ROTATION_ESTIMATOR_H_
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "rotation_averaging/irls_rotation_local_refiner.h"
+#include "rotation_averaging/rotation_estimator.h"
+
+namespace gopt {
+
+// Divide-and-conquer rotation estimator for view graphs that are too large to
+// be solved at once. The view graph is partitioned by the normalized cut of
+// Graclus into clusters of about max_cluster_size views, and the rotations of
+// each cluster are estimated independently (and in parallel) by the inner
+// rotation estimator.
+//
+// The rotations R_v^k of the views v of a cluster k are only defined up to a
+// rotation X_k of the cluster, i.e. R_v = R_v^k * X_k. Each view pair (i, j)
+// cut between the clusters k and l measures the relative rotation of the
+// clusters
+//
+//   X_l * X_k^t = (R_j^l)^t * R_ij * R_i^k,
+//
+// and the cut view pairs of two clusters are combined by their chordal median.
+// The rotations X_k are then estimated by a small rotation averaging problem
+// over the clusters, solved by the inner estimator as well. Optionally, the
+// aligned rotations of all views are polished by IRLS. Only the problems of
+// the clusters which are solved concurrently are alive at the same time, so
+// the memory scales with the cluster size rather than the size of the view
+// graph.
+class PartitionedRotationEstimator : public RotationEstimator {
+ public:
+  struct Options {
+    int num_threads = 8;
+
+    // Maximum number of views of a cluster.
+    int max_cluster_size = 2000;
+
+    // Refine the aligned rotations of all views by IRLS, which recovers the
+    // accuracy lost at the cuts at the cost of one global linear system.
+    bool refine_rotations = true;
+    IRLSRotationLocalRefiner::IRLSRefinerOptions irls_options;
+  };
+
+  // Creates the estimator that solves a problem with num_views views. It is
+  // called once per cluster and once for the alignment, from a single thread.
+  typedef std::function<std::unique_ptr<RotationEstimator>(const int num_views)>
+      RotationEstimatorFactory;
+
+  PartitionedRotationEstimator(
+      const PartitionedRotationEstimator::Options& options,
+      const RotationEstimatorFactory& estimator_factory);
+
+  // The rotations of the views are initialized with rotations. Views without
+  // view pairs keep their rotations. Returns true if all clusters were solved
+  // and could be aligned, false if there was a failure.
+  bool EstimateRotations(
+      const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+      std::unordered_map<image_t, Eigen::Vector3d>* rotations) override;
+
+ private:
+  // Partitions the views by the normalized cut into disjoint clusters of at
+  // most max_cluster_size views. Parts of the cut which are not connected are
+  // split into their connected components, so that each cluster can be solved
+  // on its own. The clusters hold view indices in ascending order.
+  void PartitionViews(std::vector<std::vector<int>>* clusters) const;
+
+  // Estimates the rotation of each cluster from the cut view pairs. Returns
+  // false if the clusters are not connected.
+  bool AlignClusters(
+      const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+      const std::vector<int>& view_clusters,
+      const std::vector<std::unordered_map<image_t, Eigen::Vector3d>>&
+          cluster_rotations,
+      std::vector<Eigen::Vector3d>* alignments) const;
+
+  const PartitionedRotationEstimator::Options options_;
+  const RotationEstimatorFactory estimator_factory_;
+
+  // The views of the view pairs in ascending order of view id, and the view
+  // pairs in ascending order.
+  std::vector<image_t> index_to_view_id_;
+  std::unordered_map<image_t, int> view_id_to_index_;
+  std::vector<ImagePair> view_id_pairs_;
+  std::vector<std::pair<int, int>> edges_;
+  std::vector<int> edge_weights_;
+
+  // Incident edges of each view.
+  std::vector<std::vector<int>> adjacent_edges_;
+
+  DISALLOW_COPY_AND_ASSIGN(PartitionedRotationEstimator);
+};
+
+}  // namespace gopt
+
+#endif  // ROTATION_AVERAGING_PARTITIONED_ROTATION_ESTIMATOR_H_
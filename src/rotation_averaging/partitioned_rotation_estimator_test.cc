@@ -0,0 +1,116 @@
+#include "rotation_averaging/partitioned_rotation_estimator.h"
+
+#include <unordered_map>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "geometry/rotation_utils.h"
+#include "rotation_averaging/robust_l1l2_rotation_estimator.h"
+#include "rotation_averaging/test_util.h"
+#include "util/map_util.h"
+#include "util/random.h"
+
+namespace gopt {
+namespace {
+
+// Returns the ground truth rotations of the views of the view pairs, rotated
+// by a random rotation per call, as the clusters are only defined up to a
+// rotation.
+class GTRotationEstimator : public RotationEstimator {
+ public:
+  GTRotationEstimator(
+      const std::unordered_map<image_t, Eigen::Vector3d>& gt_rotations,
+      const unsigned seed)
+      : gt_rotations_(gt_rotations), rng_(seed) {}
+
+  bool EstimateRotations(
+      const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+      std::unordered_map<image_t, Eigen::Vector3d>* rotations) override {
+    const Eigen::Vector3d alignment = rng_.RandVector3d();
+    for (const auto& view_pair : view_pairs) {
+      for (const image_t view_id :
+           {view_pair.first.first, view_pair.first.second}) {
+        (*rotations)[view_id] = geometry::MultiplyRotations(
+            FindOrDie(gt_rotations_, view_id), alignment);
+      }
+    }
+    return true;
+  }
+
+ private:
+  const std::unordered_map<image_t, Eigen::Vector3d>& gt_rotations_;
+  RandomNumberGenerator rng_;
+};
+
+}  // namespace
+
+class PartitionedRotationEstimatorTest : public RotationAveragingTest {
+ public:
+  PartitionedRotationEstimatorTest() : RotationAveragingTest(69) {}
+
+  // Solves the clusters with the robust L1-L2 estimator, or with the ground
+  // truth up to a random rotation if use_robust_l1l2 is false.
+  void TestPartitionedRotationEstimator(const int num_views,
+                                        const int num_neighbors,
+                                        const int max_cluster_size,
+                                        const double rotation_noise_degrees,
+                                        const double tolerance_degrees,
+                                        const bool use_robust_l1l2) {
+    CreateGTRotations(num_views);
+    CreateRelativeRotations(num_neighbors, rotation_noise_degrees);
+
+    // The clusters and the alignment of the ground truth are consistent, but
+    // the alignment of the clusters is still estimated from the noisy view
+    // pairs.
+    unsigned seed = 0;
+    const PartitionedRotationEstimator::RotationEstimatorFactory
+        estimator_factory = [this, use_robust_l1l2, &seed](const int) {
+          std::unique_ptr<RotationEstimator> rotation_estimator;
+          if (use_robust_l1l2) {
+            RobustL1L2RotationEstimator::RobustL1L2RotationEstimatorOptions
+                options;
+            rotation_estimator.reset(new RobustL1L2RotationEstimator(options));
+          } else {
+            rotation_estimator.reset(
+                new GTRotationEstimator(rotations_, seed++));
+          }
+          return rotation_estimator;
+        };
+
+    PartitionedRotationEstimator::Options options;
+    options.max_cluster_size = max_cluster_size;
+    options.refine_rotations = use_robust_l1l2;
+    PartitionedRotationEstimator rotation_estimator(options,
+                                                    estimator_factory);
+
+    std::unordered_map<image_t, Eigen::Vector3d> estimated_rotations;
+    for (const auto& rotation : rotations_) {
+      estimated_rotations[rotation.first] = Eigen::Vector3d::Zero();
+    }
+    EXPECT_TRUE(rotation_estimator.EstimateRotations(view_pairs_,
+                                                     &estimated_rotations));
+    EXPECT_EQ(estimated_rotations.size(), rotations_.size());
+
+    // Rotations are recovered up to a rotation G.
+    EXPECT_LT(geometry::ComputeMeanRotationErrorDegrees(rotations_,
+                                                        estimated_rotations),
+              tolerance_degrees);
+  }
+};
+
+TEST_F(PartitionedRotationEstimatorTest, SingleCluster) {
+  TestPartitionedRotationEstimator(40, 4, 100, 0.0, 1e-6, false);
+}
+
+TEST_F(PartitionedRotationEstimatorTest, ClustersAreAligned) {
+  TestPartitionedRotationEstimator(500, 4, 50, 0.0, 1e-6, false);
+}
+
+TEST_F(PartitionedRotationEstimatorTest, RobustL1L2ClustersWithNoise) {
+  TestPartitionedRotationEstimator(400, 6, 80, 2.0, 3.0, true);
+}
+
+}  // namespace gopt
@@ -30,23 +30,37 @@ bool RobustL1L2RotationEstimator::EstimateRotations(
   CHECK_GT(N, 0);
   CHECK_GT(view_pairs.size(), 0);
 
-  Eigen::SparseMatrix<double> sparse_matrix;
+  // The matrix A is assembled once and shared by both stages.
+  const std::shared_ptr<Eigen::SparseMatrix<double>> sparse_matrix =
+      std::make_shared<Eigen::SparseMatrix<double>>();
   LOG(INFO) << "Setup linear system";
   internal::ViewIdToAscentIndex(*global_rotations, &view_id_to_index_);
   internal::SetupLinearSystem(
       view_pairs, (*global_rotations).size(),
-      view_id_to_index_, &sparse_matrix);
+      view_id_to_index_, sparse_matrix.get(),
+      options_.irls_options.num_threads);
   LOG(INFO) << "end setup linear system";
   l1_rotation_estimator_.reset(
      new L1RotationGlobalEstimator(N, view_pairs.size(), options_.l1_options));
   irls_rotation_refiner_.reset(
       new IRLSRotationLocalRefiner(N, view_pairs.size(), options_.irls_options));
   
+  // Both stages factorize A^t * A, whose pattern is only analyzed once.
+  const std::shared_ptr<SymbolicFactorizationCache>
+      symbolic_factorization_cache =
+          symbolic_factorization_cache_ != nullptr
+              ? symbolic_factorization_cache_
+              : std::make_shared<SymbolicFactorizationCache>();
+
   l1_rotation_estimator_->SetViewIdToIndex(view_id_to_index_);
   l1_rotation_estimator_->SetSparseMatrix(sparse_matrix);
+  l1_rotation_estimator_->SetSymbolicFactorizationCache(
+      symbolic_factorization_cache);
 
   irls_rotation_refiner_->SetViewIdToIndex(view_id_to_index_);
   irls_rotation_refiner_->SetSparseMatrix(sparse_matrix);
+  irls_rotation_refiner_->SetSymbolicFactorizationCache(
+      symbolic_factorization_cache);
 
   // Estimate global rotations that resides within the cone of 
   // convergence for IRLS.
@@ -64,6 +78,25 @@ bool RobustL1L2RotationEstimator::EstimateRotations(
   return true;
 }
 
+const std::unordered_map<image_t, Eigen::Matrix3d>&
+RobustL1L2RotationEstimator::GetCovariances() const {
+  CHECK(irls_rotation_refiner_ != nullptr)
+      << "EstimateRotations() has not been called.";
+  return irls_rotation_refiner_->GetCovariances();
+}
+
+const std::unordered_map<ImagePair, Eigen::Matrix3d>&
+RobustL1L2RotationEstimator::GetEdgeCovariances() const {
+  CHECK(irls_rotation_refiner_ != nullptr)
+      << "EstimateRotations() has not been called.";
+  return irls_rotation_refiner_->GetEdgeCovariances();
+}
+
+void RobustL1L2RotationEstimator::SetSymbolicFactorizationCache(
+    const std::shared_ptr<SymbolicFactorizationCache>& cache) {
+  symbolic_factorization_cache_ = cache;
+}
+
 void RobustL1L2RotationEstimator::GlobalRotationsToTangentSpace(
     const std::unordered_map<image_t, Eigen::Vector3d>& global_rotations,
     Eigen::VectorXd* tangent_space_step) {
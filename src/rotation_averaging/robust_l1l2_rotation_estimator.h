@@ -4,6 +4,7 @@
 #include <memory>
 #include <unordered_map>
 
+#include "math/symbolic_factorization_cache.h"
 #include "rotation_averaging/rotation_estimator.h"
 #include "rotation_averaging/irls_rotation_local_refiner.h"
 #include "rotation_averaging/l1_rotation_global_estimator.h"
@@ -29,6 +30,19 @@ class RobustL1L2RotationEstimator : public RotationEstimator {
       const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
       std::unordered_map<image_t, Eigen::Vector3d>* global_rotations) override;
 
+  // The covariances of the rotations and the cross covariances of the views of
+  // the relative rotations computed by the IRLS refinement, if enabled by
+  // irls_options (see IRLSRotationLocalRefiner::GetCovariances()).
+  const std::unordered_map<image_t, Eigen::Matrix3d>& GetCovariances() const;
+  const std::unordered_map<ImagePair, Eigen::Matrix3d>& GetEdgeCovariances()
+      const;
+
+  // Shares the symbolic analysis of the normal equations of both stages with
+  // other solvers. Otherwise, each call of EstimateRotations() uses its own
+  // cache.
+  void SetSymbolicFactorizationCache(
+      const std::shared_ptr<SymbolicFactorizationCache>& cache);
+
  private:
   void GlobalRotationsToTangentSpace(
     const std::unordered_map<image_t, Eigen::Vector3d>& global_rotations,
@@ -42,6 +56,8 @@ class RobustL1L2RotationEstimator : public RotationEstimator {
 
   std::unique_ptr<L1RotationGlobalEstimator> l1_rotation_estimator_;
   std::unique_ptr<IRLSRotationLocalRefiner> irls_rotation_refiner_;
+
+  std::shared_ptr<SymbolicFactorizationCache> symbolic_factorization_cache_;
 };
 
 }  // namespace gopt
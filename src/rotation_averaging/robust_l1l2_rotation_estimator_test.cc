@@ -6,6 +6,7 @@
 #include <Eigen/Core>
 #include <Eigen/Dense>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -14,6 +15,7 @@
 
 #include "geometry/rotation_utils.h"
 #include "math/distribution.h"
+#include "math/symbolic_factorization_cache.h"
 #include "util/map_util.h"
 #include "util/random.h"
 #include "util/timer.h"
@@ -170,6 +172,25 @@ class RobustL1L2RotationAveragingTest : public ::testing::Test {
   }
 };
 
+TEST_F(RobustL1L2RotationAveragingTest, StagesShareSymbolicFactorization) {
+  CreateGTOrientations(50);
+  CreateRelativeRotations(75, 1.0, 0.0, 0.2);
+  std::unordered_map<image_t, Eigen::Vector3d> estimated_orientations;
+  InitializeRotationsFromSpanningTree(estimated_orientations);
+
+  RobustL1L2RotationEstimator::RobustL1L2RotationEstimatorOptions options;
+  RobustL1L2RotationEstimator rotation_estimator(options);
+  const std::shared_ptr<SymbolicFactorizationCache> cache =
+      std::make_shared<SymbolicFactorizationCache>();
+  rotation_estimator.SetSymbolicFactorizationCache(cache);
+  EXPECT_TRUE(rotation_estimator.EstimateRotations(view_pairs_,
+                                                   &estimated_orientations));
+
+  // The L1 stage analyzes A^t * A, and the IRLS stage reuses the analysis.
+  EXPECT_EQ(cache->NumEntries(), 1);
+  EXPECT_EQ(cache->NumHits(), 1);
+}
+
 TEST_F(RobustL1L2RotationAveragingTest, smallTestNoNoise) {
   const int num_views = 4;
   const int num_view_pairs = 6;
@@ -335,4 +356,48 @@ TEST_F(RobustL1L2RotationAveragingTest, FiveThousandViewsTestWithLargeNoise) {
                                     variance, rotation_tolerance_degrees);
 }
 
+TEST_F(RobustL1L2RotationAveragingTest, Covariances) {
+  const int num_views = 50;
+  const int num_view_pairs = 200;
+  CreateGTOrientations(num_views);
+  CreateRelativeRotations(num_view_pairs, 1.0, 0.0, 0.1);
+  std::unordered_map<image_t, Eigen::Vector3d> estimated_orientations;
+  InitializeRotationsFromSpanningTree(estimated_orientations);
+
+  RobustL1L2RotationEstimator::RobustL1L2RotationEstimatorOptions options;
+  options.irls_options.compute_covariances = true;
+  options.irls_options.compute_edge_covariances = true;
+  RobustL1L2RotationEstimator rotation_estimator(options);
+  ASSERT_TRUE(rotation_estimator.EstimateRotations(view_pairs_,
+                                                   &estimated_orientations));
+
+  const std::unordered_map<image_t, Matrix3d>& covariances =
+      rotation_estimator.GetCovariances();
+  ASSERT_EQ(covariances.size(), orientations_.size());
+  // The first view is kept constant.
+  EXPECT_EQ(FindOrDie(covariances, 0), Matrix3d::Zero());
+  for (int i = 1; i < num_views; i++) {
+    const Matrix3d& covariance = FindOrDie(covariances, i);
+    EXPECT_GT(covariance.diagonal().minCoeff(), 0.0);
+    // The axes of the linearized system are decoupled.
+    EXPECT_EQ(covariance(0, 1), 0.0);
+    EXPECT_EQ(covariance(1, 2), 0.0);
+    EXPECT_EQ(covariance(0, 2), 0.0);
+  }
+
+  const std::unordered_map<ImagePair, Matrix3d>& edge_covariances =
+      rotation_estimator.GetEdgeCovariances();
+  ASSERT_EQ(edge_covariances.size(), view_pairs_.size());
+  for (const auto& edge_covariance : edge_covariances) {
+    const Matrix3d& covariance1 =
+        FindOrDie(covariances, edge_covariance.first.first);
+    const Matrix3d& covariance2 =
+        FindOrDie(covariances, edge_covariance.first.second);
+    for (int c = 0; c < 3; c++) {
+      EXPECT_LE(std::abs(edge_covariance.second(c, c)),
+                std::sqrt(covariance1(c, c) * covariance2(c, c)) + 1e-12);
+    }
+  }
+}
+
 }  // namespace gopt
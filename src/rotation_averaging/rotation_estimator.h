@@ -7,6 +7,7 @@
 #include <Eigen/Geometry>
 #include <unordered_map>
 
+#include "graph/edge_sparsification.h"
 #include "solver/solver_options.h"
 #include "rotation_averaging/l1_rotation_global_estimator.h"
 #include "rotation_averaging/irls_rotation_local_refiner.h"
@@ -23,7 +24,10 @@ namespace gopt {
 enum class GlobalRotationEstimatorType : int {
   LAGRANGIAN_DUAL = 0,
   HYBRID = 1,
-  ROBUST_L1L2 = 2
+  ROBUST_L1L2 = 2,
+  // Only available where CONSENSUS_ADMM_ENABLED is defined, i.e. on Linux,
+  // see ConsensusADMMRotationEstimator.
+  CONSENSUS_ADMM = 3
 };
 
 enum class GlobalRotationEstimatorInitMethod : int {
@@ -43,6 +47,23 @@ struct RotationEstimatorOptions {
   L1RotationGlobalEstimator::L1RotationOptions l1_options;
 
   IRLSRotationLocalRefiner::IRLSRefinerOptions irls_options;
+
+  // View graphs with more views than max_cluster_size are partitioned into
+  // clusters by the normalized cut, whose rotations are estimated separately
+  // and then aligned. No partitioning if max_cluster_size is 0.
+  int max_cluster_size = 0;
+
+  // Number of worker processes of the consensus ADMM estimator, which always
+  // partitions the view graph, into clusters of max_cluster_size views if it
+  // is set. Its consensus starts from the initial rotations, which
+  // MAXIMUM_SPANNING_TREE chains along the maximum spanning tree of the view
+  // graph.
+  int num_admm_workers = 4;
+
+  // Dense view graphs can be sparsified before the rotations are estimated,
+  // which keeps the maximum spanning tree and drops redundant view pairs.
+  bool sparsify_view_graph = false;
+  graph::EdgeSparsificationOptions sparsification_options;
 };
 
 // A generic class defining the interface for global rotation estimation
@@ -0,0 +1,62 @@
+#ifndef ROTATION_AVERAGING_TEST_UTIL_H_
+#define ROTATION_AVERAGING_TEST_UTIL_H_
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <Eigen/Core>
+#include <gtest/gtest.h>
+
+#include "geometry/rotation_utils.h"
+#include "util/map_util.h"
+#include "util/random.h"
+#include "util/types.h"
+
+namespace gopt {
+
+// A fixture with random ground truth rotations and the relative rotations of
+// a sequence, shared by the tests of the rotation averaging methods.
+class RotationAveragingTest : public ::testing::Test {
+ protected:
+  explicit RotationAveragingTest(const unsigned seed) : rng_(seed) {}
+
+  void CreateGTRotations(const int num_views) {
+    for (int i = 0; i < num_views; i++) {
+      rotations_[i] = rng_.RandVector3d();
+    }
+  }
+
+  // Each view is matched to its next views along the sequence. If
+  // outlier_period is positive, every outlier_period-th relative rotation is
+  // replaced by a random one.
+  void CreateRelativeRotations(const int num_neighbors,
+                               const double rotation_noise_degrees,
+                               const int outlier_period = 0) {
+    const int num_views = rotations_.size();
+    int num_view_pairs = 0;
+    for (int i = 0; i < num_views; i++) {
+      for (int j = i + 1; j <= std::min(i + num_neighbors, num_views - 1);
+           j++) {
+        TwoViewGeometry two_view_geometry;
+        if (outlier_period > 0 && ++num_view_pairs % outlier_period == 0) {
+          two_view_geometry.rotation_2 = rng_.RandVector3d();
+        } else {
+          two_view_geometry.rotation_2 =
+              geometry::RelativeRotationFromTwoRotations(
+                  FindOrDie(rotations_, i), FindOrDie(rotations_, j),
+                  rotation_noise_degrees);
+        }
+        view_pairs_[ImagePair(i, j)] = two_view_geometry;
+      }
+    }
+  }
+
+  std::unordered_map<image_t, Eigen::Vector3d> rotations_;
+  std::unordered_map<ImagePair, TwoViewGeometry> view_pairs_;
+
+  RandomNumberGenerator rng_;
+};
+
+}  // namespace gopt
+
+#endif  // ROTATION_AVERAGING_TEST_UTIL_H_
@@ -0,0 +1,198 @@
+#include "solver/amg_preconditioner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "graph/graph_coarsening.h"
+#include "util/profiler.h"
+
+namespace gopt {
+namespace {
+
+// Graclus matches along integer edge weights, so the strengths in [0, 1] are
+// quantized to this resolution.
+const double kStrengthResolution = 1000.0;
+
+}  // namespace
+
+AMGPreconditioner::AMGPreconditioner() : info_(Eigen::Success) {}
+
+void AMGPreconditioner::SetOptions(
+    const solver::AMGPreconditionerOptions& options) {
+  CHECK_GT(options.coarsest_size, 0);
+  CHECK_GT(options.num_matchings_per_level, 0);
+  CHECK_GE(options.num_smoothing_sweeps, 0);
+  options_ = options;
+}
+
+int AMGPreconditioner::NumLevels() const { return levels_.size(); }
+
+double AMGPreconditioner::OperatorComplexity() const {
+  if (levels_.empty() || levels_[0].lhs.nonZeros() == 0) {
+    return 0.0;
+  }
+  double num_nonzeros = 0.0;
+  for (const Level& level : levels_) {
+    num_nonzeros += level.lhs.nonZeros();
+  }
+  return num_nonzeros / levels_[0].lhs.nonZeros();
+}
+
+void AMGPreconditioner::Setup(const Eigen::SparseMatrix<double>& mat) {
+  GOPT_PROFILE_SCOPE("AMGSetup");
+  CHECK_EQ(mat.rows(), mat.cols());
+  levels_.clear();
+  info_ = Eigen::Success;
+
+  Eigen::SparseMatrix<double> lhs = mat.selfadjointView<Eigen::Upper>();
+  std::vector<std::vector<int>> aggregates;
+  ComputeAggregates(lhs, &aggregates);
+
+  levels_.resize(aggregates.size() + 1);
+  for (size_t l = 0; l < levels_.size(); l++) {
+    Level& level = levels_[l];
+    level.lhs = lhs;
+    level.inverse_diagonal = lhs.diagonal();
+    if (level.inverse_diagonal.size() > 0 &&
+        level.inverse_diagonal.minCoeff() <= 0.0) {
+      LOG(ERROR) << "The matrix of level " << l
+                 << " has a non-positive diagonal entry.";
+      info_ = Eigen::NumericalIssue;
+      return;
+    }
+    level.inverse_diagonal = level.inverse_diagonal.cwiseInverse();
+
+    if (l == aggregates.size()) {
+      break;
+    }
+
+    // The Galerkin product with the piecewise constant prolongation.
+    level.aggregates = aggregates[l];
+    const int num_aggregates =
+        *std::max_element(level.aggregates.begin(), level.aggregates.end()) +
+        1;
+    Eigen::SparseMatrix<double> prolongation(lhs.rows(), num_aggregates);
+    std::vector<Eigen::Triplet<double>> triplets;
+    triplets.reserve(lhs.rows());
+    for (int i = 0; i < lhs.rows(); i++) {
+      triplets.emplace_back(i, level.aggregates[i], 1.0);
+    }
+    prolongation.setFromTriplets(triplets.begin(), triplets.end());
+    lhs = prolongation.transpose() * lhs * prolongation;
+  }
+
+  coarsest_solver_.compute(lhs);
+  if (coarsest_solver_.info() != Eigen::Success) {
+    LOG(ERROR) << "Failed to factorize the coarsest matrix of AMG.";
+    info_ = Eigen::NumericalIssue;
+    return;
+  }
+
+  VLOG(2) << "AMG hierarchy with " << levels_.size() << " levels, coarsest "
+          << lhs.rows() << " unknowns, operator complexity "
+          << OperatorComplexity();
+}
+
+void AMGPreconditioner::ComputeAggregates(
+    const Eigen::SparseMatrix<double>& lhs,
+    std::vector<std::vector<int>>* aggregates) const {
+  const int num_unknowns = lhs.rows();
+  const Eigen::VectorXd diagonal = lhs.diagonal();
+  std::vector<std::pair<int, int>> edges;
+  std::vector<int> weights;
+  edges.reserve(lhs.nonZeros() / 2);
+  weights.reserve(lhs.nonZeros() / 2);
+  for (int col = 0; col < lhs.outerSize(); col++) {
+    for (Eigen::SparseMatrix<double>::InnerIterator it(lhs, col); it; ++it) {
+      if (it.row() >= col || it.value() == 0.0) {
+        continue;
+      }
+      const double strength =
+          std::abs(it.value()) /
+          std::sqrt(std::abs(diagonal(it.row()) * diagonal(col)));
+      edges.emplace_back(it.row(), col);
+      weights.push_back(std::max(
+          1, static_cast<int>(std::round(
+                 kStrengthResolution * std::min(strength, 1.0)))));
+    }
+  }
+
+  const std::vector<std::vector<int>> hierarchy =
+      graph::ComputeCoarseningHierarchy(num_unknowns, edges, weights,
+                                        options_.coarsest_size);
+
+  // Merge consecutive matchings into one level.
+  for (size_t step = 0; step < hierarchy.size();
+       step += options_.num_matchings_per_level) {
+    std::vector<int> level_aggregates = hierarchy[step];
+    const size_t last_step = std::min(
+        hierarchy.size(), step + options_.num_matchings_per_level);
+    for (size_t s = step + 1; s < last_step; s++) {
+      for (int& aggregate : level_aggregates) {
+        aggregate = hierarchy[s][aggregate];
+      }
+    }
+    aggregates->emplace_back(std::move(level_aggregates));
+  }
+}
+
+Eigen::VectorXd AMGPreconditioner::solve(const Eigen::VectorXd& rhs) const {
+  Eigen::VectorXd solution;
+  VCycle(0, rhs, &solution);
+  return solution;
+}
+
+void AMGPreconditioner::VCycle(const int level_index,
+                               const Eigen::VectorXd& rhs,
+                               Eigen::VectorXd* solution) const {
+  if (level_index + 1 == static_cast<int>(levels_.size())) {
+    *solution = coarsest_solver_.solve(rhs);
+    return;
+  }
+
+  const Level& level = levels_[level_index];
+  solution->setZero(rhs.size());
+  for (int i = 0; i < options_.num_smoothing_sweeps; i++) {
+    GaussSeidelSweep(level, rhs, true, solution);
+  }
+
+  // Restrict the residual to the aggregates.
+  const Eigen::VectorXd residual = rhs - level.lhs * (*solution);
+  const int num_aggregates = levels_[level_index + 1].lhs.rows();
+  Eigen::VectorXd coarse_rhs = Eigen::VectorXd::Zero(num_aggregates);
+  for (int i = 0; i < residual.size(); i++) {
+    coarse_rhs(level.aggregates[i]) += residual(i);
+  }
+
+  Eigen::VectorXd coarse_solution;
+  VCycle(level_index + 1, coarse_rhs, &coarse_solution);
+  for (int i = 0; i < solution->size(); i++) {
+    (*solution)(i) += coarse_solution(level.aggregates[i]);
+  }
+
+  for (int i = 0; i < options_.num_smoothing_sweeps; i++) {
+    GaussSeidelSweep(level, rhs, false, solution);
+  }
+}
+
+void AMGPreconditioner::GaussSeidelSweep(const Level& level,
+                                         const Eigen::VectorXd& rhs,
+                                         const bool forward,
+                                         Eigen::VectorXd* solution) const {
+  const int num_unknowns = rhs.size();
+  for (int k = 0; k < num_unknowns; k++) {
+    const int row = forward ? k : num_unknowns - 1 - k;
+    double residual = rhs(row);
+    for (Eigen::SparseMatrix<double, Eigen::RowMajor>::InnerIterator it(
+             level.lhs, row);
+         it; ++it) {
+      residual -= it.value() * (*solution)(it.col());
+    }
+    (*solution)(row) += residual * level.inverse_diagonal(row);
+  }
+}
+
+}  // namespace gopt
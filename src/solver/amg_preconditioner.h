@@ -0,0 +1,105 @@
+#ifndef SOLVER_AMG_PRECONDITIONER_H_
+#define SOLVER_AMG_PRECONDITIONER_H_
+
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/SparseCholesky>
+#include <Eigen/SparseCore>
+
+#include "solver/solver_options.h"
+#include "util/util.h"
+
+namespace gopt {
+
+// An aggregation based algebraic multigrid preconditioner for sparse symmetric
+// positive definite matrices whose graph resembles a graph Laplacian, e.g. the
+// normal equations of the IRLS, L1 and LUD solvers.
+//
+// The aggregates come from the coarsening hierarchy of Graclus (see
+// graph::ComputeCoarseningHierarchy()) of the graph of the matrix, whose edges
+// are the off-diagonal non-zeros weighted by their strength
+// |a_ij| / sqrt(a_ii * a_jj). The coarse matrices are the Galerkin products
+// P^t * A * P with the piecewise constant prolongations P of the aggregates.
+// One application of the preconditioner is a V-cycle with forward Gauss-Seidel
+// pre-smoothing, backward Gauss-Seidel post-smoothing and a factorization of
+// the coarsest matrix, which is a symmetric positive definite operator as
+// conjugate gradients requires. Setup and application take time and memory
+// linear in the number of non-zeros.
+//
+// The interface follows Eigen's preconditioners, so that the class can be used
+// as the preconditioner of Eigen::ConjugateGradient. Only the upper triangle of
+// the matrix is read.
+class AMGPreconditioner {
+ public:
+  AMGPreconditioner();
+
+  void SetOptions(const solver::AMGPreconditionerOptions& options);
+
+  // The hierarchy depends on the values of the matrix, so it is built by
+  // factorize(). The matrix is only taken for the interface of Eigen.
+  template <typename MatrixType>
+  AMGPreconditioner& analyzePattern(const MatrixType& /*mat*/) {
+    return *this;
+  }
+
+  template <typename MatrixType>
+  AMGPreconditioner& factorize(const MatrixType& mat) {
+    Setup(mat);
+    return *this;
+  }
+
+  template <typename MatrixType>
+  AMGPreconditioner& compute(const MatrixType& mat) {
+    return factorize(mat);
+  }
+
+  // Applies one V-cycle to rhs, starting from zero.
+  Eigen::VectorXd solve(const Eigen::VectorXd& rhs) const;
+
+  Eigen::ComputationInfo info() const { return info_; }
+
+  // The number of levels, including the finest and the coarsest level.
+  int NumLevels() const;
+
+  // The total number of non-zeros of the matrices of all levels relative to
+  // the number of non-zeros of the finest matrix.
+  double OperatorComplexity() const;
+
+ private:
+  struct Level {
+    // The complete symmetric matrix of the level.
+    Eigen::SparseMatrix<double, Eigen::RowMajor> lhs;
+    Eigen::VectorXd inverse_diagonal;
+    // The aggregate, i.e. the unknown of the next coarser level, of each
+    // unknown. Empty on the coarsest level.
+    std::vector<int> aggregates;
+  };
+
+  void Setup(const Eigen::SparseMatrix<double>& mat);
+
+  // Computes the aggregates of the unknowns of the finest level for each
+  // level of the hierarchy.
+  void ComputeAggregates(const Eigen::SparseMatrix<double>& lhs,
+                         std::vector<std::vector<int>>* aggregates) const;
+
+  // Approximately solves the system of the level, starting from zero.
+  void VCycle(const int level, const Eigen::VectorXd& rhs,
+              Eigen::VectorXd* solution) const;
+
+  // One Gauss-Seidel sweep over the unknowns in increasing (forward = true)
+  // or decreasing order.
+  void GaussSeidelSweep(const Level& level, const Eigen::VectorXd& rhs,
+                        const bool forward, Eigen::VectorXd* solution) const;
+
+  solver::AMGPreconditionerOptions options_;
+  std::vector<Level> levels_;
+  Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> coarsest_solver_;
+  Eigen::ComputationInfo info_;
+
+  DISALLOW_COPY_AND_ASSIGN(AMGPreconditioner);
+};
+
+}  // namespace gopt
+
+#endif  // SOLVER_AMG_PRECONDITIONER_H_
@@ -0,0 +1,100 @@
+#include "solver/amg_preconditioner.h"
+
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/IterativeLinearSolvers>
+#include <Eigen/SparseCore>
+
+#include "gtest/gtest.h"
+#include "util/random.h"
+
+namespace gopt {
+namespace {
+
+// The upper triangle of the weighted Laplacian of a width x height grid graph
+// with one grounded vertex, which makes it positive definite like the normal
+// equations with one fixed view.
+Eigen::SparseMatrix<double> CreateGridLaplacian(const int width,
+                                                const int height,
+                                                RandomNumberGenerator* rng) {
+  const int num_vertices = width * height;
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.emplace_back(0, 0, 1.0);
+  const auto add_edge = [&](const int i, const int j) {
+    const double weight = rng->RandDouble(0.5, 2.0);
+    triplets.emplace_back(i, i, weight);
+    triplets.emplace_back(j, j, weight);
+    triplets.emplace_back(std::min(i, j), std::max(i, j), -weight);
+  };
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      if (x + 1 < width) {
+        add_edge(y * width + x, y * width + x + 1);
+      }
+      if (y + 1 < height) {
+        add_edge(y * width + x, (y + 1) * width + x);
+      }
+    }
+  }
+
+  Eigen::SparseMatrix<double> laplacian(num_vertices, num_vertices);
+  laplacian.setFromTriplets(triplets.begin(), triplets.end());
+  return laplacian;
+}
+
+}  // namespace
+
+TEST(AMGPreconditioner, Hierarchy) {
+  RandomNumberGenerator rng(66);
+  const Eigen::SparseMatrix<double> lhs = CreateGridLaplacian(50, 40, &rng);
+
+  solver::AMGPreconditionerOptions options;
+  options.coarsest_size = 50;
+  AMGPreconditioner preconditioner;
+  preconditioner.SetOptions(options);
+  preconditioner.compute(lhs);
+  ASSERT_EQ(preconditioner.info(), Eigen::Success);
+  EXPECT_GT(preconditioner.NumLevels(), 2);
+  EXPECT_LT(preconditioner.OperatorComplexity(), 2.0);
+
+  // One V-cycle is symmetric.
+  Eigen::VectorXd x(lhs.rows()), y(lhs.rows());
+  rng.SetRandom(&x);
+  rng.SetRandom(&y);
+  EXPECT_NEAR(x.dot(preconditioner.solve(y)), y.dot(preconditioner.solve(x)),
+              1e-8 * x.norm() * y.norm());
+}
+
+TEST(AMGPreconditioner, ConjugateGradient) {
+  RandomNumberGenerator rng(66);
+  const Eigen::SparseMatrix<double> lhs = CreateGridLaplacian(60, 60, &rng);
+  Eigen::VectorXd rhs(lhs.rows());
+  rng.SetRandom(&rhs);
+
+  Eigen::ConjugateGradient<Eigen::SparseMatrix<double>, Eigen::Upper,
+                           Eigen::DiagonalPreconditioner<double>>
+      jacobi_cg;
+  jacobi_cg.setTolerance(1e-10);
+  jacobi_cg.compute(lhs);
+  const Eigen::VectorXd jacobi_solution = jacobi_cg.solve(rhs);
+  ASSERT_EQ(jacobi_cg.info(), Eigen::Success);
+
+  Eigen::ConjugateGradient<Eigen::SparseMatrix<double>, Eigen::Upper,
+                           AMGPreconditioner>
+      amg_cg;
+  solver::AMGPreconditionerOptions options;
+  options.coarsest_size = 50;
+  amg_cg.preconditioner().SetOptions(options);
+  amg_cg.setTolerance(1e-10);
+  amg_cg.compute(lhs);
+  const Eigen::VectorXd amg_solution = amg_cg.solve(rhs);
+  ASSERT_EQ(amg_cg.info(), Eigen::Success);
+
+  const Eigen::MatrixXd dense_lhs =
+      Eigen::MatrixXd(lhs).selfadjointView<Eigen::Upper>();
+  EXPECT_LT((dense_lhs * amg_solution - rhs).norm(), 1e-8 * rhs.norm());
+  EXPECT_LT(2 * amg_cg.iterations(), jacobi_cg.iterations());
+}
+
+}  // namespace gopt
@@ -5,10 +5,12 @@
 #include <Eigen/Core>
 #include <Eigen/SparseCore>
 #include <algorithm>
+#include <cmath>
 #include <string>
 #include <iomanip>
+#include <vector>
 
-#include "math/sparse_cholesky_llt.h"
+#include "util/profiler.h"
 #include "util/stringprintf.h"
 
 namespace gopt {
@@ -19,13 +21,16 @@ ConstrainedL1Solver::ConstrainedL1Solver(
     const Eigen::VectorXd& geq_vec)
     : options_(options),
       num_l1_residuals_(b.size()),
-      num_inequality_constraints_(geq_vec.size()) {
+      num_inequality_constraints_(geq_vec.size()),
+      linear_solver_(
+          SparseLinearSolver::Create(options.linear_solver_options)) {
+  GOPT_PROFILE_SCOPE("ConstrainedL1Setup");
   CHECK_EQ(A.cols(), geq_mat.cols());
   CHECK_EQ(A.rows(), b.rows());
   CHECK_EQ(geq_mat.rows(), geq_vec.rows());
 
   // Allocate matrix A.
-  A_.resize(A.rows() + geq_mat.rows(), A.cols());
+  unweighted_A_.resize(A.rows() + geq_mat.rows(), A.cols());
 
   // Iterate over the input mat and geq_mat and store the entries in A.
   std::vector<Eigen::Triplet<double> > triplets;
@@ -42,18 +47,134 @@ ConstrainedL1Solver::ConstrainedL1Solver(
       triplets.emplace_back(A.rows() + it.row(), it.col(), it.value());
     }
   }
-  A_.setFromTriplets(triplets.begin(), triplets.end());
+  unweighted_A_.setFromTriplets(triplets.begin(), triplets.end());
+  A_ = unweighted_A_;
 
-  Eigen::SparseMatrix<double> spd_mat(A.cols(), A.cols());
-  spd_mat.selfadjointView<Eigen::Upper>().rankUpdate(A_.transpose());
+  // Set the modified b vector.
+  unweighted_b_.resize(b.size() + geq_vec.size());
+  unweighted_b_.head(b.size()) = b;
+  unweighted_b_.tail(geq_vec.size()) = geq_vec;
+  b_ = unweighted_b_;
 
-  linear_solver_.Compute(spd_mat);
-  CHECK_EQ(linear_solver_.Info(), Eigen::Success);
+  row_weights_.setOnes(A_.rows());
+  z_.setZero(A_.rows());
+  u_.setZero(A_.rows());
 
-  // Set the modified b vector.
-  b_.resize(b.size() + geq_vec.size());
-  b_.head(b.size()) = b;
-  b_.tail(geq_vec.size()) = geq_vec;
+  // The eliminated columns must not share any row, such that their block of
+  // A^t * A is diagonal.
+  CHECK_GE(options_.num_eliminated_columns, 0);
+  CHECK_LT(options_.num_eliminated_columns, A_.cols());
+  num_reduced_columns_ = A_.cols() - options_.num_eliminated_columns;
+  std::vector<bool> is_row_used(A_.rows(), false);
+  for (int i = num_reduced_columns_; i < A_.cols(); i++) {
+    for (Eigen::SparseMatrix<double>::InnerIterator it(A_, i); it; ++it) {
+      CHECK(!is_row_used[it.row()])
+          << "The eliminated columns of A must not share any row.";
+      is_row_used[it.row()] = true;
+    }
+  }
+
+  // The sparsity pattern of the linear system does not depend on the weights,
+  // so it is only analyzed once.
+  FactorizeLinearSystem(true);
+}
+
+void ConstrainedL1Solver::SetInitialSolution(const Eigen::VectorXd& solution) {
+  CHECK_EQ(solution.size(), A_.cols());
+  // The splitting variable of a feasible solution, with the inequality
+  // constraints projected onto the feasible set.
+  z_ = ModifiedShrinkage(A_ * solution - b_, 0.0);
+  u_.setZero();
+}
+
+void ConstrainedL1Solver::SetL1Weights(const Eigen::VectorXd& weights) {
+  GOPT_PROFILE_SCOPE("ConstrainedL1Reweight");
+  CHECK_EQ(weights.size(), num_l1_residuals_);
+  CHECK_GT(weights.minCoeff(), 0.0);
+
+  // z lives in the space of the weighted residuals, so rescale it to match the
+  // new weights. The scaled dual variable is bounded by the L1 subgradient
+  // irrespective of the weights and is kept as is.
+  z_.head(num_l1_residuals_).array() *=
+      weights.array() / row_weights_.head(num_l1_residuals_).array();
+  row_weights_.head(num_l1_residuals_) = weights;
+
+  A_ = row_weights_.asDiagonal() * unweighted_A_;
+  b_ = row_weights_.cwiseProduct(unweighted_b_);
+  FactorizeLinearSystem(false);
+}
+
+// With A = [A_1 A_2], where A_2 are the eliminated columns, the normal
+// equations read
+//
+//   [A_1^t A_1  A_1^t A_2] [x_1]   [r_1]
+//   [A_2^t A_1  D        ] [x_2] = [r_2]
+//
+// with the diagonal D = A_2^t A_2. Eliminating x_2 leaves the Schur complement
+//
+//   (A_1^t A_1 - F^t F) x_1 = r_1 - F^t D^(-1/2) r_2,  F = D^(-1/2) A_2^t A_1,
+//
+// and x_2 = D^(-1) r_2 - D^(-1/2) F x_1 is recovered in closed form. F^t F
+// couples all columns of A_1 which share a row with the same eliminated
+// column, so the Schur complement has more nonzeros than A_1^t A_1. For LUD,
+// the scale of a pair couples all six coordinates of its two positions, i.e.
+// a dense 3x3 block per pair where A_1^t A_1 only has its diagonal. This is
+// the fill-in which the elimination of the columns by the factorization of
+// the full system would produce as well, so the elimination saves their rows
+// and columns of the factor, not nonzeros of the reduced system. The pattern
+// does not depend on the weights, so it is still analyzed once.
+void ConstrainedL1Solver::FactorizeLinearSystem(const bool analyze_pattern) {
+  Eigen::SparseMatrix<double> spd_mat(num_reduced_columns_,
+                                      num_reduced_columns_);
+  if (options_.num_eliminated_columns == 0) {
+    spd_mat.selfadjointView<Eigen::Upper>().rankUpdate(A_.transpose());
+  } else {
+    const Eigen::SparseMatrix<double> A1 = A_.leftCols(num_reduced_columns_);
+    const Eigen::SparseMatrix<double> A2 =
+        A_.rightCols(options_.num_eliminated_columns);
+
+    inv_sqrt_diagonal_.resize(options_.num_eliminated_columns);
+    for (int i = 0; i < A2.outerSize(); i++) {
+      double squared_norm = 0.0;
+      for (Eigen::SparseMatrix<double>::InnerIterator it(A2, i); it; ++it) {
+        squared_norm += it.value() * it.value();
+      }
+      CHECK_GT(squared_norm, 0.0);
+      inv_sqrt_diagonal_[i] = 1.0 / std::sqrt(squared_norm);
+    }
+
+    schur_coupling_ =
+        inv_sqrt_diagonal_.asDiagonal() * (A2.transpose() * A1);
+    const Eigen::SparseMatrix<double> schur_complement =
+        A1.transpose() * A1 - schur_coupling_.transpose() * schur_coupling_;
+    spd_mat = schur_complement.triangularView<Eigen::Upper>();
+  }
+
+  if (analyze_pattern) {
+    linear_solver_->AnalyzePattern(spd_mat);
+    CHECK_EQ(linear_solver_->Info(), Eigen::Success);
+  }
+  linear_solver_->Factorize(spd_mat);
+  CHECK_EQ(linear_solver_->Info(), Eigen::Success);
+}
+
+Eigen::VectorXd ConstrainedL1Solver::SolveLinearSystem(
+    const Eigen::VectorXd& rhs) {
+  if (options_.num_eliminated_columns == 0) {
+    return linear_solver_->Solve(rhs);
+  }
+
+  const int num_eliminated_columns = options_.num_eliminated_columns;
+  const Eigen::VectorXd scaled_rhs =
+      inv_sqrt_diagonal_.cwiseProduct(rhs.tail(num_eliminated_columns));
+  const Eigen::VectorXd reduced_rhs =
+      rhs.head(num_reduced_columns_) - schur_coupling_.transpose() * scaled_rhs;
+
+  Eigen::VectorXd solution(rhs.size());
+  solution.head(num_reduced_columns_) = linear_solver_->Solve(reduced_rhs);
+  solution.tail(num_eliminated_columns) = inv_sqrt_diagonal_.cwiseProduct(
+      scaled_rhs - schur_coupling_ * solution.head(num_reduced_columns_));
+  return solution;
 }
 
 // We create a modified L1 solver such that ||Bx - b|| is minimized under L1
@@ -75,11 +196,11 @@ ConstrainedL1Solver::ConstrainedL1Solver(
 // This can now be solved in the same form as the L1 minimization, with a
 // slightly different z update.
 void ConstrainedL1Solver::Solve(Eigen::VectorXd* solution) {
+  GOPT_PROFILE_SCOPE("ConstrainedL1Solve");
   CHECK_NOTNULL(solution)->resize(A_.cols());
   Eigen::VectorXd& x = *solution;
-  Eigen::VectorXd z(A_.rows()), u(A_.rows());
-  z.setZero();
-  u.setZero();
+  Eigen::VectorXd& z = z_;
+  Eigen::VectorXd& u = u_;
 
   Eigen::VectorXd a_times_x(A_.rows()), z_old(z.size()), ax_hat(A_.rows());
   // Precompute some convergence terms.
@@ -96,9 +217,9 @@ void ConstrainedL1Solver::Solve(Eigen::VectorXd* solution) {
 
   // qp_options.max_num_iterations = 100;
   for (int i = 0; i < options_.max_num_iterations; i++) {
-    x.noalias() = linear_solver_.Solve(A_.transpose() * (b_ + z - u));
+    x.noalias() = SolveLinearSystem(A_.transpose() * (b_ + z - u));
 
-    if (linear_solver_.Info() != Eigen::Success) {
+    if (linear_solver_->Info() != Eigen::Success) {
       LOG(ERROR) << "L1 Minimization failed. Could not solve the sparse "
                     "linear system with Cholesky Decomposition";
       return;
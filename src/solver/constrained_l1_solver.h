@@ -6,7 +6,10 @@
 #include <Eigen/Core>
 #include <Eigen/SparseCore>
 
-#include "math/sparse_cholesky_llt.h"
+#include <memory>
+
+#include "solver/solver_options.h"
+#include "solver/sparse_linear_solver.h"
 
 namespace gopt {
 
@@ -26,6 +29,12 @@ namespace gopt {
 // the solution to optain the global optimum. The speed improvements are because
 // the linear system only needs to be factorized (e.g., by Cholesky
 // decomposition) once, as opposed to every iteration.
+//
+// The L1 terms may be reweighted between calls to Solve(), i.e. minimizing
+// ||W(Ax - b)||_1 for a diagonal W, as done by reweighted L1 schemes. The
+// sparsity pattern of the linear system does not change with the weights, so
+// only the numeric factorization is repeated, and the ADMM state is kept so
+// that the next Solve() is warm started from the previous solution.
 class ConstrainedL1Solver {
  public:
   struct Options {
@@ -38,6 +47,15 @@ class ConstrainedL1Solver {
     // Stopping criteria.
     double absolute_tolerance = 1e-4;
     double relative_tolerance = 1e-2;
+
+    // Number of trailing columns of A that are eliminated from the linear
+    // system by the Schur complement. These columns must not share any row
+    // (e.g. the per-pair scales of LUD), so their block of A^t * A is diagonal
+    // and only the remaining columns have to be factorized.
+    int num_eliminated_columns = 0;
+
+    // The solver of the (reduced) linear system of the x-update.
+    solver::LinearSolverOptions linear_solver_options;
   };
 
   // The linear system along with the equality and inequality constraints.
@@ -47,9 +65,17 @@ class ConstrainedL1Solver {
                       const Eigen::SparseMatrix<double>& geq_mat,
                       const Eigen::VectorXd& geq_vec);
 
-  // Solve the constrained L1 minimization above.
+  // Solve the constrained L1 minimization above. Consecutive calls continue
+  // from the ADMM state of the previous call.
   void Solve(Eigen::VectorXd* solution);
 
+  // Warm starts the next Solve() from the given solution.
+  void SetInitialSolution(const Eigen::VectorXd& solution);
+
+  // Sets the weights of the L1 terms, one per row of A, and refactorizes the
+  // linear system. The symbolic analysis of the system is reused.
+  void SetL1Weights(const Eigen::VectorXd& weights);
+
  private:
   // This method is used for the z-update, which is conveniently an element-wise
   // update. For the terms in vec corresponding to the L1 minimization, we
@@ -59,17 +85,45 @@ class ConstrainedL1Solver {
   Eigen::VectorXd ModifiedShrinkage(const Eigen::VectorXd& vec,
                                     const double kappa);
 
+  // Numerically factorizes A^t * A, or its Schur complement if columns are
+  // eliminated, for the current weights.
+  void FactorizeLinearSystem(const bool analyze_pattern);
+
+  // Solves A^t * A * x = rhs with the current factorization.
+  Eigen::VectorXd SolveLinearSystem(const Eigen::VectorXd& rhs);
+
   const Options options_;
   const int num_l1_residuals_;
   const int num_inequality_constraints_;
 
-  // Matrix A where || Ax - b ||_1 is the problem we are solving.
+  // The stacked matrix [A; geq_mat] and vector [b; geq_vec] before the L1
+  // weights are applied.
+  Eigen::SparseMatrix<double> unweighted_A_;
+  Eigen::VectorXd unweighted_b_;
+
+  // Matrix A where || Ax - b ||_1 is the problem we are solving, with the L1
+  // rows scaled by their weights.
   Eigen::SparseMatrix<double> A_;
   Eigen::VectorXd b_;
 
-  // Cholesky linear solver. Since our linear system will be a SPD matrix we can
-  // utilize the Cholesky factorization.
-  SparseCholeskyLLt linear_solver_;
+  // Weights of all rows of A_, the inequality constraints have unit weights.
+  Eigen::VectorXd row_weights_;
+
+  // The ADMM splitting variable and the scaled dual variable, which are kept
+  // between calls to Solve() for warm starting.
+  Eigen::VectorXd z_, u_;
+
+  // Number of columns of A that are not eliminated.
+  int num_reduced_columns_;
+
+  // D^(-1/2) and D^(-1/2) * A_2^t * A_1 of the Schur complement, see
+  // FactorizeLinearSystem().
+  Eigen::VectorXd inv_sqrt_diagonal_;
+  Eigen::SparseMatrix<double> schur_coupling_;
+
+  // Linear solver of the SPD system, by default the Cholesky factorization of
+  // CHOLMOD.
+  std::unique_ptr<SparseLinearSolver> linear_solver_;
 };
 
 }  // namespace gopt
@@ -0,0 +1,86 @@
+#include "solver/constrained_l1_solver.h"
+
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+
+#include "gtest/gtest.h"
+#include "util/random.h"
+
+namespace gopt {
+namespace {
+
+// Creates a problem with the structure of the LUD position estimation: each
+// block of three rows couples two points and one scale, which only appears in
+// this block and is constrained to be >= 1. The first point is held constant.
+void CreateProblem(const int num_points, const int num_pairs,
+                   Eigen::SparseMatrix<double>* A,
+                   Eigen::SparseMatrix<double>* geq_mat) {
+  RandomNumberGenerator rng(52);
+  const int scale_offset = 3 * (num_points - 1);
+  const int num_variables = scale_offset + num_pairs;
+  std::vector<Eigen::Triplet<double> > triplets;
+  for (int i = 0; i < num_pairs; i++) {
+    const int point1 = i % num_points;
+    const int point2 = (point1 + 1 + i / num_points) % num_points;
+    const Eigen::Vector3d direction = rng.RandVector3d().normalized();
+    for (int j = 0; j < 3; j++) {
+      if (point1 != 0) {
+        triplets.emplace_back(3 * i + j, 3 * (point1 - 1) + j, -1.0);
+      }
+      if (point2 != 0) {
+        triplets.emplace_back(3 * i + j, 3 * (point2 - 1) + j, 1.0);
+      }
+      triplets.emplace_back(3 * i + j, scale_offset + i, -direction[j]);
+    }
+  }
+  A->resize(3 * num_pairs, num_variables);
+  A->setFromTriplets(triplets.begin(), triplets.end());
+
+  geq_mat->resize(num_pairs, num_variables);
+  for (int i = 0; i < num_pairs; i++) {
+    geq_mat->insert(i, scale_offset + i) = 1.0;
+  }
+}
+
+}  // namespace
+
+TEST(ConstrainedL1Solver, SchurComplementMatchesFullSystem) {
+  static const double kTolerance = 1e-8;
+  const int num_points = 10, num_pairs = 40;
+
+  Eigen::SparseMatrix<double> A, geq_mat;
+  CreateProblem(num_points, num_pairs, &A, &geq_mat);
+  Eigen::VectorXd b(A.rows());
+  b.setZero();
+  Eigen::VectorXd geq_vec(num_pairs);
+  geq_vec.setOnes();
+
+  ConstrainedL1Solver::Options options;
+  options.max_num_iterations = 50;
+  ConstrainedL1Solver full_solver(options, A, b, geq_mat, geq_vec);
+  options.num_eliminated_columns = num_pairs;
+  ConstrainedL1Solver schur_solver(options, A, b, geq_mat, geq_vec);
+
+  Eigen::VectorXd weights(A.rows());
+  for (int i = 0; i < weights.size(); i++) {
+    weights[i] = 1.0 + 0.1 * (i % 7);
+  }
+
+  // Both solvers follow the same ADMM iterates, also after reweighting.
+  for (int i = 0; i < 2; i++) {
+    Eigen::VectorXd full_solution, schur_solution;
+    full_solver.Solve(&full_solution);
+    schur_solver.Solve(&schur_solution);
+    ASSERT_EQ(full_solution.size(), schur_solution.size());
+    for (int j = 0; j < full_solution.size(); j++) {
+      EXPECT_NEAR(full_solution[j], schur_solution[j], kTolerance);
+    }
+
+    full_solver.SetL1Weights(weights);
+    schur_solver.SetL1Weights(weights);
+  }
+}
+
+}  // namespace gopt
@@ -4,12 +4,16 @@
 #include <Eigen/Cholesky>
 #include <Eigen/Core>
 #include <algorithm>
+#include <memory>
 #include <string>
 #include <iomanip>
 
 #include <glog/logging.h>
 
-#include "math/sparse_cholesky_llt.h"
+#include "math/symbolic_factorization_cache.h"
+#include "solver/solver_options.h"
+#include "solver/sparse_linear_solver.h"
+#include "util/profiler.h"
 #include "util/stringprintf.h"
 
 namespace gopt {
@@ -20,12 +24,12 @@ namespace gopt {
 namespace l1_solver_internal {
 
 inline void Compute(const Eigen::SparseMatrix<double>& spd_mat,
-                    SparseCholeskyLLt* linear_solver) {
+                    SparseLinearSolver* linear_solver) {
   linear_solver->Compute(spd_mat);
 }
 
 inline void Compute(const Eigen::MatrixXd& spd_mat,
-                    SparseCholeskyLLt* linear_solver) {
+                    SparseLinearSolver* linear_solver) {
   linear_solver->Compute(spd_mat.sparseView());
 }
 
@@ -62,15 +66,35 @@ class L1Solver {
 
     double absolute_tolerance = 1e-4;
     double relative_tolerance = 1e-2;
+
+    // The solver of the linear system A^t * A * x = rhs of the x-update.
+    solver::LinearSolverOptions linear_solver_options;
   };
 
-  L1Solver(const Options& options, const MatrixType& mat)
-      : options_(options), a_(mat) {
+  // The symbolic analysis of A^t * A is taken from the cache if one is given
+  // and the pattern was analyzed before.
+  L1Solver(const Options& options, const MatrixType& mat,
+           const std::shared_ptr<SymbolicFactorizationCache>&
+               symbolic_factorization_cache = nullptr)
+      : L1Solver(options, std::make_shared<const MatrixType>(mat),
+                 symbolic_factorization_cache) {}
+
+  // The same, but shares mat with the caller instead of copying it.
+  L1Solver(const Options& options, const std::shared_ptr<const MatrixType>& mat,
+           const std::shared_ptr<SymbolicFactorizationCache>&
+               symbolic_factorization_cache = nullptr)
+      : options_(options),
+        shared_a_(mat),
+        a_(*CHECK_NOTNULL(shared_a_.get())),
+        linear_solver_(
+            SparseLinearSolver::Create(options.linear_solver_options)) {
+    GOPT_PROFILE_SCOPE("L1SolverSetup");
+    linear_solver_->SetSymbolicFactorizationCache(symbolic_factorization_cache);
     // Analyze the sparsity pattern once. Only the values of the entries will be
     // changed with each iteration.
     const MatrixType spd_mat = a_.transpose() * a_;
-    l1_solver_internal::Compute(spd_mat, &linear_solver_);
-    CHECK_EQ(linear_solver_.Info(), Eigen::Success);
+    l1_solver_internal::Compute(spd_mat, linear_solver_.get());
+    CHECK_EQ(linear_solver_->Info(), Eigen::Success);
   }
 
   void SetMaxIterations(const int max_iterations) {
@@ -85,6 +109,7 @@ class L1Solver {
   //        [ -A   -I ] [ y ]   [ -b ]
   // which is an equivalent linear program.
   void Solve(const Eigen::VectorXd& rhs, Eigen::VectorXd* solution) {
+    GOPT_PROFILE_SCOPE("L1Solve");
     CHECK_NOTNULL(solution);
     Eigen::VectorXd& x = *solution;
     Eigen::VectorXd z(a_.rows()), u(a_.rows());
@@ -106,8 +131,9 @@ class L1Solver {
 
     for (int i = 0; i < options_.max_num_iterations; i++) {
       // Update x.
-      x.noalias() = linear_solver_.Solve(a_.transpose() * (rhs + z - u));
-      if (linear_solver_.Info() != Eigen::Success) {
+      x.noalias() = a_.transpose() * (rhs + z - u);
+      linear_solver_->SolveInPlace(&x);
+      if (linear_solver_->Info() != Eigen::Success) {
         LOG(ERROR) << "L1 Minimization failed. Could not solve the sparse "
                       "linear system with Cholesky Decomposition";
         return;
@@ -152,12 +178,14 @@ class L1Solver {
  private:
   Options options_;
 
-  // Matrix A where || Ax - b ||_1 is the problem we are solving.
-  MatrixType a_;
+  // Matrix A where || Ax - b ||_1 is the problem we are solving, which may be
+  // shared with the caller.
+  std::shared_ptr<const MatrixType> shared_a_;
+  const MatrixType& a_;
 
-  // Cholesky linear solver. Since our linear system will be a SPD matrix we can
-  // utilize the Cholesky factorization.
-  SparseCholeskyLLt linear_solver_;
+  // Linear solver of the SPD system A^t * A, by default the Cholesky
+  // factorization of CHOLMOD.
+  std::unique_ptr<SparseLinearSolver> linear_solver_;
 
   Eigen::VectorXd Shrinkage(const Eigen::VectorXd& vec, const double kappa) {
     Eigen::ArrayXd zero_vec(vec.size());
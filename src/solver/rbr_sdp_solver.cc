@@ -13,6 +13,7 @@
 
 #include "bcm_sdp_solver.h"
 #include "math/matrix_square_root.h"
+#include "util/profiler.h"
 
 namespace gopt {
 namespace solver {
@@ -28,6 +29,7 @@ RBRSDPSolver::RBRSDPSolver(
 }
 
 void RBRSDPSolver::Solve(solver::Summary& summary) {
+  GOPT_PROFILE_SCOPE("RBRSDP");
   double prev_func_val = std::numeric_limits<double>::max();
   double cur_func_val = this->EvaluateFuncVal();
   double duration = 0.0;
@@ -3,6 +3,7 @@
 #include <algorithm>
 
 #include "geometry/rotation_utils.h"
+#include "util/profiler.h"
 #include "Spectra/SymEigsSolver.h"
 
 namespace gopt {
@@ -50,13 +51,17 @@ RiemannianStaircase::RiemannianStaircase(
     sdp_solver_(new RankRestrictedSDPSolver(n, block_dim, options)) {}
 
 void RiemannianStaircase::Solve(solver::Summary& summary) {
+  GOPT_PROFILE_SCOPE("RiemannianStaircase");
   const RiemannianStaircaseOptions& riemannian_options =
       sdp_options_.riemannian_staircase_options;
   for (size_t i = riemannian_options.min_rank; i <= riemannian_options.max_rank; ++i) {
     LOG(INFO) << "Current rank: " << i;
     // Local search for the second critical point.
     summary = Summary();
-    sdp_solver_->Solve(summary);
+    {
+      GOPT_PROFILE_SCOPE("RankRestrictedSDP");
+      sdp_solver_->Solve(summary);
+    }
 
     // Verify global optimality.
     double min_eigenvalue = 0;
@@ -105,6 +110,7 @@ bool RiemannianStaircase::KKTVerification(
     double* min_eigenvalue,
     Eigen::VectorXd* min_eigenvector,
     size_t* num_iterations) {
+  GOPT_PROFILE_SCOPE("KKTVerification");
   // First, compute the largest-magnitude eigenvalue of this matrix
   const Eigen::MatrixXd& Y = sdp_solver_->GetYStar();
   const auto& riemannian_options = sdp_options_.riemannian_staircase_options;
@@ -204,6 +210,7 @@ bool RiemannianStaircase::EscapeSaddle(
     const double lambda_min, const Eigen::VectorXd& vector_min,
     double gradient_tolerance, double preconditioned_gradient_tolerance,
     Eigen::MatrixXd* Yplus) {
+  GOPT_PROFILE_SCOPE("EscapeSaddle");
   // v_min is an eigenvector corresponding to a negative eigenvalue of Q -
   // Lambda, so the KKT conditions for the semidefinite relaxation are not
   // satisfied; this implies that Y is a saddle point of the rank-restricted
@@ -296,6 +303,7 @@ bool RiemannianStaircase::EscapeSaddle(
 }
 
 void RiemannianStaircase::RoundSolution() {
+  GOPT_PROFILE_SCOPE("RoundSolution");
   // Finally, project each dxd rotation block to SO(d).
 #pragma omp parallel for num_threads(sdp_options_.num_threads)
   for (size_t i = 0; i < n_; ++i) {
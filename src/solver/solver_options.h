@@ -3,6 +3,8 @@
 
 #include <iostream>
 
+#include "math/sparse_cholesky_llt.h"
+
 namespace gopt {
 namespace solver {
 
@@ -18,7 +20,55 @@ enum PreconditionerType {
   None,
   JACOBI,
   INCOMPLETE_CHOLESKY,
-  REGULARIZED_CHOLESKY
+  REGULARIZED_CHOLESKY,
+  // Aggregation based algebraic multigrid, see AMGPreconditioner.
+  AMG
+};
+
+struct AMGPreconditionerOptions {
+  // The coarsening stops once a level has at most this many unknowns. The
+  // coarsest level is factorized.
+  int coarsest_size = 500;
+
+  // The number of Graclus matchings merged into one level. Each matching at
+  // most halves the number of unknowns.
+  int num_matchings_per_level = 2;
+
+  // The number of symmetric Gauss-Seidel sweeps before and after the coarse
+  // grid correction.
+  int num_smoothing_sweeps = 1;
+};
+
+// Backends of SparseLinearSolver for the sparse symmetric positive definite
+// systems of the L1 and IRLS solvers.
+enum class LinearSolverType : int {
+  // Cholesky factorization of CHOLMOD, which chooses between the simplicial
+  // and the supernodal algorithm.
+  CHOLMOD = 0,
+  // Simplicial LDL^t factorization of Eigen. It has less setup overhead than
+  // CHOLMOD, which makes it the faster choice for small systems.
+  SIMPLICIAL_LDLT = 1,
+  // Preconditioned conjugate gradients of Eigen, which never forms a factor.
+  CONJUGATE_GRADIENT = 2
+};
+
+struct LinearSolverOptions {
+  LinearSolverType type = LinearSolverType::CHOLMOD;
+
+  // Ordering, factorization type and threading of the CHOLMOD backend.
+  SparseCholeskyLLtOptions cholmod_options;
+
+  // Options for the conjugate gradient backend, which supports the None,
+  // JACOBI, INCOMPLETE_CHOLESKY and AMG preconditioners.
+  PreconditionerType preconditioner_type = PreconditionerType::JACOBI;
+  AMGPreconditionerOptions amg_options;
+  int max_num_iterations = 1000;
+  // Relative tolerance on the residual norm.
+  double tolerance = 1e-10;
+  // Start from the solution of the previous solve if it has the same size.
+  // ADMM and IRLS solve a sequence of similar systems, which makes the
+  // previous solution a good guess.
+  bool warm_start = true;
 };
 
 struct RiemannianStaircaseOptions {
@@ -0,0 +1,283 @@
+#include "solver/sparse_linear_solver.h"
+
+#include <cmath>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <Eigen/IterativeLinearSolvers>
+#include <Eigen/SparseCholesky>
+
+#include "math/selected_inversion.h"
+#include "math/sparse_cholesky_llt.h"
+#include "solver/amg_preconditioner.h"
+#include "util/profiler.h"
+
+namespace gopt {
+namespace {
+
+class CholmodSparseLinearSolver : public SparseLinearSolver {
+ public:
+  explicit CholmodSparseLinearSolver(const SparseCholeskyLLtOptions& options)
+      : linear_solver_(options) {}
+
+  void SetSymbolicFactorizationCache(
+      const std::shared_ptr<SymbolicFactorizationCache>& cache) override {
+    linear_solver_.SetSymbolicFactorizationCache(cache);
+  }
+
+  void AnalyzePattern(const Eigen::SparseMatrix<double>& lhs) override {
+    linear_solver_.AnalyzePattern(lhs);
+  }
+
+  void Factorize(const Eigen::SparseMatrix<double>& lhs) override {
+    linear_solver_.Factorize(lhs);
+  }
+
+  bool UpdateDowndate(const bool update,
+                      const Eigen::SparseMatrix<double>& C) override {
+    return linear_solver_.UpdateDowndate(update, C);
+  }
+
+  bool ComputeSelectedInverse(Eigen::SparseMatrix<double>* inverse) override {
+    Eigen::SparseMatrix<double> L;
+    Eigen::VectorXi permutation;
+    if (!linear_solver_.GetFactor(&L, &permutation)) {
+      return false;
+    }
+    gopt::ComputeSelectedInverse(L, permutation, inverse);
+    return true;
+  }
+
+  Eigen::ComputationInfo Info() override { return linear_solver_.Info(); }
+
+  void SolveInPlace(Eigen::VectorXd* rhs) override {
+    linear_solver_.SolveInPlace(rhs);
+  }
+
+  void SolveInPlace(Eigen::MatrixXd* rhs) override {
+    linear_solver_.SolveInPlace(rhs);
+  }
+
+ private:
+  SparseCholeskyLLt linear_solver_;
+};
+
+class SimplicialLDLTSparseLinearSolver : public SparseLinearSolver {
+ public:
+  SimplicialLDLTSparseLinearSolver() : info_(Eigen::Success) {}
+
+  void AnalyzePattern(const Eigen::SparseMatrix<double>& lhs) override {
+    GOPT_PROFILE_SCOPE("LDLTAnalyze");
+    ldlt_.analyzePattern(lhs);
+    info_ = ldlt_.info();
+  }
+
+  void Factorize(const Eigen::SparseMatrix<double>& lhs) override {
+    GOPT_PROFILE_SCOPE("LDLTFactorize");
+    ldlt_.factorize(lhs);
+    info_ = ldlt_.info();
+  }
+
+  // The factor L * D * L^t of Eigen is scaled to L * D^{1/2}, whose rows are
+  // sorted by setFromTriplets().
+  bool ComputeSelectedInverse(Eigen::SparseMatrix<double>* inverse) override {
+    CHECK_NOTNULL(inverse);
+    if (info_ != Eigen::Success) {
+      return false;
+    }
+    const Eigen::SparseMatrix<double> unit_factor =
+        ldlt_.matrixL().nestedExpression();
+    const Eigen::VectorXd& diagonal = ldlt_.vectorD();
+    if (diagonal.size() > 0 && diagonal.minCoeff() <= 0.0) {
+      return false;
+    }
+    std::vector<Eigen::Triplet<double>> triplets;
+    triplets.reserve(unit_factor.nonZeros() + unit_factor.cols());
+    for (int col = 0; col < unit_factor.outerSize(); col++) {
+      const double scale = std::sqrt(diagonal(col));
+      triplets.emplace_back(col, col, scale);
+      for (Eigen::SparseMatrix<double>::InnerIterator it(unit_factor, col); it;
+           ++it) {
+        if (it.row() > col) {
+          triplets.emplace_back(it.row(), col, scale * it.value());
+        }
+      }
+    }
+    Eigen::SparseMatrix<double> L(unit_factor.rows(), unit_factor.cols());
+    L.setFromTriplets(triplets.begin(), triplets.end());
+
+    // Eigen factorizes P * lhs * P^t, so the k-th row of L is the row
+    // P^{-1}(k) of lhs.
+    const Eigen::VectorXi permutation = ldlt_.permutationPinv().indices();
+    gopt::ComputeSelectedInverse(L, permutation, inverse);
+    return true;
+  }
+
+  Eigen::ComputationInfo Info() override { return info_; }
+
+  // The solution is written to a workspace whose storage is then swapped with
+  // rhs, so repeated solves of the same size do not allocate.
+  void SolveInPlace(Eigen::VectorXd* rhs) override {
+    GOPT_PROFILE_SCOPE("LDLTSolve");
+    CHECK_NOTNULL(rhs);
+    vector_workspace_ = ldlt_.solve(*rhs);
+    info_ = ldlt_.info();
+    rhs->swap(vector_workspace_);
+  }
+
+  void SolveInPlace(Eigen::MatrixXd* rhs) override {
+    GOPT_PROFILE_SCOPE("LDLTSolve");
+    CHECK_NOTNULL(rhs);
+    matrix_workspace_ = ldlt_.solve(*rhs);
+    info_ = ldlt_.info();
+    rhs->swap(matrix_workspace_);
+  }
+
+ private:
+  Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>, Eigen::Upper> ldlt_;
+  Eigen::ComputationInfo info_;
+  Eigen::VectorXd vector_workspace_;
+  Eigen::MatrixXd matrix_workspace_;
+};
+
+// Only the AMG preconditioner has options.
+template <typename Preconditioner>
+void SetPreconditionerOptions(const solver::LinearSolverOptions& options,
+                              Preconditioner* preconditioner) {}
+
+void SetPreconditionerOptions(const solver::LinearSolverOptions& options,
+                              AMGPreconditioner* preconditioner) {
+  preconditioner->SetOptions(options.amg_options);
+}
+
+template <typename Preconditioner>
+class ConjugateGradientSparseLinearSolver : public SparseLinearSolver {
+ public:
+  explicit ConjugateGradientSparseLinearSolver(
+      const solver::LinearSolverOptions& options)
+      : warm_start_(options.warm_start), info_(Eigen::Success) {
+    CHECK_GT(options.max_num_iterations, 0);
+    CHECK_GT(options.tolerance, 0.0);
+    conjugate_gradient_.setMaxIterations(options.max_num_iterations);
+    conjugate_gradient_.setTolerance(options.tolerance);
+    SetPreconditionerOptions(options, &conjugate_gradient_.preconditioner());
+  }
+
+  // Eigen only keeps a reference to the matrix, so it is copied.
+  void AnalyzePattern(const Eigen::SparseMatrix<double>& lhs) override {
+    GOPT_PROFILE_SCOPE("CGAnalyze");
+    lhs_ = lhs;
+    conjugate_gradient_.analyzePattern(lhs_);
+    info_ = conjugate_gradient_.info();
+  }
+
+  void Factorize(const Eigen::SparseMatrix<double>& lhs) override {
+    GOPT_PROFILE_SCOPE("CGPreconditioner");
+    lhs_ = lhs;
+    conjugate_gradient_.factorize(lhs_);
+    info_ = conjugate_gradient_.info();
+  }
+
+  Eigen::ComputationInfo Info() override { return info_; }
+
+  void SolveInPlace(Eigen::VectorXd* rhs) override {
+    Solve(rhs, &vector_solution_);
+  }
+
+  void SolveInPlace(Eigen::MatrixXd* rhs) override {
+    Solve(rhs, &matrix_solution_);
+  }
+
+ private:
+  // The previous solution is kept as the initial guess of the next solve.
+  template <typename MatrixType>
+  void Solve(MatrixType* rhs, MatrixType* solution) {
+    GOPT_PROFILE_SCOPE("CGSolve");
+    CHECK_NOTNULL(rhs);
+    if (warm_start_ && solution->rows() == rhs->rows() &&
+        solution->cols() == rhs->cols()) {
+      *solution = conjugate_gradient_.solveWithGuess(*rhs, *solution);
+    } else {
+      *solution = conjugate_gradient_.solve(*rhs);
+    }
+    info_ = conjugate_gradient_.info();
+    VLOG(3) << "Conjugate gradients: " << conjugate_gradient_.iterations()
+            << " iterations, estimated error " << conjugate_gradient_.error();
+    *rhs = *solution;
+  }
+
+  const bool warm_start_;
+  Eigen::ConjugateGradient<Eigen::SparseMatrix<double>, Eigen::Upper,
+                           Preconditioner>
+      conjugate_gradient_;
+  Eigen::SparseMatrix<double> lhs_;
+  Eigen::ComputationInfo info_;
+  Eigen::VectorXd vector_solution_;
+  Eigen::MatrixXd matrix_solution_;
+};
+
+}  // namespace
+
+std::unique_ptr<SparseLinearSolver> SparseLinearSolver::Create(
+    const solver::LinearSolverOptions& options) {
+  std::unique_ptr<SparseLinearSolver> linear_solver;
+  switch (options.type) {
+    case solver::LinearSolverType::CHOLMOD:
+      linear_solver.reset(new CholmodSparseLinearSolver(options.cholmod_options));
+      break;
+    case solver::LinearSolverType::SIMPLICIAL_LDLT:
+      linear_solver.reset(new SimplicialLDLTSparseLinearSolver());
+      break;
+    case solver::LinearSolverType::CONJUGATE_GRADIENT:
+      switch (options.preconditioner_type) {
+        case solver::PreconditionerType::None:
+          linear_solver.reset(new ConjugateGradientSparseLinearSolver<
+                              Eigen::IdentityPreconditioner>(options));
+          break;
+        case solver::PreconditionerType::JACOBI:
+          linear_solver.reset(new ConjugateGradientSparseLinearSolver<
+                              Eigen::DiagonalPreconditioner<double>>(options));
+          break;
+        case solver::PreconditionerType::INCOMPLETE_CHOLESKY:
+          linear_solver.reset(
+              new ConjugateGradientSparseLinearSolver<
+                  Eigen::IncompleteCholesky<double, Eigen::Upper,
+                                            Eigen::AMDOrdering<int>>>(options));
+          break;
+        case solver::PreconditionerType::AMG:
+          linear_solver.reset(
+              new ConjugateGradientSparseLinearSolver<AMGPreconditioner>(
+                  options));
+          break;
+        default:
+          LOG(FATAL) << "The preconditioner is not supported by the conjugate "
+                        "gradient solver.";
+      }
+      break;
+    default:
+      LOG(FATAL) << "Unknown linear solver type.";
+  }
+  return linear_solver;
+}
+
+void SparseLinearSolver::Compute(const Eigen::SparseMatrix<double>& lhs) {
+  AnalyzePattern(lhs);
+  if (Info() == Eigen::Success) {
+    Factorize(lhs);
+  }
+}
+
+Eigen::VectorXd SparseLinearSolver::Solve(const Eigen::VectorXd& rhs) {
+  Eigen::VectorXd solution = rhs;
+  SolveInPlace(&solution);
+  return solution;
+}
+
+Eigen::MatrixXd SparseLinearSolver::Solve(const Eigen::MatrixXd& rhs) {
+  Eigen::MatrixXd solution = rhs;
+  SolveInPlace(&solution);
+  return solution;
+}
+
+}  // namespace gopt
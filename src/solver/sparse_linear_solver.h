@@ -0,0 +1,83 @@
+#ifndef SOLVER_SPARSE_LINEAR_SOLVER_H_
+#define SOLVER_SPARSE_LINEAR_SOLVER_H_
+
+#include <memory>
+
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+
+#include "math/symbolic_factorization_cache.h"
+#include "solver/solver_options.h"
+#include "util/util.h"
+
+namespace gopt {
+
+// A common interface of the solvers for sparse symmetric positive definite
+// linear systems lhs * x = rhs, which mimics SparseCholeskyLLt. Only the upper
+// triangle of lhs is read, so the matrices may either be stored completely or
+// as their upper triangle.
+//
+// The backend is selected by solver::LinearSolverOptions, so the solvers of
+// the estimators can be benchmarked with CHOLMOD, Eigen's SimplicialLDLT and
+// Eigen's preconditioned conjugate gradients.
+class SparseLinearSolver {
+ public:
+  SparseLinearSolver() {}
+  virtual ~SparseLinearSolver() {}
+
+  static std::unique_ptr<SparseLinearSolver> Create(
+      const solver::LinearSolverOptions& options);
+
+  // Shares the symbolic analyses with other solvers. Backends without a
+  // symbolic analysis ignore the cache.
+  virtual void SetSymbolicFactorizationCache(
+      const std::shared_ptr<SymbolicFactorizationCache>& cache) {}
+
+  // Analyzes the sparsity pattern of lhs, which is reused by Factorize() for
+  // matrices with the same pattern.
+  virtual void AnalyzePattern(const Eigen::SparseMatrix<double>& lhs) = 0;
+
+  // Numerically factorizes lhs (or sets up the preconditioner).
+  virtual void Factorize(const Eigen::SparseMatrix<double>& lhs) = 0;
+
+  // Updates (update = true) or downdates (update = false) the factorization of
+  // lhs to the factorization of lhs + C * C^t or lhs - C * C^t. Returns false
+  // if the backend cannot modify its factorization or the modification failed,
+  // in which case the modified lhs has to be factorized again.
+  virtual bool UpdateDowndate(const bool update,
+                              const Eigen::SparseMatrix<double>& C) {
+    return false;
+  }
+
+  // Computes the entries of the inverse of the factorized lhs on the sparsity
+  // pattern of its Cholesky factor by selected inversion (see
+  // ComputeSelectedInverse()), and stores their lower triangle in inverse. The
+  // pattern contains the pattern of lhs, so these are e.g. the marginal
+  // covariances of the variables and the covariances of the variables coupled
+  // by lhs. Returns false if the backend has no Cholesky factor.
+  virtual bool ComputeSelectedInverse(Eigen::SparseMatrix<double>* inverse) {
+    return false;
+  }
+
+  // The same as AnalyzePattern() followed by Factorize().
+  void Compute(const Eigen::SparseMatrix<double>& lhs);
+
+  // Returns the state of the last step. After each step users should ensure
+  // that Info() returns Eigen::Success.
+  virtual Eigen::ComputationInfo Info() = 0;
+
+  // Overwrites rhs with the solution x. All columns of a matrix are solved
+  // with the same factorization.
+  virtual void SolveInPlace(Eigen::VectorXd* rhs) = 0;
+  virtual void SolveInPlace(Eigen::MatrixXd* rhs) = 0;
+
+  Eigen::VectorXd Solve(const Eigen::VectorXd& rhs);
+  Eigen::MatrixXd Solve(const Eigen::MatrixXd& rhs);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(SparseLinearSolver);
+};
+
+}  // namespace gopt
+
+#endif  // SOLVER_SPARSE_LINEAR_SOLVER_H_
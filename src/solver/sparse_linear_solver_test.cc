@@ -0,0 +1,292 @@
+#include "solver/sparse_linear_solver.h"
+
+#include <vector>
+
+#include <Eigen/Cholesky>
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+
+#include "gtest/gtest.h"
+#include "math/sparse_cholesky_llt.h"
+#include "math/selected_inversion.h"
+#include "util/random.h"
+
+namespace gopt {
+namespace {
+
+// A random graph Laplacian plus the identity, which is sparse and positive
+// definite, stored completely or as its upper triangle.
+Eigen::SparseMatrix<double> CreateLaplacian(const int num_vertices,
+                                            const int num_edges,
+                                            const bool upper_triangle_only,
+                                            RandomNumberGenerator* rng) {
+  std::vector<Eigen::Triplet<double>> triplets;
+  for (int i = 0; i < num_vertices; i++) {
+    triplets.emplace_back(i, i, 1.0);
+  }
+  for (int e = 0; e < num_edges; e++) {
+    const int i = rng->RandInt(0, num_vertices - 1);
+    const int j = rng->RandInt(0, num_vertices - 1);
+    if (i == j) {
+      continue;
+    }
+    const double weight = rng->RandDouble(0.1, 1.0);
+    triplets.emplace_back(i, i, weight);
+    triplets.emplace_back(j, j, weight);
+    if (!upper_triangle_only || i < j) {
+      triplets.emplace_back(i, j, -weight);
+    }
+    if (!upper_triangle_only || j < i) {
+      triplets.emplace_back(j, i, -weight);
+    }
+  }
+
+  Eigen::SparseMatrix<double> laplacian(num_vertices, num_vertices);
+  laplacian.setFromTriplets(triplets.begin(), triplets.end());
+  return laplacian;
+}
+
+void TestSparseLinearSolver(const solver::LinearSolverOptions& options,
+                            const bool upper_triangle_only,
+                            const double tolerance) {
+  static const int kNumVertices = 200;
+  static const int kNumRhs = 3;
+  RandomNumberGenerator rng(62);
+
+  const Eigen::SparseMatrix<double> lhs =
+      CreateLaplacian(kNumVertices, 4 * kNumVertices, upper_triangle_only, &rng);
+  const Eigen::MatrixXd dense_lhs =
+      Eigen::MatrixXd(lhs).selfadjointView<Eigen::Upper>();
+  Eigen::MatrixXd rhs(kNumVertices, kNumRhs);
+  rng.SetRandom(&rhs);
+  const Eigen::MatrixXd expected_solution = dense_lhs.ldlt().solve(rhs);
+
+  std::unique_ptr<SparseLinearSolver> linear_solver =
+      SparseLinearSolver::Create(options);
+  linear_solver->Compute(lhs);
+  ASSERT_EQ(linear_solver->Info(), Eigen::Success);
+
+  const Eigen::VectorXd solution = linear_solver->Solve(
+      static_cast<Eigen::VectorXd>(rhs.col(0)));
+  ASSERT_EQ(linear_solver->Info(), Eigen::Success);
+  EXPECT_LT((solution - expected_solution.col(0)).norm(), tolerance);
+
+  Eigen::MatrixXd solutions = rhs;
+  linear_solver->SolveInPlace(&solutions);
+  ASSERT_EQ(linear_solver->Info(), Eigen::Success);
+  EXPECT_LT((solutions - expected_solution).norm(), tolerance);
+
+  // The numeric factorization of a matrix with the same pattern.
+  linear_solver->Factorize(2.0 * lhs);
+  ASSERT_EQ(linear_solver->Info(), Eigen::Success);
+  solutions = rhs;
+  linear_solver->SolveInPlace(&solutions);
+  ASSERT_EQ(linear_solver->Info(), Eigen::Success);
+  EXPECT_LT((2.0 * solutions - expected_solution).norm(), tolerance);
+}
+
+}  // namespace
+
+TEST(SparseLinearSolver, Cholmod) {
+  solver::LinearSolverOptions options;
+  options.type = solver::LinearSolverType::CHOLMOD;
+  TestSparseLinearSolver(options, false, 1e-8);
+  TestSparseLinearSolver(options, true, 1e-8);
+}
+
+TEST(SparseLinearSolver, CholmodOptions) {
+  solver::LinearSolverOptions options;
+  options.type = solver::LinearSolverType::CHOLMOD;
+  for (const CholeskyOrderingType ordering_type :
+       {CholeskyOrderingType::AMD, CholeskyOrderingType::COLAMD}) {
+    for (const CholeskyFactorizationType factorization_type :
+         {CholeskyFactorizationType::SIMPLICIAL,
+          CholeskyFactorizationType::SUPERNODAL}) {
+      options.cholmod_options.ordering_type = ordering_type;
+      options.cholmod_options.factorization_type = factorization_type;
+      options.cholmod_options.use_gpu = 0;
+      TestSparseLinearSolver(options, false, 1e-8);
+      TestSparseLinearSolver(options, true, 1e-8);
+    }
+  }
+}
+
+TEST(SparseLinearSolver, CholmodLongIndices) {
+  solver::LinearSolverOptions options;
+  options.type = solver::LinearSolverType::CHOLMOD;
+  options.cholmod_options.index_type = CholeskyIndexType::INT64;
+  TestSparseLinearSolver(options, false, 1e-8);
+  TestSparseLinearSolver(options, true, 1e-8);
+}
+
+TEST(SparseLinearSolver, CholmodSwitchesToLongIndices) {
+  // Every factor is too large for 32-bit indices with this threshold.
+  solver::LinearSolverOptions options;
+  options.type = solver::LinearSolverType::CHOLMOD;
+  options.cholmod_options.index_type = CholeskyIndexType::AUTO;
+  options.cholmod_options.max_int32_factor_nonzeros = 1.0;
+  TestSparseLinearSolver(options, false, 1e-8);
+  TestSparseLinearSolver(options, true, 1e-8);
+
+  static const int kNumVertices = 200;
+  RandomNumberGenerator rng(64);
+  const Eigen::SparseMatrix<double> lhs =
+      CreateLaplacian(kNumVertices, 4 * kNumVertices, true, &rng);
+
+  SparseCholeskyLLt llt(options.cholmod_options);
+  llt.Compute(lhs);
+  ASSERT_EQ(llt.Info(), Eigen::Success);
+  EXPECT_TRUE(llt.UsesLongIndices());
+
+  SparseCholeskyLLtOptions default_options;
+  SparseCholeskyLLt default_llt(default_options);
+  default_llt.Compute(lhs);
+  ASSERT_EQ(default_llt.Info(), Eigen::Success);
+  EXPECT_FALSE(default_llt.UsesLongIndices());
+}
+
+TEST(SparseLinearSolver, CholmodLongSparseMatrix) {
+  static const int kNumVertices = 200;
+  RandomNumberGenerator rng(64);
+  const Eigen::SparseMatrix<double> lhs =
+      CreateLaplacian(kNumVertices, 4 * kNumVertices, true, &rng);
+  const LongSparseMatrix long_lhs = lhs;
+  const Eigen::MatrixXd dense_lhs =
+      Eigen::MatrixXd(lhs).selfadjointView<Eigen::Upper>();
+  Eigen::VectorXd rhs(kNumVertices);
+  rng.SetRandom(&rhs);
+  const Eigen::VectorXd expected_solution = dense_lhs.ldlt().solve(rhs);
+
+  // The 64-bit matrices are factorized with 64-bit indices, independent of the
+  // index type of the options.
+  SparseCholeskyLLt llt;
+  llt.AnalyzePattern(long_lhs);
+  llt.Factorize(long_lhs);
+  ASSERT_EQ(llt.Info(), Eigen::Success);
+  EXPECT_TRUE(llt.UsesLongIndices());
+  EXPECT_LT((llt.Solve(rhs) - expected_solution).norm(), 1e-8);
+
+  const LongSparseMatrix scaled_long_lhs = 2.0 * long_lhs;
+  llt.Factorize(scaled_long_lhs);
+  ASSERT_EQ(llt.Info(), Eigen::Success);
+  EXPECT_LT((2.0 * llt.Solve(rhs) - expected_solution).norm(), 1e-8);
+
+  SparseCholeskyLLt computed_llt;
+  computed_llt.Compute(long_lhs);
+  ASSERT_EQ(computed_llt.Info(), Eigen::Success);
+  EXPECT_TRUE(computed_llt.UsesLongIndices());
+  EXPECT_LT((computed_llt.Solve(rhs) - expected_solution).norm(), 1e-8);
+}
+
+TEST(SparseLinearSolver, CholmodUpdateDowndate) {
+  static const int kNumVertices = 200;
+  RandomNumberGenerator rng(65);
+  const Eigen::SparseMatrix<double> lhs =
+      CreateLaplacian(kNumVertices, 4 * kNumVertices, true, &rng);
+
+  // Two edges of a Laplacian as the columns of C.
+  std::vector<Eigen::Triplet<double>> triplets = {
+      {0, 0, 1.0}, {5, 0, -1.0}, {7, 1, 0.5}, {100, 1, -0.5}};
+  Eigen::SparseMatrix<double> C(kNumVertices, 2);
+  C.setFromTriplets(triplets.begin(), triplets.end());
+  const Eigen::MatrixXd dense_lhs =
+      Eigen::MatrixXd(lhs).selfadjointView<Eigen::Upper>();
+  const Eigen::MatrixXd updated_lhs =
+      dense_lhs + Eigen::MatrixXd(C * C.transpose());
+
+  Eigen::VectorXd rhs(kNumVertices);
+  rng.SetRandom(&rhs);
+
+  solver::LinearSolverOptions options;
+  options.type = solver::LinearSolverType::CHOLMOD;
+  std::unique_ptr<SparseLinearSolver> linear_solver =
+      SparseLinearSolver::Create(options);
+  linear_solver->Compute(lhs);
+  ASSERT_EQ(linear_solver->Info(), Eigen::Success);
+
+  ASSERT_TRUE(linear_solver->UpdateDowndate(true, C));
+  Eigen::VectorXd solution = linear_solver->Solve(rhs);
+  EXPECT_LT((solution - updated_lhs.ldlt().solve(rhs)).norm(), 1e-8);
+
+  ASSERT_TRUE(linear_solver->UpdateDowndate(false, C));
+  solution = linear_solver->Solve(rhs);
+  EXPECT_LT((solution - dense_lhs.ldlt().solve(rhs)).norm(), 1e-8);
+
+  // The Eigen backends do not support modifying their factorizations.
+  options.type = solver::LinearSolverType::SIMPLICIAL_LDLT;
+  linear_solver = SparseLinearSolver::Create(options);
+  linear_solver->Compute(lhs);
+  EXPECT_FALSE(linear_solver->UpdateDowndate(true, C));
+}
+
+TEST(SparseLinearSolver, SelectedInverse) {
+  static const int kNumVertices = 200;
+  RandomNumberGenerator rng(68);
+  const Eigen::SparseMatrix<double> lhs =
+      CreateLaplacian(kNumVertices, 4 * kNumVertices, true, &rng);
+  const Eigen::MatrixXd dense_lhs =
+      Eigen::MatrixXd(lhs).selfadjointView<Eigen::Upper>();
+  const Eigen::MatrixXd expected_inverse =
+      dense_lhs.ldlt().solve(Eigen::MatrixXd::Identity(kNumVertices,
+                                                       kNumVertices));
+
+  solver::LinearSolverOptions options;
+  for (const solver::LinearSolverType type :
+       {solver::LinearSolverType::CHOLMOD,
+        solver::LinearSolverType::SIMPLICIAL_LDLT}) {
+    options.type = type;
+    std::unique_ptr<SparseLinearSolver> linear_solver =
+        SparseLinearSolver::Create(options);
+    linear_solver->Compute(lhs);
+    ASSERT_EQ(linear_solver->Info(), Eigen::Success);
+
+    Eigen::SparseMatrix<double> inverse;
+    ASSERT_TRUE(linear_solver->ComputeSelectedInverse(&inverse));
+    for (int col = 0; col < inverse.outerSize(); col++) {
+      for (Eigen::SparseMatrix<double>::InnerIterator it(inverse, col); it;
+           ++it) {
+        ASSERT_GE(it.row(), col);
+        EXPECT_NEAR(it.value(), expected_inverse(it.row(), col), 1e-10);
+      }
+    }
+
+    // The pattern of the inverse contains the pattern of lhs.
+    for (int col = 0; col < lhs.outerSize(); col++) {
+      for (Eigen::SparseMatrix<double>::InnerIterator it(lhs, col); it; ++it) {
+        EXPECT_NEAR(GetSymmetricBlock(inverse, it.row(), col, 1, 1)(0, 0),
+                    expected_inverse(it.row(), col), 1e-10);
+      }
+    }
+  }
+
+  // Conjugate gradients do not factorize lhs.
+  options.type = solver::LinearSolverType::CONJUGATE_GRADIENT;
+  std::unique_ptr<SparseLinearSolver> linear_solver =
+      SparseLinearSolver::Create(options);
+  linear_solver->Compute(lhs);
+  Eigen::SparseMatrix<double> inverse;
+  EXPECT_FALSE(linear_solver->ComputeSelectedInverse(&inverse));
+}
+
+TEST(SparseLinearSolver, SimplicialLDLT) {
+  solver::LinearSolverOptions options;
+  options.type = solver::LinearSolverType::SIMPLICIAL_LDLT;
+  TestSparseLinearSolver(options, false, 1e-8);
+  TestSparseLinearSolver(options, true, 1e-8);
+}
+
+TEST(SparseLinearSolver, ConjugateGradient) {
+  solver::LinearSolverOptions options;
+  options.type = solver::LinearSolverType::CONJUGATE_GRADIENT;
+  for (const solver::PreconditionerType preconditioner_type :
+       {solver::PreconditionerType::None, solver::PreconditionerType::JACOBI,
+        solver::PreconditionerType::INCOMPLETE_CHOLESKY,
+        solver::PreconditionerType::AMG}) {
+    options.preconditioner_type = preconditioner_type;
+    options.amg_options.coarsest_size = 20;
+    TestSparseLinearSolver(options, false, 1e-6);
+    TestSparseLinearSolver(options, true, 1e-6);
+  }
+}
+
+}  // namespace gopt
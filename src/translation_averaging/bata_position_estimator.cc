@@ -0,0 +1,371 @@
+#include "translation_averaging/bata_position_estimator.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+
+#include <Eigen/SparseCore>
+#include <glog/logging.h>
+
+#include "math/selected_inversion.h"
+#include "math/sparse_cholesky_llt.h"
+#include "translation_averaging/internal/translation_averaging_util.h"
+#include "util/map_util.h"
+#include "util/profiler.h"
+#include "util/timer.h"
+#include "util/view_pair_util.h"
+
+namespace gopt {
+namespace {
+
+// Keeps the Laplacian positive definite when the weights of all edges of a
+// view vanish (e.g., all of them are rejected as outliers).
+const double kMinEdgeWeight = 1e-8;
+
+// Pairs whose positions are closer than this are treated as degenerate.
+const double kMinSquaredBaseline = 1e-16;
+
+}  // namespace
+
+BATAPositionEstimator::BATAPositionEstimator(
+    const BATAPositionEstimator::Options& options)
+    : options_(options) {
+  CHECK_GT(options_.max_num_iterations, 0);
+  CHECK_GT(options_.robust_loss_width, 0.0);
+}
+
+bool BATAPositionEstimator::EstimatePositions(
+    const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+    const std::unordered_map<image_t, Eigen::Vector3d>& orientations,
+    std::unordered_map<image_t, Eigen::Vector3d>* positions) {
+  GOPT_PROFILE_SCOPE("BATA");
+  CHECK_NOTNULL(positions)->clear();
+  covariances_.clear();
+
+  InitializeIndexMapping(view_pairs, orientations);
+  const int num_views = index_to_view_id_.size();
+  const int num_edges = edges_.size();
+  if (num_views < 2) {
+    LOG(ERROR) << "At least two views with known orientations are required.";
+    return false;
+  }
+
+  SetupLaplacianPattern();
+
+  // Without initial positions, the first iteration with unit baselines and
+  // weights is the linear least squares fit of the position differences to the
+  // directions.
+  Eigen::VectorXd baselines = Eigen::VectorXd::Ones(num_edges);
+  Eigen::VectorXd edge_weights = Eigen::VectorXd::Ones(num_edges);
+  Eigen::VectorXd residuals(num_edges);
+
+  // Row 0 holds the constant view.
+  Eigen::MatrixXd view_positions = Eigen::MatrixXd::Zero(num_views, 3);
+  if (InitializePositions(&view_positions)) {
+    // Start from the baselines and weights of the initial positions instead.
+    UpdateEdges(view_positions, &baselines, &residuals, &edge_weights);
+    const double mean_baseline = baselines.mean();
+    if (mean_baseline > 0.0) {
+      baselines /= mean_baseline;
+      view_positions *= mean_baseline;
+    } else {
+      baselines.setOnes();
+      edge_weights.setOnes();
+    }
+  }
+  Eigen::MatrixXd prev_view_positions = view_positions;
+  Eigen::MatrixXd rhs(num_views - 1, 3);
+  // The scale of the positions relative to the last solution.
+  double position_scale = 1.0;
+
+  SparseCholeskyLLt linear_solver;
+
+  LOG(INFO) << std::setw(12) << std::setfill(' ') << "Iter "
+            << std::setw(16) << std::setfill(' ') << "SqError "
+            << std::setw(16) << std::setfill(' ') << "Delta ";
+
+  Timer timer;
+  timer.Start();
+  for (int i = 0; i < options_.max_num_iterations; i++) {
+    UpdateLinearSystem(edge_weights, baselines, &rhs);
+
+    // The sparsity pattern never changes, so analyze it only once.
+    if (i == 0) {
+      linear_solver.AnalyzePattern(laplacian_);
+      if (linear_solver.Info() != Eigen::Success) {
+        LOG(ERROR) << "Cholesky symbolic analysis failed.";
+        return false;
+      }
+    }
+
+    linear_solver.Factorize(laplacian_);
+    if (linear_solver.Info() != Eigen::Success) {
+      LOG(ERROR) << "Failed to factorize the least squares system.";
+      return false;
+    }
+
+    // The three coordinates share the Laplacian and are solved at once.
+    linear_solver.SolveInPlace(&rhs);
+    if (linear_solver.Info() != Eigen::Success) {
+      LOG(ERROR) << "Failed to solve the least squares system.";
+      return false;
+    }
+    view_positions.bottomRows(num_views - 1) = rhs;
+
+    UpdateEdges(view_positions, &baselines, &residuals, &edge_weights);
+
+    // The objective is invariant to scaling the positions by s and the
+    // inverse baselines by 1/s. Normalizing the baselines keeps the scale of
+    // the next solution, and thus the convergence test, stable.
+    const double mean_baseline = baselines.mean();
+    if (mean_baseline <= 0.0) {
+      LOG(ERROR) << "All relative translations are inconsistent.";
+      return false;
+    }
+    baselines /= mean_baseline;
+    view_positions *= mean_baseline;
+    position_scale = mean_baseline;
+
+    const double position_norm = view_positions.norm();
+    const double delta =
+        (view_positions - prev_view_positions).norm() /
+        std::max(position_norm, std::numeric_limits<double>::epsilon());
+    prev_view_positions = view_positions;
+
+    LOG(INFO) << std::setw(12) << std::setfill(' ') << i
+              << std::setw(16) << std::setfill(' ')
+              << residuals.squaredNorm()
+              << std::setw(16) << std::setfill(' ') << delta;
+
+    if (delta < options_.convergence_criterion) {
+      LOG(INFO) << "BATA converged in " << i + 1 << " iterations.";
+      break;
+    }
+  }
+  timer.Pause();
+
+  LOG(INFO) << "Total time [BATA]: "
+            << timer.ElapsedMicroSeconds() * 1e-3 << " ms.";
+
+  for (int i = 0; i < num_views; i++) {
+    (*positions)[index_to_view_id_[i]] = view_positions.row(i).transpose();
+  }
+
+  if (options_.compute_covariances &&
+      !ComputeCovariances(position_scale, &linear_solver)) {
+    LOG(WARNING) << "Failed to compute the covariances of the positions.";
+  }
+  return true;
+}
+
+const std::unordered_map<image_t, Eigen::Matrix3d>&
+BATAPositionEstimator::GetCovariances() const {
+  return covariances_;
+}
+
+bool BATAPositionEstimator::ComputeCovariances(
+    const double position_scale, SparseCholeskyLLt* linear_solver) {
+  GOPT_PROFILE_SCOPE("BATACovariances");
+
+  // The positions are the last solution of laplacian_ * x = rhs scaled by
+  // position_scale, so their covariances are the diagonal of the inverse of
+  // laplacian_ scaled by position_scale^2. Only the entries on the pattern of
+  // the factor are computed, which contains the diagonal.
+  Eigen::SparseMatrix<double> factor;
+  Eigen::VectorXi permutation;
+  if (!linear_solver->GetFactor(&factor, &permutation)) {
+    return false;
+  }
+  Eigen::SparseMatrix<double> inverse;
+  ComputeSelectedInverse(factor, permutation, &inverse);
+
+  const int num_views = index_to_view_id_.size();
+  covariances_[index_to_view_id_[0]].setZero();
+  for (int k = 1; k < num_views; k++) {
+    const double variance = position_scale * position_scale *
+                            GetSymmetricBlock(inverse, k - 1, k - 1, 1, 1)(0);
+    covariances_[index_to_view_id_[k]] =
+        variance * Eigen::Matrix3d::Identity();
+  }
+  return true;
+}
+
+void BATAPositionEstimator::InitializeIndexMapping(
+    const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+    const std::unordered_map<image_t, Eigen::Vector3d>& orientations) {
+  edges_.clear();
+  directions_.clear();
+
+  std::vector<ImagePair> valid_pairs;
+  IndexViewPairs(view_pairs, orientations, &valid_pairs, &index_to_view_id_,
+                 &view_id_to_index_);
+
+  edges_.reserve(valid_pairs.size());
+  directions_.reserve(valid_pairs.size());
+  for (const ImagePair& view_id_pair : valid_pairs) {
+    const TwoViewGeometry& two_view_geometry =
+        FindOrDieNoPrint(view_pairs, view_id_pair);
+    // Rotate the relative translation so that it is aligned to the global
+    // orientation frame.
+    const Eigen::Vector3d direction = internal::GetRotatedTranslation(
+        FindOrDie(orientations, view_id_pair.first),
+        two_view_geometry.translation_2);
+    if (direction.squaredNorm() == 0.0) {
+      continue;
+    }
+
+    edges_.emplace_back(FindOrDie(view_id_to_index_, view_id_pair.first),
+                        FindOrDie(view_id_to_index_, view_id_pair.second));
+    directions_.push_back(direction.normalized());
+  }
+
+  VLOG(2) << edges_.size() << " camera to camera constraints were added "
+                              "to the position estimation problem.";
+}
+
+bool BATAPositionEstimator::InitializePositions(
+    Eigen::MatrixXd* view_positions) const {
+  if (initial_positions_.empty()) {
+    return false;
+  }
+
+  for (const image_t view_id : index_to_view_id_) {
+    if (!ContainsKey(initial_positions_, view_id)) {
+      LOG(WARNING) << "The initial positions do not cover view " << view_id
+                   << ", they are ignored.";
+      return false;
+    }
+  }
+
+  // Translate the positions such that the constant view is at the origin.
+  const Eigen::Vector3d& origin =
+      FindOrDie(initial_positions_, index_to_view_id_[0]);
+  for (size_t i = 0; i < index_to_view_id_.size(); i++) {
+    view_positions->row(i) =
+        (FindOrDie(initial_positions_, index_to_view_id_[i]) - origin)
+            .transpose();
+  }
+  return true;
+}
+
+void BATAPositionEstimator::SetupLaplacianPattern() {
+  const int num_views = index_to_view_id_.size();
+  const int num_edges = edges_.size();
+
+  adjacent_edges_.assign(num_views, std::vector<int>());
+  for (int e = 0; e < num_edges; e++) {
+    adjacent_edges_[edges_[e].first].push_back(e);
+    adjacent_edges_[edges_[e].second].push_back(e);
+  }
+
+  // The reduced index of view k is k - 1, the constant view is removed.
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.reserve(num_views + num_edges);
+  for (int k = 1; k < num_views; k++) {
+    triplets.emplace_back(k - 1, k - 1, 0.0);
+  }
+  for (const auto& edge : edges_) {
+    const int row = std::min(edge.first, edge.second) - 1;
+    const int col = std::max(edge.first, edge.second) - 1;
+    if (row != kConstantViewIndex && row != col) {
+      triplets.emplace_back(row, col, 0.0);
+    }
+  }
+
+  laplacian_.resize(num_views - 1, num_views - 1);
+  laplacian_.setFromTriplets(triplets.begin(), triplets.end());
+  laplacian_.makeCompressed();
+
+  const int* outer_index = laplacian_.outerIndexPtr();
+  const int* inner_index = laplacian_.innerIndexPtr();
+  const auto find_slot = [&](const int row, const int col) {
+    const int* slot = std::lower_bound(inner_index + outer_index[col],
+                                       inner_index + outer_index[col + 1],
+                                       row);
+    CHECK(slot != inner_index + outer_index[col + 1] && *slot == row);
+    return static_cast<int>(slot - inner_index);
+  };
+
+  diagonal_slots_.assign(num_views, -1);
+  off_diagonal_slots_.assign(num_views, std::vector<int>());
+  for (int k = 1; k < num_views; k++) {
+    diagonal_slots_[k] = find_slot(k - 1, k - 1);
+    off_diagonal_slots_[k].reserve(adjacent_edges_[k].size());
+    for (const int e : adjacent_edges_[k]) {
+      const int other =
+          (edges_[e].first == k) ? edges_[e].second : edges_[e].first;
+      // Only the upper triangle is stored, so the entry belongs to the column
+      // of the view with the larger index.
+      if (other != 0 && other < k) {
+        off_diagonal_slots_[k].push_back(find_slot(other - 1, k - 1));
+      } else {
+        off_diagonal_slots_[k].push_back(-1);
+      }
+    }
+  }
+}
+
+void BATAPositionEstimator::UpdateLinearSystem(
+    const Eigen::VectorXd& edge_weights, const Eigen::VectorXd& baselines,
+    Eigen::MatrixXd* rhs) {
+  const int num_views = index_to_view_id_.size();
+  double* values = laplacian_.valuePtr();
+  const int* outer_index = laplacian_.outerIndexPtr();
+
+  // Each view only writes the values of its own column and its own row of the
+  // right hand side, so the views can be processed in parallel.
+#pragma omp parallel for num_threads(options_.num_threads)
+  for (int k = 1; k < num_views; k++) {
+    std::fill(values + outer_index[k - 1], values + outer_index[k], 0.0);
+
+    Eigen::Vector3d b = Eigen::Vector3d::Zero();
+    const std::vector<int>& adjacent_edges = adjacent_edges_[k];
+    for (size_t a = 0; a < adjacent_edges.size(); a++) {
+      const int e = adjacent_edges[a];
+      const double weight =
+          edge_weights[e] * baselines[e] * baselines[e] + kMinEdgeWeight;
+      values[diagonal_slots_[k]] += weight;
+      if (off_diagonal_slots_[k][a] >= 0) {
+        values[off_diagonal_slots_[k][a]] -= weight;
+      }
+
+      // d_ij * (c_j - c_i) ~ v_ij, so the view is on the positive side of the
+      // constraint if it is the second view of the pair.
+      const double sign = (edges_[e].second == k) ? 1.0 : -1.0;
+      b += sign * edge_weights[e] * baselines[e] * directions_[e];
+    }
+    rhs->row(k - 1) = b.transpose();
+  }
+}
+
+void BATAPositionEstimator::UpdateEdges(const Eigen::MatrixXd& positions,
+                                        Eigen::VectorXd* baselines,
+                                        Eigen::VectorXd* residuals,
+                                        Eigen::VectorXd* edge_weights) {
+  const int num_edges = edges_.size();
+  const double sigma_sq =
+      options_.robust_loss_width * options_.robust_loss_width;
+
+#pragma omp parallel for num_threads(options_.num_threads)
+  for (int e = 0; e < num_edges; e++) {
+    const Eigen::Vector3d baseline_vector =
+        (positions.row(edges_[e].second) - positions.row(edges_[e].first))
+            .transpose();
+    const double sq_baseline = baseline_vector.squaredNorm();
+
+    // The inverse baseline minimizing || d * (c_j - c_i) - v_ij || for d >= 0.
+    double inverse_baseline = 0.0;
+    if (sq_baseline > kMinSquaredBaseline) {
+      inverse_baseline =
+          std::max(baseline_vector.dot(directions_[e]), 0.0) / sq_baseline;
+    }
+
+    const double residual =
+        (inverse_baseline * baseline_vector - directions_[e]).norm();
+    (*baselines)[e] = inverse_baseline;
+    (*residuals)[e] = residual;
+    (*edge_weights)[e] = sigma_sq / (residual * residual + sigma_sq);
+  }
+}
+
+}  // namespace gopt
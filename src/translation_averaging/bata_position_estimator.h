@@ -0,0 +1,137 @@
+#ifndef TRANSLATION_AVERAGING_BATA_POSITION_ESTIMATOR_H_
+#define TRANSLATION_AVERAGING_BATA_POSITION_ESTIMATOR_H_
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+
+#include "math/sparse_cholesky_llt.h"
+#include "translation_averaging/position_estimator.h"
+
+namespace gopt {
+
+// Baseline desensitizing translation averaging (BATA) position estimator. The
+// implementation follows the paper:
+//   B. Zhuang, L.F. Cheong and G.H. Lee. Baseline Desensitizing in Translation
+//   Averaging. CVPR 2018.
+//
+// Given the relative translation directions v_ij rotated into the global frame,
+// BATA minimizes the bilinear angle-based objective
+//
+//   sum_ij rho(|| d_ij * (c_j - c_i) - v_ij ||)
+//
+// over the positions c and the per-pair inverse baselines d_ij >= 0. The
+// problem is solved by alternation inside an IRLS loop: for fixed d and robust
+// weights the positions solve a weighted graph-Laplacian least squares
+// problem, and for fixed positions each d_ij and each weight has a closed form.
+// Since the three coordinates decouple, the Laplacian is only (N-1) x (N-1).
+// Its sparsity pattern never changes, so the symbolic analysis is done once and
+// only the numeric factorization is repeated per iteration.
+class BATAPositionEstimator : public PositionEstimator {
+ public:
+  struct Options {
+    int num_threads = 8;
+
+    // Maximum number of IRLS iterations.
+    int max_num_iterations = 100;
+
+    // The IRLS minimization terminates when the relative change of the
+    // positions falls below this threshold.
+    double convergence_criterion = 1e-5;
+
+    // Width of the Cauchy-like robust loss on the angle-based residuals.
+    double robust_loss_width = 0.1;
+
+    // Computes the covariances of the positions from the factorization of the
+    // last iteration by selected inversion (see GetCovariances()).
+    bool compute_covariances = false;
+  };
+
+  BATAPositionEstimator(const BATAPositionEstimator::Options& options);
+
+  // Returns true if the optimization was a success, false if there was a
+  // failure.
+  bool EstimatePositions(
+      const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+      const std::unordered_map<image_t, Eigen::Vector3d>& orientation,
+      std::unordered_map<image_t, Eigen::Vector3d>* positions) override;
+
+  // The 3x3 covariances of the positions, i.e. the diagonal entries of the
+  // inverse of the reduced Laplacian of the last iteration times the identity,
+  // up to the variance of the noise of the directions. The inverse baselines
+  // and robust weights of the last iteration are taken as fixed. The
+  // covariances are relative to the constant view, whose covariance is zero.
+  // Since the coordinates decouple, the covariances are isotropic. Only
+  // computed if compute_covariances is set.
+  const std::unordered_map<image_t, Eigen::Matrix3d>& GetCovariances() const;
+
+  // We keep one of the positions as constant to remove the translation
+  // ambiguity of the linear system.
+  static const int kConstantViewIndex = -1;
+
+ private:
+  // Collects the view pairs with known orientations, assigns each view an
+  // index in ascending order of view id and rotates the relative translations
+  // into the global frame.
+  void InitializeIndexMapping(
+      const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+      const std::unordered_map<image_t, Eigen::Vector3d>& orientations);
+
+  // Copies the initial positions, if they are set and cover all views, into
+  // the rows of view_positions relative to the constant view.
+  bool InitializePositions(Eigen::MatrixXd* view_positions) const;
+
+  // Builds the (upper triangular) sparsity pattern of the reduced graph
+  // Laplacian, and for each view the slots of its column in the value array.
+  void SetupLaplacianPattern();
+
+  // Fills the Laplacian values with the current edge weights and computes the
+  // right hand sides of the three coordinate systems. Parallel over views.
+  void UpdateLinearSystem(const Eigen::VectorXd& edge_weights,
+                          const Eigen::VectorXd& baselines,
+                          Eigen::MatrixXd* rhs);
+
+  // Updates the inverse baselines, the residuals and the robust weights of all
+  // edges given the current positions. Parallel over edges.
+  void UpdateEdges(const Eigen::MatrixXd& positions,
+                   Eigen::VectorXd* baselines,
+                   Eigen::VectorXd* residuals,
+                   Eigen::VectorXd* edge_weights);
+
+  // Computes the covariances from the factorization of the last iteration,
+  // whose solution was scaled by position_scale. Returns false if the factor
+  // cannot be exported.
+  bool ComputeCovariances(const double position_scale,
+                          SparseCholeskyLLt* linear_solver);
+
+  const BATAPositionEstimator::Options options_;
+
+  std::vector<image_t> index_to_view_id_;
+  std::unordered_map<image_t, int> view_id_to_index_;
+
+  // Endpoints (view indices) and global frame directions of each edge.
+  std::vector<std::pair<int, int>> edges_;
+  std::vector<Eigen::Vector3d> directions_;
+
+  // Incident edges of each view.
+  std::vector<std::vector<int>> adjacent_edges_;
+
+  // The reduced Laplacian (the constant view removed), upper triangle only.
+  Eigen::SparseMatrix<double> laplacian_;
+  // For each view, the value slot of its diagonal entry and, for each of its
+  // incident edges, the slot of the off-diagonal entry in its column or -1 if
+  // that entry lives in the column of the other view.
+  std::vector<int> diagonal_slots_;
+  std::vector<std::vector<int>> off_diagonal_slots_;
+
+  std::unordered_map<image_t, Eigen::Matrix3d> covariances_;
+
+  DISALLOW_COPY_AND_ASSIGN(BATAPositionEstimator);
+};
+
+}  // namespace gopt
+
+#endif  // TRANSLATION_AVERAGING_BATA_POSITION_ESTIMATOR_H_
@@ -0,0 +1,121 @@
+#include "translation_averaging/bata_position_estimator.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "translation_averaging/ligt_position_estimator.h"
+#include "translation_averaging/test_util.h"
+#include "util/map_util.h"
+
+namespace gopt {
+
+class BATAPositionEstimatorTest : public TranslationAveragingTest {
+ public:
+  void TestBATAPositionEstimator(const int num_views,
+                                 const int num_view_pairs,
+                                 const double translation_noise_degrees,
+                                 const int num_outliers,
+                                 const double position_tolerance,
+                                 const bool linear_initialization = false) {
+    // At least a cycle graph.
+    ASSERT_LE(num_views + 1, num_view_pairs);
+
+    CreateGTCameras(num_views);
+    CreateRelativeTranslations(num_view_pairs, translation_noise_degrees,
+                               num_outliers);
+
+    BATAPositionEstimator::Options options;
+    options.convergence_criterion = 1e-8;
+    options.max_num_iterations = 500;
+    BATAPositionEstimator position_estimator(options);
+    if (linear_initialization) {
+      LiGTPositionEstimator::Options ligt_options;
+      LiGTPositionEstimator ligt_position_estimator(ligt_options);
+      std::unordered_map<image_t, Eigen::Vector3d> initial_positions;
+      EXPECT_TRUE(ligt_position_estimator.EstimatePositions(
+          view_pairs_, orientations_, &initial_positions));
+      position_estimator.SetInitialPositions(initial_positions);
+    }
+
+    std::unordered_map<image_t, Eigen::Vector3d> estimated_positions;
+    EXPECT_TRUE(position_estimator.EstimatePositions(
+        view_pairs_, orientations_, &estimated_positions));
+    EXPECT_EQ(estimated_positions.size(), positions_.size());
+
+    // Positions are recovered up to a translation and a scale.
+    AlignPositions(&estimated_positions);
+    for (const auto& position : positions_) {
+      const Eigen::Vector3d& estimated_position =
+          FindOrDie(estimated_positions, position.first);
+      EXPECT_LT((estimated_position - position.second).norm(),
+                position_tolerance);
+    }
+  }
+};
+
+TEST_F(BATAPositionEstimatorTest, SmallTestNoNoise) {
+  TestBATAPositionEstimator(20, 60, 0.0, 0, 1e-4);
+}
+
+TEST_F(BATAPositionEstimatorTest, SmallTestWithNoise) {
+  TestBATAPositionEstimator(20, 80, 1.0, 0, 0.5);
+}
+
+TEST_F(BATAPositionEstimatorTest, MediumTestWithOutliers) {
+  TestBATAPositionEstimator(100, 600, 1.0, 30, 1.0);
+}
+
+TEST_F(BATAPositionEstimatorTest, MediumTestWithOutliersLinearInitialization) {
+  TestBATAPositionEstimator(100, 600, 1.0, 30, 1.0, true);
+}
+
+TEST_F(BATAPositionEstimatorTest, CovariancesWithoutNoise) {
+  const int num_views = 20;
+  CreateGTCameras(num_views);
+  CreateRelativeTranslations(60, 0.0);
+
+  BATAPositionEstimator::Options options;
+  options.convergence_criterion = 1e-10;
+  options.max_num_iterations = 500;
+  options.compute_covariances = true;
+  BATAPositionEstimator position_estimator(options);
+  std::unordered_map<image_t, Eigen::Vector3d> estimated_positions;
+  ASSERT_TRUE(position_estimator.EstimatePositions(view_pairs_, orientations_,
+                                                   &estimated_positions));
+
+  // Without noise the robust weights are one and the inverse baselines are the
+  // inverse distances of the estimated positions, so the covariances are the
+  // diagonal of the inverse of the Laplacian with the edge weights
+  // 1 / ||c_j - c_i||^2, without the constant view 0.
+  Eigen::MatrixXd laplacian = Eigen::MatrixXd::Zero(num_views, num_views);
+  for (const auto& view_pair : view_pairs_) {
+    const int i = view_pair.first.first;
+    const int j = view_pair.first.second;
+    const double weight = 1.0 / (FindOrDie(estimated_positions, j) -
+                                 FindOrDie(estimated_positions, i))
+                                    .squaredNorm();
+    laplacian(i, i) += weight;
+    laplacian(j, j) += weight;
+    laplacian(i, j) -= weight;
+    laplacian(j, i) -= weight;
+  }
+  const Eigen::MatrixXd inverse =
+      laplacian.bottomRightCorner(num_views - 1, num_views - 1).inverse();
+
+  const std::unordered_map<image_t, Eigen::Matrix3d>& covariances =
+      position_estimator.GetCovariances();
+  ASSERT_EQ(covariances.size(), static_cast<size_t>(num_views));
+  EXPECT_EQ(FindOrDie(covariances, 0), Eigen::Matrix3d::Zero());
+  for (int k = 1; k < num_views; k++) {
+    const Eigen::Matrix3d expected_covariance =
+        inverse(k - 1, k - 1) * Eigen::Matrix3d::Identity();
+    EXPECT_LT((FindOrDie(covariances, k) - expected_covariance).norm(),
+              1e-4 * expected_covariance.norm());
+  }
+}
+
+}  // namespace gopt
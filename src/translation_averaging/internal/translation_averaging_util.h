@@ -0,0 +1,25 @@
+#ifndef TRANSLATION_AVERAGING_INTERNAL_TRANSLATION_AVERAGING_UTIL_H_
+#define TRANSLATION_AVERAGING_INTERNAL_TRANSLATION_AVERAGING_UTIL_H_
+
+#include <ceres/rotation.h>
+#include <Eigen/Core>
+
+namespace gopt {
+namespace internal {
+
+// Rotates the relative translation from the frame of a view, given by its
+// angle-axis orientation, into the global frame.
+static inline Eigen::Vector3d GetRotatedTranslation(
+    const Eigen::Vector3d& rotation_angle_axis,
+    const Eigen::Vector3d& translation) {
+  Eigen::Matrix3d rotation;
+  ceres::AngleAxisToRotationMatrix(
+      rotation_angle_axis.data(),
+      ceres::ColumnMajorAdapter3x3(rotation.data()));
+  return rotation.transpose() * translation;
+}
+
+}  // namespace internal
+}  // namespace gopt
+
+#endif  // TRANSLATION_AVERAGING_INTERNAL_TRANSLATION_AVERAGING_UTIL_H_
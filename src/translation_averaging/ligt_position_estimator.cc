@@ -0,0 +1,187 @@
+#include "translation_averaging/ligt_position_estimator.h"
+
+#include <algorithm>
+
+#include <Eigen/SparseCore>
+#include <glog/logging.h>
+
+#include "math/sparse_cholesky_llt.h"
+#include "translation_averaging/internal/translation_averaging_util.h"
+#include "util/map_util.h"
+#include "util/profiler.h"
+#include "util/timer.h"
+#include "util/view_pair_util.h"
+
+namespace gopt {
+namespace {
+
+// Number of upper triangular entries of a 3x3 diagonal block.
+const int kNumUpperBlockEntries = 6;
+
+}  // namespace
+
+LiGTPositionEstimator::LiGTPositionEstimator(
+    const LiGTPositionEstimator::Options& options)
+    : options_(options) {
+  CHECK_GT(options_.baseline_prior_weight, 0.0);
+  CHECK_LE(options_.baseline_prior_weight, 1.0);
+}
+
+bool LiGTPositionEstimator::EstimatePositions(
+    const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+    const std::unordered_map<image_t, Eigen::Vector3d>& orientations,
+    std::unordered_map<image_t, Eigen::Vector3d>* positions) {
+  GOPT_PROFILE_SCOPE("LiGT");
+  CHECK_NOTNULL(positions)->clear();
+
+  InitializeIndexMapping(view_pairs, orientations);
+  const int num_views = index_to_view_id_.size();
+  if (num_views < 2) {
+    LOG(ERROR) << "At least two views with known orientations are required.";
+    return false;
+  }
+
+  Timer timer;
+  timer.Start();
+
+  Eigen::SparseMatrix<double> lhs;
+  Eigen::VectorXd rhs;
+  SetupLinearSystem(&lhs, &rhs);
+
+  SparseCholeskyLLt linear_solver;
+  linear_solver.Compute(lhs);
+  if (linear_solver.Info() != Eigen::Success) {
+    LOG(ERROR) << "Failed to factorize the least squares system. Is the view "
+                  "graph connected?";
+    return false;
+  }
+
+  const Eigen::VectorXd solution = linear_solver.Solve(rhs);
+  if (linear_solver.Info() != Eigen::Success) {
+    LOG(ERROR) << "Failed to solve the least squares system.";
+    return false;
+  }
+  timer.Pause();
+
+  LOG(INFO) << "Total time [LiGT]: "
+            << timer.ElapsedMicroSeconds() * 1e-3 << " ms.";
+
+  (*positions)[index_to_view_id_[0]] = Eigen::Vector3d::Zero();
+  for (int i = 1; i < num_views; i++) {
+    (*positions)[index_to_view_id_[i]] = solution.segment<3>(3 * (i - 1));
+  }
+
+  return true;
+}
+
+void LiGTPositionEstimator::InitializeIndexMapping(
+    const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+    const std::unordered_map<image_t, Eigen::Vector3d>& orientations) {
+  edges_.clear();
+  directions_.clear();
+
+  std::vector<ImagePair> valid_pairs;
+  IndexViewPairs(view_pairs, orientations, &valid_pairs, &index_to_view_id_,
+                 &view_id_to_index_);
+
+  edges_.reserve(valid_pairs.size());
+  directions_.reserve(valid_pairs.size());
+  for (const ImagePair& view_id_pair : valid_pairs) {
+    const TwoViewGeometry& two_view_geometry =
+        FindOrDieNoPrint(view_pairs, view_id_pair);
+    // Rotate the relative translation so that it is aligned to the global
+    // orientation frame.
+    const Eigen::Vector3d direction = internal::GetRotatedTranslation(
+        FindOrDie(orientations, view_id_pair.first),
+        two_view_geometry.translation_2);
+    if (direction.squaredNorm() == 0.0) {
+      continue;
+    }
+
+    edges_.emplace_back(FindOrDie(view_id_to_index_, view_id_pair.first),
+                        FindOrDie(view_id_to_index_, view_id_pair.second));
+    directions_.push_back(direction.normalized());
+  }
+
+  VLOG(2) << edges_.size() << " camera to camera constraints were added "
+                              "to the position estimation problem.";
+}
+
+void LiGTPositionEstimator::SetupLinearSystem(Eigen::SparseMatrix<double>* lhs,
+                                              Eigen::VectorXd* rhs) {
+  GOPT_PROFILE_SCOPE("SetupLinearSystem");
+  const int num_views = index_to_view_id_.size();
+  const int num_edges = edges_.size();
+  const double lambda = options_.baseline_prior_weight;
+
+  // The number of triplets of each edge only depends on whether one of its
+  // views is the constant view, so the offsets of all edges are known upfront.
+  std::vector<int> triplet_offsets(num_edges + 1, 0);
+  for (int e = 0; e < num_edges; e++) {
+    const bool is_variable1 = edges_[e].first != 0;
+    const bool is_variable2 = edges_[e].second != 0;
+    int num_triplets = 0;
+    if (is_variable1) {
+      num_triplets += kNumUpperBlockEntries;
+    }
+    if (is_variable2) {
+      num_triplets += kNumUpperBlockEntries;
+    }
+    if (is_variable1 && is_variable2) {
+      num_triplets += 9;
+    }
+    triplet_offsets[e + 1] = triplet_offsets[e] + num_triplets;
+  }
+
+  std::vector<Eigen::Triplet<double>> triplets(triplet_offsets[num_edges]);
+
+#pragma omp parallel for num_threads(options_.num_threads)
+  for (int e = 0; e < num_edges; e++) {
+    const Eigen::Vector3d& direction = directions_[e];
+    const Eigen::Matrix3d block =
+        Eigen::Matrix3d::Identity() -
+        (1.0 - lambda) * direction * direction.transpose();
+
+    // The reduced index of view k is 3 * (k - 1), the constant view is removed.
+    const int index1 = 3 * (edges_[e].first - 1);
+    const int index2 = 3 * (edges_[e].second - 1);
+    Eigen::Triplet<double>* triplet = triplets.data() + triplet_offsets[e];
+    for (const int index : {index1, index2}) {
+      if (index == 3 * kConstantViewIndex) {
+        continue;
+      }
+      for (int c = 0; c < 3; c++) {
+        for (int r = 0; r <= c; r++) {
+          *triplet++ =
+              Eigen::Triplet<double>(index + r, index + c, block(r, c));
+        }
+      }
+    }
+
+    if (index1 != 3 * kConstantViewIndex && index2 != 3 * kConstantViewIndex) {
+      const int row = std::min(index1, index2);
+      const int col = std::max(index1, index2);
+      for (int c = 0; c < 3; c++) {
+        for (int r = 0; r < 3; r++) {
+          *triplet++ = Eigen::Triplet<double>(row + r, col + c, -block(r, c));
+        }
+      }
+    }
+  }
+
+  lhs->resize(3 * (num_views - 1), 3 * (num_views - 1));
+  lhs->setFromTriplets(triplets.begin(), triplets.end());
+
+  // The baseline prior pulls v_ij^t * (c_j - c_i) towards one.
+  rhs->setZero(3 * (num_views - 1));
+  for (int e = 0; e < num_edges; e++) {
+    if (edges_[e].first != 0) {
+      rhs->segment<3>(3 * (edges_[e].first - 1)) -= lambda * directions_[e];
+    }
+    if (edges_[e].second != 0) {
+      rhs->segment<3>(3 * (edges_[e].second - 1)) += lambda * directions_[e];
+    }
+  }
+}
+
+}  // namespace gopt
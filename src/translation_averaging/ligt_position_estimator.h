@@ -0,0 +1,83 @@
+#ifndef TRANSLATION_AVERAGING_LIGT_POSITION_ESTIMATOR_H_
+#define TRANSLATION_AVERAGING_LIGT_POSITION_ESTIMATOR_H_
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+
+#include "translation_averaging/position_estimator.h"
+
+namespace gopt {
+
+// Linear global translation (LiGT-style) position estimator. In the spirit of
+//   Q. Cai, L. Zhang, Y. Wu, W. Yu and D. Hu. A Pose-only Solution to Visual
+//   Reconstruction and Navigation. TPAMI 2021.
+// the positions are the solution of a single sparse linear least squares
+// problem. Since the view graph only carries the relative translation
+// directions, the pose-only constraints are formed per view pair: with v_ij
+// the direction rotated into the global frame, the residuals
+//
+//   [v_ij]_x * (c_j - c_i)   and   sqrt(lambda) * (v_ij^t * (c_j - c_i) - 1)
+//
+// penalize the displacement of c_j - c_i orthogonal to v_ij, and weakly pull
+// the baselines towards one to fix the scale of the solution. The normal
+// equations form a 3(N-1) x 3(N-1) block Laplacian with the blocks
+// I - (1 - lambda) * v_ij * v_ij^t, whose entries are assembled in parallel.
+//
+// The estimator is fast but not robust to outliers. It is meant for throughput
+// runs and as the initialization of LUD or BATA.
+class LiGTPositionEstimator : public PositionEstimator {
+ public:
+  struct Options {
+    int num_threads = 8;
+
+    // Weight lambda of the baseline prior. Smaller values trust the directions
+    // more, but the linear system gets worse conditioned.
+    double baseline_prior_weight = 1e-4;
+  };
+
+  LiGTPositionEstimator(const LiGTPositionEstimator::Options& options);
+
+  // Returns true if the optimization was a success, false if there was a
+  // failure.
+  bool EstimatePositions(
+      const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+      const std::unordered_map<image_t, Eigen::Vector3d>& orientation,
+      std::unordered_map<image_t, Eigen::Vector3d>* positions) override;
+
+  // We keep one of the positions as constant to remove the translation
+  // ambiguity of the linear system.
+  static const int kConstantViewIndex = -1;
+
+ private:
+  // Collects the view pairs with known orientations, assigns each view an
+  // index in ascending order of view id and rotates the relative translations
+  // into the global frame.
+  void InitializeIndexMapping(
+      const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+      const std::unordered_map<image_t, Eigen::Vector3d>& orientations);
+
+  // Assembles the upper triangle of the normal equations and the right hand
+  // side. Each edge writes its own range of triplets, so the edges are
+  // processed in parallel.
+  void SetupLinearSystem(Eigen::SparseMatrix<double>* lhs,
+                         Eigen::VectorXd* rhs);
+
+  const LiGTPositionEstimator::Options options_;
+
+  std::vector<image_t> index_to_view_id_;
+  std::unordered_map<image_t, int> view_id_to_index_;
+
+  // Endpoints (view indices) and global frame directions of each edge.
+  std::vector<std::pair<int, int>> edges_;
+  std::vector<Eigen::Vector3d> directions_;
+
+  DISALLOW_COPY_AND_ASSIGN(LiGTPositionEstimator);
+};
+
+}  // namespace gopt
+
+#endif  // TRANSLATION_AVERAGING_LIGT_POSITION_ESTIMATOR_H_
@@ -0,0 +1,58 @@
+#include "translation_averaging/ligt_position_estimator.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "translation_averaging/test_util.h"
+#include "util/map_util.h"
+
+namespace gopt {
+
+class LiGTPositionEstimatorTest : public TranslationAveragingTest {
+ public:
+  void TestLiGTPositionEstimator(const int num_views,
+                                 const int num_view_pairs,
+                                 const double translation_noise_degrees,
+                                 const double position_tolerance) {
+    // At least a cycle graph.
+    ASSERT_LE(num_views + 1, num_view_pairs);
+
+    CreateGTCameras(num_views);
+    CreateRelativeTranslations(num_view_pairs, translation_noise_degrees);
+
+    LiGTPositionEstimator::Options options;
+    LiGTPositionEstimator position_estimator(options);
+
+    std::unordered_map<image_t, Eigen::Vector3d> estimated_positions;
+    EXPECT_TRUE(position_estimator.EstimatePositions(
+        view_pairs_, orientations_, &estimated_positions));
+    EXPECT_EQ(estimated_positions.size(), positions_.size());
+
+    // Positions are recovered up to a translation and a scale.
+    AlignPositions(&estimated_positions);
+    for (const auto& position : positions_) {
+      const Eigen::Vector3d& estimated_position =
+          FindOrDie(estimated_positions, position.first);
+      EXPECT_LT((estimated_position - position.second).norm(),
+                position_tolerance);
+    }
+  }
+};
+
+TEST_F(LiGTPositionEstimatorTest, SmallTestNoNoise) {
+  TestLiGTPositionEstimator(20, 60, 0.0, 1e-2);
+}
+
+TEST_F(LiGTPositionEstimatorTest, SmallTestWithNoise) {
+  TestLiGTPositionEstimator(20, 80, 1.0, 0.5);
+}
+
+TEST_F(LiGTPositionEstimatorTest, MediumTestWithNoise) {
+  TestLiGTPositionEstimator(100, 600, 1.0, 0.5);
+}
+
+}  // namespace gopt
@@ -1,6 +1,8 @@
 #include "translation_averaging/lud_position_estimator.h"
 
-#include <unordered_set>
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 #include <ceres/rotation.h>
 #include <Eigen/SparseCore>
@@ -8,19 +10,15 @@
 
 #include "solver/constrained_l1_solver.h"
 #include "util/map_util.h"
+#include "util/profiler.h"
+#include "util/view_pair_util.h"
 
 namespace gopt {
 namespace {
 
-Eigen::Vector3d GetRotatedTranslation(
-    const Eigen::Vector3d& rotation_angle_axis,
-    const Eigen::Vector3d& translation) {
-  Eigen::Matrix3d rotation;
-  ceres::AngleAxisToRotationMatrix(
-      rotation_angle_axis.data(),
-      ceres::ColumnMajorAdapter3x3(rotation.data()));
-  return rotation.transpose() * translation;
-}
+// Residuals below this threshold do not increase the weight of a constraint any
+// further, which keeps the reweighted linear system well conditioned.
+const double kMinReweightingResidual = 1e-3;
 
 }  // namespace
 
@@ -35,6 +33,7 @@ bool LUDPositionEstimator::EstimatePositions(
     const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
     const std::unordered_map<image_t, Eigen::Vector3d>& orientations,
     std::unordered_map<image_t, Eigen::Vector3d>* positions) {
+  GOPT_PROFILE_SCOPE("LUD");
   CHECK_NOTNULL(positions)->clear();
 
   InitializeIndexMapping(view_pairs, orientations);
@@ -61,9 +60,52 @@ bool LUDPositionEstimator::EstimatePositions(
   // Solve for camera positions by solving a constrained L1 problem to enforce
   // all relative translations scales > 1.
   ConstrainedL1Solver::Options l1_options;
+  l1_options.max_num_iterations = options_.max_num_iterations;
+  // The scales only appear in the rows of their own view pair, so they are
+  // eliminated and only the 3(N-1) positions are factorized. Each eliminated
+  // scale couples the six coordinates of its pair in the reduced system.
+  l1_options.num_eliminated_columns = num_view_pairs;
   ConstrainedL1Solver solver(
       l1_options, constraint_matrix_, b, geq_mat, geq_vec);
-  solver.Solve(&solution);
+  if (InitializeSolution(&solution)) {
+    solver.SetInitialSolution(solution);
+  }
+
+  // Reweighted L1 minimization: the first solve minimizes sum_j ||r_j||_1, the
+  // L1 relaxation of the unsquared deviations sum_j ||r_j||_2 of LUD. Each
+  // later solve weights the camera to camera constraint j by the inverse of
+  // max(||r_j||_2, kMinReweightingResidual) at the previous solution, so the
+  // weighted objective approaches sum_j ||r_j||_1 / ||r_j||_2. That is not the
+  // LUD objective. It roughly counts the violated constraints, like the
+  // reweighted L1 minimization of Candes, Wakin and Boyd, which suppresses
+  // outliers further. The solver keeps its symbolic factorization and warm
+  // starts from the previous solution.
+  const int num_constraints = constraint_matrix_.rows() / 3;
+  Eigen::VectorXd weights(constraint_matrix_.rows());
+  Eigen::VectorXd residuals, last_solution;
+  for (int i = 0; i < options_.max_num_reweighted_iterations; i++) {
+    last_solution = solution;
+    solver.Solve(&solution);
+
+    const double solution_change =
+        (solution - last_solution).norm() / std::max(solution.norm(), 1e-12);
+    VLOG(1) << "Reweighted iteration " << i
+            << ", relative solution change: " << solution_change;
+    if (i > 0 && solution_change < options_.convergence_criterion) {
+      break;
+    }
+    if (i + 1 == options_.max_num_reweighted_iterations) {
+      break;
+    }
+
+    residuals.noalias() = constraint_matrix_ * solution;
+    for (int j = 0; j < num_constraints; j++) {
+      const double residual = residuals.segment<3>(3 * j).norm();
+      weights.segment<3>(3 * j).setConstant(
+          1.0 / std::max(residual, kMinReweightingResidual));
+    }
+    solver.SetL1Weights(weights);
+  }
 
   // Set the estimated positions.
   for (const auto& view_id_index : view_id_to_index_) {
@@ -79,95 +121,194 @@ bool LUDPositionEstimator::EstimatePositions(
   return true;
 }
 
+bool LUDPositionEstimator::InitializeSolution(Eigen::VectorXd* solution) const {
+  if (initial_positions_.empty() || view_id_pair_to_index_.empty()) {
+    return false;
+  }
+
+  const Eigen::Vector3d* origin = nullptr;
+  for (const auto& view_id_index : view_id_to_index_) {
+    const Eigen::Vector3d* position =
+        FindOrNull(initial_positions_, view_id_index.first);
+    if (position == nullptr) {
+      LOG(WARNING) << "The initial positions do not cover view "
+                   << view_id_index.first << ", they are ignored.";
+      return false;
+    }
+    if (view_id_index.second == kConstantViewIndex) {
+      origin = position;
+    }
+  }
+  CHECK_NOTNULL(origin);
+
+  solution->setZero(constraint_matrix_.cols());
+  for (const auto& view_id_index : view_id_to_index_) {
+    if (view_id_index.second != kConstantViewIndex) {
+      solution->segment<3>(view_id_index.second) =
+          FindOrDie(initial_positions_, view_id_index.first) - *origin;
+    }
+  }
+
+  // With zero scales, the residuals are the position differences. The scale
+  // columns hold the negated directions, so their dot products with the
+  // residuals are the baselines of the view pairs along the directions.
+  const Eigen::VectorXd position_differences = constraint_matrix_ * *solution;
+  const int num_positions = constraint_matrix_.cols() -
+                            static_cast<int>(view_id_pair_to_index_.size());
+  std::vector<double> baselines;
+  baselines.reserve(view_id_pair_to_index_.size());
+  for (int i = num_positions; i < constraint_matrix_.cols(); i++) {
+    double baseline = 0.0;
+    for (Eigen::SparseMatrix<double>::InnerIterator it(constraint_matrix_, i);
+         it; ++it) {
+      baseline -= it.value() * position_differences[it.row()];
+    }
+    baselines.push_back(baseline);
+  }
+
+  std::vector<double> sorted_baselines = baselines;
+  std::nth_element(sorted_baselines.begin(),
+                   sorted_baselines.begin() + sorted_baselines.size() / 2,
+                   sorted_baselines.end());
+  const double median_baseline = sorted_baselines[sorted_baselines.size() / 2];
+  if (median_baseline <= 0.0) {
+    LOG(WARNING) << "The initial positions are inconsistent with the relative "
+                    "translations, they are ignored.";
+    return false;
+  }
+
+  solution->head(num_positions) /= median_baseline;
+  for (size_t i = 0; i < baselines.size(); i++) {
+    (*solution)[num_positions + i] =
+        std::max(baselines[i] / median_baseline, 1.0);
+  }
+  return true;
+}
+
 void LUDPositionEstimator::InitializeIndexMapping(
     const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
     const std::unordered_map<image_t, Eigen::Vector3d>& orientations) {
-  std::unordered_set<image_t> views;
-  for (const auto& view_pair : view_pairs) {
-    if (ContainsKey(orientations, view_pair.first.first) &&
-        ContainsKey(orientations, view_pair.first.second)) {
-      views.insert(view_pair.first.first);
-      views.insert(view_pair.first.second);
-    }
-  }
+  view_id_to_index_.clear();
+  view_id_pair_to_index_.clear();
+
+  IndexViewPairs(view_pairs, orientations, &index_to_view_id_pair_,
+                 &index_to_view_id_, nullptr);
 
-  // Create a mapping from the view id to the index of the linear system.
-  int index = kConstantViewIndex;
-  view_id_to_index_.reserve(views.size());
-  for (const image_t view_id : views) {
-    view_id_to_index_[view_id] = index;
-    index += 3;
+  // Create a mapping from the view id to the index of the linear system. The
+  // first view is the constant one.
+  view_id_to_index_.reserve(index_to_view_id_.size());
+  for (size_t i = 0; i < index_to_view_id_.size(); i++) {
+    view_id_to_index_[index_to_view_id_[i]] = kConstantViewIndex + 3 * i;
   }
 
   // Create a mapping from the view id pair to the index of the linear system.
-  view_id_pair_to_index_.reserve(view_pairs.size());
-  for (const auto& view_pair : view_pairs) {
-    if (ContainsKey(view_id_to_index_, view_pair.first.first) &&
-        ContainsKey(view_id_to_index_, view_pair.first.second)) {
-      view_id_pair_to_index_[view_pair.first] = index;
-      ++index;
-    }
+  const int num_positions = 3 * (index_to_view_id_.size() - 1);
+  view_id_pair_to_index_.reserve(index_to_view_id_pair_.size());
+  for (size_t i = 0; i < index_to_view_id_pair_.size(); i++) {
+    view_id_pair_to_index_[index_to_view_id_pair_[i]] = num_positions + i;
   }
 }
 
+// The constraint matrix is assembled directly in compressed column storage.
+// The 3 rows of view pair p are 3p, 3p + 1 and 3p + 2, each row holds
+//
+//   position2 - position1 - scale_1_2 * translation_direction
+//
+// for one coordinate. The column of a position coordinate thus has one entry
+// per incident view pair and each scale column has 3 entries, so the column
+// offsets are the prefix sums of the view degrees. Each column is written by
+// exactly one task.
 void LUDPositionEstimator::SetupConstraintMatrix(
     const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
     const std::unordered_map<image_t, Eigen::Vector3d>& orientations) {
-  constraint_matrix_.resize(
-      3 * view_id_pair_to_index_.size(),
-      3 * (view_id_to_index_.size() - 1) + view_pairs.size());
-
-  // Add the camera to camera constraints.
-  std::vector<Eigen::Triplet<double>> triplet_list;
-  triplet_list.reserve(9 * view_pairs.size());
-  int row = 0;
-  for (const auto& view_pair : view_pairs) {
-    const ImagePair view_id_pair = view_pair.first;
-    if (!ContainsKey(view_id_to_index_, view_id_pair.first) ||
-        !ContainsKey(view_id_to_index_, view_id_pair.second)) {
-      continue;
-    }
+  GOPT_PROFILE_SCOPE("SetupConstraintMatrix");
+  const int num_views = index_to_view_id_.size();
+  const int num_view_pairs = index_to_view_id_pair_.size();
+  const int num_positions = 3 * (num_views - 1);
 
-    const int view1_index = FindOrDie(view_id_to_index_, view_id_pair.first);
-    const int view2_index = FindOrDie(view_id_to_index_, view_id_pair.second);
-    const int scale_index =
-        FindOrDieNoPrint(view_id_pair_to_index_, view_id_pair);
+  // Precompute the rotation of each view once, instead of once per pair.
+  std::vector<Eigen::Matrix3d> rotations(num_views);
+#pragma omp parallel for num_threads(options_.num_threads)
+  for (int i = 0; i < num_views; i++) {
+    ceres::AngleAxisToRotationMatrix(
+        FindOrDie(orientations, index_to_view_id_[i]).data(),
+        ceres::ColumnMajorAdapter3x3(rotations[i].data()));
+  }
 
-    // Rotate the relative translation so that it is aligned to the global
-    // orientation frame.
-    const Eigen::Vector3d translation_direction =
-        GetRotatedTranslation(FindOrDie(orientations, view_id_pair.first),
-                              view_pair.second.translation_2);
-
-    // Add the constraint for view 1 in the minimization:
-    //   position2 - position1 - scale_1_2 * translation_direction.
-    if (view1_index != kConstantViewIndex) {
-      triplet_list.emplace_back(row + 0, view1_index + 0, -1.0);
-      triplet_list.emplace_back(row + 1, view1_index + 1, -1.0);
-      triplet_list.emplace_back(row + 2, view1_index + 2, -1.0);
-    }
+  // The views of each pair and, in ascending order of pairs, the incident
+  // pairs of each view.
+  const auto view_index = [&](const image_t view_id) {
+    return (FindOrDie(view_id_to_index_, view_id) - kConstantViewIndex) / 3;
+  };
+  std::vector<std::pair<int, int>> pair_views(num_view_pairs);
+  std::vector<int> degree_offsets(num_views + 1, 0);
+  for (int p = 0; p < num_view_pairs; p++) {
+    pair_views[p].first = view_index(index_to_view_id_pair_[p].first);
+    pair_views[p].second = view_index(index_to_view_id_pair_[p].second);
+    ++degree_offsets[pair_views[p].first + 1];
+    ++degree_offsets[pair_views[p].second + 1];
+  }
+  for (int i = 0; i < num_views; i++) {
+    degree_offsets[i + 1] += degree_offsets[i];
+  }
+  std::vector<int> adjacent_pairs(degree_offsets[num_views]);
+  std::vector<int> fill_offsets(degree_offsets.begin(),
+                                degree_offsets.end() - 1);
+  for (int p = 0; p < num_view_pairs; p++) {
+    adjacent_pairs[fill_offsets[pair_views[p].first]++] = p;
+    adjacent_pairs[fill_offsets[pair_views[p].second]++] = p;
+  }
 
-    // Add the constraint for view 2 in the minimization:
-    //   position2 - position1 - scale_1_2 * translation_direction.
-    if (view2_index != kConstantViewIndex) {
-      triplet_list.emplace_back(row + 0, view2_index + 0, 1.0);
-      triplet_list.emplace_back(row + 1, view2_index + 1, 1.0);
-      triplet_list.emplace_back(row + 2, view2_index + 2, 1.0);
+  // Column offsets. The constant view (index 0) has no columns.
+  const int num_cols = num_positions + num_view_pairs;
+  const int num_position_entries =
+      3 * (degree_offsets[num_views] - degree_offsets[1]);
+  constraint_matrix_.resize(3 * num_view_pairs, num_cols);
+  constraint_matrix_.resizeNonZeros(num_position_entries + 3 * num_view_pairs);
+  int* outer_index = constraint_matrix_.outerIndexPtr();
+  int* inner_index = constraint_matrix_.innerIndexPtr();
+  double* values = constraint_matrix_.valuePtr();
+  for (int i = 1; i < num_views; i++) {
+    const int degree = degree_offsets[i + 1] - degree_offsets[i];
+    const int view_offset = 3 * (degree_offsets[i] - degree_offsets[1]);
+    for (int c = 0; c < 3; c++) {
+      outer_index[3 * (i - 1) + c] = view_offset + c * degree;
     }
+  }
+  for (int p = 0; p <= num_view_pairs; p++) {
+    outer_index[num_positions + p] = num_position_entries + 3 * p;
+  }
 
-    // Add the constraint for scale in the minimization:
-    //   position2 - position1 - scale_1_2 * translation_direction.
-    triplet_list.emplace_back(row + 0, scale_index, -translation_direction[0]);
-    triplet_list.emplace_back(row + 1, scale_index, -translation_direction[1]);
-    triplet_list.emplace_back(row + 2, scale_index, -translation_direction[2]);
-
-    row += 3;
+  // Position columns, one task per view.
+#pragma omp parallel for num_threads(options_.num_threads)
+  for (int i = 1; i < num_views; i++) {
+    for (int c = 0; c < 3; c++) {
+      int slot = outer_index[3 * (i - 1) + c];
+      for (int a = degree_offsets[i]; a < degree_offsets[i + 1]; a++) {
+        const int p = adjacent_pairs[a];
+        inner_index[slot] = 3 * p + c;
+        values[slot] = (pair_views[p].first == i) ? -1.0 : 1.0;
+        ++slot;
+      }
+    }
   }
 
-  constraint_matrix_.setFromTriplets(triplet_list.begin(), triplet_list.end());
+  // Scale columns, one task per view pair. The relative translation is
+  // rotated so that it is aligned to the global orientation frame.
+#pragma omp parallel for num_threads(options_.num_threads)
+  for (int p = 0; p < num_view_pairs; p++) {
+    const Eigen::Vector3d translation_direction =
+        rotations[pair_views[p].first].transpose() *
+        FindOrDieNoPrint(view_pairs, index_to_view_id_pair_[p]).translation_2;
+    const int slot = outer_index[num_positions + p];
+    for (int c = 0; c < 3; c++) {
+      inner_index[slot + c] = 3 * p + c;
+      values[slot + c] = -translation_direction[c];
+    }
+  }
 
-  VLOG(2) << view_pairs.size() << " camera to camera constraints were added "
-                                  "to the position estimation problem.";
+  VLOG(2) << num_view_pairs << " camera to camera constraints were added "
+                               "to the position estimation problem.";
 }
 
 }  // namespace gopt
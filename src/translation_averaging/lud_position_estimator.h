@@ -1,20 +1,34 @@
 #ifndef TRANSLATION_AVERAGING_LUD_POSITION_ESTIMATOR_H_
 #define TRANSLATION_AVERAGING_LUD_POSITION_ESTIMATOR_H_
 
+#include <unordered_map>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+
 #include "translation_averaging/position_estimator.h"
 
 namespace gopt {
-// Least Unsquared Deviation (LUD) position estimator.
+// Least Unsquared Deviation (LUD) position estimator. The positions are
+// estimated by a sequence of reweighted constrained L1 minimizations, which
+// share the symbolic factorization of the linear system. The first of them
+// relaxes the LUD objective to the L1 norm, and the reweighting by the inverse
+// residual norms then trades it for the robustness to outliers of reweighted
+// L1 minimization.
 class LUDPositionEstimator : public PositionEstimator {
  public:
   struct Options {
+    int num_threads = 8;
+
     // Options for ADMM QP solver.
     int max_num_iterations = 400;
 
     // Maximum number of reweighted iterations.
     int max_num_reweighted_iterations = 10;
 
-    // A measurement for convergence criterion.
+    // The reweighting terminates when the relative change of the solution
+    // falls below this threshold.
     double convergence_criterion = 1e-4;
   };
 
@@ -28,17 +42,30 @@ class LUDPositionEstimator : public PositionEstimator {
       std::unordered_map<image_t, Eigen::Vector3d>* positions);
 
  private:
+  // Assigns the views and view pairs with known orientations their columns in
+  // ascending order of ids.
   void InitializeIndexMapping(
       const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
       const std::unordered_map<image_t, Eigen::Vector3d>& orientations);
 
-  // Creates camera to camera constraints from relative translations.
+  // Converts the initial positions, if they are set and cover all views, into
+  // a solution of the constrained L1 problem. The positions are scaled such
+  // that the median scale of the view pairs is one.
+  bool InitializeSolution(Eigen::VectorXd* solution) const;
+
+  // Creates camera to camera constraints from relative translations. The
+  // columns of the constraint matrix are filled in parallel.
   void SetupConstraintMatrix(
       const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
       const std::unordered_map<image_t, Eigen::Vector3d>& orientations);
 
   const LUDPositionEstimator::Options options_;
 
+  // Views and view pairs in ascending order of their ids.
+  std::vector<image_t> index_to_view_id_;
+  std::vector<ImagePair> index_to_view_id_pair_;
+
+  // The columns of the positions and the scales in the linear system.
   std::unordered_map<ImagePair, int> view_id_pair_to_index_;
   std::unordered_map<image_t, int> view_id_to_index_;
   static const int kConstantViewIndex = -3;
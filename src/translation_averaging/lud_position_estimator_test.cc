@@ -0,0 +1,102 @@
+#include "translation_averaging/lud_position_estimator.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "translation_averaging/ligt_position_estimator.h"
+#include "translation_averaging/test_util.h"
+#include "util/map_util.h"
+
+namespace gopt {
+
+class LUDPositionEstimatorTest : public TranslationAveragingTest {
+ public:
+  void TestLUDPositionEstimator(const int num_views,
+                                 const int num_view_pairs,
+                                 const double translation_noise_degrees,
+                                 const int num_outliers,
+                                 const double position_tolerance,
+                                 const bool linear_initialization = false) {
+    // At least a cycle graph.
+    ASSERT_LE(num_views + 1, num_view_pairs);
+
+    CreateGTCameras(num_views);
+    CreateRelativeTranslations(num_view_pairs, translation_noise_degrees,
+                               num_outliers);
+
+    LUDPositionEstimator::Options options;
+    options.max_num_iterations = 1000;
+    LUDPositionEstimator position_estimator(options);
+    if (linear_initialization) {
+      LiGTPositionEstimator::Options ligt_options;
+      LiGTPositionEstimator ligt_position_estimator(ligt_options);
+      std::unordered_map<image_t, Eigen::Vector3d> initial_positions;
+      EXPECT_TRUE(ligt_position_estimator.EstimatePositions(
+          view_pairs_, orientations_, &initial_positions));
+      position_estimator.SetInitialPositions(initial_positions);
+    }
+
+    std::unordered_map<image_t, Eigen::Vector3d> estimated_positions;
+    EXPECT_TRUE(position_estimator.EstimatePositions(
+        view_pairs_, orientations_, &estimated_positions));
+    EXPECT_EQ(estimated_positions.size(), positions_.size());
+
+    // Positions are recovered up to a translation and a scale.
+    AlignPositions(&estimated_positions);
+    for (const auto& position : positions_) {
+      const Eigen::Vector3d& estimated_position =
+          FindOrDie(estimated_positions, position.first);
+      EXPECT_LT((estimated_position - position.second).norm(),
+                position_tolerance);
+    }
+  }
+
+  void TestDeterminism(const int num_views, const int num_view_pairs) {
+    CreateGTCameras(num_views);
+    CreateRelativeTranslations(num_view_pairs, 1.0, 0);
+
+    // The same view pairs with a different iteration order.
+    std::unordered_map<ImagePair, TwoViewGeometry> rehashed_view_pairs(
+        view_pairs_.begin(), view_pairs_.end(), 8 * view_pairs_.size());
+
+    LUDPositionEstimator::Options options;
+    options.max_num_reweighted_iterations = 2;
+    LUDPositionEstimator position_estimator(options);
+    std::unordered_map<image_t, Eigen::Vector3d> positions1, positions2;
+    EXPECT_TRUE(position_estimator.EstimatePositions(
+        view_pairs_, orientations_, &positions1));
+    EXPECT_TRUE(position_estimator.EstimatePositions(
+        rehashed_view_pairs, orientations_, &positions2));
+
+    ASSERT_EQ(positions1.size(), positions2.size());
+    for (const auto& position : positions1) {
+      EXPECT_EQ(position.second, FindOrDie(positions2, position.first));
+    }
+  }
+};
+
+TEST_F(LUDPositionEstimatorTest, SmallTestNoNoise) {
+  TestLUDPositionEstimator(20, 60, 0.0, 0, 1e-4);
+}
+
+TEST_F(LUDPositionEstimatorTest, SmallTestWithNoise) {
+  TestLUDPositionEstimator(20, 80, 1.0, 0, 0.5);
+}
+
+TEST_F(LUDPositionEstimatorTest, MediumTestWithOutliers) {
+  TestLUDPositionEstimator(100, 600, 1.0, 30, 1.0);
+}
+
+TEST_F(LUDPositionEstimatorTest, DeterministicForAnyHashOrder) {
+  TestDeterminism(50, 200);
+}
+
+TEST_F(LUDPositionEstimatorTest, MediumTestWithOutliersLinearInitialization) {
+  TestLUDPositionEstimator(100, 600, 1.0, 30, 1.0, true);
+}
+
+}  // namespace gopt
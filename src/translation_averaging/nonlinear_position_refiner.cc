@@ -0,0 +1,229 @@
+#include "translation_averaging/nonlinear_position_refiner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+#include <ceres/autodiff_cost_function.h>
+#include <ceres/cost_function.h>
+#include <ceres/loss_function.h>
+#include <ceres/problem.h>
+#include <ceres/solver.h>
+#include <Eigen/Geometry>
+#include <glog/logging.h>
+
+#include "translation_averaging/internal/translation_averaging_util.h"
+#include "util/map_util.h"
+#include "util/profiler.h"
+
+namespace gopt {
+namespace {
+
+// Keeps the derivatives finite when two positions coincide or the residual
+// vanishes.
+const double kEpsilon = 1e-12;
+
+// The chordal distance between the measured direction and the direction
+// between the two positions, i.e. the difference of the unit vectors.
+struct ChordalDirectionError {
+  explicit ChordalDirectionError(const Eigen::Vector3d& direction)
+      : direction_(direction) {}
+
+  template <typename T>
+  bool operator()(const T* position1, const T* position2, T* residuals) const {
+    Eigen::Matrix<T, 3, 1> baseline;
+    baseline << position2[0] - position1[0], position2[1] - position1[1],
+        position2[2] - position1[2];
+    const T norm = sqrt(baseline.squaredNorm() + T(kEpsilon));
+
+    residuals[0] = baseline[0] / norm - T(direction_[0]);
+    residuals[1] = baseline[1] / norm - T(direction_[1]);
+    residuals[2] = baseline[2] / norm - T(direction_[2]);
+
+    return true;
+  }
+
+  static ceres::CostFunction* Create(const Eigen::Vector3d& direction) {
+    return new ceres::AutoDiffCostFunction<ChordalDirectionError, 3, 3, 3>(
+        new ChordalDirectionError(direction));
+  }
+
+  Eigen::Vector3d direction_;
+};
+
+// The angle between the measured direction and the direction between the two
+// positions.
+struct AngularDirectionError {
+  explicit AngularDirectionError(const Eigen::Vector3d& direction)
+      : direction_(direction) {}
+
+  template <typename T>
+  bool operator()(const T* position1, const T* position2, T* residuals) const {
+    Eigen::Matrix<T, 3, 1> baseline;
+    baseline << position2[0] - position1[0], position2[1] - position1[1],
+        position2[2] - position1[2];
+    const Eigen::Matrix<T, 3, 1> direction = direction_.cast<T>();
+
+    const T sin_angle =
+        sqrt(baseline.cross(direction).squaredNorm() + T(kEpsilon));
+    residuals[0] = atan2(sin_angle, baseline.dot(direction));
+
+    return true;
+  }
+
+  static ceres::CostFunction* Create(const Eigen::Vector3d& direction) {
+    return new ceres::AutoDiffCostFunction<AngularDirectionError, 1, 3, 3>(
+        new AngularDirectionError(direction));
+  }
+
+  Eigen::Vector3d direction_;
+};
+
+// The relative deviation of the distance between two positions from a fixed
+// baseline, which removes the scale ambiguity of the direction residuals.
+struct BaselineError {
+  explicit BaselineError(const double baseline) : baseline_(baseline) {}
+
+  template <typename T>
+  bool operator()(const T* position1, const T* position2, T* residuals) const {
+    Eigen::Matrix<T, 3, 1> baseline;
+    baseline << position2[0] - position1[0], position2[1] - position1[1],
+        position2[2] - position1[2];
+    residuals[0] =
+        sqrt(baseline.squaredNorm() + T(kEpsilon)) / T(baseline_) - T(1.0);
+    return true;
+  }
+
+  static ceres::CostFunction* Create(const double baseline) {
+    return new ceres::AutoDiffCostFunction<BaselineError, 1, 3, 3>(
+        new BaselineError(baseline));
+  }
+
+  double baseline_;
+};
+
+}  // namespace
+
+NonlinearPositionRefiner::NonlinearPositionRefiner(
+    const NonlinearPositionRefiner::Options& options)
+    : options_(options) {
+  CHECK_GT(options_.num_threads, 0);
+  CHECK_GT(options_.max_num_iterations, 0);
+}
+
+bool NonlinearPositionRefiner::RefinePositions(
+    const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+    const std::unordered_map<image_t, Eigen::Vector3d>& orientations,
+    std::unordered_map<image_t, Eigen::Vector3d>* positions) {
+  GOPT_PROFILE_SCOPE("NonlinearPositionRefinement");
+  CHECK_NOTNULL(positions);
+  summary_ = solver::Summary();
+  summary_.begin_time = std::chrono::high_resolution_clock::now();
+
+  ceres::LossFunction* loss_function = nullptr;
+  if (options_.robust_loss_width > 0.0) {
+    loss_function = new ceres::CauchyLoss(options_.robust_loss_width);
+  }
+
+  // The positions are refined in place, the elements of the hash map are not
+  // moved while the problem is alive.
+  ceres::Problem problem;
+  image_t constant_view_id = std::numeric_limits<image_t>::max();
+  image_t reference_view_id = std::numeric_limits<image_t>::max();
+  for (const auto& view_pair : view_pairs) {
+    const image_t view_id1 = view_pair.first.first;
+    const image_t view_id2 = view_pair.first.second;
+    Eigen::Vector3d* position1 = FindOrNull(*positions, view_id1);
+    Eigen::Vector3d* position2 = FindOrNull(*positions, view_id2);
+    const Eigen::Vector3d* orientation1 = FindOrNull(orientations, view_id1);
+    if (position1 == nullptr || position2 == nullptr ||
+        orientation1 == nullptr || !ContainsKey(orientations, view_id2)) {
+      continue;
+    }
+
+    // Rotate the relative translation so that it is aligned to the global
+    // orientation frame.
+    const Eigen::Vector3d direction = internal::GetRotatedTranslation(
+        *orientation1, view_pair.second.translation_2);
+    if (direction.squaredNorm() == 0.0) {
+      continue;
+    }
+
+    ceres::CostFunction* cost_function =
+        (options_.residual_type == DirectionResidualType::CHORDAL)
+            ? ChordalDirectionError::Create(direction.normalized())
+            : AngularDirectionError::Create(direction.normalized());
+    problem.AddResidualBlock(cost_function, loss_function, position1->data(),
+                             position2->data());
+
+    // The view with the smallest id and its neighbor with the smallest id fix
+    // the gauge.
+    const image_t min_view_id = std::min(view_id1, view_id2);
+    const image_t max_view_id = std::max(view_id1, view_id2);
+    if (min_view_id < constant_view_id) {
+      constant_view_id = min_view_id;
+      reference_view_id = max_view_id;
+    } else if (min_view_id == constant_view_id) {
+      reference_view_id = std::min(reference_view_id, max_view_id);
+    }
+  }
+
+  if (problem.NumResidualBlocks() == 0) {
+    delete loss_function;
+    LOG(WARNING) << "No view pairs to refine the positions with.";
+    return false;
+  }
+
+  // Fix one position to remove the translation ambiguity, and the baseline to
+  // one of its neighbors to remove the scale ambiguity.
+  Eigen::Vector3d& constant_position = FindOrDie(*positions, constant_view_id);
+  Eigen::Vector3d& reference_position =
+      FindOrDie(*positions, reference_view_id);
+  problem.SetParameterBlockConstant(constant_position.data());
+  const double baseline = (reference_position - constant_position).norm();
+  if (baseline > 0.0) {
+    problem.AddResidualBlock(BaselineError::Create(baseline), nullptr,
+                             constant_position.data(),
+                             reference_position.data());
+  } else {
+    LOG(WARNING) << "The positions of the views " << constant_view_id
+                 << " and " << reference_view_id
+                 << " coincide, the scale is not fixed.";
+  }
+
+  // The positions are restored if Ceres fails.
+  const std::unordered_map<image_t, Eigen::Vector3d> initial_positions =
+      *positions;
+
+  ceres::Solver::Options solver_options;
+  solver_options.linear_solver_type = ceres::SPARSE_NORMAL_CHOLESKY;
+  solver_options.num_threads = options_.num_threads;
+  solver_options.max_num_iterations = options_.max_num_iterations;
+
+  ceres::Solver::Summary solver_summary;
+  ceres::Solve(solver_options, &problem, &solver_summary);
+  VLOG(2) << solver_summary.FullReport();
+
+  summary_.total_iterations_num = solver_summary.iterations.size();
+  summary_.end_time = std::chrono::high_resolution_clock::now();
+
+  LOG(INFO) << "Nonlinear position refinement: "
+            << summary_.total_iterations_num << " iterations, cost "
+            << solver_summary.initial_cost << " -> "
+            << solver_summary.final_cost << ", total time "
+            << summary_.TotalTime() << " ms.";
+
+  if (!solver_summary.IsSolutionUsable()) {
+    for (auto& position : *positions) {
+      position.second = FindOrDie(initial_positions, position.first);
+    }
+    return false;
+  }
+  return true;
+}
+
+const solver::Summary& NonlinearPositionRefiner::GetSummary() const {
+  return summary_;
+}
+
+}  // namespace gopt
@@ -0,0 +1,60 @@
+#ifndef TRANSLATION_AVERAGING_NONLINEAR_POSITION_REFINER_H_
+#define TRANSLATION_AVERAGING_NONLINEAR_POSITION_REFINER_H_
+
+#include <unordered_map>
+
+#include <Eigen/Core>
+
+#include "solver/summary.h"
+#include "translation_averaging/position_estimator.h"
+
+namespace gopt {
+
+// Refines the positions estimated by a (convex or linear) position estimator,
+// e.g. LUD or BATA, by minimizing the robustified direction residuals
+//
+//   sum_ij rho(d(v_ij, (c_j - c_i) / || c_j - c_i ||)^2)
+//
+// with Ceres, where v_ij is the relative translation direction rotated into the
+// global frame and d is the chordal or the angular distance. The residuals
+// are invariant to the translation and the scale of the positions, so the
+// position of one view and its distance to one of its neighbors are kept. The
+// estimated positions are the warm start.
+class NonlinearPositionRefiner {
+ public:
+  struct Options {
+    int num_threads = 8;
+
+    int max_num_iterations = 100;
+
+    DirectionResidualType residual_type = DirectionResidualType::CHORDAL;
+
+    // Width of the Cauchy loss on the direction residuals. Non-positive values
+    // disable the robust loss.
+    double robust_loss_width = 0.1;
+  };
+
+  NonlinearPositionRefiner(const NonlinearPositionRefiner::Options& options);
+
+  // Refines the positions in place. Views without a position or an orientation
+  // are not refined. Returns true if Ceres returned a usable solution,
+  // otherwise the positions are left unchanged.
+  bool RefinePositions(
+      const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+      const std::unordered_map<image_t, Eigen::Vector3d>& orientations,
+      std::unordered_map<image_t, Eigen::Vector3d>* positions);
+
+  // The number of Ceres iterations and the time of the last refinement.
+  const solver::Summary& GetSummary() const;
+
+ private:
+  const NonlinearPositionRefiner::Options options_;
+
+  solver::Summary summary_;
+
+  DISALLOW_COPY_AND_ASSIGN(NonlinearPositionRefiner);
+};
+
+}  // namespace gopt
+
+#endif  // TRANSLATION_AVERAGING_NONLINEAR_POSITION_REFINER_H_
@@ -0,0 +1,80 @@
+#include "translation_averaging/nonlinear_position_refiner.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "translation_averaging/test_util.h"
+#include "util/map_util.h"
+
+namespace gopt {
+
+class NonlinearPositionRefinerTest : public TranslationAveragingTest {
+ public:
+  void TestNonlinearPositionRefiner(const int num_views,
+                                    const int num_view_pairs,
+                                    const double translation_noise_degrees,
+                                    const double position_noise,
+                                    const DirectionResidualType residual_type,
+                                    const double position_tolerance) {
+    // At least a cycle graph.
+    ASSERT_LE(num_views + 1, num_view_pairs);
+
+    CreateGTCameras(num_views);
+    CreateRelativeTranslations(num_view_pairs, translation_noise_degrees);
+
+    // Start from perturbed ground truth positions.
+    std::unordered_map<image_t, Eigen::Vector3d> estimated_positions;
+    for (const auto& position : positions_) {
+      estimated_positions[position.first] =
+          position.second + position_noise * rng_.RandVector3d();
+    }
+
+    // The gauge is fixed by the position of the view 0 and its distance to
+    // the view 1, which are neighbors in the cycle graph.
+    const Eigen::Vector3d position0 = FindOrDie(estimated_positions, 0);
+    const double baseline =
+        (FindOrDie(estimated_positions, 1) - position0).norm();
+
+    NonlinearPositionRefiner::Options options;
+    options.residual_type = residual_type;
+    NonlinearPositionRefiner position_refiner(options);
+    EXPECT_TRUE(position_refiner.RefinePositions(view_pairs_, orientations_,
+                                                 &estimated_positions));
+    EXPECT_EQ(FindOrDie(estimated_positions, 0), position0);
+    EXPECT_NEAR(
+        (FindOrDie(estimated_positions, 1) - position0).norm() / baseline, 1.0,
+        1e-3);
+    EXPECT_EQ(estimated_positions.size(), positions_.size());
+    EXPECT_GT(position_refiner.GetSummary().total_iterations_num, 0u);
+
+    // Positions are recovered up to a translation and a scale.
+    AlignPositions(&estimated_positions);
+    for (const auto& position : positions_) {
+      const Eigen::Vector3d& estimated_position =
+          FindOrDie(estimated_positions, position.first);
+      EXPECT_LT((estimated_position - position.second).norm(),
+                position_tolerance);
+    }
+  }
+};
+
+TEST_F(NonlinearPositionRefinerTest, ChordalNoNoise) {
+  TestNonlinearPositionRefiner(20, 60, 0.0, 0.5, DirectionResidualType::CHORDAL,
+                               1e-3);
+}
+
+TEST_F(NonlinearPositionRefinerTest, AngularNoNoise) {
+  TestNonlinearPositionRefiner(20, 60, 0.0, 0.5, DirectionResidualType::ANGULAR,
+                               1e-3);
+}
+
+TEST_F(NonlinearPositionRefinerTest, ChordalWithNoise) {
+  TestNonlinearPositionRefiner(50, 300, 1.0, 0.5,
+                               DirectionResidualType::CHORDAL, 0.5);
+}
+
+}  // namespace gopt
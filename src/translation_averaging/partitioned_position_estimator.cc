@@ -0,0 +1,311 @@
+#include "translation_averaging/partitioned_position_estimator.h"
+
+#include <algorithm>
+
+#include <Eigen/Cholesky>
+#include <glog/logging.h>
+
+#include "graph/graph_partition.h"
+#include "util/map_util.h"
+#include "util/profiler.h"
+#include "util/timer.h"
+#include "util/view_pair_util.h"
+
+namespace gopt {
+namespace {
+
+// Number of unknowns (scale and translation) of the alignment of a cluster.
+const int kNumAlignmentParameters = 4;
+
+// Pivots of the alignment system below this fraction of the largest pivot are
+// treated as zero.
+const double kMinRelativePivot = 1e-10;
+
+int FindRoot(const int cluster, std::vector<int>* parents) {
+  int root = cluster;
+  while ((*parents)[root] != root) {
+    root = (*parents)[root];
+  }
+  return root;
+}
+
+}  // namespace
+
+PartitionedPositionEstimator::PartitionedPositionEstimator(
+    const PartitionedPositionEstimator::Options& options,
+    const PositionEstimatorFactory& estimator_factory)
+    : options_(options), estimator_factory_(estimator_factory) {
+  CHECK_GT(options_.num_threads, 0);
+  CHECK_GT(options_.max_cluster_size, 1);
+  CHECK_GE(options_.overlap_ratio, 0.0);
+  CHECK(estimator_factory_);
+}
+
+bool PartitionedPositionEstimator::EstimatePositions(
+    const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+    const std::unordered_map<image_t, Eigen::Vector3d>& orientations,
+    std::unordered_map<image_t, Eigen::Vector3d>* positions) {
+  GOPT_PROFILE_SCOPE("PartitionedPositionEstimation");
+  CHECK_NOTNULL(positions)->clear();
+
+  edges_.clear();
+  edge_weights_.clear();
+  adjacent_edges_.clear();
+
+  IndexViewPairs(view_pairs, orientations, &view_id_pairs_, &index_to_view_id_,
+                 &view_id_to_index_);
+
+  const int num_views = index_to_view_id_.size();
+  if (num_views <= options_.max_cluster_size) {
+    VLOG(1) << "The view graph is not partitioned, it has only " << num_views
+            << " views.";
+    std::unique_ptr<PositionEstimator> position_estimator =
+        estimator_factory_();
+    position_estimator->SetInitialPositions(initial_positions_);
+    return position_estimator->EstimatePositions(view_pairs, orientations,
+                                                 positions);
+  }
+
+  adjacent_edges_.resize(num_views);
+  edges_.reserve(view_id_pairs_.size());
+  edge_weights_.reserve(view_id_pairs_.size());
+  for (const ImagePair& view_id_pair : view_id_pairs_) {
+    const int e = edges_.size();
+    edges_.emplace_back(FindOrDie(view_id_to_index_, view_id_pair.first),
+                        FindOrDie(view_id_to_index_, view_id_pair.second));
+    edge_weights_.push_back(std::max(
+        FindOrDieNoPrint(view_pairs, view_id_pair).visibility_score, 1));
+    adjacent_edges_[edges_.back().first].push_back(e);
+    adjacent_edges_[edges_.back().second].push_back(e);
+  }
+
+  Timer timer;
+  timer.Start();
+
+  std::vector<std::vector<int>> clusters;
+  PartitionViews(&clusters);
+
+  // The estimators are created upfront, since the factory is not required to
+  // be thread safe, and each one is released once its cluster is solved.
+  std::vector<std::unique_ptr<PositionEstimator>> position_estimators;
+  position_estimators.reserve(clusters.size());
+  for (size_t k = 0; k < clusters.size(); k++) {
+    position_estimators.push_back(estimator_factory_());
+  }
+
+  std::vector<std::unordered_map<image_t, Eigen::Vector3d>> cluster_positions(
+      clusters.size());
+  std::vector<char> cluster_success(clusters.size(), 0);
+
+#pragma omp parallel for num_threads(options_.num_threads) schedule(dynamic)
+  for (size_t k = 0; k < clusters.size(); k++) {
+    const std::vector<int>& cluster = clusters[k];
+
+    // The view pairs with both views in the cluster. Each pair is added by its
+    // first view.
+    std::unordered_map<ImagePair, TwoViewGeometry> cluster_view_pairs;
+    std::unordered_map<image_t, Eigen::Vector3d> initial_positions;
+    for (const int view_index : cluster) {
+      for (const int e : adjacent_edges_[view_index]) {
+        if (edges_[e].first == view_index &&
+            std::binary_search(cluster.begin(), cluster.end(),
+                               edges_[e].second)) {
+          cluster_view_pairs[view_id_pairs_[e]] =
+              FindOrDieNoPrint(view_pairs, view_id_pairs_[e]);
+        }
+      }
+
+      const Eigen::Vector3d* initial_position =
+          FindOrNull(initial_positions_, index_to_view_id_[view_index]);
+      if (initial_position != nullptr) {
+        initial_positions[index_to_view_id_[view_index]] = *initial_position;
+      }
+    }
+
+    position_estimators[k]->SetInitialPositions(initial_positions);
+    cluster_success[k] = position_estimators[k]->EstimatePositions(
+        cluster_view_pairs, orientations, &cluster_positions[k]);
+    position_estimators[k].reset();
+  }
+
+  for (size_t k = 0; k < clusters.size(); k++) {
+    if (!cluster_success[k]) {
+      LOG(ERROR) << "Failed to estimate the positions of cluster " << k
+                 << " with " << clusters[k].size() << " views.";
+      return false;
+    }
+  }
+
+  std::vector<double> scales;
+  std::vector<Eigen::Vector3d> translations;
+  if (!AlignClusters(clusters, cluster_positions, &scales, &translations)) {
+    return false;
+  }
+
+  // Average the aligned positions of the views that are shared by clusters.
+  std::vector<Eigen::Vector3d> position_sums(num_views,
+                                             Eigen::Vector3d::Zero());
+  std::vector<int> num_memberships(num_views, 0);
+  for (size_t k = 0; k < clusters.size(); k++) {
+    for (const int view_index : clusters[k]) {
+      const Eigen::Vector3d* position = FindOrNull(
+          cluster_positions[k], index_to_view_id_[view_index]);
+      if (position == nullptr) {
+        continue;
+      }
+      position_sums[view_index] += scales[k] * *position + translations[k];
+      ++num_memberships[view_index];
+    }
+  }
+
+  for (int i = 0; i < num_views; i++) {
+    if (num_memberships[i] > 0) {
+      (*positions)[index_to_view_id_[i]] =
+          position_sums[i] / num_memberships[i];
+    }
+  }
+  timer.Pause();
+
+  LOG(INFO) << "Total time [Partitioned, " << clusters.size()
+            << " clusters]: " << timer.ElapsedMicroSeconds() * 1e-3 << " ms.";
+
+  return true;
+}
+
+void PartitionedPositionEstimator::PartitionViews(
+    std::vector<std::vector<int>>* clusters) const {
+  GOPT_PROFILE_SCOPE("PartitionViews");
+  const int num_views = index_to_view_id_.size();
+
+  graph::OverlappingPartitionOptions partition_options;
+  partition_options.num_threads = options_.num_threads;
+  partition_options.max_cluster_size = options_.max_cluster_size;
+  partition_options.num_hops = 1;
+  partition_options.max_overlap_ratio = options_.overlap_ratio;
+  graph::OverlappingPartition partition;
+  graph::ComputeOverlappingPartition(num_views, edges_, edge_weights_,
+                                     partition_options, &partition);
+  clusters->swap(partition.clusters);
+
+  if (partition.num_overlap_components > 1) {
+    LOG(WARNING) << "The " << clusters->size() << " clusters form "
+                 << partition.num_overlap_components
+                 << " components by their overlaps.";
+  }
+  VLOG(1) << "Partitioned " << num_views << " views into " << clusters->size()
+          << " clusters with " << partition.overlaps.size() << " overlaps.";
+}
+
+bool PartitionedPositionEstimator::AlignClusters(
+    const std::vector<std::vector<int>>& clusters,
+    const std::vector<std::unordered_map<image_t, Eigen::Vector3d>>&
+        cluster_positions,
+    std::vector<double>* scales,
+    std::vector<Eigen::Vector3d>* translations) const {
+  GOPT_PROFILE_SCOPE("AlignClusters");
+  const int num_views = index_to_view_id_.size();
+  const int num_clusters = clusters.size();
+
+  // The clusters that estimated a position for each view, in ascending order.
+  std::vector<std::vector<int>> view_clusters(num_views);
+  for (int k = 0; k < num_clusters; k++) {
+    for (const int view_index : clusters[k]) {
+      if (ContainsKey(cluster_positions[k], index_to_view_id_[view_index])) {
+        view_clusters[view_index].push_back(k);
+      }
+    }
+  }
+
+  // Each shared view constrains its consecutive clusters. The first cluster
+  // is fixed, so the parameters of cluster k > 0 start at 4 * (k - 1).
+  const int num_parameters = kNumAlignmentParameters * (num_clusters - 1);
+  Eigen::MatrixXd lhs = Eigen::MatrixXd::Zero(num_parameters, num_parameters);
+  Eigen::VectorXd rhs = Eigen::VectorXd::Zero(num_parameters);
+  std::vector<int> parents(num_clusters);
+  for (int k = 0; k < num_clusters; k++) {
+    parents[k] = k;
+  }
+
+  for (int i = 0; i < num_views; i++) {
+    const std::vector<int>& memberships = view_clusters[i];
+    for (size_t m = 1; m < memberships.size(); m++) {
+      // The residual is J_k * x_k - J_l * x_l with J = [c, I].
+      const int cluster_ids[2] = {memberships[m - 1], memberships[m]};
+      Eigen::Matrix<double, 3, kNumAlignmentParameters> jacobians[2];
+      for (int j = 0; j < 2; j++) {
+        jacobians[j].col(0) = FindOrDie(cluster_positions[cluster_ids[j]],
+                                        index_to_view_id_[i]);
+        jacobians[j].rightCols<3>().setIdentity();
+      }
+      jacobians[1] *= -1.0;
+
+      // The constant first cluster contributes J_0 * [1, 0, 0, 0]^t.
+      if (cluster_ids[0] == 0) {
+        const Eigen::Vector3d residual = jacobians[0].col(0);
+        const int offset = kNumAlignmentParameters * (cluster_ids[1] - 1);
+        lhs.block<kNumAlignmentParameters, kNumAlignmentParameters>(
+            offset, offset) += jacobians[1].transpose() * jacobians[1];
+        rhs.segment<kNumAlignmentParameters>(offset) -=
+            jacobians[1].transpose() * residual;
+      } else {
+        for (int a = 0; a < 2; a++) {
+          const int offset_a = kNumAlignmentParameters * (cluster_ids[a] - 1);
+          for (int b = 0; b < 2; b++) {
+            const int offset_b =
+                kNumAlignmentParameters * (cluster_ids[b] - 1);
+            lhs.block<kNumAlignmentParameters, kNumAlignmentParameters>(
+                offset_a, offset_b) +=
+                jacobians[a].transpose() * jacobians[b];
+          }
+        }
+      }
+
+      parents[FindRoot(cluster_ids[1], &parents)] =
+          FindRoot(cluster_ids[0], &parents);
+    }
+  }
+
+  for (int k = 1; k < num_clusters; k++) {
+    if (FindRoot(k, &parents) != FindRoot(0, &parents)) {
+      LOG(ERROR) << "Cluster " << k << " shares no views with the others.";
+      return false;
+    }
+  }
+
+  // A single shared view gives 3 equations for the 4 unknowns of a cluster,
+  // so connected clusters can still leave a scale and a translation free. LDLT
+  // succeeds on such a singular system, so its pivots are checked instead.
+  const Eigen::LDLT<Eigen::MatrixXd> ldlt(lhs);
+  if (ldlt.info() != Eigen::Success) {
+    LOG(ERROR) << "Failed to solve the alignment of the clusters.";
+    return false;
+  }
+  if (num_parameters > 0) {
+    const Eigen::VectorXd pivots = ldlt.vectorD().cwiseAbs();
+    if (pivots.minCoeff() <= kMinRelativePivot * pivots.maxCoeff()) {
+      LOG(ERROR) << "The clusters do not share enough views to be aligned.";
+      return false;
+    }
+  }
+  const Eigen::VectorXd solution = ldlt.solve(rhs);
+  if (!solution.allFinite()) {
+    LOG(ERROR) << "Failed to solve the alignment of the clusters.";
+    return false;
+  }
+
+  scales->assign(num_clusters, 1.0);
+  translations->assign(num_clusters, Eigen::Vector3d::Zero());
+  for (int k = 1; k < num_clusters; k++) {
+    const int offset = kNumAlignmentParameters * (k - 1);
+    (*scales)[k] = solution[offset];
+    (*translations)[k] = solution.segment<3>(offset + 1);
+    if ((*scales)[k] <= 0.0) {
+      LOG(ERROR) << "The scale of cluster " << k << " is not positive.";
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}  // namespace gopt
@@ -0,0 +1,98 @@
+#ifndef TRANSLATION_AVERAGING_PARTITIONED_POSITION_ESTIMATOR_H_
+#define TRANSLATION_AVERAGING_PARTITIONED_POSITION_ESTIMATOR_H_
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "translation_averaging/position_estimator.h"
+
+namespace gopt {
+
+// Divide-and-conquer position estimator for view graphs that are too large to
+// be solved at once. The view graph is partitioned by the normalized cut of
+// Graclus into clusters of at most max_cluster_size views. Each cluster is
+// grown by the outside views it is most strongly connected to, so that the
+// neighboring clusters share some views, and the positions of each cluster are
+// estimated independently (and in parallel) by the inner position estimator.
+//
+// Since the orientations are known, the positions of a cluster k are only
+// defined up to a scale s_k and a translation t_k. These are estimated by a
+// small linear least squares problem over the shared views v:
+//
+//   sum_v sum_(k, l) || (s_k * c_v^k + t_k) - (s_l * c_v^l + t_l) ||^2
+//
+// with s_0 = 1 and t_0 = 0 for the first cluster. The final position of a view
+// is the mean of its aligned cluster positions. Only the linear systems of the
+// clusters which are solved concurrently are alive at the same time, so the
+// memory scales with the cluster size rather than the size of the view graph.
+class PartitionedPositionEstimator : public PositionEstimator {
+ public:
+  struct Options {
+    int num_threads = 8;
+
+    // Maximum number of views of a cluster before it is grown.
+    int max_cluster_size = 2000;
+
+    // Each cluster is grown by at most this fraction of its size.
+    double overlap_ratio = 0.2;
+  };
+
+  // Creates the estimator that solves a single cluster. It is called once per
+  // cluster, from a single thread.
+  typedef std::function<std::unique_ptr<PositionEstimator>()>
+      PositionEstimatorFactory;
+
+  PartitionedPositionEstimator(
+      const PartitionedPositionEstimator::Options& options,
+      const PositionEstimatorFactory& estimator_factory);
+
+  // Returns true if all clusters were solved and could be aligned, false if
+  // there was a failure.
+  bool EstimatePositions(
+      const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+      const std::unordered_map<image_t, Eigen::Vector3d>& orientation,
+      std::unordered_map<image_t, Eigen::Vector3d>* positions) override;
+
+ private:
+  // Partitions the views by the normalized cut into clusters of at most
+  // max_cluster_size views, and grows each cluster by its most strongly
+  // connected outside views. The clusters hold view indices in ascending order.
+  void PartitionViews(std::vector<std::vector<int>>* clusters) const;
+
+  // Estimates the scale and the translation of each cluster from the shared
+  // views. Returns false if the clusters do not overlap sufficiently, i.e. if
+  // the shared views do not determine all scales and translations.
+  bool AlignClusters(
+      const std::vector<std::vector<int>>& clusters,
+      const std::vector<std::unordered_map<image_t, Eigen::Vector3d>>&
+          cluster_positions,
+      std::vector<double>* scales,
+      std::vector<Eigen::Vector3d>* translations) const;
+
+  const PartitionedPositionEstimator::Options options_;
+  const PositionEstimatorFactory estimator_factory_;
+
+  // The views with known orientations in ascending order of view id, and the
+  // valid view pairs in ascending order.
+  std::vector<image_t> index_to_view_id_;
+  std::unordered_map<image_t, int> view_id_to_index_;
+  std::vector<ImagePair> view_id_pairs_;
+  std::vector<std::pair<int, int>> edges_;
+  std::vector<int> edge_weights_;
+
+  // Incident edges of each view.
+  std::vector<std::vector<int>> adjacent_edges_;
+
+  friend class PartitionedPositionEstimatorTest;
+
+  DISALLOW_COPY_AND_ASSIGN(PartitionedPositionEstimator);
+};
+
+}  // namespace gopt
+
+#endif  // TRANSLATION_AVERAGING_PARTITIONED_POSITION_ESTIMATOR_H_
@@ -0,0 +1,205 @@
+#include "translation_averaging/partitioned_position_estimator.h"
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "translation_averaging/bata_position_estimator.h"
+#include "translation_averaging/test_util.h"
+#include "util/map_util.h"
+#include "util/random.h"
+
+namespace gopt {
+namespace {
+
+// Returns the ground truth positions of the views of the view pairs, with a
+// random scale and translation per call, as the clusters are only defined up
+// to a similarity.
+class GTPositionEstimator : public PositionEstimator {
+ public:
+  GTPositionEstimator(
+      const std::unordered_map<image_t, Eigen::Vector3d>& gt_positions,
+      const unsigned seed)
+      : gt_positions_(gt_positions), rng_(seed) {}
+
+  bool EstimatePositions(
+      const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+      const std::unordered_map<image_t, Eigen::Vector3d>& orientation,
+      std::unordered_map<image_t, Eigen::Vector3d>* positions) override {
+    const double scale = rng_.RandDouble(0.1, 10.0);
+    const Eigen::Vector3d translation = 10.0 * rng_.RandVector3d();
+    for (const auto& view_pair : view_pairs) {
+      for (const image_t view_id :
+           {view_pair.first.first, view_pair.first.second}) {
+        (*positions)[view_id] =
+            scale * FindOrDie(gt_positions_, view_id) + translation;
+      }
+    }
+    return true;
+  }
+
+ private:
+  const std::unordered_map<image_t, Eigen::Vector3d>& gt_positions_;
+  RandomNumberGenerator rng_;
+};
+
+}  // namespace
+
+class PartitionedPositionEstimatorTest : public TranslationAveragingTest {
+ public:
+  // Solves the clusters with BATA, or with the ground truth up to a random
+  // similarity if use_bata is false.
+  void TestPartitionedPositionEstimator(const int num_views,
+                                        const int num_neighbors,
+                                        const int max_cluster_size,
+                                        const double translation_noise_degrees,
+                                        const double position_tolerance,
+                                        const bool use_bata) {
+    CreateSequentialGTCameras(num_views);
+    CreateSequentialRelativeTranslations(num_neighbors,
+                                         translation_noise_degrees);
+
+    unsigned seed = 0;
+    const PartitionedPositionEstimator::PositionEstimatorFactory
+        estimator_factory = [this, use_bata, &seed]() {
+          std::unique_ptr<PositionEstimator> position_estimator;
+          if (use_bata) {
+            BATAPositionEstimator::Options options;
+            options.convergence_criterion = 1e-8;
+            options.max_num_iterations = 500;
+            position_estimator.reset(new BATAPositionEstimator(options));
+          } else {
+            position_estimator.reset(
+                new GTPositionEstimator(positions_, seed++));
+          }
+          return position_estimator;
+        };
+
+    PartitionedPositionEstimator::Options options;
+    options.max_cluster_size = max_cluster_size;
+    PartitionedPositionEstimator position_estimator(options,
+                                                    estimator_factory);
+
+    std::unordered_map<image_t, Eigen::Vector3d> estimated_positions;
+    EXPECT_TRUE(position_estimator.EstimatePositions(
+        view_pairs_, orientations_, &estimated_positions));
+    EXPECT_EQ(estimated_positions.size(), positions_.size());
+
+    // Positions are recovered up to a translation and a scale.
+    AlignPositions(&estimated_positions);
+    for (const auto& position : positions_) {
+      const Eigen::Vector3d& estimated_position =
+          FindOrDie(estimated_positions, position.first);
+      EXPECT_LT((estimated_position - position.second).norm(),
+                position_tolerance);
+    }
+  }
+
+  // Aligns the clusters of views 0, ..., num_views - 1 whose ground truth
+  // positions are moved by a random similarity per cluster, except for the
+  // first cluster. Returns false if the alignment fails.
+  bool TestAlignClusters(const int num_views,
+                         const std::vector<std::vector<int>>& clusters) {
+    CreateGTCameras(num_views);
+
+    PartitionedPositionEstimator::Options options;
+    PartitionedPositionEstimator position_estimator(
+        options, []() { return std::unique_ptr<PositionEstimator>(); });
+    for (int i = 0; i < num_views; i++) {
+      position_estimator.index_to_view_id_.push_back(i);
+    }
+
+    std::vector<std::unordered_map<image_t, Eigen::Vector3d>> cluster_positions(
+        clusters.size());
+    for (size_t k = 0; k < clusters.size(); k++) {
+      const double scale = k == 0 ? 1.0 : rng_.RandDouble(0.1, 10.0);
+      const Eigen::Vector3d translation =
+          k == 0 ? Eigen::Vector3d::Zero().eval() : 10.0 * rng_.RandVector3d();
+      for (const int view_index : clusters[k]) {
+        cluster_positions[k][view_index] =
+            scale * FindOrDie(positions_, view_index) + translation;
+      }
+    }
+
+    std::vector<double> scales;
+    std::vector<Eigen::Vector3d> translations;
+    if (!position_estimator.AlignClusters(clusters, cluster_positions, &scales,
+                                          &translations)) {
+      return false;
+    }
+
+    // The aligned positions of all clusters are the ground truth positions.
+    for (size_t k = 0; k < clusters.size(); k++) {
+      for (const int view_index : clusters[k]) {
+        const Eigen::Vector3d aligned_position =
+            scales[k] * FindOrDie(cluster_positions[k], view_index) +
+            translations[k];
+        EXPECT_LT((aligned_position - FindOrDie(positions_, view_index)).norm(),
+                  1e-8);
+      }
+    }
+    return true;
+  }
+
+ private:
+  // The cameras follow a random walk, as in a sequential capture.
+  void CreateSequentialGTCameras(const int num_views) {
+    Eigen::Vector3d position = Eigen::Vector3d::Zero();
+    for (int i = 0; i < num_views; i++) {
+      orientations_[i] = 0.2 * rng_.RandVector3d();
+      position += rng_.RandVector3d();
+      positions_[i] = position;
+    }
+  }
+
+  // Each view is matched to its next views along the sequence.
+  void CreateSequentialRelativeTranslations(
+      const int num_neighbors, const double translation_noise_degrees) {
+    const int num_views = positions_.size();
+    for (int i = 0; i < num_views; i++) {
+      for (int j = i + 1; j <= std::min(i + num_neighbors, num_views - 1);
+           j++) {
+        AddViewPair(i, j, translation_noise_degrees);
+      }
+    }
+  }
+};
+
+TEST_F(PartitionedPositionEstimatorTest, SingleCluster) {
+  TestPartitionedPositionEstimator(40, 4, 100, 0.0, 1e-8, false);
+}
+
+TEST_F(PartitionedPositionEstimatorTest, ClustersAreAligned) {
+  TestPartitionedPositionEstimator(500, 4, 50, 0.0, 1e-8, false);
+}
+
+TEST_F(PartitionedPositionEstimatorTest, BATAClustersWithNoise) {
+  TestPartitionedPositionEstimator(300, 6, 60, 1.0, 1.0, true);
+}
+
+TEST_F(PartitionedPositionEstimatorTest, AlignClustersSharingTwoViews) {
+  EXPECT_TRUE(TestAlignClusters(10, {{0, 1, 2, 3, 4, 5}, {4, 5, 6, 7, 8, 9}}));
+}
+
+TEST_F(PartitionedPositionEstimatorTest, AlignClustersSharingOneView) {
+  // One shared view leaves the scale of the second cluster undetermined.
+  for (int shared_view = 1; shared_view < 9; shared_view++) {
+    std::vector<std::vector<int>> clusters(2);
+    for (int i = 0; i < 10; i++) {
+      if (i <= shared_view) {
+        clusters[0].push_back(i);
+      }
+      if (i >= shared_view) {
+        clusters[1].push_back(i);
+      }
+    }
+    EXPECT_FALSE(TestAlignClusters(10, clusters));
+  }
+}
+
+}  // namespace gopt
@@ -13,14 +13,26 @@ namespace gopt {
 
 enum class PositionEstimatorType : int {
   LUD = 0,
-  BATA = 1
+  BATA = 1,
+  LIGT = 2
+};
+
+enum class DirectionResidualType : int {
+  // The difference of the unit directions, i.e. 2 * sin(theta / 2).
+  CHORDAL = 0,
+  // The angle theta between the directions.
+  ANGULAR = 1
 };
 
 struct PositionEstimatorOptions {
+  // LUD remains the default. BATA is usually more robust to outliers and
+  // faster on large scenes, but has to be selected explicitly.
   PositionEstimatorType estimator_type = PositionEstimatorType::LUD;
 
   bool verbose = true;
 
+  int num_threads = 8;
+
   // Options for ADMM QP solver.
   int max_num_iterations = 400;
 
@@ -29,6 +41,42 @@ struct PositionEstimatorOptions {
 
   // A measurement for convergence criterion.
   double convergence_criterion = 1e-4;
+
+  // Options for BATA.
+  // Maximum number of IRLS iterations, which BATA needs considerably more of
+  // than the reweighted iterations of LUD.
+  int bata_max_num_iterations = 100;
+  // Width of the robust loss on the angle-based residuals.
+  double robust_loss_width = 0.1;
+
+  // Options for LiGT.
+  // Weight of the prior pulling the baselines towards one.
+  double baseline_prior_weight = 1e-4;
+
+  // Initialize LUD or BATA with the positions estimated by LiGT.
+  bool linear_initialization = false;
+
+  // Options for the divide-and-conquer estimation. View graphs with more views
+  // than max_cluster_size are partitioned into clusters, which are solved
+  // independently by the estimator above and aligned by a similarity each.
+  // Non-positive values disable the partitioning.
+  int max_cluster_size = 0;
+  // Fraction of views by which each cluster is grown into its neighbors.
+  double cluster_overlap_ratio = 0.2;
+
+  // Options for the 1DSfM filter, which removes view pairs with inconsistent
+  // relative translations before the position estimation.
+  bool filter_relative_translations = false;
+  int num_filter_iterations = 48;
+  double translation_projection_tolerance = 0.1;
+
+  // Options for the nonlinear refinement of the estimated positions.
+  bool nonlinear_refinement = false;
+  int max_num_refinement_iterations = 100;
+  DirectionResidualType refinement_residual_type =
+      DirectionResidualType::CHORDAL;
+  // Width of the Cauchy loss on the direction residuals.
+  double refinement_robust_loss_width = 0.1;
 };
 
 // A generic class defining the interface for global position estimation
@@ -53,6 +101,16 @@ class PositionEstimator {
       const std::unordered_map<image_t, Eigen::Vector3d>& orientation,
       std::unordered_map<image_t, Eigen::Vector3d>* positions) = 0;
 
+  // Sets the positions the estimation starts from. Estimators that need an
+  // initialization use them if all views are covered, others ignore them.
+  void SetInitialPositions(
+      const std::unordered_map<image_t, Eigen::Vector3d>& positions) {
+    initial_positions_ = positions;
+  }
+
+ protected:
+  std::unordered_map<image_t, Eigen::Vector3d> initial_positions_;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(PositionEstimator);
 };
@@ -0,0 +1,118 @@
+#ifndef TRANSLATION_AVERAGING_TEST_UTIL_H_
+#define TRANSLATION_AVERAGING_TEST_UTIL_H_
+
+#include <unordered_map>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <gtest/gtest.h>
+
+#include "geometry/rotation_utils.h"
+#include "util/map_util.h"
+#include "util/random.h"
+#include "util/types.h"
+
+namespace gopt {
+
+// A fixture with random ground truth cameras and the relative translations
+// between them, shared by the tests of the translation averaging methods.
+class TranslationAveragingTest : public ::testing::Test {
+ protected:
+  void CreateGTCameras(const int num_views) {
+    for (int i = 0; i < num_views; i++) {
+      orientations_[i] = 0.2 * rng_.RandVector3d();
+      positions_[i] = 10.0 * rng_.RandVector3d();
+    }
+  }
+
+  void AddViewPair(const image_t view_id1, const image_t view_id2,
+                   const double translation_noise_degrees) {
+    const ImagePair view_id_pair(view_id1, view_id2);
+    if (ContainsKey(view_pairs_, view_id_pair)) {
+      return;
+    }
+
+    // The relative translation direction in the frame of the first view.
+    const Eigen::Vector3d direction =
+        geometry::RelativeTranslationFromTwoPositions(
+            FindOrDie(positions_, view_id1), FindOrDie(positions_, view_id2),
+            FindOrDie(orientations_, view_id1));
+    const Eigen::AngleAxisd noise(
+        geometry::DegToRad(translation_noise_degrees),
+        rng_.RandVector3d().normalized());
+
+    TwoViewGeometry two_view_geometry;
+    two_view_geometry.translation_2 = noise * direction;
+    view_pairs_[view_id_pair] = two_view_geometry;
+  }
+
+  void CreateRelativeTranslations(const int num_view_pairs,
+                                  const double translation_noise_degrees,
+                                  const int num_outliers = 0) {
+    const int num_views = positions_.size();
+
+    // Create a cycle graph to ensure the graph is connected.
+    for (int i = 0; i < num_views; i++) {
+      AddViewPair(i, (i + 1) % num_views, translation_noise_degrees);
+    }
+
+    while (view_pairs_.size() < static_cast<size_t>(num_view_pairs)) {
+      const image_t view_id1 = rng_.RandInt(0, num_views - 1);
+      const image_t view_id2 = rng_.RandInt(0, num_views - 1);
+      if (view_id1 < view_id2) {
+        AddViewPair(view_id1, view_id2, translation_noise_degrees);
+      }
+    }
+
+    // Replace some of the directions by random ones.
+    int num_corrupted = 0;
+    for (auto& view_pair : view_pairs_) {
+      if (num_corrupted == num_outliers) {
+        break;
+      }
+      if (view_pair.first.second == view_pair.first.first + 1) {
+        continue;
+      }
+      view_pair.second.translation_2 = rng_.RandVector3d().normalized();
+      ++num_corrupted;
+    }
+  }
+
+  // Aligns the estimated positions to the ground truth by a translation and a
+  // scale, up to which the positions are recovered.
+  void AlignPositions(
+      std::unordered_map<image_t, Eigen::Vector3d>* estimated_positions) {
+    Eigen::Vector3d gt_center = Eigen::Vector3d::Zero();
+    Eigen::Vector3d estimated_center = Eigen::Vector3d::Zero();
+    for (const auto& position : positions_) {
+      gt_center += position.second;
+      estimated_center += FindOrDie(*estimated_positions, position.first);
+    }
+    gt_center /= positions_.size();
+    estimated_center /= positions_.size();
+
+    double numerator = 0.0, denominator = 0.0;
+    for (const auto& position : positions_) {
+      const Eigen::Vector3d estimated_offset =
+          FindOrDie(*estimated_positions, position.first) - estimated_center;
+      numerator += estimated_offset.dot(position.second - gt_center);
+      denominator += estimated_offset.squaredNorm();
+    }
+    const double scale = numerator / denominator;
+
+    for (auto& position : *estimated_positions) {
+      position.second =
+          scale * (position.second - estimated_center) + gt_center;
+    }
+  }
+
+  std::unordered_map<image_t, Eigen::Vector3d> orientations_;
+  std::unordered_map<image_t, Eigen::Vector3d> positions_;
+  std::unordered_map<ImagePair, TwoViewGeometry> view_pairs_;
+
+  RandomNumberGenerator rng_ = RandomNumberGenerator(59);
+};
+
+}  // namespace gopt
+
+#endif  // TRANSLATION_AVERAGING_TEST_UTIL_H_
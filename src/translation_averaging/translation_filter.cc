@@ -0,0 +1,209 @@
+#include "translation_averaging/translation_filter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "translation_averaging/internal/translation_averaging_util.h"
+#include "util/map_util.h"
+#include "util/profiler.h"
+#include "util/random.h"
+
+namespace gopt {
+namespace {
+
+// The edges of the view graph with their endpoints as view indices.
+struct FilterGraph {
+  std::vector<std::pair<int, int>> edges;
+  std::vector<Eigen::Vector3d> directions;
+  // Incident edges of each view.
+  std::vector<std::vector<int>> adjacent_edges;
+};
+
+// Orders the views along a 1D projection by the greedy minimum feedback arc
+// set heuristic: the edge e points from its first to its second view if the
+// projection is positive, and the view with the smallest ratio of incoming to
+// outgoing weight (i.e. the most source-like view) is placed next. Edges which
+// point backwards in the ordering are charged with their weight.
+void AccumulateInconsistency(const FilterGraph& graph,
+                             const Eigen::Vector3d& axis,
+                             std::vector<double>* projections,
+                             std::vector<double>* in_weights,
+                             std::vector<double>* out_weights,
+                             std::vector<int>* ordering,
+                             std::vector<double>* inconsistency) {
+  const int num_views = graph.adjacent_edges.size();
+  const int num_edges = graph.edges.size();
+
+  std::fill(in_weights->begin(), in_weights->end(), 0.0);
+  std::fill(out_weights->begin(), out_weights->end(), 0.0);
+  for (int e = 0; e < num_edges; e++) {
+    const double projection = graph.directions[e].dot(axis);
+    (*projections)[e] = projection;
+    const int source = (projection > 0.0) ? graph.edges[e].first
+                                          : graph.edges[e].second;
+    const int target = (projection > 0.0) ? graph.edges[e].second
+                                          : graph.edges[e].first;
+    (*out_weights)[source] += std::abs(projection);
+    (*in_weights)[target] += std::abs(projection);
+  }
+
+  const auto score = [&](const int view) {
+    return ((*in_weights)[view] + 1.0) / ((*out_weights)[view] + 1.0);
+  };
+
+  std::set<std::pair<double, int>> remaining_views;
+  for (int i = 0; i < num_views; i++) {
+    remaining_views.emplace(score(i), i);
+  }
+
+  std::fill(ordering->begin(), ordering->end(), -1);
+  for (int position = 0; position < num_views; position++) {
+    const int view = remaining_views.begin()->second;
+    remaining_views.erase(remaining_views.begin());
+    (*ordering)[view] = position;
+
+    // Remove the edges of the placed view from its remaining neighbors.
+    for (const int e : graph.adjacent_edges[view]) {
+      const int neighbor = (graph.edges[e].first == view)
+                               ? graph.edges[e].second
+                               : graph.edges[e].first;
+      if ((*ordering)[neighbor] >= 0) {
+        continue;
+      }
+
+      remaining_views.erase(std::make_pair(score(neighbor), neighbor));
+      const double projection = (*projections)[e];
+      const bool is_source = graph.edges[e].first == view;
+      if (is_source == (projection > 0.0)) {
+        (*in_weights)[neighbor] -= std::abs(projection);
+      } else {
+        (*out_weights)[neighbor] -= std::abs(projection);
+      }
+      remaining_views.emplace(score(neighbor), neighbor);
+    }
+  }
+
+  for (int e = 0; e < num_edges; e++) {
+    const double projection = (*projections)[e];
+    const int order1 = (*ordering)[graph.edges[e].first];
+    const int order2 = (*ordering)[graph.edges[e].second];
+    if ((projection > 0.0 && order1 > order2) ||
+        (projection < 0.0 && order1 < order2)) {
+      (*inconsistency)[e] += std::abs(projection);
+    }
+  }
+}
+
+}  // namespace
+
+int FilterViewPairsFromRelativeTranslation(
+    const TranslationFilterOptions& options,
+    const std::unordered_map<image_t, Eigen::Vector3d>& orientations,
+    std::unordered_map<ImagePair, TwoViewGeometry>* view_pairs) {
+  GOPT_PROFILE_SCOPE("TranslationFilter");
+  CHECK_NOTNULL(view_pairs);
+  CHECK_GT(options.num_threads, 0);
+  CHECK_GT(options.num_iterations, 0);
+
+  // Sort the pairs so that the result does not depend on the iteration order
+  // of the hash maps.
+  std::vector<ImagePair> view_id_pairs;
+  view_id_pairs.reserve(view_pairs->size());
+  std::vector<image_t> view_ids;
+  for (const auto& view_pair : *view_pairs) {
+    if (ContainsKey(orientations, view_pair.first.first) &&
+        ContainsKey(orientations, view_pair.first.second) &&
+        view_pair.second.translation_2.squaredNorm() > 0.0) {
+      view_id_pairs.push_back(view_pair.first);
+      view_ids.push_back(view_pair.first.first);
+      view_ids.push_back(view_pair.first.second);
+    }
+  }
+  if (view_id_pairs.empty()) {
+    return 0;
+  }
+  std::sort(view_id_pairs.begin(), view_id_pairs.end());
+  std::sort(view_ids.begin(), view_ids.end());
+  view_ids.erase(std::unique(view_ids.begin(), view_ids.end()),
+                 view_ids.end());
+
+  std::unordered_map<image_t, int> view_id_to_index;
+  view_id_to_index.reserve(view_ids.size());
+  for (size_t i = 0; i < view_ids.size(); i++) {
+    view_id_to_index[view_ids[i]] = i;
+  }
+
+  FilterGraph graph;
+  graph.edges.reserve(view_id_pairs.size());
+  graph.directions.reserve(view_id_pairs.size());
+  graph.adjacent_edges.resize(view_ids.size());
+  for (const ImagePair& view_id_pair : view_id_pairs) {
+    // Rotate the relative translation so that it is aligned to the global
+    // orientation frame.
+    const int e = graph.edges.size();
+    graph.edges.emplace_back(FindOrDie(view_id_to_index, view_id_pair.first),
+                             FindOrDie(view_id_to_index, view_id_pair.second));
+    graph.directions.push_back(
+        internal::GetRotatedTranslation(
+            FindOrDie(orientations, view_id_pair.first),
+            FindOrDieNoPrint(*view_pairs, view_id_pair).translation_2)
+            .normalized());
+    graph.adjacent_edges[graph.edges.back().first].push_back(e);
+    graph.adjacent_edges[graph.edges.back().second].push_back(e);
+  }
+
+  // Sample the projection directions from the measured directions, such that
+  // they follow the distribution of the baselines.
+  const int num_edges = graph.edges.size();
+  RandomNumberGenerator rng(options.seed);
+  std::vector<Eigen::Vector3d> axes(options.num_iterations);
+  for (Eigen::Vector3d& axis : axes) {
+    axis = (graph.directions[rng.RandInt(0, num_edges - 1)] +
+            0.1 * rng.RandVector3d())
+               .normalized();
+  }
+
+  // Each task owns its accumulator and working memory. The accumulators are
+  // summed in a fixed order, so the result does not depend on the scheduling.
+  const int num_tasks = std::min(options.num_threads, options.num_iterations);
+  std::vector<std::vector<double>> task_inconsistencies(
+      num_tasks, std::vector<double>(num_edges, 0.0));
+
+#pragma omp parallel for num_threads(num_tasks) schedule(static, 1)
+  for (int t = 0; t < num_tasks; t++) {
+    std::vector<double> projections(num_edges);
+    std::vector<double> in_weights(view_ids.size());
+    std::vector<double> out_weights(view_ids.size());
+    std::vector<int> ordering(view_ids.size());
+    for (int i = t; i < options.num_iterations; i += num_tasks) {
+      AccumulateInconsistency(graph, axes[i], &projections, &in_weights,
+                              &out_weights, &ordering,
+                              &task_inconsistencies[t]);
+    }
+  }
+
+  int num_removed_view_pairs = 0;
+  for (int e = 0; e < num_edges; e++) {
+    double inconsistency = 0.0;
+    for (int t = 0; t < num_tasks; t++) {
+      inconsistency += task_inconsistencies[t][e];
+    }
+
+    if (inconsistency / options.num_iterations >
+        options.translation_projection_tolerance) {
+      view_pairs->erase(view_id_pairs[e]);
+      ++num_removed_view_pairs;
+    }
+  }
+
+  VLOG(1) << "Removed " << num_removed_view_pairs << " of " << num_edges
+          << " view pairs with inconsistent relative translations.";
+  return num_removed_view_pairs;
+}
+
+}  // namespace gopt
@@ -0,0 +1,47 @@
+#ifndef TRANSLATION_AVERAGING_TRANSLATION_FILTER_H_
+#define TRANSLATION_AVERAGING_TRANSLATION_FILTER_H_
+
+#include <unordered_map>
+
+#include <Eigen/Core>
+
+#include "util/types.h"
+#include "util/hash.h"
+
+namespace gopt {
+
+struct TranslationFilterOptions {
+  int num_threads = 8;
+
+  // Number of random 1D projections. Each projection is solved independently.
+  int num_iterations = 48;
+
+  // View pairs whose accumulated inconsistency, averaged over all projections,
+  // exceeds this threshold are removed.
+  double translation_projection_tolerance = 0.1;
+
+  // Seed of the random projection directions.
+  unsigned seed = 0;
+};
+
+// Removes view pairs whose relative translation directions are inconsistent
+// with the others, following the 1DSfM outlier filter of:
+//   K. Wilson and N. Snavely. Robust Global Translations with 1DSfM.
+//   ECCV 2014.
+//
+// The relative translations are rotated into the global frame and projected
+// onto random 1D directions. For each direction, the projections define a
+// weighted directed graph, whose vertices are ordered by a greedy minimum
+// feedback arc set approximation. Edges that disagree with the ordering are
+// charged with the magnitude of their projection. The projections are
+// independent, so each one is solved by its own task in parallel.
+//
+// Returns the number of removed view pairs.
+int FilterViewPairsFromRelativeTranslation(
+    const TranslationFilterOptions& options,
+    const std::unordered_map<image_t, Eigen::Vector3d>& orientations,
+    std::unordered_map<ImagePair, TwoViewGeometry>* view_pairs);
+
+}  // namespace gopt
+
+#endif  // TRANSLATION_AVERAGING_TRANSLATION_FILTER_H_
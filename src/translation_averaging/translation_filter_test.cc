@@ -0,0 +1,84 @@
+#include "translation_averaging/translation_filter.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "translation_averaging/test_util.h"
+#include "util/map_util.h"
+
+namespace gopt {
+
+class TranslationFilterTest : public TranslationAveragingTest {
+ public:
+  void TestTranslationFilter(const int num_views,
+                             const int num_view_pairs,
+                             const double translation_noise_degrees,
+                             const int num_outliers) {
+    // At least a cycle graph.
+    ASSERT_LE(num_views + 1, num_view_pairs);
+
+    CreateGTCameras(num_views);
+    CreateRelativeTranslations(num_view_pairs, translation_noise_degrees);
+    std::unordered_set<ImagePair> outliers;
+    CreateOutliers(num_outliers, &outliers);
+
+    TranslationFilterOptions options;
+    std::unordered_map<ImagePair, TwoViewGeometry> filtered_view_pairs =
+        view_pairs_;
+    const int num_removed_view_pairs = FilterViewPairsFromRelativeTranslation(
+        options, orientations_, &filtered_view_pairs);
+    EXPECT_EQ(num_removed_view_pairs,
+              view_pairs_.size() - filtered_view_pairs.size());
+
+    // Most of the outliers are removed, but only few of the inliers.
+    int num_removed_outliers = 0, num_removed_inliers = 0;
+    for (const auto& view_pair : view_pairs_) {
+      if (ContainsKey(filtered_view_pairs, view_pair.first)) {
+        continue;
+      }
+      if (ContainsKey(outliers, view_pair.first)) {
+        ++num_removed_outliers;
+      } else {
+        ++num_removed_inliers;
+      }
+    }
+    EXPECT_GE(num_removed_outliers, 0.8 * num_outliers);
+    EXPECT_LE(num_removed_inliers, 0.05 * (num_view_pairs - num_outliers));
+  }
+
+ private:
+  // Flips the directions of some of the view pairs that are not part of the
+  // cycle.
+  void CreateOutliers(const int num_outliers,
+                      std::unordered_set<ImagePair>* outliers) {
+    for (auto& view_pair : view_pairs_) {
+      if (static_cast<int>(outliers->size()) == num_outliers) {
+        break;
+      }
+      if (view_pair.first.second == view_pair.first.first + 1) {
+        continue;
+      }
+      view_pair.second.translation_2 *= -1.0;
+      outliers->insert(view_pair.first);
+    }
+  }
+};
+
+TEST_F(TranslationFilterTest, NoOutliersNoNoise) {
+  TestTranslationFilter(20, 60, 0.0, 0);
+}
+
+TEST_F(TranslationFilterTest, OutliersWithNoise) {
+  TestTranslationFilter(50, 300, 1.0, 15);
+}
+
+TEST_F(TranslationFilterTest, ManyOutliersWithNoise) {
+  TestTranslationFilter(100, 800, 2.0, 80);
+}
+
+}  // namespace gopt
@@ -0,0 +1,208 @@
+#include "util/profiler.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+
+namespace gopt {
+namespace {
+
+std::string EscapeJsonString(const char* str) {
+  std::string escaped;
+  for (const char* c = str; *c != '\0'; ++c) {
+    if (*c == '"' || *c == '\\') {
+      escaped.push_back('\\');
+    }
+    escaped.push_back(*c);
+  }
+  return escaped;
+}
+
+}  // namespace
+
+Profiler& Profiler::Instance() {
+  static Profiler profiler;
+  return profiler;
+}
+
+Profiler::Profiler()
+    : enabled_(false), epoch_(std::chrono::steady_clock::now()) {}
+
+void Profiler::SetEnabled(const bool enabled) {
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& thread_buffer : thread_buffers_) {
+    thread_buffer->events.clear();
+  }
+}
+
+double Profiler::NowMicroSeconds() const {
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - epoch_)
+      .count();
+}
+
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer() {
+  // Each thread registers its buffer once. The buffers are owned by the
+  // profiler so that events of finished (e.g. OpenMP worker) threads survive.
+  static thread_local ThreadBuffer* thread_buffer = nullptr;
+  if (thread_buffer == nullptr) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    thread_buffers_.emplace_back(new ThreadBuffer);
+    thread_buffer = thread_buffers_.back().get();
+    thread_buffer->thread_id = static_cast<int>(thread_buffers_.size()) - 1;
+  }
+  return thread_buffer;
+}
+
+void Profiler::BeginZone() {
+  ++GetThreadBuffer()->depth;
+}
+
+void Profiler::EndZone(const char* name, const double begin_us) {
+  const double end_us = NowMicroSeconds();
+  ThreadBuffer* thread_buffer = GetThreadBuffer();
+  --thread_buffer->depth;
+
+  Event event;
+  event.name = name;
+  event.begin_us = begin_us;
+  event.duration_us = end_us - begin_us;
+  event.depth = thread_buffer->depth;
+  thread_buffer->events.push_back(event);
+}
+
+bool Profiler::WriteChromeTrace(const std::string& filename) const {
+  std::ofstream out(filename);
+  if (!out.is_open()) {
+    LOG(ERROR) << "Cannot write chrome trace: " << filename;
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  out << std::fixed << std::setprecision(3);
+  out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+  bool first_event = true;
+  for (const auto& thread_buffer : thread_buffers_) {
+    if (!first_event) {
+      out << ",\n";
+    }
+    first_event = false;
+    out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": "
+        << thread_buffer->thread_id << ", \"args\": {\"name\": \"thread "
+        << thread_buffer->thread_id << "\"}}";
+
+    for (const Event& event : thread_buffer->events) {
+      out << ",\n{\"name\": \"" << EscapeJsonString(event.name)
+          << "\", \"cat\": \"gopt\", \"ph\": \"X\", \"pid\": 0, \"tid\": "
+          << thread_buffer->thread_id << ", \"ts\": " << event.begin_us
+          << ", \"dur\": " << event.duration_us << "}";
+    }
+  }
+  out << "\n]}\n";
+
+  return true;
+}
+
+std::vector<Profiler::PhaseStatistics> Profiler::AggregatePhases() const {
+  std::vector<PhaseStatistics> phases;
+  std::unordered_map<std::string, size_t> path_to_phase;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& thread_buffer : thread_buffers_) {
+    // Events are recorded when a zone ends, so children precede their
+    // parents. Sorting by begin time (parents first on ties) recovers the
+    // depth-first order of the zone tree.
+    std::vector<Event> events = thread_buffer->events;
+    std::sort(events.begin(), events.end(),
+              [](const Event& event1, const Event& event2) {
+                if (event1.begin_us != event2.begin_us) {
+                  return event1.begin_us < event2.begin_us;
+                }
+                return event1.depth < event2.depth;
+              });
+
+    // Stack of the phase indices of the currently open ancestors.
+    std::vector<std::pair<int, size_t>> ancestors;
+    for (const Event& event : events) {
+      while (!ancestors.empty() && ancestors.back().first >= event.depth) {
+        ancestors.pop_back();
+      }
+
+      std::string path = event.name;
+      if (!ancestors.empty()) {
+        path = phases[ancestors.back().second].path + "/" + path;
+      }
+
+      auto phase_iter = path_to_phase.find(path);
+      if (phase_iter == path_to_phase.end()) {
+        PhaseStatistics phase;
+        phase.path = path;
+        phase.depth = static_cast<int>(ancestors.size());
+        phase_iter = path_to_phase.emplace(path, phases.size()).first;
+        phases.push_back(phase);
+      }
+
+      const double duration_ms = event.duration_us * 1e-3;
+      PhaseStatistics& phase = phases[phase_iter->second];
+      phase.num_calls++;
+      phase.total_ms += duration_ms;
+      phase.self_ms += duration_ms;
+      phase.max_ms = std::max(phase.max_ms, duration_ms);
+      if (!ancestors.empty()) {
+        phases[ancestors.back().second].self_ms -= duration_ms;
+      }
+
+      ancestors.emplace_back(event.depth, phase_iter->second);
+    }
+  }
+
+  return phases;
+}
+
+std::string Profiler::ReportTable() const {
+  const std::vector<PhaseStatistics> phases = AggregatePhases();
+
+  double root_total_ms = 0.0;
+  for (const PhaseStatistics& phase : phases) {
+    if (phase.depth == 0) {
+      root_total_ms += phase.total_ms;
+    }
+  }
+
+  std::ostringstream table;
+  table << std::fixed << std::setprecision(3);
+  table << std::left << std::setw(48) << "Phase" << std::right
+        << std::setw(10) << "Calls" << std::setw(14) << "Total(ms)"
+        << std::setw(14) << "Self(ms)" << std::setw(14) << "Mean(ms)"
+        << std::setw(14) << "Max(ms)" << std::setw(10) << "%" << "\n";
+
+  for (const PhaseStatistics& phase : phases) {
+    const size_t name_begin = phase.path.find_last_of('/');
+    const std::string name = (name_begin == std::string::npos)
+                                 ? phase.path
+                                 : phase.path.substr(name_begin + 1);
+    const double percentage =
+        (root_total_ms > 0.0) ? 100.0 * phase.total_ms / root_total_ms : 0.0;
+
+    table << std::left << std::setw(48)
+          << std::string(2 * phase.depth, ' ') + name << std::right
+          << std::setw(10) << phase.num_calls << std::setw(14)
+          << phase.total_ms << std::setw(14) << phase.self_ms
+          << std::setw(14) << phase.total_ms / phase.num_calls
+          << std::setw(14) << phase.max_ms << std::setw(10)
+          << std::setprecision(1) << percentage << std::setprecision(3)
+          << "\n";
+  }
+
+  return table.str();
+}
+
+}  // namespace gopt
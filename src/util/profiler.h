@@ -0,0 +1,133 @@
+#ifndef UTIL_PROFILER_H_
+#define UTIL_PROFILER_H_
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace gopt {
+
+// A light-weight, thread-aware profiler for the phases of the optimization
+// pipeline. Phases are marked by RAII zones (see ScopedProfileZone and the
+// GOPT_PROFILE_SCOPE macro) which record a begin timestamp and a duration into
+// a buffer owned by the calling thread, so that recording never takes a lock.
+// Zones opened inside another zone on the same thread become its children.
+//
+// When the profiler is disabled (the default) a zone costs a single relaxed
+// atomic load, so the zones can be left in production code.
+//
+// After the pipeline finishes, the recorded events can be exported as a
+// Chrome trace (chrome://tracing or https://ui.perfetto.dev) or summarized as
+// an aggregated per-phase table.
+//
+// NOTE: WriteChromeTrace(), ReportTable() and Clear() must not be called
+// concurrently with open zones.
+class Profiler {
+ public:
+  struct Event {
+    // Zone names must outlive the profiler, string literals are expected.
+    const char* name;
+    // Begin time relative to the profiler epoch, in microseconds.
+    double begin_us;
+    double duration_us;
+    // Nesting depth of the zone in the thread which recorded it.
+    int depth;
+  };
+
+  // Aggregated statistics of all zones sharing the same path, where a path is
+  // the '/'-joined names of a zone and all its enclosing zones.
+  struct PhaseStatistics {
+    std::string path;
+    int depth = 0;
+    size_t num_calls = 0;
+    double total_ms = 0.0;
+    // Time not covered by any child zone.
+    double self_ms = 0.0;
+    double max_ms = 0.0;
+  };
+
+  static Profiler& Instance();
+
+  void SetEnabled(const bool enabled);
+  bool IsEnabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  // Discards all recorded events.
+  void Clear();
+
+  // Microseconds elapsed since the profiler was created.
+  double NowMicroSeconds() const;
+
+  // Called by ScopedProfileZone.
+  void BeginZone();
+  void EndZone(const char* name, const double begin_us);
+
+  // Writes all recorded events as a Chrome trace JSON file.
+  bool WriteChromeTrace(const std::string& filename) const;
+
+  // Aggregates the recorded events of all threads by path, sorted in the
+  // depth-first order of first appearance.
+  std::vector<PhaseStatistics> AggregatePhases() const;
+
+  // Returns the aggregated phases as a human readable table.
+  std::string ReportTable() const;
+
+ private:
+  struct ThreadBuffer {
+    int thread_id;
+    int depth = 0;
+    std::vector<Event> events;
+  };
+
+  Profiler();
+
+  ThreadBuffer* GetThreadBuffer();
+
+  std::atomic<bool> enabled_;
+  const std::chrono::steady_clock::time_point epoch_;
+
+  // Guards the registration of thread buffers only.
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<ThreadBuffer>> thread_buffers_;
+};
+
+// Records the lifetime of the enclosing scope as a zone named `name`.
+class ScopedProfileZone {
+ public:
+  explicit ScopedProfileZone(const char* name)
+      : name_(name), begin_us_(-1.0) {
+    Profiler& profiler = Profiler::Instance();
+    if (profiler.IsEnabled()) {
+      profiler.BeginZone();
+      begin_us_ = profiler.NowMicroSeconds();
+    }
+  }
+
+  ~ScopedProfileZone() {
+    if (begin_us_ >= 0.0) {
+      Profiler::Instance().EndZone(name_, begin_us_);
+    }
+  }
+
+ private:
+  const char* name_;
+  double begin_us_;
+
+  ScopedProfileZone(const ScopedProfileZone&);
+  void operator=(const ScopedProfileZone&);
+};
+
+#define GOPT_PROFILE_CONCAT_INNER(a, b) a##b
+#define GOPT_PROFILE_CONCAT(a, b) GOPT_PROFILE_CONCAT_INNER(a, b)
+
+// Opens a profiling zone which ends with the enclosing scope.
+#define GOPT_PROFILE_SCOPE(name) \
+  ::gopt::ScopedProfileZone GOPT_PROFILE_CONCAT(gopt_profile_zone_, __LINE__)(name)
+
+}  // namespace gopt
+
+#endif  // UTIL_PROFILER_H_
@@ -0,0 +1,94 @@
+#include "util/profiler.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace gopt {
+
+class ProfilerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    Profiler::Instance().Clear();
+    Profiler::Instance().SetEnabled(true);
+  }
+
+  void TearDown() override {
+    Profiler::Instance().SetEnabled(false);
+    Profiler::Instance().Clear();
+  }
+};
+
+TEST_F(ProfilerTest, DisabledProfilerRecordsNothing) {
+  Profiler::Instance().SetEnabled(false);
+  {
+    GOPT_PROFILE_SCOPE("Disabled");
+  }
+  EXPECT_TRUE(Profiler::Instance().AggregatePhases().empty());
+}
+
+TEST_F(ProfilerTest, NestedZonesAreAggregatedByPath) {
+  for (int i = 0; i < 3; i++) {
+    GOPT_PROFILE_SCOPE("Outer");
+    {
+      GOPT_PROFILE_SCOPE("Inner");
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    {
+      GOPT_PROFILE_SCOPE("Inner");
+    }
+  }
+
+  const std::vector<Profiler::PhaseStatistics> phases =
+      Profiler::Instance().AggregatePhases();
+  ASSERT_EQ(phases.size(), 2);
+
+  EXPECT_EQ(phases[0].path, "Outer");
+  EXPECT_EQ(phases[0].depth, 0);
+  EXPECT_EQ(phases[0].num_calls, 3);
+
+  EXPECT_EQ(phases[1].path, "Outer/Inner");
+  EXPECT_EQ(phases[1].depth, 1);
+  EXPECT_EQ(phases[1].num_calls, 6);
+
+  EXPECT_GE(phases[0].total_ms, phases[1].total_ms);
+  EXPECT_NEAR(phases[0].self_ms, phases[0].total_ms - phases[1].total_ms,
+              1e-6);
+  EXPECT_GE(phases[1].total_ms, 3.0);
+}
+
+TEST_F(ProfilerTest, ZonesOfOtherThreadsAreRecorded) {
+  std::thread worker([]() { GOPT_PROFILE_SCOPE("Worker"); });
+  worker.join();
+  {
+    GOPT_PROFILE_SCOPE("Main");
+  }
+
+  const std::string table = Profiler::Instance().ReportTable();
+  EXPECT_NE(table.find("Worker"), std::string::npos);
+  EXPECT_NE(table.find("Main"), std::string::npos);
+}
+
+TEST_F(ProfilerTest, WriteChromeTrace) {
+  {
+    GOPT_PROFILE_SCOPE("Phase \"quoted\"");
+  }
+
+  const std::string filename = "profiler_test_trace.json";
+  ASSERT_TRUE(Profiler::Instance().WriteChromeTrace(filename));
+
+  std::ifstream in(filename);
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+  const std::string trace = buffer.str();
+  EXPECT_NE(trace.find("\"traceEvents\""), std::string::npos);
+  EXPECT_NE(trace.find("\"ph\": \"X\""), std::string::npos);
+  EXPECT_NE(trace.find("Phase \\\"quoted\\\""), std::string::npos);
+  std::remove(filename.c_str());
+}
+
+}  // namespace gopt
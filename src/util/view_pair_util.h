@@ -0,0 +1,52 @@
+#ifndef UTIL_VIEW_PAIR_UTIL_H_
+#define UTIL_VIEW_PAIR_UTIL_H_
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "util/map_util.h"
+#include "util/types.h"
+
+namespace gopt {
+
+// Collects the view pairs whose two views are keys of views, together with
+// the ids of these views. Both are sorted so that the systems assembled from
+// them do not depend on the iteration order of the hash maps. If
+// view_id_to_index is not null, it maps each view id to its position in
+// view_ids.
+template <typename ViewMap>
+void IndexViewPairs(
+    const std::unordered_map<ImagePair, TwoViewGeometry>& view_pairs,
+    const ViewMap& views, std::vector<ImagePair>* view_id_pairs,
+    std::vector<image_t>* view_ids,
+    std::unordered_map<image_t, int>* view_id_to_index) {
+  view_id_pairs->clear();
+  view_ids->clear();
+  view_id_pairs->reserve(view_pairs.size());
+  for (const auto& view_pair : view_pairs) {
+    if (ContainsKey(views, view_pair.first.first) &&
+        ContainsKey(views, view_pair.first.second)) {
+      view_id_pairs->push_back(view_pair.first);
+      view_ids->push_back(view_pair.first.first);
+      view_ids->push_back(view_pair.first.second);
+    }
+  }
+
+  std::sort(view_ids->begin(), view_ids->end());
+  view_ids->erase(std::unique(view_ids->begin(), view_ids->end()),
+                  view_ids->end());
+  std::sort(view_id_pairs->begin(), view_id_pairs->end());
+
+  if (view_id_to_index != nullptr) {
+    view_id_to_index->clear();
+    view_id_to_index->reserve(view_ids->size());
+    for (size_t i = 0; i < view_ids->size(); i++) {
+      (*view_id_to_index)[(*view_ids)[i]] = i;
+    }
+  }
+}
+
+}  // namespace gopt
+
+#endif  // UTIL_VIEW_PAIR_UTIL_H_